@@ -0,0 +1,151 @@
+"""Per-module static RAM report from a GNU ld map file.
+
+PlatformIO runs this after linking the board envs (extra_scripts) and writes
+ram_report.txt next to firmware.elf. It also works by hand:
+
+    python scripts/ram_report.py .pio/build/nano33ble_rev2/firmware.map
+
+Static RAM is every .data/.bss/COMMON input section the linker placed; the
+heap and the thread stacks come out of what is left, which is why the
+firmware also reports runtime stack/heap high-water marks in device info.
+"""
+
+from __future__ import annotations
+
+import os
+import re
+import sys
+from collections import defaultdict
+
+RAM_SECTIONS = (".data", ".bss", "COMMON")
+DEFAULT_RAM_BYTES = 256 * 1024  # nRF52840
+
+# " .bss.sampleBuffer  0x20001234  0x960 path/inference.cpp.o" (may wrap after the name)
+SECTION_RE = re.compile(r"^ (\S+)\s*$|^ (\S+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+CONTINUATION_RE = re.compile(r"^\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s+(\S.*)$")
+MEMORY_RE = re.compile(r"^(\w+)\s+0x([0-9a-fA-F]+)\s+0x([0-9a-fA-F]+)\s*\S*\s*$")
+
+
+def is_ram_section(name: str) -> bool:
+    return any(name == s or name.startswith(s + ".") for s in RAM_SECTIONS)
+
+
+def module_name(path: str) -> str:
+    """src/inference.cpp.o -> inference.cpp; libfoo.a(bar.o) -> libfoo.a(bar.o)."""
+    path = path.strip()
+    archive = re.match(r"^(.*?\.a)\((.*)\)$", path)
+    if archive:
+        return "%s(%s)" % (os.path.basename(archive.group(1)), archive.group(2))
+    base = os.path.basename(path)
+    return base[:-2] if base.endswith(".o") else base
+
+
+def parse_map(lines):
+    """Return ({module: {"data": n, "bss": n}}, ram_bytes or None)."""
+    modules = defaultdict(lambda: {"data": 0, "bss": 0})
+    ram_bytes = None
+    in_memory_config = False
+    in_layout = False
+    pending = None
+
+    for line in lines:
+        line = line.rstrip("\n")
+        if line.startswith("Memory Configuration"):
+            in_memory_config = True
+            continue
+        if line.startswith("Linker script and memory map"):
+            in_memory_config = False
+            in_layout = True
+            continue
+        if in_memory_config:
+            match = MEMORY_RE.match(line)
+            if match and match.group(1).upper() == "RAM":
+                ram_bytes = int(match.group(3), 16)
+            continue
+        if not in_layout:
+            continue
+
+        if pending is not None:
+            match = CONTINUATION_RE.match(line)
+            if match:
+                add_section(modules, pending, int(match.group(1), 16),
+                            int(match.group(2), 16), match.group(3))
+            pending = None
+            continue
+
+        match = SECTION_RE.match(line)
+        if not match:
+            continue
+        if match.group(1):
+            if is_ram_section(match.group(1)):
+                pending = match.group(1)
+            continue
+        if is_ram_section(match.group(2)):
+            add_section(modules, match.group(2), int(match.group(3), 16),
+                        int(match.group(4), 16), match.group(5))
+
+    return modules, ram_bytes
+
+
+def add_section(modules, name, address, size, path):
+    # Discarded/debug sections sit at address 0; RAM is never there on Cortex-M
+    if size == 0 or address == 0 or path.startswith("*"):
+        return
+    kind = "data" if name.startswith(".data") else "bss"
+    modules[module_name(path)][kind] += size
+
+
+def format_report(modules, ram_bytes) -> str:
+    ram_bytes = ram_bytes or DEFAULT_RAM_BYTES
+    rows = sorted(modules.items(), key=lambda item: -(item[1]["data"] + item[1]["bss"]))
+    total_data = sum(m["data"] for _, m in rows)
+    total_bss = sum(m["bss"] for _, m in rows)
+    total = total_data + total_bss
+
+    out = ["%-40s %9s %9s %9s %6s" % ("Module", "data", "bss", "total", "RAM%")]
+    for name, m in rows:
+        size = m["data"] + m["bss"]
+        out.append("%-40.40s %9d %9d %9d %5.1f%%" % (name, m["data"], m["bss"], size,
+                                                    100.0 * size / ram_bytes))
+    out.append("%-40s %9d %9d %9d %5.1f%%" % ("TOTAL static", total_data, total_bss, total,
+                                             100.0 * total / ram_bytes))
+    out.append("Left for heap + stacks: %d of %d bytes" % (ram_bytes - total, ram_bytes))
+    return "\n".join(out) + "\n"
+
+
+def report_from_file(map_path: str) -> str:
+    with open(map_path, encoding="utf-8", errors="replace") as handle:
+        modules, ram_bytes = parse_map(handle)
+    return format_report(modules, ram_bytes)
+
+
+def main(argv) -> int:
+    if len(argv) != 2:
+        sys.stderr.write("usage: %s <firmware.map>\n" % argv[0])
+        return 2
+    sys.stdout.write(report_from_file(argv[1]))
+    return 0
+
+
+# ============================================================================
+# PlatformIO hook
+# ============================================================================
+
+try:
+    Import("env")  # noqa: F821 - injected by PlatformIO's SCons
+except NameError:
+    env = None
+
+if env is not None:
+    map_path = os.path.join(env.subst("$BUILD_DIR"), "firmware.map")
+    env.Append(LINKFLAGS=["-Wl,-Map," + map_path])
+
+    def _print_ram_report(source, target, env):  # noqa: ARG001 - SCons signature
+        report = report_from_file(map_path)
+        with open(os.path.join(env.subst("$BUILD_DIR"), "ram_report.txt"), "w") as handle:
+            handle.write(report)
+        print("\nStatic RAM by module (" + map_path + ")\n" + report)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", _print_ram_report)
+elif __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,40 @@
+#include "ble_write_queue.h"
+#include <string.h>
+
+BleWriteQueue::BleWriteQueue() : peakDepth(0) {
+    for (uint32_t i = 0; i < BLE_WRITE_SOURCE_COUNT; i++) {
+        drops[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+bool BleWriteQueue::push(uint8_t source, const uint8_t* data, int length) {
+    BleWrite write;
+    write.source = source;
+    write.length = (uint8_t)(length < 0 ? 0 : length < BLE_WRITE_MAX_SIZE ? length : BLE_WRITE_MAX_SIZE);
+    memcpy(write.data, data, write.length);
+
+    const uint32_t depth = (uint32_t)ring.size() + 1;
+    if (depth > peakDepth.load(std::memory_order_relaxed)) {
+        peakDepth.store(depth, std::memory_order_relaxed);
+    }
+    if (!ring.push(write)) {
+        if (source < BLE_WRITE_SOURCE_COUNT) {
+            drops[source].store(drops[source].load(std::memory_order_relaxed) + 1,
+                                std::memory_order_relaxed);
+        }
+        return false;
+    }
+    return true;
+}
+
+uint32_t BleWriteQueue::getDrops() const {
+    uint32_t total = 0;
+    for (uint32_t i = 0; i < BLE_WRITE_SOURCE_COUNT; i++) {
+        total += drops[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+uint32_t BleWriteQueue::getDrops(uint8_t source) const {
+    return source < BLE_WRITE_SOURCE_COUNT ? drops[source].load(std::memory_order_relaxed) : 0;
+}
@@ -0,0 +1,67 @@
+#ifndef BLE_WRITE_QUEUE_H
+#define BLE_WRITE_QUEUE_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include "config.h"
+#include "spsc_ring.h"
+
+// ============================================================================
+// BLE Write Ingestion Queue
+// ============================================================================
+//
+// ArduinoBLE delivers central writes inside BLE.poll(). Polling written()
+// once per loop pass keeps only the last write to each characteristic, so
+// two upload chunks (or a mode switch and a config write) landing in one
+// poll lose all but one. Instead every writable characteristic has a
+// BLEWritten event handler that copies the write into this queue (the
+// producer), and the loop handles the queue in arrival order (the
+// consumer). The queue is an SpscRing, so the handler never waits on the
+// loop even where the BLE stack runs in its own thread.
+//
+// A full queue drops the NEW write, counted per source. The depth high-water
+// mark and the drops are reported in DeviceInfo bytes 44-47 so the depth can
+// be sized from real sessions.
+// ============================================================================
+
+enum BleWriteSource : uint8_t {
+    BLE_WRITE_MODE = 0,
+    BLE_WRITE_CONFIG,
+    BLE_WRITE_UPLOAD,
+    BLE_WRITE_DIAGNOSTICS,
+    BLE_WRITE_SOURCE_COUNT
+};
+
+struct BleWrite {
+    uint8_t source;   // BleWriteSource
+    uint8_t length;
+    uint8_t data[BLE_WRITE_MAX_SIZE];
+};
+
+class BleWriteQueue {
+public:
+    BleWriteQueue();
+
+    // Producer (write event handler). Longer writes are truncated to
+    // BLE_WRITE_MAX_SIZE. Returns false (and counts a drop) if full.
+    bool push(uint8_t source, const uint8_t* data, int length);
+
+    // Consumer (loop). Returns false if empty.
+    bool pop(BleWrite& write) { return ring.pop(write); }
+
+    size_t depth() const { return ring.size(); }
+    static constexpr size_t capacity() { return BLE_WRITE_QUEUE_DEPTH; }
+
+    // Deepest the queue has been, counting the write that was dropped
+    uint32_t getPeakDepth() const { return peakDepth.load(std::memory_order_relaxed); }
+    uint32_t getDrops() const;
+    uint32_t getDrops(uint8_t source) const;
+
+private:
+    SpscRing<BleWrite, BLE_WRITE_QUEUE_DEPTH> ring;
+    std::atomic<uint32_t> peakDepth;                       // Written by the producer only
+    std::atomic<uint32_t> drops[BLE_WRITE_SOURCE_COUNT];   // Written by the producer only
+};
+
+#endif // BLE_WRITE_QUEUE_H
@@ -0,0 +1,86 @@
+#include "bmi270_fifo.h"
+
+static inline int16_t readInt16LE(const uint8_t* bytes) {
+    return (int16_t)((uint16_t)bytes[0] | ((uint16_t)bytes[1] << 8));
+}
+
+Bmi270FifoParseResult parseBmi270Fifo(const uint8_t* data, size_t length,
+                                      Bmi270FifoFrame* frames, int maxFrames) {
+    Bmi270FifoParseResult result;
+    result.frames = 0;
+    result.bytesConsumed = 0;
+    result.skippedFrames = 0;
+    result.sensorTimeValid = false;
+    result.sensorTime = 0;
+
+    size_t pos = 0;
+    while (pos < length && result.frames < maxFrames) {
+        const uint8_t header = data[pos];
+        size_t payload = 0;
+
+        // Regular frames may carry interrupt tags in the two low bits
+        switch (header & 0xFC) {
+        case BMI270_FIFO_HEADER_GYR_ACC:
+            payload = 12;
+            break;
+        case BMI270_FIFO_HEADER_ACC:
+        case BMI270_FIFO_HEADER_GYR:
+            payload = 6;
+            break;
+        default:
+            break;
+        }
+
+        if (payload == 0) {
+            switch (header) {
+            case BMI270_FIFO_HEADER_SKIP:
+                payload = 1;
+                break;
+            case BMI270_FIFO_HEADER_SENSORTIME:
+                payload = 3;
+                break;
+            case BMI270_FIFO_HEADER_INPUT_CONFIG:
+                payload = 4;
+                break;
+            default:
+                // Over-read marker (FIFO empty) or unknown frame: stop here
+                return result;
+            }
+        }
+
+        if (pos + 1 + payload > length) {
+            // Truncated frame at the end of the burst
+            break;
+        }
+
+        const uint8_t* body = &data[pos + 1];
+        if ((header & 0xFC) == BMI270_FIFO_HEADER_GYR_ACC) {
+            Bmi270FifoFrame& frame = frames[result.frames++];
+            for (int axis = 0; axis < 3; axis++) {
+                frame.gyr[axis] = readInt16LE(&body[axis * 2]);
+                frame.acc[axis] = readInt16LE(&body[6 + axis * 2]);
+            }
+        } else if (header == BMI270_FIFO_HEADER_SKIP) {
+            result.skippedFrames += body[0];
+        } else if (header == BMI270_FIFO_HEADER_SENSORTIME) {
+            result.sensorTime = (uint32_t)body[0] | ((uint32_t)body[1] << 8) |
+                                ((uint32_t)body[2] << 16);
+            result.sensorTimeValid = true;
+        }
+
+        pos += 1 + payload;
+        result.bytesConsumed = pos;
+    }
+
+    return result;
+}
+
+uint8_t bmi270OdrCode(uint16_t sampleRateHz) {
+    uint8_t code = BMI270_ODR_25HZ;
+    for (uint16_t rate = 25; rate <= 1600; rate *= 2, code++) {
+        if (rate == sampleRateHz) {
+            return code;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#ifndef BMI270_FIFO_H
+#define BMI270_FIFO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// BMI270 Hardware FIFO (register map + frame parser)
+// ============================================================================
+//
+// The BMI270 can buffer samples in a 6 KB on-chip FIFO at its own output
+// data rate. Instead of two I2C transactions per sample we drain many frames
+// in one burst read of FIFO_DATA and split them here. The parser has no
+// hardware dependencies so it is unit-tested on the host.
+//
+// We run the FIFO in header mode with accel + gyro enabled. Each regular
+// frame is a 1-byte header followed by gyro XYZ then accel XYZ (int16 LE).
+// ============================================================================
+
+// I2C address on the Nano 33 BLE Sense Rev2 (internal Wire1 bus)
+#define BMI270_I2C_ADDRESS 0x68
+
+// Registers
+#define BMI270_REG_STATUS 0x03
+#define BMI270_REG_DATA_ACC_X 0x0C // 12 bytes: acc XYZ then gyr XYZ
+#define BMI270_REG_DATA_GYR_X 0x12
+#define BMI270_REG_FIFO_LENGTH_0 0x24
+#define BMI270_REG_FIFO_DATA 0x26
+#define BMI270_REG_ACC_CONF 0x40
+#define BMI270_REG_ACC_RANGE 0x41
+#define BMI270_REG_GYR_CONF 0x42
+#define BMI270_REG_GYR_RANGE 0x43
+#define BMI270_REG_FIFO_CONFIG_0 0x48
+#define BMI270_REG_FIFO_CONFIG_1 0x49
+#define BMI270_REG_CMD 0x7E
+
+// Register values
+#define BMI270_ODR_25HZ 0x06       // ACC_CONF/GYR_CONF odr field; each +1 doubles
+#define BMI270_ACC_RANGE_4G 0x01   // 8192 LSB/g  (matches ACCEL_SCALE)
+#define BMI270_GYR_RANGE_2000 0x00 // 16.384 LSB/dps
+#define BMI270_FIFO_CONFIG_0_TIME_EN 0x02
+#define BMI270_FIFO_CONFIG_1_GYR_ACC_HEADER 0xD0
+#define BMI270_CMD_FIFO_FLUSH 0xB0
+#define BMI270_STATUS_DRDY_ACC 0x80
+#define BMI270_STATUS_DRDY_GYR 0x40
+#define BMI270_FIFO_LENGTH_MASK 0x3FFF
+#define BMI270_FIFO_SIZE_BYTES 6144
+
+// FIFO frame headers (header mode)
+#define BMI270_FIFO_HEADER_ACC 0x84
+#define BMI270_FIFO_HEADER_GYR 0x88
+#define BMI270_FIFO_HEADER_GYR_ACC 0x8C
+#define BMI270_FIFO_HEADER_SKIP 0x40
+#define BMI270_FIFO_HEADER_SENSORTIME 0x44
+#define BMI270_FIFO_HEADER_INPUT_CONFIG 0x48
+#define BMI270_FIFO_HEADER_OVER_READ 0x80
+
+// One burst from STATUS through the last gyro byte (skips over AUX data)
+#define BMI270_DATA_BURST_BYTES (BMI270_REG_DATA_GYR_X + 6 - BMI270_REG_STATUS)
+
+#define BMI270_FIFO_GYR_ACC_FRAME_BYTES 13
+#define BMI270_SENSORTIME_TICK_NS 39063 // 24-bit counter, 39.0625 us per tick
+
+struct Bmi270FifoFrame {
+    int16_t acc[3];
+    int16_t gyr[3];
+};
+
+struct Bmi270FifoParseResult {
+    int frames;              // Complete accel + gyro frames written
+    size_t bytesConsumed;    // Bytes up to the last complete frame
+    uint32_t skippedFrames;  // Frames the chip dropped (FIFO overflow)
+    bool sensorTimeValid;    // A sensortime frame was present
+    uint32_t sensorTime;     // 24-bit sensortime of the last frame
+};
+
+/**
+ * Split a burst read of FIFO_DATA into accel + gyro frames.
+ *
+ * Parsing stops at the over-read marker (FIFO empty), an unknown header, a
+ * truncated trailing frame (the chip re-sends it on the next read) or when
+ * maxFrames frames have been written. Accel-only or gyro-only frames, which
+ * appear briefly after a config change, are skipped.
+ */
+Bmi270FifoParseResult parseBmi270Fifo(const uint8_t* data, size_t length,
+                                      Bmi270FifoFrame* frames, int maxFrames);
+
+/**
+ * ACC_CONF/GYR_CONF odr code for a sample rate (25 Hz × 2^k up to 1600 Hz)
+ * Returns 0 if the rate is not a BMI270 output data rate.
+ */
+uint8_t bmi270OdrCode(uint16_t sampleRateHz);
+
+#endif // BMI270_FIFO_H
@@ -10,7 +10,7 @@
 #define FIRMWARE_VERSION_MAJOR 1
 #endif
 #ifndef FIRMWARE_VERSION_MINOR
-#define FIRMWARE_VERSION_MINOR 1
+#define FIRMWARE_VERSION_MINOR 7
 #endif
 
 // ============================================================================
@@ -57,6 +57,8 @@ static const DeviceMapping DEVICE_MAP[] = {
   "19B10006-E8F2-537E-4F6C-D104768A1214" // Model upload (write)
 #define MODEL_STATUS_UUID                                                      \
   "19B10007-E8F2-537E-4F6C-D104768A1214" // Upload status (notify)
+#define DIAGNOSTICS_UUID                                                       \
+  "19B10008-E8F2-537E-4F6C-D104768A1214" // Profiler report (PROFILING_ENABLED)
 
 // ============================================================================
 // MODEL STORAGE CONFIGURATION
@@ -65,13 +67,26 @@ static const DeviceMapping DEVICE_MAP[] = {
 // See docs/NEURAL_NETWORK_BASICS.md for details
 #define MODEL_CHUNK_SIZE 240 // BLE MTU-safe chunk size
 
-// Persistent model storage mode (future use).
-// Current implementation stores models in RAM only, so uploads are lost
-// on power cycle regardless of this flag.
+// CRC-32 table variant for upload checks (see crc32.h): 1 = bytewise
+// (1 KB table), 4 = slice-by-4 (4 KB), 8 = slice-by-8 (8 KB, fastest)
+#ifndef CRC32_SLICE_BY
+#define CRC32_SLICE_BY 8
+#endif
+
+// Persistent model storage: save each uploaded model to one of two A/B
+// slots in internal flash and load the newest intact one at boot (see
+// model_slots.h). 0 = RAM only, every power cycle needs a new upload.
 #ifndef PERSISTENT_MODEL
-#define PERSISTENT_MODEL 0
+#define PERSISTENT_MODEL 1
 #endif
 
+// Flash reserved for the model slots: the top 192 KB of the nRF52840's
+// 1 MB, two 96 KB slots. Persistence turns itself off if the sketch image
+// ever grows into it.
+#define MODEL_FLASH_BASE 0xD0000
+#define MODEL_FLASH_SIZE 0x30000
+#define MODEL_FLASH_PAGE_SIZE 4096
+
 // ============================================================================
 // SIMPLENN CONFIGURATION
 // ============================================================================
@@ -81,6 +96,7 @@ static const DeviceMapping DEVICE_MAP[] = {
 #define NN_HIDDEN_SIZE 32 // Hidden layer neurons
 #define NN_MAX_CLASSES 8  // Maximum gesture classes
 #define LABEL_MAX_LEN 16  // Fixed-width class label storage
+#define NN_MAX_HEADS 3    // Output heads sharing the hidden layer (1 primary + 2)
 
 // Model weight buffer sizes
 // hiddenWeights: 32 × 600 = 19,200 floats = 76,800 bytes
@@ -90,6 +106,31 @@ static const DeviceMapping DEVICE_MAP[] = {
 // Total max: ~78 KB
 #define MAX_MODEL_SIZE 85000 // ~83 KB buffer for SimpleNN weights
 
+// Selective-repeat uploads: chunks that arrive ahead of a missing one are
+// held in a reorder window (RAM) and tracked per block; out-of-order chunks
+// must start on a block boundary. The host asks for the missing ranges with
+// the QUERY command (at most MODEL_MISSING_RANGES_MAX per reply).
+#ifndef MODEL_UPLOAD_BLOCK_SIZE
+#define MODEL_UPLOAD_BLOCK_SIZE 16
+#endif
+#ifndef MODEL_UPLOAD_WINDOW
+#define MODEL_UPLOAD_WINDOW 4096 // Multiple of MODEL_UPLOAD_BLOCK_SIZE
+#endif
+#define MODEL_MISSING_RANGES_MAX 8
+
+// Characteristic writes are queued as they arrive (BLE write events, see
+// ble_write_queue.h) and handled by the loop in order. Uploads get all but
+// BLE_WRITE_QUEUE_RESERVE slots as credits: every model status update
+// advertises how many upload writes the host may have in flight, so it can
+// pipeline writes without response and a mode or config write still fits
+#ifndef BLE_WRITE_QUEUE_DEPTH
+#define BLE_WRITE_QUEUE_DEPTH 16 // Power of two, ~250 bytes RAM per slot
+#endif
+#define BLE_WRITE_QUEUE_RESERVE 2
+#define MODEL_UPLOAD_WRITE_MAX 244  // Upload characteristic size
+#define BLE_WRITE_MAX_SIZE MODEL_UPLOAD_WRITE_MAX // Largest writable characteristic
+#define MODEL_UPLOAD_CREDITS (BLE_WRITE_QUEUE_DEPTH - BLE_WRITE_QUEUE_RESERVE)
+
 // ============================================================================
 // SENSOR CONFIGURATION
 // ============================================================================
@@ -97,6 +138,70 @@ static const DeviceMapping DEVICE_MAP[] = {
 #define MIN_SAMPLE_RATE_HZ 10
 #define MAX_SAMPLE_RATE_HZ 50
 
+// Oversampling mode: poll the IMU IMU_OVERSAMPLE_FACTOR times faster than the
+// model rate and low-pass/decimate back down (see decimator.h) so fast shakes
+// do not alias into the gesture band. 1 = off (sample directly at 25 Hz).
+// 4 → 100 Hz IMU polling. Polling never sets the chip's output data rate
+// (BMI270 100 Hz, LSM9DS1 119 Hz as the libraries leave them), so 8 → 200 Hz
+// needs BMI270_USE_FIFO, which does.
+#ifndef IMU_OVERSAMPLE_FACTOR
+#define IMU_OVERSAMPLE_FACTOR 1
+#endif
+#define IMU_SAMPLE_RATE_HZ (DEFAULT_SAMPLE_RATE_HZ * IMU_OVERSAMPLE_FACTOR)
+
+// In collect mode, stream the oversampled IMU rate instead of the filtered
+// model rate (only meaningful when IMU_OVERSAMPLE_FACTOR > 1).
+#ifndef STREAM_RAW_RATE
+#define STREAM_RAW_RATE 0
+#endif
+#if STREAM_RAW_RATE
+#define STREAM_SAMPLE_RATE_HZ IMU_SAMPLE_RATE_HZ
+#else
+#define STREAM_SAMPLE_RATE_HZ DEFAULT_SAMPLE_RATE_HZ
+#endif
+
+// Resample onto a uniform time grid using a micros() timestamp per sample
+// (see resampler.h), so loop jitter does not distort the model's 25 Hz
+// assumption. 0 = feed samples into the pipeline exactly as read.
+#ifndef RESAMPLE_UNIFORM_GRID
+#define RESAMPLE_UNIFORM_GRID 1
+#endif
+#define JITTER_REPORT_INTERVAL_S 30 // Serial jitter summary period
+
+// BMI270 only: buffer samples in the chip's hardware FIFO at
+// IMU_SAMPLE_RATE_HZ and drain them in burst I2C reads (see bmi270_fifo.h)
+// instead of polling one sample per loop pass. Survives long BLE or
+// inference stalls without dropping samples.
+#ifndef BMI270_USE_FIFO
+#define BMI270_USE_FIFO 0
+#endif
+#if IMU_OVERSAMPLE_FACTOR > 4 &&                                              \
+    (defined(USE_LSM9DS1) || (defined(USE_BMI270) && !BMI270_USE_FIFO))
+#error "IMU_OVERSAMPLE_FACTOR > 4 polls faster than the IMU samples; use BMI270_USE_FIFO"
+#endif
+#define BMI270_FIFO_DRAIN_INTERVAL_MS 20 // Loop drain period in FIFO mode
+#define BMI270_FIFO_BURST_BYTES 208      // 16 frames per I2C burst read
+#define SENSOR_BATCH_MAX_SAMPLES 32      // Max samples per readBatch() call
+
+// Sample from a timer interrupt + high-priority thread into a lock-free ring
+// (see sampler.h) that the main loop drains, so inference or BLE stalls no
+// longer delay reads. 0 = poll the sensor from loop(). Needs the mbed core.
+// Off until it has been run on Rev1 and Rev2 boards: the sampler thread
+// shares Wire1 and the CPU with the BLE stack at osPriorityHigh.
+#ifndef SAMPLE_INTERRUPT_DRIVEN
+#define SAMPLE_INTERRUPT_DRIVEN 0
+#endif
+#define SAMPLE_RING_CAPACITY 128        // Power of two; ~1.3s at 100 Hz
+#define SAMPLER_THREAD_STACK_BYTES 2048
+
+// Read the IMU's raw output registers in one I2C burst and rescale with
+// integer math (see imu_scaling.h) instead of the Arduino libraries' float
+// g/dps API. 0 = use the library read functions. Off until it has been run
+// on Rev1 and Rev2 boards.
+#ifndef IMU_DIRECT_REGISTERS
+#define IMU_DIRECT_REGISTERS 0
+#endif
+
 // Scaling factors for conversion
 #define ACCEL_SCALE 8192.0f // int16 ÷ 8192 → g (±4g range)
 #define GYRO_SCALE 16.4f    // int16 ÷ 16.4 → dps (±2000°/s range)
@@ -111,9 +216,19 @@ static const DeviceMapping DEVICE_MAP[] = {
 
 // Inference packet metadata (4-byte inference characteristic)
 // [prediction, confidence, status_flags, reserved]
+// Multi-head models append [prediction, confidence] for each extra head.
+// Hosts that set CONFIG_INFERENCE_TIMING get a timing block after that:
+// [newest_sequence u16, queued_us u32, network_us u32, post_us u32]
+// post_us ends when the packet is built, so it leaves out the notification
+// write itself (profiled separately as PROFILE_WRITE_INFERENCE).
 #define INFERENCE_STATUS_NONE 0x00
 #define INFERENCE_STATUS_NO_MODEL 0x01
+#define INFERENCE_STATUS_MULTI_HEAD 0x02 // [prediction, confidence] per extra head follow
+#define INFERENCE_STATUS_TIMING 0x04     // Timing block follows the heads
 #define INFERENCE_PREDICTION_NO_MODEL 0xFF
+#define INFERENCE_TIMING_SIZE 14
+#define INFERENCE_RESULT_MAX_SIZE                                              \
+  (4 + 2 * (NN_MAX_HEADS - 1) + INFERENCE_TIMING_SIZE)
 
 // ============================================================================
 // OPERATING MODES
@@ -126,13 +241,47 @@ static const DeviceMapping DEVICE_MAP[] = {
 // ============================================================================
 #define WATCHDOG_TIMEOUT_MS 4000
 #define RECONNECT_DEBOUNCE_MS 500
-#define MIN_FREE_HEAP_BYTES 2048
+#define MIN_FREE_HEAP_BYTES 2048 // Warn below this (see memory_stats.h)
+
+// Device info: 28 bytes of version/stats, then RAM telemetry:
+// [main_stack_peak u16, main_stack_size u16, heap_free u32,
+//  heap_min_free u32, sampler_stack_peak u16, sampler_stack_size u16]
+// and BLE write queue telemetry:
+// [write_queue_peak u8, write_queue_capacity u8, write_drops u16]
+#define DEVICE_INFO_SIZE 48
+
+// ============================================================================
+// PROFILING
+// ============================================================================
+// Time hot-path stages (addSample, runInference, dense layers, softmax, BLE
+// writes) with the DWT cycle counter, or std::chrono in the native env, and
+// publish min/avg/max/p99 per stage (see profiler.h). Read it from the
+// diagnostics characteristic or send 'p' over serial ('r' resets).
+// 0 compiles every scope, the characteristic and the tables out.
+#ifndef PROFILING_ENABLED
+#define PROFILING_ENABLED 0
+#endif
+#define PROFILE_REPORT_INTERVAL_MS 1000 // Diagnostics characteristic refresh
 
 // ============================================================================
 // PACKET STRUCTURE
 // ============================================================================
 #define SENSOR_PACKET_SIZE 17 // 6×int16 + 2×uint16 + 1×uint8 = 17 bytes
 
+// Collect-mode stream formats, negotiated through the config characteristic:
+// [sample_rate u16, window u16, stream_format u8, batch_samples u8,
+//  inference_flags u8]
+// Hosts that never write config keep getting legacy packets.
+#define SENSOR_STREAM_LEGACY 0     // One SensorPacket per notification
+#define SENSOR_STREAM_BATCHED 1    // Many samples per notification (sensor_stream.h)
+#define SENSOR_STREAM_COMPRESSED 2 // Batched zigzag-varint deltas + keyframes
+#define SENSOR_NOTIFY_MAX_SIZE 244 // Needs ATT MTU 247, same as model upload
+// A pending batch goes out once its oldest sample is this old, full or not,
+// so batching bounds sensor-to-host latency whatever the batch size
+#define SENSOR_BATCH_MAX_AGE_MS 200
+#define CONFIG_INFERENCE_TIMING 0x01 // inference_flags: append timing block
+#define CONFIG_CHAR_SIZE 7
+
 // ============================================================================
 // DEBUG (uncomment to enable serial debugging)
 // ============================================================================
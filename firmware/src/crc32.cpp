@@ -0,0 +1,111 @@
+#include "crc32.h"
+#include <string.h>
+#include "config.h"
+
+#if !defined(__BYTE_ORDER__) || __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Sliced CRC32 loads little-endian words"
+#endif
+
+// ============================================================================
+// Tables
+// ============================================================================
+// table[0] is the classic byte table. table[k][n] is the CRC register after
+// feeding byte n followed by k zero bytes, which lets the sliced loops look
+// up 4 or 8 input bytes independently and XOR the results together.
+// Built at compile time, so the tables live in flash.
+
+template <int Slices>
+struct Crc32Tables {
+    uint32_t table[Slices][256];
+
+    constexpr Crc32Tables() : table() {
+        for (uint32_t n = 0; n < 256; n++) {
+            uint32_t c = n;
+            for (int bit = 0; bit < 8; bit++) {
+                c = (c & 1) ? (c >> 1) ^ 0xEDB88320u : c >> 1;
+            }
+            table[0][n] = c;
+        }
+        for (int s = 1; s < Slices; s++) {
+            for (uint32_t n = 0; n < 256; n++) {
+                const uint32_t previous = table[s - 1][n];
+                table[s][n] = (previous >> 8) ^ table[0][previous & 0xFF];
+            }
+        }
+    }
+};
+
+static constexpr Crc32Tables<1> bytewiseTables{};
+static constexpr Crc32Tables<4> slice4Tables{};
+static constexpr Crc32Tables<8> slice8Tables{};
+
+static inline uint32_t loadWord(const uint8_t* data) {
+    uint32_t word;
+    memcpy(&word, data, sizeof(word));  // Single LDR on Cortex-M4
+    return word;
+}
+
+// ============================================================================
+// Variants
+// ============================================================================
+
+uint32_t crc32UpdateBytewise(uint32_t crc, const uint8_t* data, size_t length) {
+    const uint32_t (&t)[1][256] = bytewiseTables.table;
+    for (size_t i = 0; i < length; i++) {
+        crc = t[0][(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint32_t crc32UpdateSlice4(uint32_t crc, const uint8_t* data, size_t length) {
+    const uint32_t (&t)[4][256] = slice4Tables.table;
+    while (length >= 4) {
+        const uint32_t word = loadWord(data) ^ crc;
+        crc = t[3][word & 0xFF] ^ t[2][(word >> 8) & 0xFF] ^
+              t[1][(word >> 16) & 0xFF] ^ t[0][word >> 24];
+        data += 4;
+        length -= 4;
+    }
+    while (length--) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+uint32_t crc32UpdateSlice8(uint32_t crc, const uint8_t* data, size_t length) {
+    const uint32_t (&t)[8][256] = slice8Tables.table;
+    while (length >= 8) {
+        const uint32_t low = loadWord(data) ^ crc;
+        const uint32_t high = loadWord(data + 4);
+        crc = t[7][low & 0xFF] ^ t[6][(low >> 8) & 0xFF] ^
+              t[5][(low >> 16) & 0xFF] ^ t[4][low >> 24] ^
+              t[3][high & 0xFF] ^ t[2][(high >> 8) & 0xFF] ^
+              t[1][(high >> 16) & 0xFF] ^ t[0][high >> 24];
+        data += 8;
+        length -= 8;
+    }
+    while (length--) {
+        crc = t[0][(crc ^ *data++) & 0xFF] ^ (crc >> 8);
+    }
+    return crc;
+}
+
+// ============================================================================
+// Public API
+// ============================================================================
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length) {
+#if CRC32_SLICE_BY == 8
+    return crc32UpdateSlice8(crc, data, length);
+#elif CRC32_SLICE_BY == 4
+    return crc32UpdateSlice4(crc, data, length);
+#elif CRC32_SLICE_BY == 1
+    return crc32UpdateBytewise(crc, data, length);
+#else
+#error "CRC32_SLICE_BY must be 1, 4 or 8"
+#endif
+}
+
+uint32_t calculateCrc32(const uint8_t* data, size_t length) {
+    return crc32Finish(crc32Update(CRC32_INITIAL, data, length));
+}
@@ -0,0 +1,45 @@
+#ifndef CRC32_H
+#define CRC32_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// CRC-32 (IEEE 802.3, reflected, as zlib / the web app compute it)
+// ============================================================================
+//
+// crc32Update() works on the raw CRC register so a checksum can be built up
+// chunk by chunk as data arrives:
+//
+//   uint32_t crc = CRC32_INITIAL;
+//   crc = crc32Update(crc, first, firstLength);
+//   crc = crc32Update(crc, second, secondLength);
+//   uint32_t result = crc32Finish(crc);
+//
+// CRC32_SLICE_BY (config.h) picks the table variant behind crc32Update():
+//
+//   1  byte at a time, 1 KB table   (smallest flash)
+//   4  slice-by-4,     4 KB table
+//   8  slice-by-8,     8 KB table   (fastest)
+//
+// All variants are always compiled so tests and benchmarks can compare
+// them; the linker drops the tables of the ones firmware never calls.
+// ============================================================================
+
+#define CRC32_INITIAL 0xFFFFFFFFu
+
+uint32_t crc32Update(uint32_t crc, const uint8_t* data, size_t length);
+
+inline uint32_t crc32Finish(uint32_t crc) {
+    return crc ^ 0xFFFFFFFFu;
+}
+
+// One-shot CRC of a whole buffer
+uint32_t calculateCrc32(const uint8_t* data, size_t length);
+
+// The individual variants (same contract as crc32Update)
+uint32_t crc32UpdateBytewise(uint32_t crc, const uint8_t* data, size_t length);
+uint32_t crc32UpdateSlice4(uint32_t crc, const uint8_t* data, size_t length);
+uint32_t crc32UpdateSlice8(uint32_t crc, const uint8_t* data, size_t length);
+
+#endif // CRC32_H
@@ -0,0 +1,24 @@
+#ifndef CRC8_H
+#define CRC8_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// CRC-8/MAXIM Implementation (for packet validation)
+// ============================================================================
+inline uint8_t crc8(const uint8_t* data, size_t len) {
+    uint8_t crc = 0x00;
+    while (len--) {
+        uint8_t byte = *data++;
+        for (uint8_t i = 0; i < 8; i++) {
+            uint8_t mix = (crc ^ byte) & 0x01;
+            crc >>= 1;
+            if (mix) crc ^= 0x8C;
+            byte >>= 1;
+        }
+    }
+    return crc;
+}
+
+#endif // CRC8_H
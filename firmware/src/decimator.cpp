@@ -0,0 +1,130 @@
+#include "decimator.h"
+#include <math.h>
+#include <string.h>
+
+// Cutoff as a fraction of the output Nyquist frequency. Leaving 20% headroom
+// puts most of the Hamming transition band above the output Nyquist, so
+// gesture content (< 8 Hz at 25 Hz output) passes untouched.
+static const float DECIMATOR_CUTOFF_FRACTION = 0.8f;
+static const float DECIMATOR_PI = 3.14159265358979f;
+
+static inline int16_t saturateInt16(int32_t value) {
+    if (value > 32767) return 32767;
+    if (value < -32768) return -32768;
+    return (int16_t)value;
+}
+
+PolyphaseDecimator::PolyphaseDecimator() {
+    factor = 1;
+    phase = 0;
+    head = 0;
+    memset(coeffs, 0, sizeof(coeffs));
+    memset(history, 0, sizeof(history));
+    memset(acc, 0, sizeof(acc));
+}
+
+bool PolyphaseDecimator::begin(int decimationFactor) {
+    if (decimationFactor < 1 || decimationFactor > DECIMATOR_MAX_FACTOR) {
+        return false;
+    }
+
+    factor = decimationFactor;
+    memset(coeffs, 0, sizeof(coeffs));
+
+    if (factor > 1) {
+        // Windowed-sinc low-pass prototype, designed once in float and then
+        // quantized so the taps sum to exactly 1.0 in Q15 (unity DC gain).
+        const int numTaps = factor * DECIMATOR_TAPS_PER_PHASE;
+        const float cutoff = DECIMATOR_CUTOFF_FRACTION * 0.5f / (float)factor;
+        const float center = (float)(numTaps - 1) * 0.5f;
+
+        float prototype[DECIMATOR_MAX_FACTOR * DECIMATOR_TAPS_PER_PHASE];
+        float sum = 0.0f;
+        for (int n = 0; n < numTaps; n++) {
+            const float t = (float)n - center;
+            const float x = 2.0f * DECIMATOR_PI * cutoff * t;
+            const float sinc = (fabsf(x) < 1e-6f) ? 1.0f : sinf(x) / x;
+            const float window =
+                0.54f - 0.46f * cosf(2.0f * DECIMATOR_PI * (float)n / (float)(numTaps - 1));
+            prototype[n] = sinc * window;
+            sum += prototype[n];
+        }
+
+        int32_t quantizedSum = 0;
+        int16_t quantized[DECIMATOR_MAX_FACTOR * DECIMATOR_TAPS_PER_PHASE];
+        for (int n = 0; n < numTaps; n++) {
+            quantized[n] = (int16_t)lroundf(prototype[n] / sum * 32768.0f);
+            quantizedSum += quantized[n];
+        }
+        quantized[numTaps / 2] = (int16_t)(quantized[numTaps / 2] + (32768 - quantizedSum));
+
+        for (int r = 0; r < factor; r++) {
+            for (int p = 0; p < DECIMATOR_TAPS_PER_PHASE; p++) {
+                coeffs[r][p] = quantized[p * factor + (factor - 1 - r)];
+            }
+        }
+    }
+
+    reset();
+    return true;
+}
+
+void PolyphaseDecimator::reset() {
+    phase = 0;
+    head = 0;
+    memset(history, 0, sizeof(history));
+    memset(acc, 0, sizeof(acc));
+}
+
+int16_t PolyphaseDecimator::getCoefficient(int tap) const {
+    if (factor <= 1) {
+        return tap == 0 ? 32767 : 0;
+    }
+    if (tap < 0 || tap >= getNumTaps()) {
+        return 0;
+    }
+    // Invert the branch mapping used in begin()
+    const int p = tap / factor;
+    const int r = factor - 1 - (tap % factor);
+    return coeffs[r][p];
+}
+
+bool PolyphaseDecimator::push(const int16_t input[DECIMATOR_AXES], int16_t output[DECIMATOR_AXES]) {
+    if (factor <= 1) {
+        for (int a = 0; a < DECIMATOR_AXES; a++) {
+            output[a] = input[a];
+        }
+        return true;
+    }
+
+    // Store the new sample in this phase's branch, then run only that branch
+    int16_t (*line)[DECIMATOR_AXES] = history[phase];
+    const int16_t* branch = coeffs[phase];
+    for (int a = 0; a < DECIMATOR_AXES; a++) {
+        line[head][a] = input[a];
+    }
+
+    int idx = head;
+    for (int p = 0; p < DECIMATOR_TAPS_PER_PHASE; p++) {
+        const int32_t c = branch[p];
+        const int16_t* s = line[idx];
+        for (int a = 0; a < DECIMATOR_AXES; a++) {
+            acc[a] += c * (int32_t)s[a];
+        }
+        idx = (idx == 0) ? (DECIMATOR_TAPS_PER_PHASE - 1) : (idx - 1);
+    }
+
+    phase++;
+    if (phase < factor) {
+        return false;
+    }
+
+    // Block complete: round the Q15 accumulators back to int16
+    for (int a = 0; a < DECIMATOR_AXES; a++) {
+        output[a] = saturateInt16((acc[a] + (1 << 14)) >> 15);
+        acc[a] = 0;
+    }
+    phase = 0;
+    head = (head + 1) % DECIMATOR_TAPS_PER_PHASE;
+    return true;
+}
@@ -0,0 +1,71 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <stdint.h>
+
+// ============================================================================
+// Polyphase FIR Decimator (anti-alias filter for oversampled IMU data)
+// ============================================================================
+//
+// The IMU can be polled several times faster than the model's 25 Hz rate.
+// Simply keeping every Nth sample would fold fast shakes (> 12.5 Hz) back
+// into the gesture band, so we low-pass filter first and then drop samples.
+//
+// A polyphase decimator only ever computes the outputs it keeps: the FIR is
+// split into `factor` branches and each incoming sample is multiplied by just
+// one branch, so the cost is DECIMATOR_TAPS_PER_PHASE multiply-adds per axis
+// per input sample regardless of the decimation factor.
+//
+// Coefficients are Q15 integers and the accumulators are int32, so the
+// per-sample path has no floating point at all.
+// ============================================================================
+
+#define DECIMATOR_AXES 6
+#define DECIMATOR_MAX_FACTOR 8
+#define DECIMATOR_TAPS_PER_PHASE 8
+
+class PolyphaseDecimator {
+public:
+    PolyphaseDecimator();
+
+    /**
+     * Design the low-pass filter and reset state.
+     * @param factor Decimation factor (1 = passthrough, max DECIMATOR_MAX_FACTOR)
+     * @return false if factor is out of range
+     */
+    bool begin(int factor);
+
+    /**
+     * Clear the delay lines (e.g. after a sampling gap)
+     */
+    void reset();
+
+    /**
+     * Push one input sample (6 axes).
+     * @param input  Raw int16 axes at the oversampled rate
+     * @param output Filtered axes at the output rate (written only on true)
+     * @return true once every `factor` inputs, when an output is ready
+     */
+    bool push(const int16_t input[DECIMATOR_AXES], int16_t output[DECIMATOR_AXES]);
+
+    int getFactor() const { return factor; }
+    int getNumTaps() const { return factor * DECIMATOR_TAPS_PER_PHASE; }
+
+    /**
+     * Prototype FIR coefficient h[tap] in Q15 (tap < getNumTaps())
+     */
+    int16_t getCoefficient(int tap) const;
+
+private:
+    int factor;
+    int phase;  // Position of the next input within the current output block
+    int head;   // Newest slot of every branch delay line
+
+    // coeffs[r][p] multiplies the p-th most recent input that arrived at
+    // block phase r, i.e. prototype tap h[p * factor + (factor - 1 - r)].
+    int16_t coeffs[DECIMATOR_MAX_FACTOR][DECIMATOR_TAPS_PER_PHASE];
+    int16_t history[DECIMATOR_MAX_FACTOR][DECIMATOR_TAPS_PER_PHASE][DECIMATOR_AXES];
+    int32_t acc[DECIMATOR_AXES];
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,133 @@
+#include "flash_region.h"
+#include <Arduino.h>
+#include "config.h"
+
+#if defined(ARDUINO_ARCH_MBED)
+#include <nrf.h>
+
+// ============================================================================
+// nRF52840 Internal Flash (NVMC)
+// ============================================================================
+// Flash is memory mapped, so reads are plain loads. Erase and write go
+// through the NVMC: enable the mode in CONFIG, start the operation, wait for
+// READY. The CPU stalls on flash fetches while a page erase runs (up to
+// 85 ms), so callers should expect the loop to pause.
+
+// End of the sketch image in flash, from the mbed GCC linker script
+extern "C" uint32_t __etext;
+extern "C" uint32_t __data_start__;
+extern "C" uint32_t __data_end__;
+
+class NvmcFlashRegion : public FlashRegion {
+public:
+    NvmcFlashRegion(uint32_t base, uint32_t size) : base(base), regionSize(size) {}
+
+    uint32_t pageSize() const override { return MODEL_FLASH_PAGE_SIZE; }
+    uint32_t size() const override { return regionSize; }
+
+    bool read(uint32_t offset, void* out, uint32_t length) override {
+        if (!inRange(offset, length)) {
+            return false;
+        }
+        memcpy(out, address(offset), length);
+        return true;
+    }
+
+    bool erasePage(uint32_t offset) override {
+        if (offset % MODEL_FLASH_PAGE_SIZE != 0 || !inRange(offset, MODEL_FLASH_PAGE_SIZE)) {
+            return false;
+        }
+        setMode(NVMC_CONFIG_WEN_Een);
+        NRF_NVMC->ERASEPAGE = base + offset;
+        waitReady();
+        setMode(NVMC_CONFIG_WEN_Ren);
+
+        const uint32_t* page = (const uint32_t*)address(offset);
+        for (uint32_t i = 0; i < MODEL_FLASH_PAGE_SIZE / 4; i++) {
+            if (page[i] != 0xFFFFFFFF) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool program(uint32_t offset, const void* data, uint32_t length) override {
+        if (offset % 4 != 0 || length % 4 != 0 || !inRange(offset, length)) {
+            return false;
+        }
+        const uint8_t* bytes = (const uint8_t*)data;
+        volatile uint32_t* target = (volatile uint32_t*)address(offset);
+
+        setMode(NVMC_CONFIG_WEN_Wen);
+        for (uint32_t i = 0; i < length / 4; i++) {
+            uint32_t word;
+            memcpy(&word, &bytes[i * 4], 4);
+            target[i] = word;
+            waitReady();
+        }
+        setMode(NVMC_CONFIG_WEN_Ren);
+
+        return memcmp(address(offset), data, length) == 0;
+    }
+
+    const uint8_t* mapped() const override { return (const uint8_t*)address(0); }
+
+private:
+    uint32_t base;
+    uint32_t regionSize;
+
+    const void* address(uint32_t offset) const {
+        return (const void*)(uintptr_t)(base + offset);
+    }
+
+    bool inRange(uint32_t offset, uint32_t length) const {
+        return offset <= regionSize && length <= regionSize - offset;
+    }
+
+    static void waitReady() {
+        while (NRF_NVMC->READY == NVMC_READY_READY_Busy) {
+        }
+    }
+
+    static void setMode(uint32_t mode) {
+        NRF_NVMC->CONFIG = mode << NVMC_CONFIG_WEN_Pos;
+        __ISB();
+        __DSB();
+    }
+};
+
+FlashRegion* getModelFlashRegion() {
+    static NvmcFlashRegion region(MODEL_FLASH_BASE, MODEL_FLASH_SIZE);
+    static bool checked = false;
+    static bool usable = false;
+
+    if (!checked) {
+        // .text is followed by the initial values of .data
+        const uint32_t imageEnd = (uint32_t)(uintptr_t)&__etext +
+                                  (uint32_t)((uintptr_t)&__data_end__ - (uintptr_t)&__data_start__);
+        usable = imageEnd <= MODEL_FLASH_BASE;
+        checked = true;
+        if (!usable) {
+            char warning[96];
+            sprintf(warning, "WARNING: sketch image ends at 0x%05lX, past MODEL_FLASH_BASE",
+                    (unsigned long)imageEnd);
+            DEBUG_PRINTLN(warning);
+            DEBUG_PRINTLN("Model persistence disabled");
+        }
+    }
+    return usable ? &region : nullptr;
+}
+
+#else
+
+static FlashRegion* installedRegion = nullptr;
+
+FlashRegion* getModelFlashRegion() {
+    return installedRegion;
+}
+
+void setModelFlashRegion(FlashRegion* region) {
+    installedRegion = region;
+}
+
+#endif
@@ -0,0 +1,52 @@
+#ifndef FLASH_REGION_H
+#define FLASH_REGION_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// ============================================================================
+// Flash Region Interface
+// ============================================================================
+//
+// A window of NOR flash addressed by offset from its start:
+//
+// - erasePage() sets one page (offset a multiple of pageSize()) to 0xFF.
+// - program() can only clear bits, so it targets erased words. Offset and
+//   length are multiples of 4 (the nRF52840 NVMC writes 32-bit words).
+// - Every call returns false on a bad argument or a failed operation.
+// - mapped() exposes the region for reading in place where the part maps
+//   flash into the address space; the bytes change under it as pages are
+//   erased and programmed.
+//
+// On the board this is the NVMC-driven internal flash; native tests use
+// FileFlashRegion (src/host/file_flash.h), which can also cut power in the
+// middle of an operation.
+// ============================================================================
+
+class FlashRegion {
+public:
+    virtual ~FlashRegion() {}
+
+    virtual uint32_t pageSize() const = 0;
+    virtual uint32_t size() const = 0;
+
+    virtual bool read(uint32_t offset, void* out, uint32_t length) = 0;
+    virtual bool erasePage(uint32_t offset) = 0;
+    virtual bool program(uint32_t offset, const void* data, uint32_t length) = 0;
+
+    // Start of the region in the address space, or nullptr if it can only
+    // be read through read()
+    virtual const uint8_t* mapped() const { return nullptr; }
+};
+
+// Flash reserved for model storage on this board (MODEL_FLASH_BASE/SIZE),
+// or nullptr if there is none: native builds without a region installed,
+// or a sketch image that has grown into the reserved area
+FlashRegion* getModelFlashRegion();
+
+#if !defined(ARDUINO_ARCH_MBED)
+// Native builds: install the region getModelFlashRegion() returns
+void setModelFlashRegion(FlashRegion* region);
+#endif
+
+#endif // FLASH_REGION_H
@@ -5,98 +5,196 @@
  * UPDATED: Now stores SimpleNN format instead of TFLite!
  * ============================================================================
  * 
- * Uses RAM buffer for storing trained neural network models.
- * The model is lost on power cycle.
+ * Uses a single RAM buffer for the model that inference runs from. With
+ * PERSISTENT_MODEL, every successful upload is also saved to one of two A/B
+ * slots in the nRF52840's internal flash (see model_slots.h), and boot loads
+ * the newest intact slot back into the buffer. Without it, or when no flash
+ * region is available, the model is lost on power cycle.
+ *
+ * Uploads stream straight into that buffer: there is no second copy in RAM
+ * to validate first. Chunks land at their final offsets, and
+ * finalizeModelUpload() checks the bytes in place and commits them by
+ * setting hasModel. The buffer starts each upload holding the current model,
+ * which is the base a DELTA payload patches (the staging copy).
+ *
+ * Hot swap: if the current model is also saved in a flash slot, and flash is
+ * memory mapped (FlashRegion::mapped()), beginModelUpload() points the
+ * committed model at that saved copy, so inference keeps running from flash
+ * while the RAM buffer is overwritten. A successful finalize points it back
+ * at RAM; the caller reloads SimpleNN between windows. The save then goes to
+ * the other slot, so the copy inference ran from is never erased under it.
+ * The caller makes sure there is a saved copy where it can (see
+ * canServeModelDuringUpload: main saves the model first, at START).
+ * Without one the current model keeps running from RAM until the
+ * first chunk that writes over it retires it (the caller unloads it from
+ * SimpleNN then); a DELTA refused for the wrong base never does. After a
+ * failed or cancelled upload that retired it, restoreSavedModel() brings
+ * back the last model saved to flash (without persistence the board is left
+ * with no model).
  *
- * IMPORTANT:
- * PERSISTENT_MODEL is defined for future feature work only. This file does
- * not currently implement nRF52840 flash read/write. To keep classroom
- * behavior predictable, startup always clears model state.
- * 
- * For persistent storage in the future, implement flash-backed load/save
- * paths and remove the startup wipe in initFlashStorage().
- * 
  * See docs/NEURAL_NETWORK_BASICS.md for details on the SimpleNN format.
  */
 
 #include "flash_storage.h"
+#include "crc32.h"
+#include "flash_region.h"
+#include "model_codec.h"
+#include "model_slots.h"
 
 // ============================================================================
 // Storage Buffer (RAM-based)
 // ============================================================================
 
-// Static buffer to hold the model - persists during runtime
-static SimpleNNModel storedModel;
-static bool hasModel = false;
+// The one model buffer: holds the committed model, or the model being
+// uploaded while an upload is in progress (never both)
+alignas(4) static StoredModelData storedModel;
+static uint32_t storedModelSize = 0;
+static bool hasModel = false;  // committedModel passed validation and is committed
+
+// What inference runs from: storedModel, or during an upload the same
+// model's saved copy in mapped flash
+static const StoredModelData* committedModel = &storedModel;
 
-// Upload buffer and state
-static uint8_t uploadBuffer[sizeof(SimpleNNModel)];
+static_assert(offsetof(StoredModelData, extraHeads) == sizeof(SimpleNNModel),
+              "Extra heads must follow the primary model with no padding");
+
+// Upload state (validation is tracked here, separately from the data)
+static ModelUploadDecoder uploadDecoder;  // Wire bytes → storedModel
 static UploadState currentUploadState = UPLOAD_IDLE;
-static uint32_t bytesReceived = 0;
+static uint32_t bytesReceived = 0;  // Bytes [0, bytesReceived) are decoded
 static uint32_t expectedSize = 0;
+// CRC register over bytes [0, bytesReceived): bytes are decoded in order,
+// so finalize only has to compare, not re-read 78 KB
+static uint32_t uploadCrc = CRC32_INITIAL;
+static UploadStatus uploadError = STATUS_ERROR_FORMAT;  // Why a chunk failed it
+// The committed model is in the buffer with no saved copy to serve: it is
+// retired when the decoder first writes over it (a refused delta never does)
+static bool retireOnWrite = false;
+
+// Reorder window: chunks ahead of bytesReceived wait here until the gap
+// before them is filled. Block b lives at ring slot b % UPLOAD_WINDOW_BLOCKS
+// and its bit says the slot holds it.
+static_assert(MODEL_UPLOAD_WINDOW % MODEL_UPLOAD_BLOCK_SIZE == 0,
+              "The reorder window must hold whole blocks");
+#define UPLOAD_WINDOW_BLOCKS (MODEL_UPLOAD_WINDOW / MODEL_UPLOAD_BLOCK_SIZE)
+alignas(4) static uint8_t uploadWindow[MODEL_UPLOAD_WINDOW];
+static uint32_t uploadWindowBits[(UPLOAD_WINDOW_BLOCKS + 31) / 32];
 static uint32_t uploadNumClasses = 0;
 static char uploadLabels[NN_MAX_CLASSES][LABEL_MAX_LEN];
 
 // ============================================================================
-// CRC32 Implementation (IEEE 802.3 polynomial)
+// Flash Storage Functions
 // ============================================================================
-static const uint32_t crc32Table[256] = {
-    0x00000000, 0x77073096, 0xEE0E612C, 0x990951BA, 0x076DC419, 0x706AF48F,
-    0xE963A535, 0x9E6495A3, 0x0EDB8832, 0x79DCB8A4, 0xE0D5E91E, 0x97D2D988,
-    0x09B64C2B, 0x7EB17CBD, 0xE7B82D07, 0x90BF1D91, 0x1DB71064, 0x6AB020F2,
-    0xF3B97148, 0x84BE41DE, 0x1ADAD47D, 0x6DDDE4EB, 0xF4D4B551, 0x83D385C7,
-    0x136C9856, 0x646BA8C0, 0xFD62F97A, 0x8A65C9EC, 0x14015C4F, 0x63066CD9,
-    0xFA0F3D63, 0x8D080DF5, 0x3B6E20C8, 0x4C69105E, 0xD56041E4, 0xA2677172,
-    0x3C03E4D1, 0x4B04D447, 0xD20D85FD, 0xA50AB56B, 0x35B5A8FA, 0x42B2986C,
-    0xDBBBC9D6, 0xACBCF940, 0x32D86CE3, 0x45DF5C75, 0xDCD60DCF, 0xABD13D59,
-    0x26D930AC, 0x51DE003A, 0xC8D75180, 0xBFD06116, 0x21B4F4B5, 0x56B3C423,
-    0xCFBA9599, 0xB8BDA50F, 0x2802B89E, 0x5F058808, 0xC60CD9B2, 0xB10BE924,
-    0x2F6F7C87, 0x58684C11, 0xC1611DAB, 0xB6662D3D, 0x76DC4190, 0x01DB7106,
-    0x98D220BC, 0xEFD5102A, 0x71B18589, 0x06B6B51F, 0x9FBFE4A5, 0xE8B8D433,
-    0x7807C9A2, 0x0F00F934, 0x9609A88E, 0xE10E9818, 0x7F6A0DBB, 0x086D3D2D,
-    0x91646C97, 0xE6635C01, 0x6B6B51F4, 0x1C6C6162, 0x856530D8, 0xF262004E,
-    0x6C0695ED, 0x1B01A57B, 0x8208F4C1, 0xF50FC457, 0x65B0D9C6, 0x12B7E950,
-    0x8BBEB8EA, 0xFCB9887C, 0x62DD1DDF, 0x15DA2D49, 0x8CD37CF3, 0xFBD44C65,
-    0x4DB26158, 0x3AB551CE, 0xA3BC0074, 0xD4BB30E2, 0x4ADFA541, 0x3DD895D7,
-    0xA4D1C46D, 0xD3D6F4FB, 0x4369E96A, 0x346ED9FC, 0xAD678846, 0xDA60B8D0,
-    0x44042D73, 0x33031DE5, 0xAA0A4C5F, 0xDD0D7CC9, 0x5005713C, 0x270241AA,
-    0xBE0B1010, 0xC90C2086, 0x5768B525, 0x206F85B3, 0xB966D409, 0xCE61E49F,
-    0x5EDEF90E, 0x29D9C998, 0xB0D09822, 0xC7D7A8B4, 0x59B33D17, 0x2EB40D81,
-    0xB7BD5C3B, 0xC0BA6CAD, 0xEDB88320, 0x9ABFB3B6, 0x03B6E20C, 0x74B1D29A,
-    0xEAD54739, 0x9DD277AF, 0x04DB2615, 0x73DC1683, 0xE3630B12, 0x94643B84,
-    0x0D6D6A3E, 0x7A6A5AA8, 0xE40ECF0B, 0x9309FF9D, 0x0A00AE27, 0x7D079EB1,
-    0xF00F9344, 0x8708A3D2, 0x1E01F268, 0x6906C2FE, 0xF762575D, 0x806567CB,
-    0x196C3671, 0x6E6B06E7, 0xFED41B76, 0x89D32BE0, 0x10DA7A5A, 0x67DD4ACC,
-    0xF9B9DF6F, 0x8EBEEFF9, 0x17B7BE43, 0x60B08ED5, 0xD6D6A3E8, 0xA1D1937E,
-    0x38D8C2C4, 0x4FDFF252, 0xD1BB67F1, 0xA6BC5767, 0x3FB506DD, 0x48B2364B,
-    0xD80D2BDA, 0xAF0A1B4C, 0x36034AF6, 0x41047A60, 0xDF60EFC3, 0xA867DF55,
-    0x316E8EEF, 0x4669BE79, 0xCB61B38C, 0xBC66831A, 0x256FD2A0, 0x5268E236,
-    0xCC0C7795, 0xBB0B4703, 0x220216B9, 0x5505262F, 0xC5BA3BBE, 0xB2BD0B28,
-    0x2BB45A92, 0x5CB36A04, 0xC2D7FFA7, 0xB5D0CF31, 0x2CD99E8B, 0x5BDEAE1D,
-    0x9B64C2B0, 0xEC63F226, 0x756AA39C, 0x026D930A, 0x9C0906A9, 0xEB0E363F,
-    0x72076785, 0x05005713, 0x95BF4A82, 0xE2B87A14, 0x7BB12BAE, 0x0CB61B38,
-    0x92D28E9B, 0xE5D5BE0D, 0x7CDCEFB7, 0x0BDBDF21, 0x86D3D2D4, 0xF1D4E242,
-    0x68DDB3F8, 0x1FDA836E, 0x81BE16CD, 0xF6B9265B, 0x6FB077E1, 0x18B74777,
-    0x88085AE6, 0xFF0F6A70, 0x66063BCA, 0x11010B5C, 0x8F659EFF, 0xF862AE69,
-    0x616BFFD3, 0x166CCF45, 0xA00AE278, 0xD70DD2EE, 0x4E048354, 0x3903B3C2,
-    0xA7672661, 0xD06016F7, 0x4969474D, 0x3E6E77DB, 0xAED16A4A, 0xD9D65ADC,
-    0x40DF0B66, 0x37D83BF0, 0xA9BCAE53, 0xDEBB9EC5, 0x47B2CF7F, 0x30B5FFE9,
-    0xBDBDF21C, 0xCABAC28A, 0x53B39330, 0x24B4A3A6, 0xBAD03605, 0xCDD70693,
-    0x54DE5729, 0x23D967BF, 0xB3667A2E, 0xC4614AB8, 0x5D681B02, 0x2A6F2B94,
-    0xB40BBE37, 0xC30C8EA1, 0x5A05DF1B, 0x2D02EF8D
-};
-
-uint32_t calculateCrc32(const uint8_t* data, size_t length) {
-    uint32_t crc = 0xFFFFFFFF;
-    for (size_t i = 0; i < length; i++) {
-        crc = crc32Table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
-    }
-    return crc ^ 0xFFFFFFFF;
+
+// Accepted FULL payload sizes: the classic single-head model, or the model
+// followed by an extra heads block with 1 to NN_MAX_HEADS - 1 heads.
+static bool isValidUploadSize(uint32_t size) {
+    for (uint32_t extra = 0; extra < NN_MAX_HEADS; extra++) {
+        if (size == SIMPLE_NN_UPLOAD_SIZE(extra)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-// ============================================================================
-// Flash Storage Functions
-// ============================================================================
+// Header checks shared by upload and boot: the payload must be a model this
+// firmware can run, plus a well-formed extra heads block when present
+static UploadStatus validateModelPayload(const StoredModelData* candidate, uint32_t size) {
+    if (candidate->model.magic != SIMPLE_NN_MAGIC ||
+        candidate->model.inputSize != NN_INPUT_SIZE ||
+        candidate->model.hiddenSize != NN_HIDDEN_SIZE ||
+        candidate->model.numClasses < 1 ||
+        candidate->model.numClasses > NN_MAX_CLASSES) {
+        DEBUG_PRINTLN("Model header is invalid");
+        return STATUS_ERROR_FORMAT;
+    }
+
+    if (size > sizeof(SimpleNNModel)) {
+        const SimpleNNExtraHeads& extra = candidate->extraHeads;
+        bool headsValid = extra.magic == SIMPLE_NN_HEADS_MAGIC &&
+                          extra.numExtraHeads >= 1 &&
+                          extra.numExtraHeads < NN_MAX_HEADS &&
+                          size == SIMPLE_NN_UPLOAD_SIZE(extra.numExtraHeads);
+        for (uint32_t h = 0; headsValid && h < extra.numExtraHeads; h++) {
+            headsValid = extra.heads[h].numClasses >= 1 &&
+                         extra.heads[h].numClasses <= NN_MAX_CLASSES;
+        }
+        if (!headsValid) {
+            DEBUG_PRINTLN("Model extra heads block is invalid");
+            return STATUS_ERROR_FORMAT;
+        }
+    }
+    return STATUS_SUCCESS;
+}
+
+#if PERSISTENT_MODEL
+// Save in progress (beginSaveStoredModel): committedModel → the older slot
+static ModelSlotSave modelSave;
+static bool savingModel = false;
+static uint32_t saveStartMs = 0;
+static uint32_t saveSteps = 0;
+
+// Run a pending save to the end before its source changes
+static void finishModelSave() {
+    while (continueSaveStoredModel() == STATUS_SAVING) {
+    }
+}
+
+// Newest intact flash slot → storedModel
+static bool loadSavedModel() {
+    FlashRegion* flash = getModelFlashRegion();
+    if (flash == nullptr) {
+        return false;
+    }
+
+    ModelSlotInfo info;
+    if (!loadNewestModelSlot(*flash, (uint8_t*)&storedModel, sizeof(storedModel), &info)) {
+        DEBUG_PRINTLN("No saved model in flash");
+        memset(&storedModel, 0, sizeof(storedModel));
+        return false;
+    }
+    if (!isValidUploadSize(info.payloadSize) ||
+        validateModelPayload(&storedModel, info.payloadSize) != STATUS_SUCCESS) {
+        // Intact but not runnable by this firmware (e.g. older format)
+        DEBUG_PRINTLN("Saved model does not match this firmware, ignoring it");
+        memset(&storedModel, 0, sizeof(storedModel));
+        return false;
+    }
+
+    storedModelSize = info.payloadSize;
+    committedModel = &storedModel;
+    hasModel = true;
+    DEBUG_PRINT("Loaded saved model from flash slot ");
+    DEBUG_PRINT(info.slot);
+    DEBUG_PRINT(" (save #");
+    DEBUG_PRINT(info.sequence);
+    DEBUG_PRINTLN(")");
+    return true;
+}
+
+// The committed RAM model's saved copy, read in place from mapped flash, or
+// nullptr if no slot holds exactly this model (never saved, or the save
+// failed) or flash cannot be read in place
+static const StoredModelData* findSavedCopy() {
+    FlashRegion* flash = getModelFlashRegion();
+    if (flash == nullptr || flash->mapped() == nullptr ||
+        !hasModel || committedModel != &storedModel) {
+        return nullptr;
+    }
+    for (int slot = 0; slot < MODEL_SLOT_COUNT; slot++) {
+        uint32_t offset;
+        uint32_t size;
+        if (!findModelSlotPayload(*flash, slot, &offset, &size) || size != storedModelSize) {
+            continue;
+        }
+        const uint8_t* saved = flash->mapped() + offset;
+        if (memcmp(saved, &storedModel, storedModelSize) == 0) {
+            return (const StoredModelData*)saved;
+        }
+    }
+    return nullptr;
+}
+#endif
 
 void initFlashStorage() {
     DEBUG_PRINTLN("Initializing SimpleNN model storage...");
@@ -109,46 +207,84 @@ void initFlashStorage() {
     sprintf(testBuf, "CRC32 test: 'hello' = 0x%08lX (expected 0x3610A686)", (unsigned long)testCrc);
     DEBUG_PRINTLN(testBuf);
     
-    #if PERSISTENT_MODEL
-    DEBUG_PRINTLN("WARNING: PERSISTENT_MODEL=1 set, but flash persistence is not implemented yet.");
-    #endif
-
-    // Clear storage on init (RAM-based model buffer, non-persistent).
+    // Start empty; a saved model (if any) is loaded below
     memset(&storedModel, 0, sizeof(storedModel));
+    storedModelSize = 0;
+    committedModel = &storedModel;
     hasModel = false;
     
     currentUploadState = UPLOAD_IDLE;
     bytesReceived = 0;
+    retireOnWrite = false;
+
+#if PERSISTENT_MODEL
+    savingModel = false;
+    if (loadSavedModel()) {
+        DEBUG_PRINTLN("Model storage ready (flash A/B slots, SimpleNN format)");
+        return;
+    }
+#endif
     
     DEBUG_PRINTLN("Model storage ready (RAM mode, SimpleNN format)");
 }
 
 bool hasStoredModel() {
-    return hasModel && storedModel.magic == SIMPLE_NN_MAGIC;
+    return hasModel && committedModel->model.magic == SIMPLE_NN_MAGIC;
+}
+
+bool isServingSavedModel() {
+    return hasStoredModel() && committedModel != &storedModel;
 }
 
 const SimpleNNModel* getStoredSimpleNNModel() {
     if (!hasStoredModel()) {
         return nullptr;
     }
-    return &storedModel;
+    return &committedModel->model;
+}
+
+const SimpleNNExtraHeads* getStoredExtraHeads() {
+    if (!hasStoredModel() || storedModelSize <= sizeof(SimpleNNModel)) {
+        return nullptr;
+    }
+    return &committedModel->extraHeads;
 }
 
 uint32_t getStoredModelSize() {
     if (!hasStoredModel()) return 0;
-    return sizeof(SimpleNNModel);
+    return storedModelSize;
 }
 
 uint32_t getStoredModelNumClasses() {
     if (!hasStoredModel()) return 0;
-    return storedModel.numClasses;
+    return committedModel->model.numClasses;
 }
 
 const char* getStoredModelLabel(uint8_t classIndex) {
     if (!hasStoredModel() || classIndex >= NN_MAX_CLASSES) {
         return "Unknown";
     }
-    return storedModel.labels[classIndex];
+    return committedModel->model.labels[classIndex];
+}
+
+bool canServeModelDuringUpload() {
+    if (!hasStoredModel() || isServingSavedModel()) {
+        return true;
+    }
+#if PERSISTENT_MODEL
+    return !savingModel && findSavedCopy() != nullptr;
+#else
+    return false;
+#endif
+}
+
+bool canSaveModelForUpload() {
+#if PERSISTENT_MODEL
+    FlashRegion* flash = getModelFlashRegion();
+    return hasStoredModel() && flash != nullptr && flash->mapped() != nullptr;
+#else
+    return false;
+#endif
 }
 
 void beginModelUpload(uint32_t totalSize, uint32_t numClasses) {
@@ -158,37 +294,119 @@ void beginModelUpload(uint32_t totalSize, uint32_t numClasses) {
     DEBUG_PRINT(numClasses);
     DEBUG_PRINTLN(" classes");
     
-    if (totalSize != sizeof(uploadBuffer)) {
+    // The exact size depends on the wire format, which is only known from
+    // the first payload word; finalize checks it
+    if (totalSize < MODEL_UPLOAD_MIN_SIZE || totalSize > MAX_MODEL_SIZE) {
         DEBUG_PRINT("Invalid model size, expected ");
-        DEBUG_PRINT(sizeof(uploadBuffer));
+        DEBUG_PRINT(MODEL_UPLOAD_MIN_SIZE);
+        DEBUG_PRINT(" to ");
+        DEBUG_PRINT(MAX_MODEL_SIZE);
         DEBUG_PRINT(" got ");
         DEBUG_PRINTLN(totalSize);
         currentUploadState = UPLOAD_ERROR;
         return;
     }
     
-    // Clear upload buffer
-    memset(uploadBuffer, 0, sizeof(uploadBuffer));
+    // The RAM buffer is about to be overwritten: keep serving the current
+    // model from its saved copy if it has one, otherwise retire it once the
+    // payload first writes to the buffer. Either way the buffer holds it as
+    // the base for a DELTA payload.
+    const uint32_t baseSize = hasStoredModel() ? storedModelSize : 0;
+    const StoredModelData* savedCopy = nullptr;
+#if PERSISTENT_MODEL
+    finishModelSave();  // It reads the buffer the upload is about to overwrite
+    savedCopy = isServingSavedModel() ? committedModel : findSavedCopy();
+#endif
+    if (savedCopy != nullptr) {
+        // An earlier upload may have left RAM overwritten already
+        memcpy(&storedModel, savedCopy, baseSize);
+        committedModel = savedCopy;
+        DEBUG_PRINTLN("Serving the current model from flash during the upload");
+    }
+    retireOnWrite = savedCopy == nullptr && hasModel;
     memset(uploadLabels, 0, sizeof(uploadLabels));
+    memset(uploadWindowBits, 0, sizeof(uploadWindowBits));
+    uploadDecoder.begin(&storedModel, baseSize);
+    uploadError = STATUS_ERROR_FORMAT;
     
     uploadNumClasses = numClasses;
     bytesReceived = 0;
     expectedSize = totalSize;
+    uploadCrc = CRC32_INITIAL;
     currentUploadState = UPLOAD_RECEIVING;
 }
 
+static bool isBlockHeld(uint32_t block) {
+    const uint32_t slot = block % UPLOAD_WINDOW_BLOCKS;
+    return (uploadWindowBits[slot / 32] >> (slot % 32)) & 1;
+}
+
+static void setBlockHeld(uint32_t block, bool held) {
+    const uint32_t slot = block % UPLOAD_WINDOW_BLOCKS;
+    if (held) {
+        uploadWindowBits[slot / 32] |= 1u << (slot % 32);
+    } else {
+        uploadWindowBits[slot / 32] &= ~(1u << (slot % 32));
+    }
+}
+
+// Unpack and decode the next bytes straight into the model buffer
+static bool decodeInOrder(const uint8_t* data, uint32_t length) {
+    const bool decoded = uploadDecoder.write(data, length);
+    if (retireOnWrite && uploadDecoder.getWireDecoder().hasWrittenTarget()) {
+        DEBUG_PRINTLN("Upload overwrote the current model, retiring it");
+        hasModel = false;
+        storedModelSize = 0;
+        retireOnWrite = false;
+    }
+    if (!decoded) {
+        if (uploadDecoder.getWireDecoder().isBaseMismatch()) {
+            DEBUG_PRINTLN("Delta upload is for a different base model");
+            uploadError = STATUS_ERROR_BASE;
+        } else {
+            DEBUG_PRINT("Malformed model payload near offset ");
+            DEBUG_PRINTLN(bytesReceived);
+        }
+        currentUploadState = UPLOAD_ERROR;
+        return false;
+    }
+    uploadCrc = crc32Update(uploadCrc, data, length);
+
+    // Blocks now wholly decoded free their window slots
+    const uint32_t firstBlock = bytesReceived / MODEL_UPLOAD_BLOCK_SIZE;
+    bytesReceived += length;
+    for (uint32_t block = firstBlock; block < bytesReceived / MODEL_UPLOAD_BLOCK_SIZE; block++) {
+        setBlockHeld(block, false);
+    }
+    return true;
+}
+
+// Decode held blocks that the last chunk made contiguous
+static bool drainUploadWindow() {
+    while (bytesReceived < expectedSize) {
+        const uint32_t block = bytesReceived / MODEL_UPLOAD_BLOCK_SIZE;
+        if (!isBlockHeld(block)) {
+            return true;
+        }
+        uint32_t blockEnd = (block + 1) * MODEL_UPLOAD_BLOCK_SIZE;
+        if (blockEnd > expectedSize) {
+            blockEnd = expectedSize;
+        }
+        const uint8_t* held = &uploadWindow[bytesReceived % MODEL_UPLOAD_WINDOW];
+        if (!decodeInOrder(held, blockEnd - bytesReceived)) {
+            return false;
+        }
+        setBlockHeld(block, false);  // Also when blockEnd is the partial last block
+    }
+    return true;
+}
+
 bool receiveModelChunk(const uint8_t* data, uint16_t length, uint32_t offset) {
     if (currentUploadState != UPLOAD_RECEIVING) {
         DEBUG_PRINTLN("Not in receiving state");
         return false;
     }
     
-    if (offset + length > sizeof(uploadBuffer)) {
-        DEBUG_PRINTLN("Chunk exceeds buffer size");
-        currentUploadState = UPLOAD_ERROR;
-        return false;
-    }
-
     if (offset + length > expectedSize) {
         DEBUG_PRINT("Chunk exceeds expected upload size: end=");
         DEBUG_PRINT(offset + length);
@@ -197,20 +415,45 @@ bool receiveModelChunk(const uint8_t* data, uint16_t length, uint32_t offset) {
         currentUploadState = UPLOAD_ERROR;
         return false;
     }
-    
-    // Enforce strictly sequential chunks to prevent gaps in the model data
-    if (offset != bytesReceived) {
-        DEBUG_PRINT("Out-of-order chunk: expected offset ");
-        DEBUG_PRINT(bytesReceived);
-        DEBUG_PRINT(" got ");
-        DEBUG_PRINTLN(offset);
-        currentUploadState = UPLOAD_ERROR;
-        return false;
+
+    // A resend of bytes already decoded: only what is new counts
+    if (offset + length <= bytesReceived) {
+        return true;
+    }
+    if (offset < bytesReceived) {
+        const uint32_t skip = bytesReceived - offset;
+        data += skip;
+        length -= skip;
+        offset = bytesReceived;
     }
 
-    // Copy chunk to buffer
-    memcpy(&uploadBuffer[offset], data, length);
-    bytesReceived += length;
+    if (offset == bytesReceived) {
+        if (!decodeInOrder(data, length) || !drainUploadWindow()) {
+            return false;
+        }
+    } else {
+        // Ahead of a gap: hold it in the window, if it fits there
+        const uint32_t end = offset + length;
+        if (offset % MODEL_UPLOAD_BLOCK_SIZE != 0 ||
+            (end % MODEL_UPLOAD_BLOCK_SIZE != 0 && end != expectedSize)) {
+            DEBUG_PRINT("Out-of-order chunk not block aligned: offset ");
+            DEBUG_PRINTLN(offset);
+            currentUploadState = UPLOAD_ERROR;
+            return false;
+        }
+        const uint32_t windowEnd =
+            (bytesReceived / MODEL_UPLOAD_BLOCK_SIZE) * MODEL_UPLOAD_BLOCK_SIZE + MODEL_UPLOAD_WINDOW;
+        if (end > windowEnd) {
+            DEBUG_PRINT("Chunk beyond reorder window dropped: offset ");
+            DEBUG_PRINTLN(offset);
+            return true;
+        }
+        for (uint32_t pos = offset; pos < end; pos += MODEL_UPLOAD_BLOCK_SIZE) {
+            const uint32_t blockLength = end - pos < MODEL_UPLOAD_BLOCK_SIZE ? end - pos : MODEL_UPLOAD_BLOCK_SIZE;
+            memcpy(&uploadWindow[pos % MODEL_UPLOAD_WINDOW], &data[pos - offset], blockLength);
+            setBlockHeld(pos / MODEL_UPLOAD_BLOCK_SIZE, true);
+        }
+    }
     
     DEBUG_PRINT("Received chunk: offset=");
     DEBUG_PRINT(offset);
@@ -222,6 +465,39 @@ bool receiveModelChunk(const uint8_t* data, uint16_t length, uint32_t offset) {
     return true;
 }
 
+uint32_t getMissingUploadRanges(UploadRange* ranges, uint32_t maxRanges) {
+    if (currentUploadState != UPLOAD_RECEIVING) {
+        return 0;
+    }
+
+    uint32_t count = 0;
+    uint32_t pos = bytesReceived;
+    const uint32_t firstBlock = bytesReceived / MODEL_UPLOAD_BLOCK_SIZE;
+    for (uint32_t block = firstBlock; block < firstBlock + UPLOAD_WINDOW_BLOCKS && pos < expectedSize; block++) {
+        const uint32_t blockStart = block * MODEL_UPLOAD_BLOCK_SIZE;
+        const uint32_t blockEnd = blockStart + MODEL_UPLOAD_BLOCK_SIZE;
+        if (!isBlockHeld(block)) {
+            continue;
+        }
+        // pos..blockStart is a gap (pos is at most blockStart here)
+        if (blockStart > pos) {
+            if (count == maxRanges) {
+                return count;
+            }
+            ranges[count].offset = pos;
+            ranges[count].length = blockStart - pos;
+            count++;
+        }
+        pos = blockEnd < expectedSize ? blockEnd : expectedSize;
+    }
+    if (pos < expectedSize && count < maxRanges) {
+        ranges[count].offset = pos;
+        ranges[count].length = expectedSize - pos;
+        count++;
+    }
+    return count;
+}
+
 void setModelLabel(uint8_t classIndex, const char* label) {
     if (classIndex >= NN_MAX_CLASSES) return;
     
@@ -250,11 +526,18 @@ UploadStatus finalizeModelUpload(uint32_t expectedCrc32) {
         return STATUS_ERROR_SIZE;
     }
 
-    if (bytesReceived != sizeof(SimpleNNModel)) {
-        DEBUG_PRINT("Unexpected payload size, expected ");
-        DEBUG_PRINT(sizeof(SimpleNNModel));
-        DEBUG_PRINT(" got ");
-        DEBUG_PRINTLN(bytesReceived);
+    // FULL payloads must be one of the fixed layouts; COMPACT ones must
+    // have ended exactly at their last label (sizes after unpacking), DELTA
+    // ones after their last patch and at one of the fixed layouts
+    const ModelWireDecoder& wireDecoder = uploadDecoder.getWireDecoder();
+    const bool fullFormat = wireDecoder.getFormat() == MODEL_WIRE_FULL;
+    const bool deltaFormat = wireDecoder.getFormat() == MODEL_WIRE_DELTA;
+    const uint32_t payloadSize = uploadDecoder.getPayloadSize();
+    const uint32_t storedSize = wireDecoder.getStoredSize();
+    if ((fullFormat && !isValidUploadSize(payloadSize)) ||
+        (deltaFormat && !isValidUploadSize(storedSize)) || !uploadDecoder.isComplete()) {
+        DEBUG_PRINT("Unexpected payload size for its format: ");
+        DEBUG_PRINTLN(payloadSize);
         currentUploadState = UPLOAD_ERROR;
         return STATUS_ERROR_SIZE;
     }
@@ -265,7 +548,7 @@ UploadStatus finalizeModelUpload(uint32_t expectedCrc32) {
     DEBUG_PRINTLN(bytesReceived);
 
     // CRC Verification — reject corrupted model data
-    uint32_t actualCrc = calculateCrc32(uploadBuffer, bytesReceived);
+    uint32_t actualCrc = crc32Finish(uploadCrc);
 
     char crcBuf[144];
     sprintf(crcBuf,
@@ -276,74 +559,146 @@ UploadStatus finalizeModelUpload(uint32_t expectedCrc32) {
             (unsigned long)actualCrc);
     DEBUG_PRINTLN(crcBuf);
 
-    char firstBytesBuf[64];
-    char* p = firstBytesBuf;
-    for (size_t i = 0; i < 16; i++) {
-        sprintf(p, "%02X", uploadBuffer[i]);
-        p += 2;
-        if (i < 15) {
-            *p++ = ' ';
-        }
-    }
-    *p = '\0';
-    DEBUG_PRINT("Payload first 16 bytes: ");
-    DEBUG_PRINTLN(firstBytesBuf);
-
-    char lastBytesBuf[64];
-    p = lastBytesBuf;
-    size_t start = bytesReceived >= 16 ? bytesReceived - 16 : 0;
-    for (size_t i = start; i < bytesReceived; i++) {
-        sprintf(p, "%02X", uploadBuffer[i]);
-        p += 2;
-        if (i + 1 < bytesReceived) {
-            *p++ = ' ';
-        }
-    }
-    *p = '\0';
-    DEBUG_PRINT("Payload last 16 bytes: ");
-    DEBUG_PRINTLN(lastBytesBuf);
-
     if (actualCrc != expectedCrc32) {
         currentUploadState = UPLOAD_ERROR;
         return STATUS_ERROR_CRC;
     }
 
-    memcpy(&storedModel, uploadBuffer, sizeof(SimpleNNModel));
+    // The patches arrived intact; the patched model must be the one they
+    // were made for
+    if (deltaFormat &&
+        calculateCrc32((const uint8_t*)&storedModel, storedSize) != wireDecoder.getResultCrc()) {
+        DEBUG_PRINTLN("Patched model CRC does not match the delta");
+        currentUploadState = UPLOAD_ERROR;
+        return STATUS_ERROR_CRC;
+    }
 
-    if (storedModel.magic != SIMPLE_NN_MAGIC ||
-        storedModel.inputSize != NN_INPUT_SIZE ||
-        storedModel.hiddenSize != NN_HIDDEN_SIZE ||
-        storedModel.numClasses < 1 ||
-        storedModel.numClasses > NN_MAX_CLASSES) {
-        DEBUG_PRINTLN("Uploaded model header is invalid");
+    // Validate the headers in place before committing the model
+    const StoredModelData* candidate = &storedModel;
+    if (validateModelPayload(candidate, storedSize) != STATUS_SUCCESS) {
         currentUploadState = UPLOAD_ERROR;
         return STATUS_ERROR_FORMAT;
     }
 
-    if (uploadNumClasses != 0 && uploadNumClasses != storedModel.numClasses) {
+    if (uploadNumClasses != 0 && uploadNumClasses != candidate->model.numClasses) {
         DEBUG_PRINT("Warning: START numClasses ");
         DEBUG_PRINT(uploadNumClasses);
         DEBUG_PRINT(" differs from payload header ");
-        DEBUG_PRINTLN(storedModel.numClasses);
+        DEBUG_PRINTLN(candidate->model.numClasses);
     }
-    
+
+    // Commit: the data is already where it belongs (bytes past the payload
+    // were zeroed by the decoder). A model served from flash until now
+    // stays readable there until the caller reloads SimpleNN.
+    committedModel = &storedModel;
+    storedModelSize = storedSize;
     hasModel = true;
+    retireOnWrite = false;
     currentUploadState = UPLOAD_COMPLETE;
     
     DEBUG_PRINTLN("SimpleNN model saved successfully!");
     DEBUG_PRINT("  Classes: ");
-    DEBUG_PRINTLN(storedModel.numClasses);
+    DEBUG_PRINTLN(storedModel.model.numClasses);
+    DEBUG_PRINT("  Extra heads: ");
+    DEBUG_PRINTLN(storedSize > sizeof(SimpleNNModel) ? storedModel.extraHeads.numExtraHeads : 0);
+    DEBUG_PRINT("  Wire format: ");
+    DEBUG_PRINT(fullFormat ? "full" : deltaFormat ? "delta" : "compact");
+    DEBUG_PRINTLN(uploadDecoder.isPacked() ? " (packed)" : "");
     
     return STATUS_SUCCESS;
 }
 
+UploadStatus beginSaveStoredModel() {
+#if PERSISTENT_MODEL
+    if (!hasStoredModel()) {
+        return STATUS_ERROR_FORMAT;
+    }
+    FlashRegion* flash = getModelFlashRegion();
+    if (flash == nullptr) {
+        return STATUS_SUCCESS;  // RAM only on this build
+    }
+
+    if (!beginModelSlotSave(*flash, (const uint8_t*)committedModel, storedModelSize, &modelSave)) {
+        DEBUG_PRINTLN("Model does not fit a flash slot; it stays in RAM until power off");
+        return STATUS_ERROR_FLASH;
+    }
+    saveStartMs = millis();
+    saveSteps = 0;
+    savingModel = true;
+    return STATUS_SAVING;
+#else
+    return STATUS_SUCCESS;
+#endif
+}
+
+UploadStatus continueSaveStoredModel() {
+#if PERSISTENT_MODEL
+    if (!savingModel) {
+        return STATUS_SUCCESS;
+    }
+    FlashRegion* flash = getModelFlashRegion();
+    ModelSlotInfo info;
+    const ModelSlotStep step = flash == nullptr ? MODEL_SLOT_STEP_FAILED
+                                                : stepModelSlotSave(*flash, &modelSave, &info);
+    saveSteps++;
+    if (step == MODEL_SLOT_STEP_BUSY) {
+        return STATUS_SAVING;
+    }
+    savingModel = false;
+    if (step == MODEL_SLOT_STEP_FAILED) {
+        DEBUG_PRINTLN("Saving model to flash failed; it stays in RAM until power off");
+        return STATUS_ERROR_FLASH;
+    }
+    char doneBuf[96];
+    sprintf(doneBuf, "Model saved to flash slot %d (save #%lu) in %lu ms, %lu steps",
+            info.slot, (unsigned long)info.sequence,
+            (unsigned long)(millis() - saveStartMs), (unsigned long)saveSteps);
+    DEBUG_PRINTLN(doneBuf);
+#endif
+    return STATUS_SUCCESS;
+}
+
+bool isSavingStoredModel() {
+#if PERSISTENT_MODEL
+    return savingModel;
+#else
+    return false;
+#endif
+}
+
+UploadStatus saveStoredModel() {
+    UploadStatus status = beginSaveStoredModel();
+    while (status == STATUS_SAVING) {
+        status = continueSaveStoredModel();
+    }
+    return status;
+}
+
+bool restoreSavedModel() {
+#if PERSISTENT_MODEL
+    // A model served from flash during the upload is copied back to RAM
+    if (currentUploadState == UPLOAD_RECEIVING || (hasStoredModel() && !isServingSavedModel())) {
+        return false;
+    }
+    return loadSavedModel();
+#else
+    return false;
+#endif
+}
+
 void cancelModelUpload() {
     currentUploadState = UPLOAD_IDLE;
+    retireOnWrite = false;
+    memset(uploadWindowBits, 0, sizeof(uploadWindowBits));
     bytesReceived = 0;
     expectedSize = 0;
     uploadNumClasses = 0;
 }
 
+UploadStatus getUploadError() {
+    return uploadError;
+}
+
 uint8_t getUploadProgress() {
     if (expectedSize == 0) return 0;
     return (uint8_t)((bytesReceived * 100) / expectedSize);
@@ -354,7 +709,12 @@ UploadState getUploadState() {
 }
 
 void clearStoredModel() {
+#if PERSISTENT_MODEL
+    finishModelSave();
+#endif
     memset(&storedModel, 0, sizeof(storedModel));
+    storedModelSize = 0;
+    committedModel = &storedModel;
     hasModel = false;
     DEBUG_PRINTLN("Stored model cleared");
 }
@@ -1,7 +1,8 @@
 /**
  * Flash Storage Module for Model Persistence
  * 
- * Stores trained neural network models in the Arduino's RAM.
+ * Stores trained neural network models in the Arduino's RAM, and with
+ * PERSISTENT_MODEL also in internal flash so they survive power cycles.
  * 
  * ============================================================================
  * UPDATED: Now stores SimpleNN format instead of TFLite!
@@ -17,6 +18,7 @@
 
 #include <Arduino.h>
 #include "config.h"
+#include "crc32.h"
 #include "simple_nn.h"
 
 // ============================================================================
@@ -39,7 +41,24 @@ enum UploadStatus {
     STATUS_ERROR_SIZE = 10,
     STATUS_ERROR_CRC = 11,
     STATUS_ERROR_FLASH = 12,
-    STATUS_ERROR_FORMAT = 13
+    STATUS_ERROR_FORMAT = 13,
+    STATUS_ERROR_BASE = 14,   // Delta for a model the board does not hold
+    STATUS_ERROR_IN_USE = 15  // Inference runs a model that could not be kept
+                              // serving during the upload: stop it first
+};
+
+// ============================================================================
+// Stored Model Layout
+// ============================================================================
+
+/**
+ * Everything stored for one uploaded model, laid out exactly as it arrives
+ * over BLE: the primary SimpleNN layers followed by the optional extra heads
+ * block (absent for single-head models).
+ */
+struct StoredModelData {
+    SimpleNNModel model;
+    SimpleNNExtraHeads extraHeads;
 };
 
 // ============================================================================
@@ -56,6 +75,12 @@ void initFlashStorage();
  */
 bool hasStoredModel();
 
+/**
+ * True while an upload runs and the committed model is served from its saved
+ * copy in flash (hot swap, see beginModelUpload)
+ */
+bool isServingSavedModel();
+
 /**
  * Get pointer to stored SimpleNN model
  * Returns nullptr if no valid model exists
@@ -63,7 +88,14 @@ bool hasStoredModel();
 const SimpleNNModel* getStoredSimpleNNModel();
 
 /**
- * Get size of stored model in bytes
+ * Get extra output heads of the stored model
+ * Returns nullptr for single-head models or if no valid model exists
+ */
+const SimpleNNExtraHeads* getStoredExtraHeads();
+
+/**
+ * Get size of stored model in bytes (SIMPLE_NN_UPLOAD_SIZE layout, which
+ * is larger than the upload for compact payloads)
  */
 uint32_t getStoredModelSize();
 
@@ -78,7 +110,31 @@ uint32_t getStoredModelNumClasses();
 const char* getStoredModelLabel(uint8_t classIndex);
 
 /**
- * Begin receiving a new model over BLE
+ * True if beginModelUpload() keeps the committed model running: there is
+ * none, or it is served from (or exactly saved in) memory-mapped flash and
+ * no save is still writing it
+ */
+bool canServeModelDuringUpload();
+
+/**
+ * True if saving the committed model first (beginSaveStoredModel) would
+ * give the next upload a copy to serve it from: a flash region exists and
+ * is memory mapped
+ */
+bool canSaveModelForUpload();
+
+/**
+ * Begin receiving a new model over BLE (FULL, COMPACT or DELTA wire format,
+ * see model_format.h, optionally packed, see model_codec.h)
+ *
+ * Chunks are written directly over the RAM model buffer, which holds the
+ * current model until then: a DELTA payload patches it. If the current
+ * model is also saved in memory-mapped flash, it stays committed and is
+ * served from there until finalize; otherwise it stays committed in RAM
+ * until the first chunk that writes to the buffer, which retires it
+ * (hasStoredModel() turns false: unload SimpleNN before the next window).
+ * Unload it from the inference engine before calling, and reload it after
+ * if hasStoredModel().
  * @param totalSize Expected total size of model data
  * @param numClasses Number of output classes
  */
@@ -86,13 +142,31 @@ void beginModelUpload(uint32_t totalSize, uint32_t numClasses);
 
 /**
  * Receive a chunk of model data
+ *
+ * Chunks may arrive out of order: one at the first missing byte is decoded
+ * straight away, one further ahead is held in the reorder window until the
+ * gap is filled (it must then start on a MODEL_UPLOAD_BLOCK_SIZE boundary).
+ * Chunks past the window and repeats of data already received are dropped
+ * without error; getMissingUploadRanges() tells the host what to resend.
  * @param data Pointer to chunk data
  * @param length Length of chunk
  * @param offset Byte offset in model
- * @return true if chunk received successfully
+ * @return false if no upload is running or this chunk failed it
  */
 bool receiveModelChunk(const uint8_t* data, uint16_t length, uint32_t offset);
 
+struct UploadRange {
+    uint32_t offset;
+    uint32_t length;
+};
+
+/**
+ * List the byte ranges of the current upload not received yet, in offset
+ * order. Everything past the reorder window counts as missing.
+ * @return number of ranges written (at most maxRanges; more may remain)
+ */
+uint32_t getMissingUploadRanges(UploadRange* ranges, uint32_t maxRanges);
+
 /**
  * Set class label for stored model
  */
@@ -100,16 +174,68 @@ void setModelLabel(uint8_t classIndex, const char* label);
 
 /**
  * Finalize and save the model
+ *
+ * On success the new model is committed in RAM: reload SimpleNN before
+ * saving, since the save may erase flash a served copy lived in.
  * @param expectedCrc32 CRC32 checksum to verify
  * @return UploadStatus code
  */
 UploadStatus finalizeModelUpload(uint32_t expectedCrc32);
 
+/**
+ * Save the committed model to flash (PERSISTENT_MODEL builds)
+ *
+ * Call after a successful finalizeModelUpload(). A full model spans 20
+ * flash pages: at up to 85 ms per page erase plus ~42 ms of word writes per
+ * page (nRF52840 datasheet maxima), this blocks for about 2.5 s. The loop uses
+ * beginSaveStoredModel() instead. STATUS_ERROR_FLASH means the model is
+ * still loaded but will not survive a power cycle; builds without
+ * persistence, or without a flash region, return STATUS_SUCCESS.
+ */
+UploadStatus saveStoredModel();
+
+/**
+ * Start the same save without blocking: each continueSaveStoredModel()
+ * call then erases or programs one page (so the loop stalls for at most
+ * ~85 ms at a time) until it returns the final status.
+ * @return STATUS_SAVING while the save runs, else the final status as for
+ *         saveStoredModel()
+ */
+UploadStatus beginSaveStoredModel();
+
+/**
+ * Next page of the save started by beginSaveStoredModel()
+ * @return STATUS_SAVING until the save ends, then its final status
+ */
+UploadStatus continueSaveStoredModel();
+
+/**
+ * True while a save started by beginSaveStoredModel() has pages left. The
+ * committed model is the save's source, so a new upload finishes the save
+ * before it overwrites the RAM buffer.
+ */
+bool isSavingStoredModel();
+
+/**
+ * Reload the newest model saved in flash into RAM, replacing whatever a
+ * failed or cancelled upload left there (and ending a hot swap: reload
+ * SimpleNN afterwards)
+ * @return true if a saved model is now the stored model
+ */
+bool restoreSavedModel();
+
 /**
  * Cancel in-progress model upload and reset upload state to idle
  */
 void cancelModelUpload();
 
+/**
+ * Status to report after receiveModelChunk() failed the upload:
+ * STATUS_ERROR_BASE for a delta against another model, otherwise
+ * STATUS_ERROR_FORMAT
+ */
+UploadStatus getUploadError();
+
 /**
  * Get current upload progress (0-100)
  */
@@ -125,9 +251,4 @@ UploadState getUploadState();
  */
 void clearStoredModel();
 
-/**
- * Calculate CRC32 of data
- */
-uint32_t calculateCrc32(const uint8_t* data, size_t length);
-
 #endif // FLASH_STORAGE_H
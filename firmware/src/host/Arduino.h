@@ -0,0 +1,97 @@
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+// ============================================================================
+// Host Arduino Shim (native env only)
+// ============================================================================
+//
+// Just enough of the Arduino core for the firmware modules to build and run
+// on Linux. Time is virtual: millis()/micros() only move when firmware code
+// calls delay() or a harness calls hostAdvanceMicros(), so a replayed or
+// synthetic sensor stream runs as fast as the CPU allows while every module
+// still sees consistent timestamps.
+//
+// The native env puts this directory on the include path; embedded builds
+// never see it and use the real core.
+// ============================================================================
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+#define DEC 10
+#define HEX 16
+
+// ============================================================================
+// Virtual Clock
+// ============================================================================
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Harness control: move time forward / back to zero
+void hostAdvanceMicros(uint64_t us);
+void hostResetClock();
+uint64_t hostMicros64();
+
+// Called after every delay(), e.g. to stop a firmware that spins forever
+typedef void (*HostDelayHook)(void* context);
+void hostSetDelayHook(HostDelayHook hook, void* context);
+
+// ============================================================================
+// nRF52840 Factory Information (device ID registers, fixed on the host)
+// ============================================================================
+struct HostFicr {
+    uint32_t DEVICEID[2];
+};
+extern HostFicr* NRF_FICR;
+
+// ============================================================================
+// Serial
+// ============================================================================
+// Prints like the Arduino Print class (floats with 2 decimals unless told
+// otherwise). Output goes to stdout; setOutput(nullptr) mutes it, which
+// keeps DEBUG_PRINT chatter out of benchmarks and test logs.
+class HostSerial {
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    void end() {}
+    operator bool() const { return true; }
+    int available() { return 0; }
+    int read() { return -1; }
+    void flush();
+
+    void setOutput(FILE* stream) { output = stream; }
+
+    size_t write(uint8_t c);
+    size_t write(const uint8_t* data, size_t length);
+
+    size_t print(const char* s);
+    size_t print(char c);
+    size_t print(unsigned long value, int base = DEC);
+    size_t print(long value, int base = DEC);
+    size_t print(unsigned int value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(int value, int base = DEC) { return print((long)value, base); }
+    size_t print(unsigned char value, int base = DEC) { return print((unsigned long)value, base); }
+    size_t print(double value, int digits = 2);
+
+    size_t println() { return print("\r\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(T value, int format) { return print(value, format) + println(); }
+
+private:
+    FILE* output = stdout;
+};
+
+extern HostSerial Serial;
+
+#endif // HOST_ARDUINO_H
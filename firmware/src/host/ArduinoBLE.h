@@ -0,0 +1,177 @@
+#ifndef HOST_ARDUINO_BLE_H
+#define HOST_ARDUINO_BLE_H
+
+// ============================================================================
+// Host ArduinoBLE Shim (native env only)
+// ============================================================================
+//
+// The subset of ArduinoBLE the firmware uses, backed by plain memory so
+// setup()/loop() run on Linux. There is no radio: a simulated central (see
+// firmware_sim.h) connects, writes characteristics and receives
+// notifications through the host* hooks below.
+//
+// Semantics kept from the real library:
+//   - written() reports a central write once, then clears
+//   - writes are delivered only when the firmware polls (BLE.central() or
+//     central.connected()), so a second write to the same characteristic
+//     before the firmware consumes the first overwrites it
+//   - a BLEWritten event handler is called for every write as it is
+//     delivered; such writes never count as overwritten
+//   - BLECharacteristic copies are handles onto the same value, as in the
+//     library (only the handler's argument is ever copied)
+//   - writeValue() truncates to the characteristic's value size and
+//     notifies the central when the characteristic has BLENotify
+// ============================================================================
+
+#include "Arduino.h"
+
+#define BLEBroadcast 0x01
+#define BLERead 0x02
+#define BLEWriteWithoutResponse 0x04
+#define BLEWrite 0x08
+#define BLENotify 0x10
+#define BLEIndicate 0x20
+
+// Characteristic events (BLERead is both a property and an event)
+#define BLESubscribed 0
+#define BLEUnsubscribed 1
+#define BLEWritten 3
+
+#define HOST_BLE_MAX_CHARACTERISTICS 16
+#define HOST_BLE_MAX_SERVICES 4
+
+class BLEDevice;
+class BLECharacteristic;
+typedef void (*BLECharacteristicEventHandler)(BLEDevice central, BLECharacteristic characteristic);
+
+class BLECharacteristic {
+public:
+    BLECharacteristic(const char* uuid, uint8_t properties, int valueSize);
+    BLECharacteristic(const BLECharacteristic& other);
+    ~BLECharacteristic();
+
+    const char* uuid() const { return _uuid; }
+    uint8_t properties() const { return _properties; }
+    int valueSize() const { return _valueSize; }
+
+    bool writeValue(const uint8_t* value, int length);
+    bool writeValue(const void* value, int length) { return writeValue((const uint8_t*)value, length); }
+    const uint8_t* value() const { return _value; }
+    int valueLength() const { return _valueLength; }
+    bool written();
+
+    // Only BLEWritten is raised on the host
+    void setEventHandler(int event, BLECharacteristicEventHandler handler);
+
+    // Central side: store a write for the firmware; returns false if it
+    // replaced one the firmware had not consumed yet
+    bool hostWrite(const uint8_t* data, int length);
+    uint32_t hostOverwrittenWrites() const { return _overwritten; }
+
+private:
+    BLECharacteristic& operator=(const BLECharacteristic&) = delete;
+
+    const char* _uuid;
+    uint8_t _properties;
+    int _valueSize;
+    uint8_t* _value;
+    bool _ownsValue = true;
+    int _valueLength = 0;
+    bool _written = false;
+    uint32_t _overwritten = 0;
+    BLECharacteristicEventHandler _writtenHandler = nullptr;
+};
+
+// Single-byte characteristic (ArduinoBLE's BLETypedCharacteristic<byte>)
+class BLEByteCharacteristic : public BLECharacteristic {
+public:
+    BLEByteCharacteristic(const char* uuid, uint8_t properties)
+        : BLECharacteristic(uuid, properties, 1) {}
+
+    bool writeValue(uint8_t value) { return BLECharacteristic::writeValue(&value, 1); }
+    uint8_t value() const { return valueLength() > 0 ? BLECharacteristic::value()[0] : 0; }
+};
+
+class BLEService {
+public:
+    explicit BLEService(const char* uuid) : _uuid(uuid) {}
+
+    const char* uuid() const { return _uuid; }
+    void addCharacteristic(BLECharacteristic& characteristic);
+    int characteristicCount() const { return _count; }
+    BLECharacteristic* characteristic(int index) const { return _characteristics[index]; }
+
+private:
+    const char* _uuid;
+    BLECharacteristic* _characteristics[HOST_BLE_MAX_CHARACTERISTICS];
+    int _count = 0;
+};
+
+class BLEDevice {
+public:
+    BLEDevice() {}
+    explicit BLEDevice(bool valid) : _valid(valid) {}
+
+    operator bool() const { return _valid; }
+    bool connected();  // Polls, like the real library
+    const char* address() const;
+
+private:
+    bool _valid = false;
+};
+
+// Firmware-side events raised by the shim for the simulated central
+typedef void (*HostBlePollHandler)(void* context);
+typedef void (*HostBleNotifyHandler)(void* context, const BLECharacteristic& characteristic,
+                                     const uint8_t* data, int length);
+
+class BLELocalDevice {
+public:
+    int begin();
+    void end() {}
+    void poll();
+
+    void setLocalName(const char* name);
+    void setDeviceName(const char* name) { (void)name; }
+    const char* localName() const { return _localName; }
+    void setAdvertisedService(const BLEService& service) { (void)service; }
+    void addService(BLEService& service);
+    int advertise() { _advertising = true; return 1; }
+    void stopAdvertise() { _advertising = false; }
+    BLEDevice central();
+
+    // ------------------------------------------------------------------
+    // Host hooks for the simulated central
+    // ------------------------------------------------------------------
+    // Called on every poll with virtual time up to date, to deliver
+    // whatever the central has scheduled
+    void hostSetPollHandler(HostBlePollHandler handler, void* context);
+    // Called for every notification the firmware sends while connected
+    void hostSetNotifyHandler(HostBleNotifyHandler handler, void* context);
+
+    bool hostConnect(const char* address);  // False if not advertising
+    void hostDisconnect();
+    bool hostConnected() const { return _connected; }
+    const char* hostCentralAddress() const { return _centralAddress; }
+    BLECharacteristic* hostFindCharacteristic(const char* uuid) const;
+
+    // Internal: BLECharacteristic::writeValue reports through here
+    void notify(const BLECharacteristic& characteristic, const uint8_t* data, int length);
+
+private:
+    BLEService* _services[HOST_BLE_MAX_SERVICES];
+    int _serviceCount = 0;
+    char _localName[32] = "";
+    char _centralAddress[18] = "";
+    bool _advertising = false;
+    bool _connected = false;
+    bool _polling = false;
+    HostBlePollHandler _pollHandler = nullptr;
+    void* _pollContext = nullptr;
+    HostBleNotifyHandler _notifyHandler = nullptr;
+    void* _notifyContext = nullptr;
+};
+
+extern BLELocalDevice BLE;
+
+#endif // HOST_ARDUINO_BLE_H
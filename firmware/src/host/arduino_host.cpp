@@ -0,0 +1,109 @@
+#include "Arduino.h"
+
+// ============================================================================
+// Virtual Clock
+// ============================================================================
+static uint64_t hostNowUs = 0;
+static HostDelayHook delayHook = nullptr;
+static void* delayHookContext = nullptr;
+
+static void runDelayHook() {
+    if (delayHook != nullptr) {
+        delayHook(delayHookContext);
+    }
+}
+
+unsigned long millis() {
+    return (unsigned long)(uint32_t)(hostNowUs / 1000);
+}
+
+unsigned long micros() {
+    return (unsigned long)(uint32_t)hostNowUs;
+}
+
+void delay(unsigned long ms) {
+    hostNowUs += (uint64_t)ms * 1000;
+    runDelayHook();
+}
+
+void delayMicroseconds(unsigned int us) {
+    hostNowUs += us;
+    runDelayHook();
+}
+
+void hostAdvanceMicros(uint64_t us) {
+    hostNowUs += us;
+}
+
+void hostResetClock() {
+    hostNowUs = 0;
+}
+
+uint64_t hostMicros64() {
+    return hostNowUs;
+}
+
+void hostSetDelayHook(HostDelayHook hook, void* context) {
+    delayHook = hook;
+    delayHookContext = context;
+}
+
+// ============================================================================
+// nRF52840 Factory Information
+// ============================================================================
+static HostFicr hostFicr = {{0x484F5354, 0x53494D00}};  // "HOST", "SIM"
+HostFicr* NRF_FICR = &hostFicr;
+
+// ============================================================================
+// Serial
+// ============================================================================
+HostSerial Serial;
+
+void HostSerial::flush() {
+    if (output != nullptr) {
+        fflush(output);
+    }
+}
+
+size_t HostSerial::write(uint8_t c) {
+    if (output == nullptr) {
+        return 1;
+    }
+    return fputc(c, output) == EOF ? 0 : 1;
+}
+
+size_t HostSerial::write(const uint8_t* data, size_t length) {
+    if (output == nullptr) {
+        return length;
+    }
+    return fwrite(data, 1, length, output);
+}
+
+size_t HostSerial::print(const char* s) {
+    return write((const uint8_t*)s, strlen(s));
+}
+
+size_t HostSerial::print(char c) {
+    return write((uint8_t)c);
+}
+
+size_t HostSerial::print(unsigned long value, int base) {
+    char text[24];
+    snprintf(text, sizeof(text), base == HEX ? "%lX" : "%lu", value);
+    return print(text);
+}
+
+size_t HostSerial::print(long value, int base) {
+    if (base == HEX) {
+        return print((unsigned long)value, base);
+    }
+    char text[24];
+    snprintf(text, sizeof(text), "%ld", value);
+    return print(text);
+}
+
+size_t HostSerial::print(double value, int digits) {
+    char text[48];
+    snprintf(text, sizeof(text), "%.*f", digits, value);
+    return print(text);
+}
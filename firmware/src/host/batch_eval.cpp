@@ -0,0 +1,262 @@
+#include "batch_eval.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <thread>
+#include "flash_storage.h"
+#include "inference_features.h"
+#include "sensor_host.h"
+#include "simple_nn.h"
+
+#define EVAL_WINDOWS_PER_CLAIM 64  // Work handed to a thread per atomic claim
+
+size_t evalWindowCount(size_t sampleCount) {
+    if (sampleCount < WINDOW_SIZE) {
+        return 0;
+    }
+    return (sampleCount - WINDOW_SIZE) / WINDOW_STRIDE + 1;
+}
+
+// ============================================================================
+// Model
+// ============================================================================
+
+bool loadEvalModel(const std::vector<uint8_t>& bytes, std::string* error) {
+    initFlashStorage();
+    beginModelUpload((uint32_t)bytes.size(), 0);
+    for (size_t offset = 0; offset < bytes.size(); offset += MODEL_CHUNK_SIZE) {
+        const size_t length = std::min((size_t)MODEL_CHUNK_SIZE, bytes.size() - offset);
+        if (!receiveModelChunk(&bytes[offset], (uint16_t)length, (uint32_t)offset)) {
+            break;
+        }
+    }
+
+    const UploadStatus status = finalizeModelUpload(calculateCrc32(bytes.data(), bytes.size()));
+    if (status != STATUS_SUCCESS) {
+        char message[96];
+        snprintf(message, sizeof(message),
+                 "model rejected (status %d, %zu bytes; expected %zu + optional heads)",
+                 (int)status, bytes.size(), sizeof(SimpleNNModel));
+        *error = message;
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// Sessions
+// ============================================================================
+
+static std::string sessionLabel(const std::filesystem::path& root, const std::filesystem::path& file) {
+    const std::filesystem::path relative = std::filesystem::relative(file, root);
+    if (relative.has_parent_path()) {
+        return relative.parent_path().filename().string();
+    }
+    const std::string name = file.filename().string();
+    return name.substr(0, name.find_first_of("_-."));
+}
+
+static int findClass(const char* label) {
+    for (uint32_t i = 0; i < getStoredModelNumClasses(); i++) {
+        if (strcasecmp(getStoredModelLabel((uint8_t)i), label) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+bool loadEvalSessions(const char* directory, std::vector<EvalSession>* sessions,
+                      std::vector<std::string>* skipped, std::string* error) {
+    std::error_code ec;
+    const std::filesystem::path root(directory);
+    std::vector<std::filesystem::path> files;
+    for (std::filesystem::recursive_directory_iterator it(root, ec), end; !ec && it != end;
+         it.increment(ec)) {
+        const std::string ext = it->path().extension().string();
+        if (it->is_regular_file() && (ext == ".csv" || ext == ".CSV" || ext == ".bin")) {
+            files.push_back(it->path());
+        }
+    }
+    if (ec) {
+        *error = "cannot read " + root.string() + ": " + ec.message();
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    for (size_t i = 0; i < files.size(); i++) {
+        const std::string label = sessionLabel(root, files[i]);
+        const int trueClass = findClass(label.c_str());
+        ReplaySensorReader reader(files[i].c_str());
+        if (trueClass < 0 || !reader.begin()) {
+            skipped->push_back(files[i].string() + (trueClass < 0 ? " (label '" + label + "')" : " (unreadable)"));
+            continue;
+        }
+
+        EvalSession session;
+        session.path = files[i].string();
+        session.trueClass = trueClass;
+        session.samples.resize(reader.getSampleCount() * 6);
+        for (size_t s = 0; s < reader.getSampleCount(); s++) {
+            memcpy(&session.samples[s * 6], reader.getSampleAxes(s), 6 * sizeof(int16_t));
+        }
+        sessions->push_back(std::move(session));
+    }
+    return true;
+}
+
+// ============================================================================
+// Evaluation
+// ============================================================================
+
+// One window exactly as addSample() + runInference() see it
+static int classifyWindow(SimpleNN& network, int idleClass, const int16_t* samples) {
+    float window[WINDOW_SIZE][6];
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        const int16_t* sample = &samples[i * 6];
+        window[i][0] = normalizeAccelSample(sample[0]);
+        window[i][1] = normalizeAccelSample(sample[1]);
+        window[i][2] = normalizeAccelSample(sample[2]);
+        window[i][3] = normalizeGyroSample(sample[3]);
+        window[i][4] = normalizeGyroSample(sample[4]);
+        window[i][5] = normalizeGyroSample(sample[5]);
+    }
+
+    float probabilities[NN_MAX_CLASSES];
+    int prediction = network.predict(&window[0][0], probabilities);
+    float confidence = network.getLastConfidence();
+    if (idleClass >= 0) {
+        const float motionScore = estimateMotionScoreFromWindow(window, WINDOW_SIZE);
+        prediction = applyIdleOverride(prediction, &confidence, idleClass, motionScore);
+    }
+    return prediction;
+}
+
+void evaluateSessions(const std::vector<EvalSession>& sessions, int threads, EvalResult* result) {
+    memset(result, 0, sizeof(*result));
+    result->numClasses = getStoredModelNumClasses();
+    for (uint32_t c = 0; c < result->numClasses; c++) {
+        strncpy(result->labels[c], getStoredModelLabel((uint8_t)c), LABEL_MAX_LEN - 1);
+    }
+
+    // Flatten (session, window) pairs: window w of session s is item firstWindow[s] + w
+    std::vector<size_t> firstWindow(sessions.size() + 1, 0);
+    for (size_t s = 0; s < sessions.size(); s++) {
+        firstWindow[s + 1] = firstWindow[s] + evalWindowCount(sessions[s].samples.size() / 6);
+    }
+    const size_t totalWindows = firstWindow.back();
+    std::vector<int8_t> predictions(totalWindows);
+
+    int idleClass = -1;
+    for (uint32_t c = 0; c < result->numClasses && idleClass < 0; c++) {
+        if (isIdleLabel(result->labels[c])) {
+            idleClass = (int)c;
+        }
+    }
+
+    if (threads <= 0) {
+        threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    }
+    result->threads = threads;
+
+    std::atomic<size_t> nextWindow(0);
+    auto worker = [&](SimpleNN* network) {
+        size_t session = 0;
+        while (true) {
+            const size_t begin = nextWindow.fetch_add(EVAL_WINDOWS_PER_CLAIM);
+            if (begin >= totalWindows) {
+                return;
+            }
+            const size_t end = std::min(begin + EVAL_WINDOWS_PER_CLAIM, totalWindows);
+            for (size_t item = begin; item < end; item++) {
+                while (firstWindow[session + 1] <= item) session++;
+                while (firstWindow[session] > item) session--;
+                const size_t window = item - firstWindow[session];
+                const int16_t* samples = &sessions[session].samples[window * WINDOW_STRIDE * 6];
+                predictions[item] = (int8_t)classifyWindow(*network, idleClass, samples);
+            }
+        }
+    };
+
+    // Loading prints through DEBUG_PRINT, so do it before the threads start
+    std::vector<SimpleNN> networks(threads);
+    for (int t = 0; t < threads; t++) {
+        networks[t].loadModel(getStoredSimpleNNModel(), getStoredExtraHeads());
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t = 1; t < threads; t++) {
+        pool.emplace_back(worker, &networks[t]);
+    }
+    worker(&networks[0]);
+    for (size_t t = 0; t < pool.size(); t++) {
+        pool[t].join();
+    }
+    result->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    result->windows = totalWindows;
+
+    for (size_t s = 0; s < sessions.size(); s++) {
+        const int truth = sessions[s].trueClass;
+        result->sessions[truth]++;
+        bool detected = false;
+        for (size_t item = firstWindow[s]; item < firstWindow[s + 1]; item++) {
+            const int predicted = predictions[item];
+            result->confusion[truth][predicted]++;
+            if (!detected && predicted == truth) {
+                const uint32_t latency = (uint32_t)(item - firstWindow[s]);
+                detected = true;
+                result->detectedSessions[truth]++;
+                result->latencyWindowSum[truth] += latency;
+                result->maxLatencyWindows[truth] = std::max(result->maxLatencyWindows[truth], latency);
+            }
+        }
+    }
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+void printEvalResult(FILE* out, const EvalResult& result) {
+    const uint32_t n = result.numClasses;
+
+    fprintf(out, "Confusion matrix (windows, rows = true class)\n%-16s", "");
+    for (uint32_t p = 0; p < n; p++) fprintf(out, " %9.9s", result.labels[p]);
+    fprintf(out, " %9s\n", "recall");
+
+    uint64_t correct = 0;
+    for (uint32_t t = 0; t < n; t++) {
+        uint64_t rowTotal = 0;
+        fprintf(out, "%-16s", result.labels[t]);
+        for (uint32_t p = 0; p < n; p++) {
+            fprintf(out, " %9u", result.confusion[t][p]);
+            rowTotal += result.confusion[t][p];
+        }
+        correct += result.confusion[t][t];
+        if (rowTotal > 0) {
+            fprintf(out, " %8.1f%%\n", 100.0 * result.confusion[t][t] / rowTotal);
+        } else {
+            fprintf(out, " %9s\n", "-");
+        }
+    }
+
+    fprintf(out, "\nLatency to first correct window (per session)\n");
+    fprintf(out, "%-16s %9s %9s %9s %9s\n", "", "sessions", "detected", "mean", "max");
+    for (uint32_t t = 0; t < n; t++) {
+        if (result.sessions[t] == 0) continue;
+        fprintf(out, "%-16s %9u %9u", result.labels[t], result.sessions[t], result.detectedSessions[t]);
+        if (result.detectedSessions[t] > 0) {
+            fprintf(out, " %9.1f %9u\n",
+                    (double)result.latencyWindowSum[t] / result.detectedSessions[t],
+                    result.maxLatencyWindows[t]);
+        } else {
+            fprintf(out, " %9s %9s\n", "-", "-");
+        }
+    }
+
+    fprintf(out, "\nWindows: %llu, accuracy %.1f%%, %.0f windows/s on %d threads\n",
+            (unsigned long long)result.windows,
+            result.windows > 0 ? 100.0 * correct / result.windows : 0.0,
+            result.seconds > 0 ? result.windows / result.seconds : 0.0, result.threads);
+}
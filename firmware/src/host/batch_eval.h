@@ -0,0 +1,62 @@
+#ifndef BATCH_EVAL_H
+#define BATCH_EVAL_H
+
+#include <stdio.h>
+#include <string>
+#include <vector>
+#include "config.h"
+
+// ============================================================================
+// Offline Batch Evaluator
+// ============================================================================
+//
+// Scores an uploaded model (the exact bytes weightsToBytes produces) on a
+// directory of recorded sessions with the firmware's own inference path:
+// int16 samples → normalizeAccel/GyroSample → 100-sample windows every
+// WINDOW_STRIDE samples → SimpleNN::predict → applyIdleOverride. Windows are
+// independent, so they are spread over all cores; each worker owns a
+// SimpleNN instance reading the one shared copy of the weights.
+//
+// Each session starts with an empty window, like the firmware after a mode
+// change. Sessions are *.csv or *.bin replay files (see sensor_host.h); the
+// true label is the name of the directory holding the file, or for files
+// directly in the root, the file name up to the first '_', '-' or '.'.
+// ============================================================================
+
+struct EvalSession {
+    std::string path;
+    int trueClass;                 // Index into the model's labels
+    std::vector<int16_t> samples;  // 6 packet-scaled axes per sample
+};
+
+struct EvalResult {
+    uint32_t numClasses;
+    char labels[NN_MAX_CLASSES][LABEL_MAX_LEN];
+    uint32_t confusion[NN_MAX_CLASSES][NN_MAX_CLASSES];  // [true][predicted] windows
+    uint32_t sessions[NN_MAX_CLASSES];                   // Per true class
+    uint32_t detectedSessions[NN_MAX_CLASSES];           // Some window correct
+    uint64_t latencyWindowSum[NN_MAX_CLASSES];           // Windows before the first correct one
+    uint32_t maxLatencyWindows[NN_MAX_CLASSES];
+    uint64_t windows;
+    int threads;
+    double seconds;                                      // Wall time of the window pass
+};
+
+// Windows the firmware runs on a session of sampleCount samples
+size_t evalWindowCount(size_t sampleCount);
+
+// Accept the model exactly as a BLE upload would (size, CRC, header checks in
+// flash_storage); on success it is the stored model
+bool loadEvalModel(const std::vector<uint8_t>& bytes, std::string* error);
+
+// Load every session under directory whose label matches a class of the
+// stored model; sessions with unknown labels are listed in *skipped
+bool loadEvalSessions(const char* directory, std::vector<EvalSession>* sessions,
+                      std::vector<std::string>* skipped, std::string* error);
+
+// threads <= 0 uses every core
+void evaluateSessions(const std::vector<EvalSession>& sessions, int threads, EvalResult* result);
+
+void printEvalResult(FILE* out, const EvalResult& result);
+
+#endif // BATCH_EVAL_H
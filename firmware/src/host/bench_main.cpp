@@ -0,0 +1,279 @@
+#ifdef HOST_BENCHMARK
+
+// ============================================================================
+// Hot-Path Micro-Benchmarks (pio run -e native_bench)
+// ============================================================================
+//
+//   program [--filter text] [--min-time-ms N] [--repeats N]
+//
+// Times the firmware's inner kernels at production shapes and prints one
+// JSON document on stdout, so two firmware versions can be compared by
+// diffing (or scripting over) their outputs. Inputs come from a fixed-seed
+// generator and every benchmark is warmed up, then run `repeats` times for
+// at least min-time-ms each; ns_per_op.min is the most stable figure.
+//
+// These are host numbers: they rank kernel changes, not nRF52840 timings.
+// ============================================================================
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+#include "config.h"
+#include "crc32.h"
+#include "crc8.h"
+#include "flash_storage.h"
+#include "inference.h"
+#include "inference_features.h"
+#include "model_codec.h"
+#include "nn_math.h"
+#include "simple_nn.h"
+
+// Keep the optimizer from deleting work whose result is unused
+static inline void benchEscape(const void* p) {
+    asm volatile("" : : "g"(p) : "memory");
+}
+
+struct BenchResult {
+    std::string name;
+    uint64_t iterations;  // Per repeat
+    double bytesPerOp;    // 0 = not a throughput benchmark
+    std::vector<double> nsPerOp;
+};
+
+struct BenchOptions {
+    const char* filter = nullptr;
+    double minTimeMs = 200.0;
+    int repeats = 7;
+};
+
+static uint32_t benchRngState = 0x5EED1234;
+
+static float benchRandom() {
+    benchRngState ^= benchRngState << 13;
+    benchRngState ^= benchRngState >> 17;
+    benchRngState ^= benchRngState << 5;
+    return (float)(benchRngState >> 8) / 16777216.0f - 0.5f;  // [-0.5, 0.5)
+}
+
+static double runBatch(const std::function<void()>& op, uint64_t iterations) {
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t i = 0; i < iterations; i++) {
+        op();
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+}
+
+static void runBenchmark(const BenchOptions& options, std::vector<BenchResult>* results,
+                         const char* name, double bytesPerOp, const std::function<void()>& op) {
+    if (options.filter != nullptr && strstr(name, options.filter) == nullptr) {
+        return;
+    }
+
+    // Calibrate: grow the batch until one batch takes ~min-time (also warms up)
+    uint64_t iterations = 1;
+    double elapsedNs = runBatch(op, iterations);
+    const double targetNs = options.minTimeMs * 1e6;
+    while (elapsedNs < targetNs) {
+        const double scale = elapsedNs > 0 ? targetNs / elapsedNs * 1.2 : 10.0;
+        iterations = (uint64_t)(iterations * std::min(std::max(scale, 2.0), 100.0));
+        elapsedNs = runBatch(op, iterations);
+    }
+
+    BenchResult result;
+    result.name = name;
+    result.iterations = iterations;
+    result.bytesPerOp = bytesPerOp;
+    for (int r = 0; r < options.repeats; r++) {
+        result.nsPerOp.push_back(runBatch(op, iterations) / iterations);
+    }
+    results->push_back(result);
+}
+
+static void printJson(const std::vector<BenchResult>& results, const BenchOptions& options) {
+    printf("{\n");
+    printf("  \"firmware_version\": \"%d.%d\",\n", FIRMWARE_VERSION_MAJOR, FIRMWARE_VERSION_MINOR);
+    printf("  \"compiler\": \"%s\",\n", __VERSION__);
+    printf("  \"min_time_ms\": %.0f,\n", options.minTimeMs);
+    printf("  \"repeats\": %d,\n", options.repeats);
+    printf("  \"benchmarks\": [");
+    for (size_t i = 0; i < results.size(); i++) {
+        std::vector<double> sorted = results[i].nsPerOp;
+        std::sort(sorted.begin(), sorted.end());
+        double mean = 0;
+        for (size_t r = 0; r < sorted.size(); r++) mean += sorted[r];
+        mean /= sorted.size();
+
+        printf("%s\n    {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": "
+               "{\"min\": %.2f, \"median\": %.2f, \"mean\": %.2f, \"max\": %.2f}",
+               i == 0 ? "" : ",", results[i].name.c_str(), (unsigned long long)results[i].iterations,
+               sorted.front(), sorted[sorted.size() / 2], mean, sorted.back());
+        if (results[i].bytesPerOp > 0) {
+            printf(", \"bytes_per_op\": %.0f, \"mb_per_s\": %.1f", results[i].bytesPerOp,
+                   results[i].bytesPerOp / sorted.front() * 1e3);
+        }
+        printf("}");
+    }
+    printf("\n  ]\n}\n");
+}
+
+// ============================================================================
+// Benchmarks
+// ============================================================================
+
+static SimpleNNModel benchModel;
+
+static void fillRandom(float* values, int count, float scale) {
+    for (int i = 0; i < count; i++) {
+        values[i] = scale * benchRandom();
+    }
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (strcmp(argv[i], "--min-time-ms") == 0 && i + 1 < argc) {
+            options.minTimeMs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--repeats") == 0 && i + 1 < argc) {
+            options.repeats = std::max(1, atoi(argv[++i]));
+        } else {
+            fprintf(stderr, "usage: %s [--filter text] [--min-time-ms N] [--repeats N]\n", argv[0]);
+            return 2;
+        }
+    }
+    Serial.setOutput(nullptr);
+
+    // Production-shaped model: 600 → 32 ReLU → 8 softmax
+    benchModel.magic = SIMPLE_NN_MAGIC;
+    benchModel.numClasses = NN_MAX_CLASSES;
+    benchModel.inputSize = NN_INPUT_SIZE;
+    benchModel.hiddenSize = NN_HIDDEN_SIZE;
+    fillRandom(benchModel.hiddenWeights, NN_HIDDEN_SIZE * NN_INPUT_SIZE, 0.1f);
+    fillRandom(benchModel.hiddenBias, NN_HIDDEN_SIZE, 0.1f);
+    fillRandom(benchModel.outputWeights, NN_MAX_CLASSES * NN_HIDDEN_SIZE, 1.0f);
+    fillRandom(benchModel.outputBias, NN_MAX_CLASSES, 0.1f);
+    SimpleNN network;
+    network.loadModel(&benchModel);
+
+    static float input[NN_INPUT_SIZE];
+    fillRandom(input, NN_INPUT_SIZE, 2.0f);
+    float hidden[NN_HIDDEN_SIZE];
+    float output[NN_MAX_CLASSES];
+    fillRandom(hidden, NN_HIDDEN_SIZE, 2.0f);
+
+    float window[WINDOW_SIZE][6];
+    fillRandom(&window[0][0], WINDOW_SIZE * 6, 0.5f);
+
+    SensorPacket packet;
+    memset(&packet, 0, sizeof(packet));
+    packet.ax = 1234;
+    packet.az = 8192;
+    packet.sequence = 42;
+
+    std::vector<BenchResult> results;
+
+    runBenchmark(options, &results, "denseLayerForward/600x32_relu", 0, [&]() {
+        denseLayerForward(input, hidden, benchModel.hiddenWeights, benchModel.hiddenBias,
+                          NN_INPUT_SIZE, NN_HIDDEN_SIZE, true);
+        benchEscape(hidden);
+    });
+    runBenchmark(options, &results, "denseLayerForward/32x8", 0, [&]() {
+        denseLayerForward(hidden, output, benchModel.outputWeights, benchModel.outputBias,
+                          NN_HIDDEN_SIZE, NN_MAX_CLASSES, false);
+        benchEscape(output);
+    });
+    runBenchmark(options, &results, "softmaxInPlace/3", 0, [&]() {
+        float logits[3] = {0.3f, -1.2f, 2.1f};
+        softmaxInPlace(logits, 3);
+        benchEscape(logits);
+    });
+    runBenchmark(options, &results, "softmaxInPlace/8", 0, [&]() {
+        float logits[NN_MAX_CLASSES] = {0.3f, -1.2f, 2.1f, 0.0f, 1.5f, -0.7f, 0.9f, -2.4f};
+        softmaxInPlace(logits, NN_MAX_CLASSES);
+        benchEscape(logits);
+    });
+    runBenchmark(options, &results, "SimpleNN::predict/600x32x8", 0, [&]() {
+        benchEscape(input);  // Input may change between calls
+        network.predict(input, output);
+        benchEscape(output);
+    });
+
+    // Fill the firmware's sliding window once; sliding again keeps it full-sized
+    resetInferenceWindow();
+    for (int i = 0; i < WINDOW_SIZE; i++) {
+        addSample((int16_t)(i * 37), (int16_t)(-i * 11), 8192, (int16_t)(i * 5), 0, (int16_t)(-i));
+    }
+    runBenchmark(options, &results, "slideWindow/100x6_stride5", 0, [&]() {
+        slideWindow();
+    });
+
+    runBenchmark(options, &results, "estimateMotionScoreFromWindow/100x6", 0, [&]() {
+        benchEscape(window);
+        float score = estimateMotionScoreFromWindow(window, WINDOW_SIZE);
+        benchEscape(&score);
+    });
+    runBenchmark(options, &results, "calculateCrc32/model", sizeof(SimpleNNModel), [&]() {
+        benchEscape(&benchModel);
+        uint32_t crc = calculateCrc32((const uint8_t*)&benchModel, sizeof(SimpleNNModel));
+        benchEscape(&crc);
+    });
+    const struct {
+        const char* name;
+        uint32_t (*update)(uint32_t, const uint8_t*, size_t);
+    } crcVariants[] = {
+        {"crc32UpdateBytewise/model", crc32UpdateBytewise},
+        {"crc32UpdateSlice4/model", crc32UpdateSlice4},
+        {"crc32UpdateSlice8/model", crc32UpdateSlice8},
+    };
+    for (const auto& variant : crcVariants) {
+        runBenchmark(options, &results, variant.name, sizeof(SimpleNNModel), [&]() {
+            benchEscape(&benchModel);
+            uint32_t crc = variant.update(CRC32_INITIAL, (const uint8_t*)&benchModel,
+                                          sizeof(SimpleNNModel));
+            benchEscape(&crc);
+        });
+    }
+
+    // Upload decoding in BLE-sized chunks, plain and packed (throughput is
+    // per wire byte)
+    static StoredModelData uploadSource;
+    static StoredModelData uploadTarget;
+    memcpy(&uploadSource.model, &benchModel, sizeof(benchModel));
+    std::vector<uint8_t> compact(sizeof(StoredModelData));
+    compact.resize(encodeCompactModel(uploadSource, sizeof(SimpleNNModel), compact.data(),
+                                      (uint32_t)compact.size()));
+    std::vector<uint8_t> packed(compact.size() + 64);
+    packed.resize(packModelPayload(compact.data(), (uint32_t)compact.size(), packed.data(),
+                                   (uint32_t)packed.size()));
+    const struct {
+        const char* name;
+        const std::vector<uint8_t>* upload;
+    } uploadVariants[] = {
+        {"ModelUploadDecoder/compact_model", &compact},
+        {"ModelUploadDecoder/packed_model", &packed},
+    };
+    for (const auto& variant : uploadVariants) {
+        const std::vector<uint8_t>& upload = *variant.upload;
+        runBenchmark(options, &results, variant.name, (double)upload.size(), [&]() {
+            ModelUploadDecoder decoder;
+            decoder.begin(&uploadTarget);
+            for (size_t offset = 0; offset < upload.size(); offset += 239) {
+                decoder.write(&upload[offset], (uint32_t)std::min<size_t>(239, upload.size() - offset));
+            }
+            benchEscape(&uploadTarget);
+        });
+    }
+    runBenchmark(options, &results, "crc8/packet16", 16, [&]() {
+        benchEscape(&packet);
+        uint8_t crc = crc8((const uint8_t*)&packet, 16);
+        benchEscape(&crc);
+    });
+
+    printJson(results, options);
+    return 0;
+}
+
+#endif // HOST_BENCHMARK
@@ -0,0 +1,187 @@
+#include "ArduinoBLE.h"
+
+BLELocalDevice BLE;
+
+// ============================================================================
+// Characteristics
+// ============================================================================
+
+BLECharacteristic::BLECharacteristic(const char* uuid, uint8_t properties, int valueSize)
+    : _uuid(uuid), _properties(properties), _valueSize(valueSize) {
+    _value = (uint8_t*)calloc(valueSize > 0 ? valueSize : 1, 1);
+}
+
+// A handle onto the same value (never owns it)
+BLECharacteristic::BLECharacteristic(const BLECharacteristic& other)
+    : _uuid(other._uuid), _properties(other._properties), _valueSize(other._valueSize),
+      _value(other._value), _ownsValue(false), _valueLength(other._valueLength) {}
+
+BLECharacteristic::~BLECharacteristic() {
+    if (_ownsValue) {
+        free(_value);
+    }
+}
+
+bool BLECharacteristic::writeValue(const uint8_t* value, int length) {
+    if (length > _valueSize) {
+        length = _valueSize;
+    }
+    memcpy(_value, value, length);
+    _valueLength = length;
+
+    if (_properties & (BLENotify | BLEIndicate)) {
+        BLE.notify(*this, _value, _valueLength);
+    }
+    return true;
+}
+
+bool BLECharacteristic::written() {
+    const bool wasWritten = _written;
+    _written = false;
+    return wasWritten;
+}
+
+void BLECharacteristic::setEventHandler(int event, BLECharacteristicEventHandler handler) {
+    if (event == BLEWritten) {
+        _writtenHandler = handler;
+    }
+}
+
+bool BLECharacteristic::hostWrite(const uint8_t* data, int length) {
+    if (_writtenHandler != nullptr) {
+        // The handler takes each write as it arrives: nothing to overwrite
+        if (length > _valueSize) {
+            length = _valueSize;
+        }
+        memcpy(_value, data, length);
+        _valueLength = length;
+        _writtenHandler(BLEDevice(BLE.hostConnected()), *this);
+        return true;
+    }
+
+    const bool replaced = _written;
+    if (replaced) {
+        _overwritten++;
+    }
+    if (length > _valueSize) {
+        length = _valueSize;
+    }
+    memcpy(_value, data, length);
+    _valueLength = length;
+    _written = true;
+    return !replaced;
+}
+
+void BLEService::addCharacteristic(BLECharacteristic& characteristic) {
+    for (int i = 0; i < _count; i++) {
+        if (_characteristics[i] == &characteristic) {
+            return;  // setup() may run again in one host process
+        }
+    }
+    if (_count < HOST_BLE_MAX_CHARACTERISTICS) {
+        _characteristics[_count++] = &characteristic;
+    }
+}
+
+// ============================================================================
+// Central
+// ============================================================================
+
+bool BLEDevice::connected() {
+    if (!_valid) {
+        return false;
+    }
+    BLE.poll();
+    return BLE.hostConnected();
+}
+
+const char* BLEDevice::address() const {
+    return BLE.hostCentralAddress();
+}
+
+// ============================================================================
+// Local Device
+// ============================================================================
+
+int BLELocalDevice::begin() {
+    _serviceCount = 0;
+    _advertising = false;
+    _connected = false;
+    return 1;
+}
+
+void BLELocalDevice::poll() {
+    // The handler may write characteristics, which must not re-enter it
+    if (_pollHandler != nullptr && !_polling) {
+        _polling = true;
+        _pollHandler(_pollContext);
+        _polling = false;
+    }
+}
+
+void BLELocalDevice::setLocalName(const char* name) {
+    strncpy(_localName, name, sizeof(_localName) - 1);
+    _localName[sizeof(_localName) - 1] = '\0';
+}
+
+void BLELocalDevice::addService(BLEService& service) {
+    for (int i = 0; i < _serviceCount; i++) {
+        if (_services[i] == &service) {
+            return;
+        }
+    }
+    if (_serviceCount < HOST_BLE_MAX_SERVICES) {
+        _services[_serviceCount++] = &service;
+    }
+}
+
+BLEDevice BLELocalDevice::central() {
+    poll();
+    return BLEDevice(_connected);
+}
+
+void BLELocalDevice::hostSetPollHandler(HostBlePollHandler handler, void* context) {
+    _pollHandler = handler;
+    _pollContext = context;
+}
+
+void BLELocalDevice::hostSetNotifyHandler(HostBleNotifyHandler handler, void* context) {
+    _notifyHandler = handler;
+    _notifyContext = context;
+}
+
+bool BLELocalDevice::hostConnect(const char* address) {
+    if (!_advertising || _connected) {
+        return false;
+    }
+    strncpy(_centralAddress, address, sizeof(_centralAddress) - 1);
+    _centralAddress[sizeof(_centralAddress) - 1] = '\0';
+    _connected = true;
+    _advertising = false;  // Peripheral stops advertising while connected
+    return true;
+}
+
+void BLELocalDevice::hostDisconnect() {
+    if (_connected) {
+        _connected = false;
+        _advertising = true;  // ArduinoBLE resumes advertising on disconnect
+    }
+}
+
+BLECharacteristic* BLELocalDevice::hostFindCharacteristic(const char* uuid) const {
+    for (int s = 0; s < _serviceCount; s++) {
+        for (int c = 0; c < _services[s]->characteristicCount(); c++) {
+            BLECharacteristic* characteristic = _services[s]->characteristic(c);
+            if (strcmp(characteristic->uuid(), uuid) == 0) {
+                return characteristic;
+            }
+        }
+    }
+    return nullptr;
+}
+
+void BLELocalDevice::notify(const BLECharacteristic& characteristic, const uint8_t* data, int length) {
+    if (_connected && _notifyHandler != nullptr) {
+        _notifyHandler(_notifyContext, characteristic, data, length);
+    }
+}
@@ -0,0 +1,89 @@
+#ifdef HOST_EVALUATOR
+
+// ============================================================================
+// Batch Evaluator CLI (pio run -e native_eval)
+// ============================================================================
+//
+//   program <model.bin> <sessions dir> [--threads N] [--verbose]
+//
+// See batch_eval.h for the pipeline and the session directory layout.
+// ============================================================================
+
+#include "batch_eval.h"
+#include "Arduino.h"
+
+static bool readModelFile(const char* path, std::vector<uint8_t>* bytes) {
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes->insert(bytes->end(), buffer, buffer + count);
+    }
+    fclose(file);
+    return true;
+}
+
+int main(int argc, char** argv) {
+    const char* modelPath = nullptr;
+    const char* sessionDir = nullptr;
+    int threads = 0;
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            threads = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (modelPath == nullptr) {
+            modelPath = argv[i];
+        } else if (sessionDir == nullptr) {
+            sessionDir = argv[i];
+        } else {
+            modelPath = nullptr;
+            break;
+        }
+    }
+    if (modelPath == nullptr || sessionDir == nullptr) {
+        fprintf(stderr, "usage: %s <model.bin> <sessions dir> [--threads N] [--verbose]\n", argv[0]);
+        return 2;
+    }
+    if (!verbose) {
+        Serial.setOutput(nullptr);
+    }
+
+    std::vector<uint8_t> model;
+    std::string error;
+    if (!readModelFile(modelPath, &model)) {
+        fprintf(stderr, "cannot read %s\n", modelPath);
+        return 2;
+    }
+    if (!loadEvalModel(model, &error)) {
+        fprintf(stderr, "%s: %s\n", modelPath, error.c_str());
+        return 2;
+    }
+
+    std::vector<EvalSession> sessions;
+    std::vector<std::string> skipped;
+    if (!loadEvalSessions(sessionDir, &sessions, &skipped, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    for (size_t i = 0; i < skipped.size(); i++) {
+        fprintf(stderr, "skipped %s\n", skipped[i].c_str());
+    }
+    if (sessions.empty()) {
+        fprintf(stderr, "no sessions with a label the model knows in %s\n", sessionDir);
+        return 2;
+    }
+
+    EvalResult result;
+    evaluateSessions(sessions, threads, &result);
+    printf("%zu sessions from %s\n\n", sessions.size(), sessionDir);
+    printEvalResult(stdout, result);
+    return 0;
+}
+
+#endif // HOST_EVALUATOR
@@ -0,0 +1,110 @@
+#include "file_flash.h"
+#include <stdio.h>
+#include <string.h>
+
+FileFlashRegion::FileFlashRegion(const std::string& path, uint32_t size, uint32_t pageSize)
+    : path(path), flashPageSize(pageSize), contents(size, 0xFF),
+      operations(0), budget(UINT32_MAX), lost(false) {}
+
+bool FileFlashRegion::open() {
+    operations = 0;
+    budget = UINT32_MAX;
+    lost = false;
+
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file != nullptr) {
+        fseek(file, 0, SEEK_END);
+        const long fileSize = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        const bool loaded = fileSize == (long)contents.size() &&
+                            fread(contents.data(), 1, contents.size(), file) == contents.size();
+        fclose(file);
+        if (loaded) {
+            return true;
+        }
+    }
+
+    // Fresh part: fully erased
+    memset(contents.data(), 0xFF, contents.size());
+    file = fopen(path.c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    const bool written = fwrite(contents.data(), 1, contents.size(), file) == contents.size();
+    fclose(file);
+    return written;
+}
+
+bool FileFlashRegion::read(uint32_t offset, void* out, uint32_t length) {
+    if (lost || !inRange(offset, length)) {
+        return false;
+    }
+    memcpy(out, &contents[offset], length);
+    return true;
+}
+
+bool FileFlashRegion::erasePage(uint32_t offset) {
+    if (lost || offset % flashPageSize != 0 || !inRange(offset, flashPageSize)) {
+        return false;
+    }
+    const bool completes = consumeOperation();
+    memset(&contents[offset], 0xFF, completes ? flashPageSize : flashPageSize / 2);
+    writeThrough(offset, flashPageSize);
+    return completes;
+}
+
+bool FileFlashRegion::program(uint32_t offset, const void* data, uint32_t length) {
+    if (lost || offset % 4 != 0 || length % 4 != 0 || !inRange(offset, length)) {
+        return false;
+    }
+    const uint8_t* bytes = (const uint8_t*)data;
+    bool verified = true;
+    uint32_t done = 0;
+    for (; done < length; done += 4) {
+        const bool completes = consumeOperation();
+        // A torn word only gets its low half-word (little-endian bytes 0-1)
+        const uint32_t programmedBytes = completes ? 4 : 2;
+        for (uint32_t b = 0; b < programmedBytes; b++) {
+            contents[offset + done + b] &= bytes[done + b];
+        }
+        if (!completes) {
+            done += 4;
+            break;
+        }
+        verified = verified && memcmp(&contents[offset + done], &bytes[done], 4) == 0;
+    }
+    writeThrough(offset, done);
+    return !lost && verified;
+}
+
+void FileFlashRegion::failAfter(uint32_t operationsLeft) {
+    budget = operationsLeft;
+}
+
+bool FileFlashRegion::inRange(uint32_t offset, uint32_t length) const {
+    return offset <= contents.size() && length <= contents.size() - offset;
+}
+
+bool FileFlashRegion::consumeOperation() {
+    operations++;
+    if (budget == UINT32_MAX) {
+        return true;
+    }
+    if (budget == 0) {
+        lost = true;
+        return false;
+    }
+    budget--;
+    return true;
+}
+
+bool FileFlashRegion::writeThrough(uint32_t offset, uint32_t length) {
+    FILE* file = fopen(path.c_str(), "r+b");
+    if (file == nullptr) {
+        return false;
+    }
+    fseek(file, (long)offset, SEEK_SET);
+    const bool written = fwrite(&contents[offset], 1, length, file) == length;
+    fclose(file);
+    return written;
+}
@@ -0,0 +1,60 @@
+#ifndef FILE_FLASH_H
+#define FILE_FLASH_H
+
+#include <string>
+#include <vector>
+#include "flash_region.h"
+
+// ============================================================================
+// File-Backed Flash Emulator
+// ============================================================================
+//
+// A FlashRegion kept in a host file, with NOR semantics: erase sets a page
+// to 0xFF, program ANDs bits in and fails its read-back check if a word was
+// not erased first. Every operation is written through to the file, so a
+// new FileFlashRegion on the same path sees exactly what a rebooted board
+// would.
+//
+// Power loss: failAfter(n) lets n more word programs / page erases finish,
+// tears the next one (half a page erased, or only the low half-word of a
+// word programmed) and fails every call after it, as if the board lost
+// power mid-operation. open() is the power coming back.
+// ============================================================================
+
+class FileFlashRegion : public FlashRegion {
+public:
+    FileFlashRegion(const std::string& path, uint32_t size, uint32_t pageSize);
+
+    // Load the file (created fully erased if missing or the wrong size)
+    bool open();
+
+    uint32_t pageSize() const override { return flashPageSize; }
+    uint32_t size() const override { return (uint32_t)contents.size(); }
+
+    bool read(uint32_t offset, void* out, uint32_t length) override;
+    bool erasePage(uint32_t offset) override;
+    bool program(uint32_t offset, const void* data, uint32_t length) override;
+
+    // Like the nRF52840: reads can go straight to the (emulated) flash
+    const uint8_t* mapped() const override { return contents.data(); }
+
+    void failAfter(uint32_t operations);
+    bool powerLost() const { return lost; }
+
+    // Page erases + programmed words since open()
+    uint32_t operationCount() const { return operations; }
+
+private:
+    std::string path;
+    uint32_t flashPageSize;
+    std::vector<uint8_t> contents;
+    uint32_t operations;
+    uint32_t budget;  // Operations left before the power cut (UINT32_MAX = never)
+    bool lost;
+
+    bool inRange(uint32_t offset, uint32_t length) const;
+    bool consumeOperation();
+    bool writeThrough(uint32_t offset, uint32_t length);
+};
+
+#endif // FILE_FLASH_H
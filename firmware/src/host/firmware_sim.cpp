@@ -0,0 +1,446 @@
+#include "firmware_sim.h"
+#include <algorithm>
+#include <ctype.h>
+#include "config.h"
+#include "flash_storage.h"
+#include "simple_nn.h"
+
+// Thrown out of delay() when the firmware spins past the end of the run
+struct FirmwareStalled {};
+
+// ============================================================================
+// Script Building
+// ============================================================================
+
+FirmwareSimulator::FirmwareSimulator() {}
+
+FirmwareSimulator::~FirmwareSimulator() {
+    BLE.hostSetPollHandler(nullptr, nullptr);
+    BLE.hostSetNotifyHandler(nullptr, nullptr);
+    hostSetDelayHook(nullptr, nullptr);
+}
+
+void FirmwareSimulator::schedule(const Event& event) {
+    // Insert after every event at the same time so script order is kept
+    auto position = std::upper_bound(
+        _events.begin() + _nextEvent, _events.end(), event,
+        [](const Event& a, const Event& b) { return a.timeUs < b.timeUs; });
+    _events.insert(position, event);
+}
+
+void FirmwareSimulator::connect(uint32_t timeMs, const char* address) {
+    Event event = {(uint64_t)timeMs * 1000, EVENT_CONNECT, nullptr, address, {}};
+    schedule(event);
+}
+
+void FirmwareSimulator::disconnect(uint32_t timeMs) {
+    Event event = {(uint64_t)timeMs * 1000, EVENT_DISCONNECT, nullptr, "", {}};
+    schedule(event);
+}
+
+void FirmwareSimulator::write(uint32_t timeMs, const char* uuid, const uint8_t* data, int length) {
+    Event event = {(uint64_t)timeMs * 1000, EVENT_WRITE, uuid, "",
+                   std::vector<uint8_t>(data, data + length)};
+    schedule(event);
+}
+
+void FirmwareSimulator::read(uint32_t timeMs, const char* uuid) {
+    Event event = {(uint64_t)timeMs * 1000, EVENT_READ, uuid, "", {}};
+    schedule(event);
+}
+
+void FirmwareSimulator::end(uint32_t timeMs) {
+    Event event = {(uint64_t)timeMs * 1000, EVENT_END, nullptr, "", {}};
+    schedule(event);
+}
+
+static void putU32LE(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+// START: [cmd, size u32, crc32 u32, numClasses, labels\0...] as the web app sends it
+static std::vector<uint8_t> buildStart(const uint8_t* model, size_t length) {
+    uint32_t numClasses = 0;
+    if (length >= 2 * sizeof(uint32_t)) {
+        memcpy(&numClasses, &model[4], sizeof(numClasses));
+    }
+    if (numClasses > NN_MAX_CLASSES) {
+        numClasses = NN_MAX_CLASSES;
+    }
+
+    std::vector<uint8_t> start(10, 0);
+    start[0] = 0x01;
+    putU32LE(&start[1], (uint32_t)length);
+    putU32LE(&start[5], calculateCrc32(model, length));
+    start[9] = (uint8_t)numClasses;
+    if (length >= sizeof(SimpleNNModel)) {
+        const SimpleNNModel* header = (const SimpleNNModel*)model;
+        for (uint32_t i = 0; i < numClasses; i++) {
+            const size_t labelLength = strnlen(header->labels[i], LABEL_MAX_LEN - 1);
+            start.insert(start.end(), header->labels[i], header->labels[i] + labelLength);
+            start.push_back(0);
+        }
+    }
+    return start;
+}
+
+uint32_t FirmwareSimulator::upload(uint32_t timeMs, const uint8_t* model, size_t length,
+                                   uint32_t intervalMs) {
+    const std::vector<uint8_t> start = buildStart(model, length);
+    const char* uploadUuid = MODEL_UPLOAD_UUID;
+    write(timeMs, uploadUuid, start.data(), (int)start.size());
+    timeMs += SIM_UPLOAD_START_SETTLE_MS;
+
+    // CHUNK: [cmd, offset u32, data...]
+    const size_t dataPerWrite = SIM_UPLOAD_WRITE_SIZE - 5;
+    uint8_t chunk[SIM_UPLOAD_WRITE_SIZE];
+    for (size_t offset = 0; offset < length; offset += dataPerWrite) {
+        const size_t chunkLength = std::min(dataPerWrite, length - offset);
+        chunk[0] = 0x02;
+        putU32LE(&chunk[1], (uint32_t)offset);
+        memcpy(&chunk[5], &model[offset], chunkLength);
+        write(timeMs, uploadUuid, chunk, (int)(5 + chunkLength));
+        timeMs += intervalMs;
+    }
+
+    // FINISH
+    const uint8_t finish = 0x03;
+    write(timeMs, uploadUuid, &finish, 1);
+    return timeMs;
+}
+
+void FirmwareSimulator::creditUpload(uint32_t timeMs, const uint8_t* model, size_t length,
+                                     int writeSize) {
+    const std::vector<uint8_t> start = buildStart(model, length);
+    write(timeMs, MODEL_UPLOAD_UUID, start.data(), (int)start.size());
+
+    // Aligned like the web app's, so a resend could land out of order
+    const size_t dataPerWrite =
+        (size_t)(writeSize - 5) / MODEL_UPLOAD_BLOCK_SIZE * MODEL_UPLOAD_BLOCK_SIZE;
+    _credit = CreditUpload();
+    for (size_t offset = 0; offset < length; offset += dataPerWrite) {
+        const size_t chunkLength = std::min(dataPerWrite, length - offset);
+        std::vector<uint8_t> chunk(5 + chunkLength);
+        chunk[0] = 0x02;
+        putU32LE(&chunk[1], (uint32_t)offset);
+        memcpy(&chunk[5], &model[offset], chunkLength);
+        _credit.writes.push_back(chunk);
+    }
+    _credit.writes.push_back(std::vector<uint8_t>(1, 0x03));  // FINISH
+    _credit.nextEventUs = (uint64_t)(timeMs + SIM_UPLOAD_START_SETTLE_MS) * 1000;
+}
+
+// ============================================================================
+// Script Files
+// ============================================================================
+
+const char* FirmwareSimulator::resolveCharacteristic(const char* name) {
+    static const struct {
+        const char* name;
+        const char* uuid;
+    } names[] = {
+        {"mode", MODE_CHAR_UUID},
+        {"sensor", SENSOR_CHAR_UUID},
+        {"inference", INFERENCE_CHAR_UUID},
+        {"info", DEVICE_INFO_UUID},
+        {"config", CONFIG_CHAR_UUID},
+        {"upload", MODEL_UPLOAD_UUID},
+        {"status", MODEL_STATUS_UUID},
+        {"diagnostics", DIAGNOSTICS_UUID},
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i].name) == 0 || strcasecmp(name, names[i].uuid) == 0) {
+            return names[i].uuid;
+        }
+    }
+    return nullptr;
+}
+
+static bool parseHex(const char* text, std::vector<uint8_t>* bytes) {
+    int nibbles = 0;
+    uint8_t current = 0;
+    for (const char* p = text; *p != '\0'; p++) {
+        if (isspace((unsigned char)*p)) {
+            continue;
+        }
+        if (!isxdigit((unsigned char)*p)) {
+            return false;
+        }
+        const uint8_t nibble = (uint8_t)(isdigit((unsigned char)*p) ? *p - '0'
+                                                                    : tolower((unsigned char)*p) - 'a' + 10);
+        current = (uint8_t)((current << 4) | nibble);
+        if (++nibbles % 2 == 0) {
+            bytes->push_back(current);
+            current = 0;
+        }
+    }
+    return nibbles > 0 && nibbles % 2 == 0;
+}
+
+static bool readFile(const std::string& path, std::vector<uint8_t>* bytes) {
+    FILE* file = fopen(path.c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t count;
+    while ((count = fread(buffer, 1, sizeof(buffer), file)) > 0) {
+        bytes->insert(bytes->end(), buffer, buffer + count);
+    }
+    fclose(file);
+    return true;
+}
+
+bool FirmwareSimulator::loadScript(const char* path, std::string* error) {
+    FILE* file = fopen(path, "r");
+    if (file == nullptr) {
+        *error = std::string("cannot open script ") + path;
+        return false;
+    }
+
+    // Model files are looked up relative to the script
+    std::string directory(path);
+    const size_t slash = directory.find_last_of('/');
+    directory = slash == std::string::npos ? "" : directory.substr(0, slash + 1);
+
+    char line[1024];
+    int lineNumber = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), file) != nullptr) {
+        lineNumber++;
+        char command[32] = "";
+        char argument[sizeof(line)] = "";
+        unsigned long timeMs;
+        int consumed = 0;
+
+        const char* text = line;
+        while (isspace((unsigned char)*text)) text++;
+        if (*text == '\0' || *text == '#') {
+            continue;
+        }
+        if (sscanf(text, "%lu %31s %n", &timeMs, command, &consumed) < 2) {
+            ok = false;
+        } else {
+            strncpy(argument, text + consumed, sizeof(argument) - 1);
+            argument[strcspn(argument, "\r\n")] = '\0';
+        }
+
+        if (!ok) {
+            // Fall through to the error below
+        } else if (strcmp(command, "connect") == 0) {
+            connect(timeMs, argument[0] != '\0' ? argument : "SIM-CENTRAL");
+        } else if (strcmp(command, "disconnect") == 0) {
+            disconnect(timeMs);
+        } else if (strcmp(command, "end") == 0) {
+            end(timeMs);
+        } else if (strcmp(command, "write") == 0 || strcmp(command, "read") == 0) {
+            char name[64] = "";
+            int nameLength = 0;
+            sscanf(argument, "%63s %n", name, &nameLength);
+            const char* uuid = resolveCharacteristic(name);
+            std::vector<uint8_t> bytes;
+            if (uuid == nullptr) {
+                ok = false;
+            } else if (command[0] == 'r') {
+                read(timeMs, uuid);
+            } else if (parseHex(argument + nameLength, &bytes)) {
+                write(timeMs, uuid, bytes.data(), (int)bytes.size());
+            } else {
+                ok = false;
+            }
+        } else if (strcmp(command, "upload") == 0) {
+            char modelPath[512] = "";
+            unsigned long intervalMs = SIM_UPLOAD_INTERVAL_MS;
+            sscanf(argument, "%511s %lu", modelPath, &intervalMs);
+            std::string resolved = modelPath[0] == '/' ? modelPath : directory + modelPath;
+            std::vector<uint8_t> model;
+            if (!readFile(resolved, &model) && !readFile(modelPath, &model)) {
+                *error = "cannot read model " + resolved;
+                fclose(file);
+                return false;
+            }
+            upload(timeMs, model.data(), model.size(), intervalMs);
+        } else {
+            ok = false;
+        }
+
+        if (!ok) {
+            char message[64];
+            snprintf(message, sizeof(message), "%s:%d: ", path, lineNumber);
+            *error = message + std::string(text);
+            error->erase(error->find_last_not_of("\r\n") + 1);
+        }
+    }
+    fclose(file);
+    return ok;
+}
+
+// ============================================================================
+// Run
+// ============================================================================
+
+bool FirmwareSimulator::apply(const Event& event) {
+    switch (event.type) {
+        case EVENT_CONNECT:
+            // Not advertising yet (still in setup) → retry on the next poll
+            return BLE.hostConnected() || BLE.hostConnect(event.address.c_str());
+
+        case EVENT_DISCONNECT:
+            BLE.hostDisconnect();
+            return true;
+
+        case EVENT_WRITE: {
+            BLECharacteristic* characteristic = BLE.hostFindCharacteristic(event.uuid);
+            if (BLE.hostConnected() && characteristic != nullptr &&
+                !characteristic->hostWrite(event.data.data(), (int)event.data.size())) {
+                _lostWrites++;
+            }
+            return true;
+        }
+
+        case EVENT_READ: {
+            BLECharacteristic* characteristic = BLE.hostFindCharacteristic(event.uuid);
+            if (characteristic != nullptr && _recording) {
+                SimRecord record = {hostMicros64() - _startUs, characteristic->uuid(), true,
+                                    std::vector<uint8_t>(characteristic->value(),
+                                                         characteristic->value() +
+                                                             characteristic->valueLength())};
+                _records.push_back(record);
+            }
+            return true;
+        }
+
+        case EVENT_END:
+            _ended = true;
+            BLE.hostDisconnect();
+            return true;
+    }
+    return true;
+}
+
+// Connection events the firmware slept through are caught up in one poll;
+// each still carries at most SIM_LINK_WRITES_PER_EVENT writes
+void FirmwareSimulator::sendCreditWrites(uint64_t now) {
+    CreditUpload& credit = _credit;
+    BLECharacteristic* characteristic = BLE.hostFindCharacteristic(MODEL_UPLOAD_UUID);
+    while (credit.next < credit.writes.size() && _startUs + credit.nextEventUs <= now &&
+           BLE.hostConnected() && characteristic != nullptr) {
+        // What the central knows at this event: notifications sent before it
+        credit.seenCredits = credit.credits;
+        credit.seenDone = credit.done;
+        credit.nextEventUs += SIM_CONNECTION_INTERVAL_US;
+
+        for (int i = 0; i < SIM_LINK_WRITES_PER_EVENT && credit.next < credit.writes.size(); i++) {
+            const uint16_t inFlight = (uint16_t)(credit.sent - credit.seenDone);
+            if (inFlight >= credit.seenCredits) {
+                break;
+            }
+            const std::vector<uint8_t>& data = credit.writes[credit.next++];
+            if (!characteristic->hostWrite(data.data(), (int)data.size())) {
+                _lostWrites++;
+            }
+            credit.sent++;
+            credit.maxInFlight = std::max(credit.maxInFlight, (uint32_t)inFlight + 1);
+            if (credit.next == credit.writes.size()) {
+                credit.finishUs = now - _startUs;
+            }
+        }
+    }
+}
+
+void FirmwareSimulator::deliverDueEvents() {
+    const uint64_t now = hostMicros64();
+    while (_nextEvent < _events.size() && _startUs + _events[_nextEvent].timeUs <= now) {
+        if (!apply(_events[_nextEvent])) {
+            break;
+        }
+        _nextEvent++;
+    }
+    sendCreditWrites(now);
+    if (now >= _endUs) {
+        _ended = true;
+        BLE.hostDisconnect();
+    }
+}
+
+void FirmwareSimulator::onPoll(void* context) {
+    ((FirmwareSimulator*)context)->deliverDueEvents();
+}
+
+void FirmwareSimulator::onNotify(void* context, const BLECharacteristic& characteristic,
+                                 const uint8_t* data, int length) {
+    FirmwareSimulator* sim = (FirmwareSimulator*)context;
+
+    Count* count = nullptr;
+    for (size_t i = 0; i < sim->_counts.size(); i++) {
+        if (sim->_counts[i].uuid == characteristic.uuid()) {
+            count = &sim->_counts[i];
+        }
+    }
+    if (count == nullptr) {
+        sim->_counts.push_back({characteristic.uuid(), 0});
+        count = &sim->_counts.back();
+    }
+    count->notifications++;
+
+    // Credit trailer after the ranges: [credits, reserved, writesDone u16]
+    if (strcmp(characteristic.uuid(), MODEL_STATUS_UUID) == 0 && length >= 4) {
+        const int trailer = 4 + 8 * data[3];
+        if (length >= trailer + 4) {
+            sim->_credit.credits = data[trailer];
+            sim->_credit.done = (uint16_t)(data[trailer + 2] | (data[trailer + 3] << 8));
+        }
+    }
+
+    if (sim->_recording) {
+        SimRecord record = {hostMicros64() - sim->_startUs, characteristic.uuid(), false,
+                            std::vector<uint8_t>(data, data + length)};
+        sim->_records.push_back(record);
+    }
+}
+
+void FirmwareSimulator::onDelay(void* context) {
+    FirmwareSimulator* sim = (FirmwareSimulator*)context;
+    if (hostMicros64() > sim->_endUs + (uint64_t)SIM_STALL_GRACE_MS * 1000) {
+        throw FirmwareStalled();
+    }
+}
+
+uint32_t FirmwareSimulator::notificationCount(const char* uuid) const {
+    for (size_t i = 0; i < _counts.size(); i++) {
+        if (strcmp(_counts[i].uuid, uuid) == 0) {
+            return _counts[i].notifications;
+        }
+    }
+    return 0;
+}
+
+bool FirmwareSimulator::run(uint32_t maxDurationMs) {
+    _startUs = hostMicros64();
+    _endUs = _startUs + (uint64_t)maxDurationMs * 1000;
+    _nextEvent = 0;
+    _ended = false;
+
+    BLE.hostSetPollHandler(onPoll, this);
+    BLE.hostSetNotifyHandler(onNotify, this);
+    hostSetDelayHook(onDelay, this);
+
+    bool completed = true;
+    try {
+        setup();
+        while (!_ended) {
+            loop();
+        }
+    } catch (const FirmwareStalled&) {
+        completed = false;
+    }
+
+    BLE.hostDisconnect();
+    BLE.hostSetPollHandler(nullptr, nullptr);
+    BLE.hostSetNotifyHandler(nullptr, nullptr);
+    hostSetDelayHook(nullptr, nullptr);
+    return completed;
+}
@@ -0,0 +1,151 @@
+#ifndef FIRMWARE_SIM_H
+#define FIRMWARE_SIM_H
+
+#include <string>
+#include <vector>
+#include "Arduino.h"
+#include "ArduinoBLE.h"
+
+// ============================================================================
+// Host Firmware Simulator
+// ============================================================================
+//
+// Runs the real setup()/loop() from main.cpp on Linux in virtual time. A
+// scripted central connects, writes characteristics (mode, config, model
+// upload chunks, ...) at given times and records every notification the
+// firmware sends. Sensor data comes from createSensorReader() on the host
+// (replay file or synthetic gesture, see sensor_host.h).
+//
+// Virtual time only advances through the firmware's own delay() calls, so
+// an hour of device time typically simulates in a few seconds.
+//
+// Script files hold one event per line, "<time_ms> <command> [args]":
+//   connect [address]          Central connects (waits for advertising)
+//   disconnect
+//   write <char> <hex bytes>   e.g. "1500 write mode 01"
+//   read <char>                Record the characteristic's current value
+//   upload <model.bin> [ms]    Web-app style START / CHUNK... / FINISH,
+//                              one write every [ms] (default 8)
+//   end                        Stop the run here
+// <char> is mode, sensor, inference, info, config, upload, status or a full
+// UUID. Blank lines and lines starting with '#' are ignored.
+// ============================================================================
+
+// Firmware entry points (main.cpp)
+void setup();
+void loop();
+
+#define SIM_UPLOAD_WRITE_SIZE 160      // Web app MAX_CHUNK_SIZE (5-byte header + data)
+#define SIM_UPLOAD_INTERVAL_MS 8       // One write-with-response per connection event
+#define SIM_UPLOAD_START_SETTLE_MS 300 // Web app waits this long after START
+#define SIM_STALL_GRACE_MS 10000       // Firmware stuck this long past the end → abort
+
+// Credit-driven uploads (writes without response): the central writes only
+// at connection events, at most SIM_LINK_WRITES_PER_EVENT per event, and
+// sees status notifications from the event after they are sent
+#define SIM_CONNECTION_INTERVAL_US 7500
+#define SIM_LINK_WRITES_PER_EVENT 4
+
+// One notification from the firmware, or a scripted read of a value
+struct SimRecord {
+    uint64_t timeUs;
+    const char* uuid;
+    bool isRead;
+    std::vector<uint8_t> data;
+};
+
+class FirmwareSimulator {
+public:
+    FirmwareSimulator();
+    ~FirmwareSimulator();
+
+    // ------------------------------------------------------------------
+    // Script (times in ms of virtual time from the start of run())
+    // ------------------------------------------------------------------
+    void connect(uint32_t timeMs, const char* address = "SIM-CENTRAL");
+    void disconnect(uint32_t timeMs);
+    void write(uint32_t timeMs, const char* uuid, const uint8_t* data, int length);
+    void read(uint32_t timeMs, const char* uuid);
+    // Returns the time of the FINISH write
+    uint32_t upload(uint32_t timeMs, const uint8_t* model, size_t length,
+                    uint32_t intervalMs = SIM_UPLOAD_INTERVAL_MS);
+    // START, then block-aligned CHUNKs and FINISH pipelined as fast as the
+    // link and the credits in model status notifications allow (one upload
+    // per run)
+    void creditUpload(uint32_t timeMs, const uint8_t* model, size_t length,
+                      int writeSize = SIM_UPLOAD_WRITE_SIZE);
+    void end(uint32_t timeMs);
+
+    bool loadScript(const char* path, std::string* error);
+
+    // Characteristic name ("mode", "config", ...) or UUID → UUID; nullptr if unknown
+    static const char* resolveCharacteristic(const char* name);
+
+    // ------------------------------------------------------------------
+    // Run
+    // ------------------------------------------------------------------
+    // setup(), then loop() until the script ends (or maxDurationMs passes).
+    // Returns false if the firmware never got back to loop() in time.
+    bool run(uint32_t maxDurationMs);
+
+    void setRecording(bool enabled) { _recording = enabled; }
+    const std::vector<SimRecord>& records() const { return _records; }
+    uint32_t notificationCount(const char* uuid) const;
+    uint32_t lostWrites() const { return _lostWrites; }
+    // Credit upload: most writes ever in flight, and when FINISH went out
+    uint32_t maxWritesInFlight() const { return _credit.maxInFlight; }
+    uint64_t creditFinishUs() const { return _credit.finishUs; }
+    uint64_t elapsedUs() const { return hostMicros64() - _startUs; }
+
+private:
+    enum EventType { EVENT_CONNECT, EVENT_DISCONNECT, EVENT_WRITE, EVENT_READ, EVENT_END };
+
+    struct Event {
+        uint64_t timeUs;
+        EventType type;
+        const char* uuid;
+        std::string address;
+        std::vector<uint8_t> data;
+    };
+
+    struct Count {
+        const char* uuid;
+        uint32_t notifications;
+    };
+
+    struct CreditUpload {
+        std::vector<std::vector<uint8_t>> writes;  // After START
+        size_t next = 0;
+        uint64_t nextEventUs = 0;   // Next connection event
+        uint16_t sent = 0;
+        uint16_t done = 0;          // From the status trailer
+        uint16_t seenDone = 0;      // As of the last connection event
+        uint8_t credits = 0;
+        uint8_t seenCredits = 0;
+        uint32_t maxInFlight = 0;
+        uint64_t finishUs = 0;
+    };
+
+    void schedule(const Event& event);
+    void deliverDueEvents();
+    void sendCreditWrites(uint64_t now);
+    bool apply(const Event& event);
+
+    static void onPoll(void* context);
+    static void onNotify(void* context, const BLECharacteristic& characteristic,
+                         const uint8_t* data, int length);
+    static void onDelay(void* context);
+
+    std::vector<Event> _events;  // Sorted by time, stable for equal times
+    size_t _nextEvent = 0;
+    std::vector<SimRecord> _records;
+    std::vector<Count> _counts;
+    bool _recording = true;
+    bool _ended = false;
+    uint32_t _lostWrites = 0;
+    CreditUpload _credit;
+    uint64_t _startUs = 0;
+    uint64_t _endUs = 0;
+};
+
+#endif // FIRMWARE_SIM_H
@@ -0,0 +1,110 @@
+#ifdef HOST_SIMULATOR
+
+// ============================================================================
+// Firmware Simulator CLI (pio run -e native_sim)
+// ============================================================================
+//
+//   program <script> [--replay file] [--gesture name] [--duration ms]
+//           [--log file.csv] [--verbose]
+//
+// Runs setup()/loop() against the script (see firmware_sim.h) and prints a
+// summary; --log writes every notification and scripted read as
+// "time_ms,uuid,kind,hex".
+// ============================================================================
+
+#include <chrono>
+#include "config.h"
+#include "firmware_sim.h"
+
+static void usage(const char* program) {
+    fprintf(stderr,
+            "usage: %s <script> [--replay file] [--gesture idle|wave|shake|circle]\n"
+            "          [--duration ms] [--log file.csv] [--verbose]\n",
+            program);
+}
+
+static void writeLog(const char* path, const std::vector<SimRecord>& records) {
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "cannot write %s\n", path);
+        return;
+    }
+    fprintf(file, "time_ms,uuid,kind,hex\n");
+    for (size_t i = 0; i < records.size(); i++) {
+        const SimRecord& record = records[i];
+        fprintf(file, "%.3f,%s,%s,", record.timeUs / 1000.0, record.uuid,
+                record.isRead ? "read" : "notify");
+        for (size_t b = 0; b < record.data.size(); b++) {
+            fprintf(file, "%02X", record.data[b]);
+        }
+        fprintf(file, "\n");
+    }
+    fclose(file);
+}
+
+int main(int argc, char** argv) {
+    const char* scriptPath = nullptr;
+    const char* logPath = nullptr;
+    unsigned long durationMs = 3600000UL;  // One hour of device time
+    bool verbose = false;
+
+    for (int i = 1; i < argc; i++) {
+        const bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--replay") == 0 && hasValue) {
+            setenv("SEVERN_REPLAY_FILE", argv[++i], 1);
+        } else if (strcmp(argv[i], "--gesture") == 0 && hasValue) {
+            setenv("SEVERN_SYNTH_GESTURE", argv[++i], 1);
+        } else if (strcmp(argv[i], "--duration") == 0 && hasValue) {
+            durationMs = strtoul(argv[++i], nullptr, 10);
+        } else if (strcmp(argv[i], "--log") == 0 && hasValue) {
+            logPath = argv[++i];
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            verbose = true;
+        } else if (argv[i][0] != '-' && scriptPath == nullptr) {
+            scriptPath = argv[i];
+        } else {
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (scriptPath == nullptr) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    FirmwareSimulator sim;
+    std::string error;
+    if (!sim.loadScript(scriptPath, &error)) {
+        fprintf(stderr, "%s\n", error.c_str());
+        return 2;
+    }
+    sim.setRecording(logPath != nullptr);
+    if (!verbose) {
+        Serial.setOutput(nullptr);
+    }
+
+    const auto wallStart = std::chrono::steady_clock::now();
+    const bool completed = sim.run((uint32_t)durationMs);
+    const double wallSeconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - wallStart).count();
+    const double virtualSeconds = sim.elapsedUs() / 1e6;
+
+    printf("Virtual time:   %.1f s\n", virtualSeconds);
+    printf("Wall time:      %.3f s (%.0fx real time)\n", wallSeconds,
+           wallSeconds > 0 ? virtualSeconds / wallSeconds : 0.0);
+    printf("Notifications:  sensor=%u inference=%u status=%u\n",
+           sim.notificationCount(SENSOR_CHAR_UUID), sim.notificationCount(INFERENCE_CHAR_UUID),
+           sim.notificationCount(MODEL_STATUS_UUID));
+    printf("Lost writes:    %u\n", sim.lostWrites());
+
+    if (logPath != nullptr) {
+        writeLog(logPath, sim.records());
+    }
+    if (!completed) {
+        fprintf(stderr, "Firmware stalled (halted in setup or never returned from loop)\n");
+        return 1;
+    }
+    return 0;
+}
+
+#endif // HOST_SIMULATOR
@@ -0,0 +1,81 @@
+#ifndef TEST_MODELS_H
+#define TEST_MODELS_H
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "flash_storage.h"
+
+// ============================================================================
+// Test Model Fixtures
+// ============================================================================
+//
+// The models the native test suites upload, encode and run. Weights come
+// from rand() seeded with `seed`, uniform in [-limit, limit] (limit 0: all
+// zero), for the used classes only; everything else stays zero, like a
+// model the web app exports. Labels are "Gesture<n>" unless given. Extra
+// head h has 2 + h classes labelled "H<h>C<c>".
+// ============================================================================
+
+// Glorot-uniform limit of the 600→32 hidden layer: spread like a freshly
+// initialised model, which is close to what training leaves behind
+#define TEST_MODEL_GLOROT_LIMIT sqrtf(6.0f / (NN_INPUT_SIZE + NN_HIDDEN_SIZE))
+
+inline void fillTestWeights(float* values, uint32_t count, float limit) {
+    for (uint32_t i = 0; i < count; i++) {
+        values[i] = limit * (2.0f * (float)rand() / (float)RAND_MAX - 1.0f);
+    }
+}
+
+/**
+ * Primary head only, in the SimpleNNModel the firmware runs from
+ */
+inline void buildTestModel(SimpleNNModel& model, uint32_t numClasses, unsigned seed,
+                           float limit = 1.0f, const char* const* labels = nullptr) {
+    memset(&model, 0, sizeof(model));
+    srand(seed);
+    model.magic = SIMPLE_NN_MAGIC;
+    model.numClasses = numClasses;
+    model.inputSize = NN_INPUT_SIZE;
+    model.hiddenSize = NN_HIDDEN_SIZE;
+    fillTestWeights(model.hiddenWeights, NN_HIDDEN_SIZE * NN_INPUT_SIZE, limit);
+    fillTestWeights(model.hiddenBias, NN_HIDDEN_SIZE, limit);
+    fillTestWeights(model.outputWeights, numClasses * NN_HIDDEN_SIZE, limit);
+    fillTestWeights(model.outputBias, numClasses, limit);
+    for (uint32_t c = 0; c < numClasses; c++) {
+        if (labels != nullptr) {
+            snprintf(model.labels[c], LABEL_MAX_LEN, "%s", labels[c]);
+        } else {
+            snprintf(model.labels[c], LABEL_MAX_LEN, "Gesture%c", (char)('0' + c));
+        }
+    }
+}
+
+/**
+ * Primary head plus numExtraHeads extra heads
+ * @return Stored size (sizeof(SimpleNNModel) without extra heads)
+ */
+inline uint32_t buildTestModel(StoredModelData& model, uint32_t numClasses,
+                               uint32_t numExtraHeads, unsigned seed, float limit = 1.0f) {
+    memset(&model, 0, sizeof(model));
+    buildTestModel(model.model, numClasses, seed, limit);
+    if (numExtraHeads == 0) {
+        return sizeof(SimpleNNModel);
+    }
+
+    model.extraHeads.magic = SIMPLE_NN_HEADS_MAGIC;
+    model.extraHeads.numExtraHeads = numExtraHeads;
+    for (uint32_t h = 0; h < numExtraHeads; h++) {
+        SimpleNNHead& head = model.extraHeads.heads[h];
+        head.numClasses = 2 + h;
+        fillTestWeights(head.outputWeights, head.numClasses * NN_HIDDEN_SIZE, limit);
+        fillTestWeights(head.outputBias, head.numClasses, limit);
+        for (uint32_t c = 0; c < head.numClasses; c++) {
+            snprintf(head.labels[c], LABEL_MAX_LEN, "H%hhuC%hhu", (uint8_t)h, (uint8_t)c);
+        }
+    }
+    return SIMPLE_NN_UPLOAD_SIZE(numExtraHeads);
+}
+
+#endif // TEST_MODELS_H
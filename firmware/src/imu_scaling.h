@@ -0,0 +1,53 @@
+#ifndef IMU_SCALING_H
+#define IMU_SCALING_H
+
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================================
+// Integer Raw-Register Scaling
+// ============================================================================
+//
+// Both IMUs run at ±4 g and ±2000 dps, and the Arduino libraries convert
+// their raw output as raw * 4/32768 g and raw * 2000/32768 dps. The packet
+// convention is g * ACCEL_SCALE and dps * GYRO_SCALE, so going through float
+// and back is pure overhead:
+//
+//   accel: raw * (4/32768) * 8192   = raw                    (identity)
+//   gyro:  raw * (2000/32768) * 16.4 = raw * 1025 / 1024     (exact)
+//
+// Results are truncated toward zero and clamped to int16, matching the float
+// scaleAccel()/scaleGyro() path.
+// ============================================================================
+
+static_assert(ACCEL_SCALE == 8192.0f && GYRO_SCALE == 16.4f,
+              "Integer IMU scaling assumes ACCEL_SCALE 8192 and GYRO_SCALE 16.4");
+
+inline int16_t scaleRawAccel(int16_t raw) {
+    return raw;
+}
+
+inline int16_t scaleRawGyro(int16_t raw) {
+    const int32_t scaled = ((int32_t)raw * 1025) / 1024;
+    if (scaled > 32767) return 32767;
+    if (scaled < -32768) return -32768;
+    return (int16_t)scaled;
+}
+
+// Little-endian int16 as laid out in both chips' output registers
+inline int16_t readImuInt16LE(const uint8_t* bytes) {
+    return (int16_t)((uint16_t)bytes[0] | ((uint16_t)bytes[1] << 8));
+}
+
+/**
+ * Scale one accel + gyro sample to the packet convention.
+ * out = [ax, ay, az, gx, gy, gz]
+ */
+inline void scaleRawImu(const int16_t acc[3], const int16_t gyr[3], int16_t out[6]) {
+    for (int axis = 0; axis < 3; axis++) {
+        out[axis] = scaleRawAccel(acc[axis]);
+        out[3 + axis] = scaleRawGyro(gyr[axis]);
+    }
+}
+
+#endif // IMU_SCALING_H
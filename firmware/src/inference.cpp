@@ -18,6 +18,7 @@
 #include "inference.h"
 #include "flash_storage.h"
 #include "inference_features.h"
+#include "profiler.h"
 #include "simple_nn.h"
 
 // ============================================================================
@@ -35,28 +36,22 @@ static int sampleIndex = 0;
 // ============================================================================
 static SimpleNN neuralNetwork;
 
+// Extra head results from the last window (index 0 unused: primary head is
+// returned directly by runInference)
+static int headPredictions[NN_MAX_HEADS];
+static float headConfidences[NN_MAX_HEADS];
+
+static uint32_t lastNetworkMicros = 0;
+
 // ============================================================================
 // Motion Heuristics (for stable Idle behavior in classroom use)
 // ============================================================================
-static bool equalsIgnoreCase(const char* a, const char* b) {
-    while (*a && *b) {
-        char ca = *a;
-        char cb = *b;
-        if (ca >= 'A' && ca <= 'Z') ca = (char)(ca + ('a' - 'A'));
-        if (cb >= 'A' && cb <= 'Z') cb = (char)(cb + ('a' - 'A'));
-        if (ca != cb) return false;
-        a++;
-        b++;
-    }
-    return *a == '\0' && *b == '\0';
-}
-
 static int findIdleClassIndex() {
     if (!neuralNetwork.isModelLoaded()) return -1;
 
     uint32_t numClasses = neuralNetwork.getNumClasses();
     for (uint32_t i = 0; i < numClasses; i++) {
-        if (equalsIgnoreCase(neuralNetwork.getLabel(i), "Idle")) {
+        if (isIdleLabel(neuralNetwork.getLabel(i))) {
             return (int)i;
         }
     }
@@ -95,7 +90,7 @@ bool reloadModel() {
         return false;
     }
 
-    if (!neuralNetwork.loadModel(modelData)) {
+    if (!neuralNetwork.loadModel(modelData, getStoredExtraHeads())) {
         DEBUG_PRINTLN("Failed to load model into SimpleNN");
         return false;
     }
@@ -111,10 +106,20 @@ bool reloadModel() {
         DEBUG_PRINT(": ");
         DEBUG_PRINTLN(neuralNetwork.getLabel(i));
     }
+    for (uint8_t h = 1; h < neuralNetwork.getNumHeads(); h++) {
+        DEBUG_PRINT("  Head ");
+        DEBUG_PRINT(h);
+        DEBUG_PRINT(" classes: ");
+        DEBUG_PRINTLN(neuralNetwork.getHeadNumClasses(h));
+    }
 
     return true;
 }
 
+void unloadModel() {
+    neuralNetwork.unloadModel();
+}
+
 bool isModelLoaded() {
     return neuralNetwork.isModelLoaded();
 }
@@ -124,6 +129,7 @@ bool isModelLoaded() {
 // ============================================================================
 
 void addSample(int16_t ax, int16_t ay, int16_t az, int16_t gx, int16_t gy, int16_t gz) {
+    PROFILE_SCOPE(PROFILE_ADD_SAMPLE);
     if (sampleIndex < WINDOW_SIZE) {
         // Step 1: Convert from raw int16 to physical units (same as web app's bleParser.ts)
         //   Accel: raw / 8192 = g units
@@ -161,6 +167,7 @@ void resetInferenceWindow() {
 // ============================================================================
 
 int runInference(float* confidence) {
+    PROFILE_SCOPE(PROFILE_RUN_INFERENCE);
     if (!isWindowReady()) {
         *confidence = 0.0f;
         return -1;
@@ -180,13 +187,10 @@ int runInference(float* confidence) {
     // ========================================================================
     // The neural network expects a flat array of 600 values:
     //   [ax0, ay0, az0, gx0, gy0, gz0, ax1, ay1, az1, gx1, ...]
+    // A C 2D array is stored row after row, so sampleBuffer already IS that
+    // array in memory - no 2.4 KB copy on the stack needed.
     // ========================================================================
-    float flatInput[WINDOW_SIZE * 6];
-    for (int i = 0; i < WINDOW_SIZE; i++) {
-        for (int j = 0; j < 6; j++) {
-            flatInput[i * 6 + j] = sampleBuffer[i][j];
-        }
-    }
+    const float* flatInput = &sampleBuffer[0][0];
 
     // ========================================================================
     // RUN THE NEURAL NETWORK
@@ -198,37 +202,30 @@ int runInference(float* confidence) {
     //   4. Apply softmax to get probabilities
     //   5. Return the class with highest probability
     // ========================================================================
+    const uint32_t networkStartUs = micros();
     float probabilities[NN_MAX_CLASSES];
     int prediction = neuralNetwork.predict(flatInput, probabilities);
     
     *confidence = neuralNetwork.getLastConfidence();
 
-    // If an Idle class exists and motion is very low, stabilize toward Idle.
-    // IMPORTANT: only override a non-Idle prediction when model confidence is low,
-    // otherwise we can suppress real gestures (e.g., Shake) too aggressively.
+    // ========================================================================
+    // EXTRA HEADS (multi-head models only)
+    // ========================================================================
+    // The hidden layer computed above is shared: each extra head is just
+    // one small 32 × N layer plus softmax on the same activations.
+    // ========================================================================
+    for (uint8_t h = 1; h < neuralNetwork.getNumHeads(); h++) {
+        float headProbabilities[NN_MAX_CLASSES];
+        headPredictions[h] = neuralNetwork.predictHead(h, headProbabilities, &headConfidences[h]);
+    }
+    lastNetworkMicros = micros() - networkStartUs;
+
+    // If an Idle class exists and motion is very low, stabilize toward Idle
+    // (see applyIdleOverride for the thresholds).
     int idleClass = findIdleClassIndex();
     if (idleClass >= 0) {
         const float motionScore = estimateMotionScoreFromWindow(sampleBuffer, sampleIndex);
-        // Handheld "still" is noisier than a table-resting board.
-        const float stillThreshold = MOTION_STILL_THRESHOLD;
-        const float lowConfidenceThreshold = 0.60f;
-
-        if (motionScore < stillThreshold) {
-            // Confidence we report when we trust stillness.
-            float stillConfidence = 0.92f - (motionScore / stillThreshold) * 0.12f;
-            if (stillConfidence < 0.78f) stillConfidence = 0.78f;
-
-            if (prediction == idleClass) {
-                // If model already says Idle, just stabilize confidence upward.
-                if (*confidence < stillConfidence) {
-                    *confidence = stillConfidence;
-                }
-            } else if (*confidence < lowConfidenceThreshold) {
-                // Only force Idle when non-Idle prediction is weak.
-                prediction = idleClass;
-                *confidence = stillConfidence;
-            }
-        }
+        prediction = applyIdleOverride(prediction, confidence, idleClass, motionScore);
     }
 
     // Print result
@@ -243,10 +240,27 @@ int runInference(float* confidence) {
     return prediction;
 }
 
+uint32_t getLastNetworkMicros() {
+    return lastNetworkMicros;
+}
+
 const char* getPredictionLabel(int classIndex) {
     return neuralNetwork.getLabel(classIndex);
 }
 
+uint8_t getNumHeads() {
+    return neuralNetwork.isModelLoaded() ? neuralNetwork.getNumHeads() : 0;
+}
+
+int getHeadPrediction(uint8_t head, float* confidence) {
+    if (head == 0 || head >= getNumHeads()) {
+        *confidence = 0.0f;
+        return -1;
+    }
+    *confidence = headConfidences[head];
+    return headPredictions[head];
+}
+
 // ============================================================================
 // SLIDING WINDOW
 // ============================================================================
@@ -19,6 +19,9 @@ bool setupInference();
 // Reload model from storage (called after BLE upload)
 bool reloadModel();
 
+// Stop using the stored model (called before an upload overwrites it)
+void unloadModel();
+
 // Check if a valid model is loaded
 bool isModelLoaded();
 
@@ -36,6 +39,17 @@ void resetInferenceWindow();
 // confidence: output parameter for confidence score (0.0-1.0)
 int runInference(float* confidence);
 
+// Microseconds the last runInference() spent in the network (primary head
+// plus extra heads); the rest of its time is window prep and post-processing
+uint32_t getLastNetworkMicros();
+
+// Number of output heads in the loaded model (1 = classic single head)
+uint8_t getNumHeads();
+
+// Result of an extra output head from the last runInference() call
+// Returns: predicted class index for the head (1 to getNumHeads() - 1), or -1
+int getHeadPrediction(uint8_t head, float* confidence);
+
 // Slide the window by WINDOW_STRIDE samples
 void slideWindow();
 
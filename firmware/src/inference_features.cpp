@@ -34,3 +34,45 @@ float estimateMotionScoreFromWindow(const float sampleWindow[][6], int sampleCou
 
     return accelDeltaMean + gyroMean;
 }
+
+bool isIdleLabel(const char* label) {
+    const char* idle = "idle";
+    while (*label && *idle) {
+        char c = *label;
+        if (c >= 'A' && c <= 'Z') c = (char)(c + ('a' - 'A'));
+        if (c != *idle) return false;
+        label++;
+        idle++;
+    }
+    return *label == '\0' && *idle == '\0';
+}
+
+int applyIdleOverride(int prediction, float* confidence, int idleClass, float motionScore) {
+    if (idleClass < 0) {
+        return prediction;
+    }
+
+    // Handheld "still" is noisier than a table-resting board.
+    // IMPORTANT: only override a non-Idle prediction when model confidence is low,
+    // otherwise we can suppress real gestures (e.g., Shake) too aggressively.
+    const float stillThreshold = MOTION_STILL_THRESHOLD;
+    const float lowConfidenceThreshold = 0.60f;
+
+    if (motionScore < stillThreshold) {
+        // Confidence we report when we trust stillness.
+        float stillConfidence = 0.92f - (motionScore / stillThreshold) * 0.12f;
+        if (stillConfidence < 0.78f) stillConfidence = 0.78f;
+
+        if (prediction == idleClass) {
+            // If model already says Idle, just stabilize confidence upward.
+            if (*confidence < stillConfidence) {
+                *confidence = stillConfidence;
+            }
+        } else if (*confidence < lowConfidenceThreshold) {
+            // Only force Idle when non-Idle prediction is weak.
+            prediction = idleClass;
+            *confidence = stillConfidence;
+        }
+    }
+    return prediction;
+}
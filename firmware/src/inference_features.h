@@ -13,4 +13,12 @@ float normalizeGyroSample(int16_t rawValue);
 
 float estimateMotionScoreFromWindow(const float sampleWindow[][6], int sampleCount);
 
+// True for the class label that the idle override targets ("Idle", any case)
+bool isIdleLabel(const char* label);
+
+// Stabilize toward Idle when the window is nearly still: boosts an Idle
+// prediction's confidence, or replaces a weak (< 60%) non-Idle prediction.
+// Returns the final prediction; idleClass < 0 disables the override.
+int applyIdleOverride(int prediction, float* confidence, int idleClass, float motionScore);
+
 #endif // INFERENCE_FEATURES_H
@@ -6,14 +6,21 @@
  *
  * Features:
  * - Over-the-air model upload via BLE
- * - Runtime model storage in RAM (lost on power cycle)
+ * - Models saved to A/B flash slots and reloaded at boot (PERSISTENT_MODEL)
  * - Real-time inference with SimpleNN
  */
 
+#include "ble_write_queue.h"
 #include "config.h"
+#include "decimator.h"
 #include "flash_storage.h"
 #include "inference.h"
+#include "memory_stats.h"
+#include "profiler.h"
+#include "resampler.h"
+#include "sampler.h"
 #include "sensor_reader.h"
+#include "sensor_stream.h"
 #include <ArduinoBLE.h>
 
 // ============================================================================
@@ -21,7 +28,6 @@
 // ============================================================================
 SensorReader *sensor = nullptr;
 uint8_t currentMode = MODE_COLLECT;
-uint32_t sampleIntervalMs = 1000 / DEFAULT_SAMPLE_RATE_HZ;
 unsigned long lastSampleTime = 0;
 unsigned long lastConnectTime = 0;
 
@@ -30,6 +36,24 @@ uint32_t uptimeSeconds = 0;
 uint32_t totalSamples = 0;
 uint32_t inferenceCount = 0;
 unsigned long lastUptimeUpdate = 0;
+unsigned long lastDiagnosticsUpdate = 0;
+
+// Uniform-grid resampling of jittery loop reads (at the IMU rate)
+UniformResampler resampler;
+uint16_t resampledSequence = 0;
+
+// Anti-alias decimation from the IMU rate down to the model rate
+PolyphaseDecimator decimator;
+uint16_t decimatedSequence = 0;
+
+// Collect-mode stream format negotiated by the host (see config.h)
+uint8_t streamFormat = SENSOR_STREAM_LEGACY;
+SensorBatchEncoder batchEncoder;
+SensorDeltaEncoder deltaEncoder;
+uint32_t batchStartMs = 0; // When the oldest pending sample was queued
+
+// Append the timing block to inference results (host opt-in via config)
+bool inferenceTimingEnabled = false;
 
 // Device name (unique per device)
 char deviceName[DEVICE_NAME_MAX_LEN];
@@ -99,26 +123,48 @@ BLEService edgeService(SERVICE_UUID);
 // Mode: 0=Collect, 1=Inference
 BLEByteCharacteristic modeChar(MODE_CHAR_UUID, BLERead | BLEWrite);
 
-// Sensor data: 17-byte packets with CRC
-BLECharacteristic sensorChar(SENSOR_CHAR_UUID, BLERead | BLENotify, 17);
+// Sensor data: 17-byte packets with CRC, or multi-sample batches once the
+// host negotiates SENSOR_STREAM_BATCHED
+BLECharacteristic sensorChar(SENSOR_CHAR_UUID, BLERead | BLENotify,
+                             SENSOR_NOTIFY_MAX_SIZE);
 
 // Inference results: [class, confidence%, status_flags, reserved]
-BLECharacteristic inferenceChar(INFERENCE_CHAR_UUID, BLERead | BLENotify, 4);
+// + [class, confidence%] per extra head for multi-head models
+BLECharacteristic inferenceChar(INFERENCE_CHAR_UUID, BLERead | BLENotify,
+                                INFERENCE_RESULT_MAX_SIZE);
 
-// Device info: firmware version, chip type, stats (24 bytes - extended)
-BLECharacteristic deviceInfoChar(DEVICE_INFO_UUID, BLERead, 24);
+// Device info: firmware version, chip type, stats, RAM and BLE write queue
+// telemetry (48 bytes)
+BLECharacteristic deviceInfoChar(DEVICE_INFO_UUID, BLERead, DEVICE_INFO_SIZE);
 
-// Config: [sample_rate_hz (uint16), window_size (uint16)]
-BLECharacteristic configChar(CONFIG_CHAR_UUID, BLERead | BLEWrite, 4);
+// Config: [sample_rate_hz (uint16), window_size (uint16), stream_format,
+//          batch_samples, inference_flags]
+BLECharacteristic configChar(CONFIG_CHAR_UUID, BLERead | BLEWrite,
+                             CONFIG_CHAR_SIZE);
 
 // Model upload: variable length chunks (max 244 bytes per write)
 // Format: [cmd(1)] [offset(4)] [data(up to 239)]
-// Commands: 0x01=start, 0x02=chunk, 0x03=finish, 0x04=cancel
+// Commands: 0x01=start, 0x02=chunk, 0x03=finish, 0x04=cancel, 0x05=query
+// Chunks may arrive out of order if block aligned (see flash_storage.h)
 BLECharacteristic modelUploadChar(MODEL_UPLOAD_UUID,
-                                  BLEWrite, 244);
+                                  BLEWrite | BLEWriteWithoutResponse,
+                                  MODEL_UPLOAD_WRITE_MAX);
 
 // Model status: [state(1), progress(1), status_code(1), reserved(1)]
-BLECharacteristic modelStatusChar(MODEL_STATUS_UUID, BLERead | BLENotify, 4);
+// QUERY reply: [state(1), progress(1), status_code(1), count(1),
+//               (offset(4), length(4)) x count] -- the missing byte ranges
+// Both end with flow control: [credits(1), reserved(1), writesDone(2)]
+#define MODEL_STATUS_CREDITS_SIZE 4
+#define MODEL_STATUS_CHAR_SIZE                                                 \
+  (4 + 8 * MODEL_MISSING_RANGES_MAX + MODEL_STATUS_CREDITS_SIZE)
+BLECharacteristic modelStatusChar(MODEL_STATUS_UUID, BLERead | BLENotify,
+                                  MODEL_STATUS_CHAR_SIZE);
+
+#if PROFILING_ENABLED
+// Diagnostics: per-stage timing report (see profiler.h); any write resets it
+BLECharacteristic diagnosticsChar(DIAGNOSTICS_UUID, BLERead | BLEWrite,
+                                  PROFILE_REPORT_SIZE);
+#endif
 
 // ============================================================================
 // MODEL UPLOAD STATE
@@ -127,16 +173,62 @@ static uint32_t uploadExpectedSize = 0;
 static uint32_t uploadExpectedCrc = 0;
 static uint8_t uploadNumClasses = 0;
 
+// The host keeps at most MODEL_UPLOAD_CREDITS upload writes in flight: it
+// sends while (writes sent since START) - writesDone < credits.
+static uint16_t uploadWritesProcessed = 0; // Since START
+static uint32_t uploadDropBase = 0;        // Upload writes dropped before START
+
+// A START waiting for the running model to be saved to flash, so it can be
+// served from there during the upload (see handleUploadStart), and the first
+// CHUNK / FINISH that arrived behind it. Everything after that one waits in
+// bleWrites; the host's credits keep it from overflowing.
+static BleWrite pendingStart;
+static bool startPending = false;
+static BleWrite heldUploadWrite;
+static bool uploadWriteHeld = false;
+
+// ============================================================================
+// BLE WRITE QUEUE
+// ============================================================================
+// Every writable characteristic has a BLEWritten handler that only copies the
+// write into bleWrites; processBleWrites() handles them in arrival order
+static BleWriteQueue bleWrites;
+static uint32_t reportedWriteDrops = 0;
+
+// Writes since START the device is done with: handled, or dropped because
+// the queue was full (a host that ignores its credits)
+static uint16_t uploadWritesDone() {
+  return (uint16_t)(uploadWritesProcessed +
+                    (bleWrites.getDrops(BLE_WRITE_UPLOAD) - uploadDropBase));
+}
+
 static uint32_t readU32LE(const uint8_t *bytes) {
   return ((uint32_t)bytes[0]) | ((uint32_t)bytes[1] << 8) |
          ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
 }
 
+static void writeU32LE(uint8_t *bytes, uint32_t value) {
+  bytes[0] = (uint8_t)value;
+  bytes[1] = (uint8_t)(value >> 8);
+  bytes[2] = (uint8_t)(value >> 16);
+  bytes[3] = (uint8_t)(value >> 24);
+}
+
 // ============================================================================
 // DEVICE INFO PACKET BUILDER
 // ============================================================================
+// Samples lost to a full hardware FIFO or a full sample ring
+static uint32_t droppedSampleCount() {
+  return sensor->getDroppedSamples() + getSampleRing().getOverruns();
+}
+
+// Clamp for the 16-bit stack fields
+static uint16_t saturateU16(uint32_t value) {
+  return value > 0xFFFF ? 0xFFFF : (uint16_t)value;
+}
+
 void updateDeviceInfo() {
-  uint8_t info[24];
+  uint8_t info[DEVICE_INFO_SIZE];
 
   info[0] = FIRMWARE_VERSION_MAJOR;
   info[1] = FIRMWARE_VERSION_MINOR;
@@ -148,7 +240,7 @@ void updateDeviceInfo() {
   memcpy(&info[4], &windowSize, 2);
 
   // Sample rate
-  uint16_t sampleRate = DEFAULT_SAMPLE_RATE_HZ;
+  uint16_t sampleRate = STREAM_SAMPLE_RATE_HZ;
   memcpy(&info[6], &sampleRate, 2);
 
   // Uptime in seconds
@@ -169,88 +261,267 @@ void updateDeviceInfo() {
   info[22] = (modelSize >> 8) & 0xFF;
   info[23] = (modelSize >> 16) & 0xFF;
 
-  deviceInfoChar.writeValue(info, 24);
+  // Dropped samples (sensor FIFO overflow + sample ring overruns)
+  uint32_t dropped = droppedSampleCount();
+  memcpy(&info[24], &dropped, 4);
+
+  // RAM telemetry (0 = not measurable on this platform)
+  updateMemoryStats();
+  const MemoryStats &memory = getMemoryStats();
+  uint16_t stackPeak = saturateU16(memory.stackPeakBytes);
+  uint16_t stackSize = saturateU16(memory.stackSize);
+  uint16_t samplerPeak = saturateU16(memory.samplerStackPeakBytes);
+  uint16_t samplerSize = saturateU16(memory.samplerStackSize);
+  memcpy(&info[28], &stackPeak, 2);
+  memcpy(&info[30], &stackSize, 2);
+  memcpy(&info[32], &memory.heapFreeBytes, 4);
+  memcpy(&info[36], &memory.heapMinFreeBytes, 4);
+  memcpy(&info[40], &samplerPeak, 2);
+  memcpy(&info[42], &samplerSize, 2);
+
+  // BLE write queue: peak depth, capacity, writes dropped because it was full
+  uint32_t peakDepth = bleWrites.getPeakDepth();
+  info[44] = (uint8_t)(peakDepth > 0xFF ? 0xFF : peakDepth);
+  info[45] = (uint8_t)bleWrites.capacity();
+  uint16_t writeDrops = saturateU16(bleWrites.getDrops());
+  memcpy(&info[46], &writeDrops, 2);
+
+  PROFILE_SCOPE(PROFILE_WRITE_INFO);
+  deviceInfoChar.writeValue(info, DEVICE_INFO_SIZE);
+}
+
+// ============================================================================
+// CONFIG / STREAM FORMAT NEGOTIATION
+// ============================================================================
+void updateConfig() {
+  uint8_t configData[CONFIG_CHAR_SIZE];
+  uint16_t rate = STREAM_SAMPLE_RATE_HZ;
+  uint16_t window = WINDOW_SIZE;
+  memcpy(&configData[0], &rate, 2);
+  memcpy(&configData[2], &window, 2);
+  configData[4] = streamFormat;
+  if (streamFormat == SENSOR_STREAM_BATCHED) {
+    configData[5] = batchEncoder.getMaxSamples();
+  } else if (streamFormat == SENSOR_STREAM_COMPRESSED) {
+    configData[5] = deltaEncoder.getMaxSamples();
+  } else {
+    configData[5] = 1;
+  }
+  configData[6] = inferenceTimingEnabled ? CONFIG_INFERENCE_TIMING : 0;
+  PROFILE_SCOPE(PROFILE_WRITE_CONFIG);
+  configChar.writeValue(configData, CONFIG_CHAR_SIZE);
+}
+
+void flushSensorBatch();
+
+/**
+ * Switch the collect-mode stream format. batchSamples = 0 picks the largest
+ * batch that fits one notification. Unknown formats fall back to legacy.
+ */
+void setStreamFormat(uint8_t format, uint8_t batchSamples) {
+  flushSensorBatch();
+  const uint16_t intervalUs = (uint16_t)(1000000UL / STREAM_SAMPLE_RATE_HZ);
+  if (format == SENSOR_STREAM_BATCHED) {
+    batchEncoder.begin(batchSamples == 0 ? SENSOR_STREAM_MAX_BATCH
+                                         : batchSamples,
+                       intervalUs);
+    streamFormat = SENSOR_STREAM_BATCHED;
+  } else if (format == SENSOR_STREAM_COMPRESSED) {
+    deltaEncoder.begin(batchSamples, intervalUs,
+                       SENSOR_DELTA_DEFAULT_KEYFRAME_INTERVAL);
+    streamFormat = SENSOR_STREAM_COMPRESSED;
+  } else {
+    batchEncoder.reset();
+    deltaEncoder.reset();
+    streamFormat = SENSOR_STREAM_LEGACY;
+  }
+  updateConfig();
+}
+
+/**
+ * Host writes [rate, window, format, batch_samples, inference_flags]. Rate
+ * and window are fixed at build time, so only the stream format and the
+ * inference timing block are negotiated; the host reads config back to see
+ * what was accepted.
+ */
+void handleConfigWrite(const uint8_t *data, int length) {
+  uint8_t format = length >= 5 ? data[4] : SENSOR_STREAM_LEGACY;
+  uint8_t batchSamples = length >= 6 ? data[5] : 0;
+  inferenceTimingEnabled =
+      length >= 7 && (data[6] & CONFIG_INFERENCE_TIMING) != 0;
+  setStreamFormat(format, batchSamples);
+
+  DEBUG_PRINT("Stream format: ");
+  DEBUG_PRINTLN(streamFormat);
 }
 
 // ============================================================================
 // MODEL UPLOAD STATUS UPDATE
 // ============================================================================
+static void appendUploadCredits(uint8_t *out) {
+  const uint16_t done = uploadWritesDone();
+  out[0] = MODEL_UPLOAD_CREDITS;
+  out[1] = 0; // Reserved
+  out[2] = (uint8_t)done;
+  out[3] = (uint8_t)(done >> 8);
+}
+
 void updateModelStatus(UploadState state, uint8_t progress,
                        UploadStatus status) {
-  uint8_t statusData[4];
+  uint8_t statusData[4 + MODEL_STATUS_CREDITS_SIZE];
   statusData[0] = (uint8_t)state;
   statusData[1] = progress;
   statusData[2] = (uint8_t)status;
   statusData[3] = 0; // Reserved
-  modelStatusChar.writeValue(statusData, 4);
+  appendUploadCredits(&statusData[4]);
+  PROFILE_SCOPE(PROFILE_WRITE_STATUS);
+  modelStatusChar.writeValue(statusData, sizeof(statusData));
+}
+
+// Reply to QUERY with the ranges the host still has to (re)send
+static void sendMissingRanges() {
+  UploadRange ranges[MODEL_MISSING_RANGES_MAX];
+  uint32_t count = getMissingUploadRanges(ranges, MODEL_MISSING_RANGES_MAX);
+
+  uint8_t statusData[MODEL_STATUS_CHAR_SIZE];
+  statusData[0] = (uint8_t)getUploadState();
+  statusData[1] = getUploadProgress();
+  statusData[2] = (uint8_t)(getUploadState() == UPLOAD_RECEIVING
+                                ? STATUS_RECEIVING
+                                : STATUS_READY);
+  statusData[3] = (uint8_t)count;
+  for (uint32_t i = 0; i < count; i++) {
+    writeU32LE(&statusData[4 + 8 * i], ranges[i].offset);
+    writeU32LE(&statusData[8 + 8 * i], ranges[i].length);
+  }
+  appendUploadCredits(&statusData[4 + 8 * count]);
+  PROFILE_SCOPE(PROFILE_WRITE_STATUS);
+  modelStatusChar.writeValue(statusData,
+                             4 + 8 * count + MODEL_STATUS_CREDITS_SIZE);
 }
 
 // ============================================================================
 // MODEL UPLOAD HANDLER
 // ============================================================================
-void handleModelUpload() {
-  if (!modelUploadChar.written())
-    return;
 
-  int len = modelUploadChar.valueLength();
-  if (len < 1)
+// An upload that did not complete may have overwritten the RAM model; bring
+// back the last one saved to flash, if any (an untouched model stays loaded)
+static void restorePreviousModel() {
+  if (restoreSavedModel() && reloadModel()) {
+    updateDeviceInfo();
+  }
+}
+
+// The first chunk written over a model with no saved copy retires it; stop
+// inference from reading the buffer before the next window
+static void retireOverwrittenModel() {
+  if (isModelLoaded() && !hasStoredModel()) {
+    unloadModel();
+    updateDeviceInfo();
+  }
+}
+
+// START, or a deferred START once the save it waited for ended (afterSave:
+// do not try to save again)
+static void handleUploadStart(const uint8_t *data, int len, bool afterSave) {
+  if (len < 10) {
+    updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_FORMAT);
     return;
+  }
 
-  const uint8_t *data = modelUploadChar.value();
-  uint8_t cmd = data[0];
+  uploadExpectedSize = readU32LE(&data[1]);
+  uploadExpectedCrc = readU32LE(&data[5]);
+  uploadNumClasses = data[9];
+
+  DEBUG_PRINT("Model upload starting: ");
+  DEBUG_PRINT(uploadExpectedSize);
+  DEBUG_PRINT(" bytes, ");
+  DEBUG_PRINT(uploadNumClasses);
+  DEBUG_PRINTLN(" classes");
+  char startBuf[128];
+  sprintf(startBuf,
+          "START crc bytes raw: %02X %02X %02X %02X -> parsed 0x%08lX",
+          data[5], data[6], data[7], data[8], (unsigned long)uploadExpectedCrc);
+  DEBUG_PRINTLN(startBuf);
+
+  if (uploadExpectedSize > MAX_MODEL_SIZE) {
+    updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_SIZE);
+    return;
+  }
 
-  switch (cmd) {
-  case 0x01: { // START: [cmd(1), size(4), crc32(4), numClasses(1), labels...]
-    if (len < 10) {
-      updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_FORMAT);
+  // Keep predicting through the upload: chunks overwrite the RAM model, so
+  // it has to be served from a copy in flash meanwhile. Without one, save
+  // it first (STATUS_SAVING, one page per loop pass) and start after that.
+  // A board that cannot keep it running refuses while inference is on.
+  if (isSavingStoredModel() || !canServeModelDuringUpload()) {
+    if (isSavingStoredModel() ||
+        (!afterSave && canSaveModelForUpload() &&
+         beginSaveStoredModel() == STATUS_SAVING)) {
+      memcpy(pendingStart.data, data, len);
+      pendingStart.length = (uint8_t)len;
+      startPending = true;
+      DEBUG_PRINTLN("Saving the running model before the upload starts");
+      updateModelStatus(UPLOAD_IDLE, 0, STATUS_SAVING);
       return;
     }
-
-    uploadExpectedSize = readU32LE(&data[1]);
-    uploadExpectedCrc = readU32LE(&data[5]);
-    uploadNumClasses = data[9];
-
-    DEBUG_PRINT("Model upload starting: ");
-    DEBUG_PRINT(uploadExpectedSize);
-    DEBUG_PRINT(" bytes, ");
-    DEBUG_PRINT(uploadNumClasses);
-    DEBUG_PRINTLN(" classes");
-    char startBuf[128];
-    sprintf(startBuf,
-            "START crc bytes raw: %02X %02X %02X %02X -> parsed 0x%08lX",
-            data[5], data[6], data[7], data[8], (unsigned long)uploadExpectedCrc);
-    DEBUG_PRINTLN(startBuf);
-
-    if (uploadExpectedSize > MAX_MODEL_SIZE) {
-      updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_SIZE);
+    if (currentMode == MODE_INFERENCE) {
+      DEBUG_PRINTLN("Upload refused: the running model has no copy to serve");
+      updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_IN_USE);
       return;
     }
+  }
 
-    beginModelUpload(uploadExpectedSize, uploadNumClasses);
-
-    // Parse class labels from remaining bytes (bounds-checked)
-    int offset = 10;
-    for (int i = 0; i < uploadNumClasses && offset < len; i++) {
-      // Find null terminator within remaining buffer
-      int remaining = len - offset;
-      const void *term = memchr(&data[offset], '\0', remaining);
-      if (!term) {
-        // Label not null-terminated — reject to prevent OOB read
-        DEBUG_PRINTLN("Label not null-terminated, rejecting");
-        updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_FORMAT);
-        return;
-      }
-      int labelLen = (const uint8_t *)term - &data[offset];
-      char safeLabel[LABEL_MAX_LEN] = {0};
-      int copyLen = labelLen < (LABEL_MAX_LEN - 1) ? labelLen : (LABEL_MAX_LEN - 1);
-      memcpy(safeLabel, &data[offset], copyLen);
-      setModelLabel(i, safeLabel);
-      offset += labelLen + 1;
+  // Chunks are written straight over the RAM model. If it is saved in
+  // flash, inference picks it up again from there (hot swap) until FINISH;
+  // otherwise it keeps running from RAM until the first chunk that
+  // overwrites it (see retireOverwrittenModel).
+  unloadModel();
+  beginModelUpload(uploadExpectedSize, uploadNumClasses);
+  if (hasStoredModel()) {
+    reloadModel();
+  }
+  if (getUploadState() != UPLOAD_RECEIVING) {
+    // Rejected before anything was overwritten: the old model is kept
+    updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_SIZE);
+    return;
+  }
+  updateDeviceInfo();
+
+  // Parse class labels from remaining bytes (bounds-checked)
+  int offset = 10;
+  for (int i = 0; i < uploadNumClasses && offset < len; i++) {
+    // Find null terminator within remaining buffer
+    int remaining = len - offset;
+    const void *term = memchr(&data[offset], '\0', remaining);
+    if (!term) {
+      // Label not null-terminated — reject to prevent OOB read
+      DEBUG_PRINTLN("Label not null-terminated, rejecting");
+      cancelModelUpload();
+      restorePreviousModel();
+      updateModelStatus(UPLOAD_ERROR, 0, STATUS_ERROR_FORMAT);
+      return;
     }
+    int labelLen = (const uint8_t *)term - &data[offset];
+    char safeLabel[LABEL_MAX_LEN] = {0};
+    int copyLen = labelLen < (LABEL_MAX_LEN - 1) ? labelLen : (LABEL_MAX_LEN - 1);
+    memcpy(safeLabel, &data[offset], copyLen);
+    setModelLabel(i, safeLabel);
+    offset += labelLen + 1;
+  }
+
+  updateModelStatus(UPLOAD_RECEIVING, 0, STATUS_RECEIVING);
+}
+
+static void handleUploadWrite(const uint8_t *data, int len) {
+  if (len < 1)
+    return;
+
+  uint8_t cmd = data[0];
 
-    updateModelStatus(UPLOAD_RECEIVING, 0, STATUS_RECEIVING);
+  switch (cmd) {
+  case 0x01: // START: [cmd(1), size(4), crc32(4), numClasses(1), labels...]
+    handleUploadStart(data, len, false);
     break;
-  }
 
   case 0x02: { // CHUNK: [cmd(1), offset(4), data(N)]
     if (len < 5) {
@@ -261,8 +532,11 @@ void handleModelUpload() {
     uint32_t offset = readU32LE(&data[1]);
     uint16_t chunkLen = len - 5;
 
-    if (!receiveModelChunk(&data[5], chunkLen, offset)) {
-      updateModelStatus(UPLOAD_ERROR, getUploadProgress(), STATUS_ERROR_FORMAT);
+    const bool received = receiveModelChunk(&data[5], chunkLen, offset);
+    retireOverwrittenModel();
+    if (!received) {
+      updateModelStatus(UPLOAD_ERROR, getUploadProgress(), getUploadError());
+      restorePreviousModel();
       return;
     }
 
@@ -277,27 +551,36 @@ void handleModelUpload() {
     UploadStatus result = finalizeModelUpload(uploadExpectedCrc);
 
     if (result == STATUS_SUCCESS) {
-      DEBUG_PRINTLN("Model saved! Reloading into SimpleNN...");
-      updateModelStatus(UPLOAD_COMPLETE, 100, STATUS_SAVING);
-
-      // Reload the model into SimpleNN inference engine
-      if (reloadModel()) {
-        updateModelStatus(UPLOAD_COMPLETE, 100, STATUS_SUCCESS);
-        updateDeviceInfo(); // Update device info with new model status
-        DEBUG_PRINTLN("SimpleNN model reload successful!");
-      } else {
+      // Swap SimpleNN onto the new model. Writes are handled between
+      // samples, so the next window is the first one it classifies.
+      if (!reloadModel()) {
         updateModelStatus(UPLOAD_ERROR, 100, STATUS_ERROR_FORMAT);
         DEBUG_PRINTLN("SimpleNN model reload failed!");
+        break;
+      }
+      DEBUG_PRINTLN("SimpleNN model reload successful!");
+      updateDeviceInfo(); // Update device info with new model status
+
+      DEBUG_PRINTLN("Model accepted! Saving to flash...");
+      updateModelStatus(UPLOAD_COMPLETE, 100, STATUS_SAVING);
+      // One page per loop pass from here (continueModelSave); a save that
+      // needs no flash is done already
+      UploadStatus saved = beginSaveStoredModel();
+      if (saved != STATUS_SAVING) {
+        updateModelStatus(UPLOAD_COMPLETE, 100, saved);
       }
     } else {
       updateModelStatus(UPLOAD_ERROR, 100, result);
+      restorePreviousModel();
     }
     break;
   }
 
   case 0x04: { // CANCEL: [cmd(1)]
     DEBUG_PRINTLN("Model upload cancelled");
+    startPending = false; // Its save still runs to the end
     cancelModelUpload();
+    restorePreviousModel();
     uploadExpectedSize = 0;
     uploadExpectedCrc = 0;
     uploadNumClasses = 0;
@@ -305,6 +588,11 @@ void handleModelUpload() {
     break;
   }
 
+  case 0x05: { // QUERY: [cmd(1)]
+    sendMissingRanges();
+    break;
+  }
+
   default:
     DEBUG_PRINT("Unknown upload command: ");
     DEBUG_PRINTLN(cmd);
@@ -312,10 +600,451 @@ void handleModelUpload() {
   }
 }
 
+// Erase or program one flash page of the model save started at FINISH. A
+// page erase stalls the CPU for up to 85 ms, so doing one per pass keeps
+// sampling and inference going; the host sees STATUS_SAVING until the final
+// status. STATUS_ERROR_FLASH: the model runs now but is gone after power off.
+static void continueModelSave() {
+  if (!isSavingStoredModel()) {
+    return;
+  }
+  UploadStatus saved = continueSaveStoredModel();
+  if (saved == STATUS_SAVING) {
+    return;
+  }
+  if (startPending) {
+    // The START that waited for this save replies instead
+    startPending = false;
+    handleUploadStart(pendingStart.data, pendingStart.length, true);
+  } else {
+    updateModelStatus(UPLOAD_COMPLETE, 100, saved);
+  }
+}
+
+// Each upload write handled frees one credit
+static void handleModelUpload(const uint8_t *data, int len) {
+  if (len > 0 && data[0] == 0x01) {
+    // START: the host counts its writes from here
+    uploadWritesProcessed = 0;
+    uploadDropBase = bleWrites.getDrops(BLE_WRITE_UPLOAD);
+  } else {
+    uploadWritesProcessed++;
+  }
+  handleUploadWrite(data, len);
+}
+
+// ============================================================================
+// BLE WRITE HANDLERS
+// ============================================================================
+// BLE write events run inside BLE.poll(): copy the write and return. A full
+// queue drops it (counted per source in bleWrites).
+static void queueWrite(uint8_t source, BLECharacteristic &characteristic) {
+  bleWrites.push(source, characteristic.value(), characteristic.valueLength());
+}
+
+static void onModeWritten(BLEDevice central, BLECharacteristic characteristic) {
+  (void)central;
+  queueWrite(BLE_WRITE_MODE, characteristic);
+}
+
+static void onConfigWritten(BLEDevice central,
+                            BLECharacteristic characteristic) {
+  (void)central;
+  queueWrite(BLE_WRITE_CONFIG, characteristic);
+}
+
+static void onModelUploadWritten(BLEDevice central,
+                                 BLECharacteristic characteristic) {
+  (void)central;
+  queueWrite(BLE_WRITE_UPLOAD, characteristic);
+}
+
+#if PROFILING_ENABLED
+static void onDiagnosticsWritten(BLEDevice central,
+                                 BLECharacteristic characteristic) {
+  (void)central;
+  queueWrite(BLE_WRITE_DIAGNOSTICS, characteristic);
+}
+#endif
+
+static void handleModeWrite(uint8_t mode) {
+  flushSensorBatch();
+  currentMode = mode;
+  DEBUG_PRINT("Mode changed to: ");
+  DEBUG_PRINTLN(currentMode == MODE_COLLECT ? "COLLECT" : "INFERENCE");
+
+  // Reset inference buffer on mode transitions so stale frames do not
+  // pollute first predictions after switching workflows.
+  resetInferenceWindow();
+
+  // Update device info when mode changes
+  updateDeviceInfo();
+}
+
+static void handleBleWrite(const BleWrite &write) {
+  switch (write.source) {
+  case BLE_WRITE_MODE:
+    if (write.length > 0) {
+      handleModeWrite(write.data[0]);
+    }
+    break;
+  case BLE_WRITE_CONFIG:
+    handleConfigWrite(write.data, write.length);
+    break;
+  case BLE_WRITE_UPLOAD:
+    handleModelUpload(write.data, write.length);
+    break;
+#if PROFILING_ENABLED
+  case BLE_WRITE_DIAGNOSTICS:
+    // Any host write to diagnostics starts a fresh measurement
+    resetProfile();
+    lastDiagnosticsUpdate = 0;
+    break;
+#endif
+  default:
+    break;
+  }
+}
+
+// Upload data for a START that is still waiting for its save
+static bool mustWaitForStart(const BleWrite &write) {
+  return startPending && write.source == BLE_WRITE_UPLOAD &&
+         write.length > 0 && (write.data[0] == 0x02 || write.data[0] == 0x03);
+}
+
+// Everything queued since the last pass, in arrival order (stopping at
+// upload data that has to wait for a deferred START)
+void processBleWrites() {
+  if (uploadWriteHeld && !startPending) {
+    uploadWriteHeld = false;
+    handleBleWrite(heldUploadWrite);
+  }
+  BleWrite write;
+  while (!uploadWriteHeld && bleWrites.pop(write)) {
+    if (mustWaitForStart(write)) {
+      heldUploadWrite = write;
+      uploadWriteHeld = true;
+      break;
+    }
+    handleBleWrite(write);
+  }
+
+  const uint32_t drops = bleWrites.getDrops();
+  if (drops != reportedWriteDrops) {
+    DEBUG_PRINT("BLE writes dropped (queue full): ");
+    DEBUG_PRINTLN(drops - reportedWriteDrops);
+    reportedWriteDrops = drops;
+  }
+}
+
+// ============================================================================
+// SAMPLE PIPELINE
+// ============================================================================
+// sensor->read() → acquireSample (uniform grid) → handleImuSample (decimate)
+// → processSample (stream or infer at the model rate)
+
+/**
+ * Send the samples waiting in the pending batch, if any.
+ */
+void flushSensorBatch() {
+  uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+  size_t length = streamFormat == SENSOR_STREAM_COMPRESSED
+                      ? deltaEncoder.finish(notification)
+                      : batchEncoder.finish(notification);
+  if (length > 0) {
+    PROFILE_SCOPE(PROFILE_WRITE_SENSOR);
+    sensorChar.writeValue(notification, length);
+  }
+}
+
+static uint8_t pendingSensorSamples() {
+  if (streamFormat == SENSOR_STREAM_COMPRESSED) {
+    return deltaEncoder.getCount();
+  }
+  return streamFormat == SENSOR_STREAM_BATCHED ? batchEncoder.getCount() : 0;
+}
+
+/**
+ * Send the pending batch once its oldest sample has waited
+ * SENSOR_BATCH_MAX_AGE_MS, however few samples it holds.
+ */
+void flushStaleSensorBatch() {
+  if (pendingSensorSamples() > 0 &&
+      millis() - batchStartMs >= SENSOR_BATCH_MAX_AGE_MS) {
+    flushSensorBatch();
+  }
+}
+
+/**
+ * Send one collect-mode sample in the negotiated stream format.
+ */
+void streamSample(const SensorPacket &packet) {
+  if (streamFormat == SENSOR_STREAM_LEGACY) {
+    PROFILE_SCOPE(PROFILE_WRITE_SENSOR);
+    sensorChar.writeValue((const uint8_t *)&packet, sizeof(packet));
+    return;
+  }
+
+  const int16_t axes[6] = {packet.ax, packet.ay, packet.az,
+                           packet.gx, packet.gy, packet.gz};
+
+  bool full;
+  if (streamFormat == SENSOR_STREAM_COMPRESSED) {
+    // Varint sizes vary, so "full" is only known once a sample won't fit
+    if (!deltaEncoder.append(axes, packet.sequence, packet.timestamp)) {
+      flushSensorBatch();
+      deltaEncoder.append(axes, packet.sequence, packet.timestamp);
+    }
+    full = deltaEncoder.isFull();
+  } else {
+    // A sequence gap (e.g. resampler restart) closes the current batch
+    if (!batchEncoder.canAppend(packet.sequence)) {
+      flushSensorBatch();
+    }
+    batchEncoder.append(axes, packet.sequence, packet.timestamp);
+    full = batchEncoder.isFull();
+  }
+
+  if (pendingSensorSamples() == 1) {
+    batchStartMs = millis();
+  }
+  if (full) {
+    flushSensorBatch();
+  } else {
+    flushStaleSensorBatch();
+  }
+}
+
+/**
+ * Run a raw IMU sample through the anti-alias decimator.
+ * Returns true once every IMU_OVERSAMPLE_FACTOR samples, with the packet
+ * rewritten to hold the filtered model-rate sample.
+ */
+bool decimateSample(SensorPacket &packet) {
+#if IMU_OVERSAMPLE_FACTOR > 1
+  const int16_t raw[DECIMATOR_AXES] = {packet.ax, packet.ay, packet.az,
+                                       packet.gx, packet.gy, packet.gz};
+  int16_t filtered[DECIMATOR_AXES];
+  if (!decimator.push(raw, filtered)) {
+    return false;
+  }
+
+  packet.ax = filtered[0];
+  packet.ay = filtered[1];
+  packet.az = filtered[2];
+  packet.gx = filtered[3];
+  packet.gy = filtered[4];
+  packet.gz = filtered[5];
+  packet.sequence = decimatedSequence++;
+  packet.crc = crc8((uint8_t *)&packet, 16);
+#else
+  (void)packet;
+#endif
+  return true;
+}
+
+/**
+ * Handle one sample at the model rate: stream it (collect mode) or feed the
+ * sliding window and run inference (inference mode).
+ * @param sampleTimeUs micros() when the newest raw sample behind it was read
+ */
+void processSample(const SensorPacket &packet, uint32_t sampleTimeUs) {
+  if (currentMode == MODE_COLLECT) {
+#if !STREAM_RAW_RATE
+    // Stream raw sensor data over BLE
+    streamSample(packet);
+#endif
+
+  } else if (currentMode == MODE_INFERENCE) {
+    // Add sample to inference buffer
+    addSample(packet.ax, packet.ay, packet.az, packet.gx, packet.gy,
+              packet.gz);
+
+    // Run inference when window is ready
+    if (isWindowReady()) {
+      const uint32_t inferenceStartUs = micros();
+      float confidence;
+      int prediction = runInference(&confidence);
+
+      if (prediction >= 0) {
+        // Send inference result
+        uint8_t result[INFERENCE_RESULT_MAX_SIZE];
+        int resultLen = 4;
+        result[0] = (uint8_t)prediction;
+        result[1] = (uint8_t)(confidence * 100);
+        result[2] = INFERENCE_STATUS_NONE;
+        result[3] = 0; // Reserved
+
+        // Append each extra head's result after the primary one
+        uint8_t numHeads = getNumHeads();
+        if (numHeads > 1) {
+          result[2] |= INFERENCE_STATUS_MULTI_HEAD;
+          for (uint8_t h = 1; h < numHeads; h++) {
+            float headConfidence;
+            int headPrediction = getHeadPrediction(h, &headConfidence);
+            result[resultLen++] = (uint8_t)headPrediction;
+            result[resultLen++] = (uint8_t)(headConfidence * 100);
+          }
+        }
+
+        // Where this prediction's latency went: waiting in the ring and the
+        // loop, the network, and everything else up to building this packet
+        // (the notification write comes after and is not counted)
+        if (inferenceTimingEnabled) {
+          const uint32_t networkUs = getLastNetworkMicros();
+          const uint32_t elapsedUs = micros() - inferenceStartUs;
+          result[2] |= INFERENCE_STATUS_TIMING;
+          result[resultLen++] = (uint8_t)(packet.sequence & 0xFF);
+          result[resultLen++] = (uint8_t)(packet.sequence >> 8);
+          writeU32LE(&result[resultLen], inferenceStartUs - sampleTimeUs);
+          writeU32LE(&result[resultLen + 4], networkUs);
+          writeU32LE(&result[resultLen + 8],
+                     elapsedUs > networkUs ? elapsedUs - networkUs : 0);
+          resultLen += 12;
+        }
+
+        {
+          PROFILE_SCOPE(PROFILE_WRITE_INFERENCE);
+          inferenceChar.writeValue(result, resultLen);
+        }
+        inferenceCount++;
+
+        DEBUG_PRINT("Prediction: ");
+        DEBUG_PRINT(prediction);
+        DEBUG_PRINT(" (");
+        DEBUG_PRINT((int)(confidence * 100));
+        DEBUG_PRINTLN("%)");
+      } else if (!isModelLoaded()) {
+        // Explicit no-model signal for the web app UI.
+        uint8_t result[4];
+        result[0] = INFERENCE_PREDICTION_NO_MODEL;
+        result[1] = 0;
+        result[2] = INFERENCE_STATUS_NO_MODEL;
+        result[3] = 0;
+
+        PROFILE_SCOPE(PROFILE_WRITE_INFERENCE);
+        inferenceChar.writeValue(result, 4);
+      }
+
+      // Slide window for next inference
+      slideWindow();
+    }
+  }
+}
+
+/**
+ * Handle one sample on the uniform IMU-rate grid.
+ */
+void handleImuSample(SensorPacket &packet, uint32_t sampleTimeUs) {
+#if STREAM_RAW_RATE
+  if (currentMode == MODE_COLLECT) {
+    streamSample(packet);
+  }
+#endif
+
+  if (decimateSample(packet)) {
+    processSample(packet, sampleTimeUs);
+  }
+}
+
+/**
+ * Place a freshly read sample onto the uniform time grid.
+ * @param sampleTimeUs micros() captured right after the read
+ */
+void acquireSample(SensorPacket &packet, uint32_t sampleTimeUs) {
+#if RESAMPLE_UNIFORM_GRID
+  const int16_t raw[RESAMPLER_AXES] = {packet.ax, packet.ay, packet.az,
+                                       packet.gx, packet.gy, packet.gz};
+  int16_t grid[RESAMPLER_MAX_GAP_PERIODS][RESAMPLER_AXES];
+  int count = resampler.push(sampleTimeUs, raw, grid, RESAMPLER_MAX_GAP_PERIODS);
+
+  for (int i = 0; i < count; i++) {
+    uint32_t gridTimeUs = resampler.getLastGridTimeUs() -
+                          (uint32_t)(count - 1 - i) * resampler.getPeriodUs();
+    SensorPacket gridPacket;
+    gridPacket.ax = grid[i][0];
+    gridPacket.ay = grid[i][1];
+    gridPacket.az = grid[i][2];
+    gridPacket.gx = grid[i][3];
+    gridPacket.gy = grid[i][4];
+    gridPacket.gz = grid[i][5];
+    gridPacket.sequence = resampledSequence++;
+    gridPacket.timestamp = (uint16_t)((gridTimeUs / 1000) & 0xFFFF);
+    gridPacket.crc = crc8((uint8_t *)&gridPacket, 16);
+    handleImuSample(gridPacket, sampleTimeUs);
+  }
+#else
+  handleImuSample(packet, sampleTimeUs);
+#endif
+}
+
+/**
+ * Print sampling jitter measured by the resampler over the last period.
+ */
+void reportJitterStats() {
+#if RESAMPLE_UNIFORM_GRID
+  JitterStats stats = resampler.getJitterStats();
+  if (stats.intervals == 0) {
+    return;
+  }
+  char jitterBuf[128];
+  snprintf(jitterBuf, sizeof(jitterBuf),
+           "Sample jitter: n=%lu mean=%luus min=%luus max=%luus rms=%luus "
+           "worst=%luus gaps=%lu",
+           (unsigned long)stats.intervals,
+           (unsigned long)stats.meanIntervalUs,
+           (unsigned long)stats.minIntervalUs,
+           (unsigned long)stats.maxIntervalUs,
+           (unsigned long)stats.rmsJitterUs,
+           (unsigned long)stats.maxJitterUs, (unsigned long)stats.gaps);
+  DEBUG_PRINTLN(jitterBuf);
+  DEBUG_PRINT("Dropped samples: ");
+  DEBUG_PRINTLN(droppedSampleCount());
+  resampler.resetJitterStats();
+#endif
+}
+
+// ============================================================================
+// DIAGNOSTICS
+// ============================================================================
+
+/**
+ * Publish the profiler report on the diagnostics characteristic.
+ */
+void updateDiagnostics() {
+#if PROFILING_ENABLED
+  uint8_t report[PROFILE_REPORT_SIZE];
+  size_t length = buildProfileReport(report, sizeof(report));
+  diagnosticsChar.writeValue(report, length);
+#endif
+}
+
+/**
+ * Single-character serial commands: 'p' prints the profile, 'r' resets it.
+ */
+void handleSerialCommand() {
+  while (Serial.available() > 0) {
+    int command = Serial.read();
+#if PROFILING_ENABLED
+    if (command == 'p') {
+      printProfile();
+    } else if (command == 'r') {
+      resetProfile();
+      Serial.println("Profile reset");
+    }
+#else
+    (void)command;
+#endif
+  }
+}
+
 // ============================================================================
 // SETUP
 // ============================================================================
 void setup() {
+  // Paint the stack before anything deep runs, for the high-water mark
+  beginMemoryStats();
+
   // Initialize serial for debugging
   Serial.begin(115200);
   delay(1000); // Wait for serial connection
@@ -324,6 +1053,14 @@ void setup() {
   DEBUG_PRINTLN("Severn Edge AI v1.1");
   DEBUG_PRINTLN("=================================");
 
+#if PROFILING_ENABLED
+  profilerBegin();
+#endif
+
+  // Boot into collect mode (the host simulator re-runs setup() on the same
+  // globals for every simulated boot)
+  currentMode = MODE_COLLECT;
+
   // Initialize sensor
   DEBUG_PRINT("Initializing sensor... ");
   sensor = createSensorReader();
@@ -340,6 +1077,22 @@ void setup() {
   DEBUG_PRINT("Detected: ");
   DEBUG_PRINTLN(sensor->getChipName());
 
+  resampler.begin(1000000UL / IMU_SAMPLE_RATE_HZ);
+  decimator.begin(IMU_OVERSAMPLE_FACTOR);
+  DEBUG_PRINT("IMU sample rate: ");
+  DEBUG_PRINT(IMU_SAMPLE_RATE_HZ);
+  DEBUG_PRINT(" Hz, model rate: ");
+  DEBUG_PRINT(DEFAULT_SAMPLE_RATE_HZ);
+  DEBUG_PRINTLN(" Hz");
+
+#if SAMPLE_INTERRUPT_DRIVEN
+  if (startSampler(sensor)) {
+    DEBUG_PRINTLN("Interrupt-driven sampling started");
+  } else {
+    DEBUG_PRINTLN("Interrupt sampler unavailable, polling from loop()");
+  }
+#endif
+
   // Initialize inference engine
   DEBUG_PRINT("Setting up inference... ");
   if (!setupInference()) {
@@ -377,6 +1130,13 @@ void setup() {
   edgeService.addCharacteristic(configChar);
   edgeService.addCharacteristic(modelUploadChar);
   edgeService.addCharacteristic(modelStatusChar);
+  modeChar.setEventHandler(BLEWritten, onModeWritten);
+  configChar.setEventHandler(BLEWritten, onConfigWritten);
+  modelUploadChar.setEventHandler(BLEWritten, onModelUploadWritten);
+#if PROFILING_ENABLED
+  edgeService.addCharacteristic(diagnosticsChar);
+  diagnosticsChar.setEventHandler(BLEWritten, onDiagnosticsWritten);
+#endif
 
   BLE.addService(edgeService);
 
@@ -384,16 +1144,20 @@ void setup() {
   modeChar.writeValue(currentMode);
   updateDeviceInfo();
 
-  uint8_t configData[4];
-  uint16_t rate = DEFAULT_SAMPLE_RATE_HZ;
-  uint16_t window = WINDOW_SIZE;
-  memcpy(&configData[0], &rate, 2);
-  memcpy(&configData[2], &window, 2);
-  configChar.writeValue(configData, 4);
+  updateConfig();
+  updateDiagnostics();
 
   // Start advertising
   BLE.advertise();
 
+  updateMemoryStats();
+  DEBUG_PRINT("Free heap: ");
+  DEBUG_PRINT(getMemoryStats().heapFreeBytes);
+  DEBUG_PRINT(" bytes, stack peak: ");
+  DEBUG_PRINT(getMemoryStats().stackPeakBytes);
+  DEBUG_PRINT("/");
+  DEBUG_PRINTLN(getMemoryStats().stackSize);
+
   DEBUG_PRINTLN("=================================");
   DEBUG_PRINTLN("Ready! Waiting for connection...");
   DEBUG_PRINTLN("=================================");
@@ -419,94 +1183,62 @@ void loop() {
     // Update device info on connection
     updateDeviceInfo();
 
+    // Every new host starts on the legacy stream (and plain inference
+    // results) until it negotiates, and with no upload waiting to start
+    inferenceTimingEnabled = false;
+    startPending = false;
+    uploadWriteHeld = false;
+    setStreamFormat(SENSOR_STREAM_LEGACY, 0);
+
     // Main loop while connected
     while (central.connected()) {
       // Update uptime counter
       if (millis() - lastUptimeUpdate >= 1000) {
         uptimeSeconds++;
         lastUptimeUpdate = millis();
-      }
-
-      // Check for mode changes
-      if (modeChar.written()) {
-        currentMode = modeChar.value();
-        DEBUG_PRINT("Mode changed to: ");
-        DEBUG_PRINTLN(currentMode == MODE_COLLECT ? "COLLECT" : "INFERENCE");
-
-        // Reset inference buffer on mode transitions so stale frames do not
-        // pollute first predictions after switching workflows.
-        resetInferenceWindow();
 
-        // Update device info when mode changes
-        updateDeviceInfo();
+        if (uptimeSeconds % JITTER_REPORT_INTERVAL_S == 0) {
+          reportJitterStats();
+        }
+        updateMemoryStats();
       }
 
-      // Handle model upload commands
-      handleModelUpload();
-
-      // Skip sensor sampling during model upload to keep the main loop fast.
-      // This prevents BLE chunk writes from being missed due to the firmware
-      // being busy with sensor reads while the next chunk arrives.
-      if (getUploadState() == UPLOAD_RECEIVING) {
-        delay(1);
-        continue;
+#if PROFILING_ENABLED
+      if (millis() - lastDiagnosticsUpdate >= PROFILE_REPORT_INTERVAL_MS) {
+        lastDiagnosticsUpdate = millis();
+        updateDiagnostics();
       }
-
-      // Sample at configured rate
-      if (millis() - lastSampleTime >= sampleIntervalMs) {
+#endif
+      handleSerialCommand();
+
+      // Mode changes, stream format negotiation and model upload commands.
+      // Writes are queued as they arrive, so sampling keeps running during
+      // an upload without losing any.
+      processBleWrites();
+      continueModelSave();
+
+      if (isSamplerRunning()) {
+        // Drain everything the sampler thread queued since the last pass
+        TimedSample sample;
+        while (getSampleRing().pop(sample)) {
+          totalSamples++;
+          acquireSample(sample.packet, sample.timestampUs);
+        }
+      } else if (millis() - lastSampleTime >= sensor->getPollIntervalMs()) {
+        // Sample at configured rate (or drain the hardware FIFO)
         lastSampleTime = millis();
 
-        SensorPacket packet;
-        if (sensor->read(packet)) {
+        SensorPacket batch[SENSOR_BATCH_MAX_SAMPLES];
+        uint32_t batchTimesUs[SENSOR_BATCH_MAX_SAMPLES];
+        int count =
+            sensor->readBatch(batch, batchTimesUs, SENSOR_BATCH_MAX_SAMPLES);
+        for (int i = 0; i < count; i++) {
           totalSamples++;
-
-          if (currentMode == MODE_COLLECT) {
-            // Stream raw sensor data over BLE
-            sensorChar.writeValue((uint8_t *)&packet, sizeof(packet));
-
-          } else if (currentMode == MODE_INFERENCE) {
-            // Add sample to inference buffer
-            addSample(packet.ax, packet.ay, packet.az, packet.gx, packet.gy,
-                      packet.gz);
-
-            // Run inference when window is ready
-            if (isWindowReady()) {
-              float confidence;
-              int prediction = runInference(&confidence);
-
-              if (prediction >= 0) {
-                // Send inference result
-                uint8_t result[4];
-                result[0] = (uint8_t)prediction;
-                result[1] = (uint8_t)(confidence * 100);
-                result[2] = INFERENCE_STATUS_NONE;
-                result[3] = 0; // Reserved
-
-                inferenceChar.writeValue(result, 4);
-                inferenceCount++;
-
-                DEBUG_PRINT("Prediction: ");
-                DEBUG_PRINT(prediction);
-                DEBUG_PRINT(" (");
-                DEBUG_PRINT((int)(confidence * 100));
-                DEBUG_PRINTLN("%)");
-              } else if (!isModelLoaded()) {
-                // Explicit no-model signal for the web app UI.
-                uint8_t result[4];
-                result[0] = INFERENCE_PREDICTION_NO_MODEL;
-                result[1] = 0;
-                result[2] = INFERENCE_STATUS_NO_MODEL;
-                result[3] = 0;
-
-                inferenceChar.writeValue(result, 4);
-              }
-
-              // Slide window for next inference
-              slideWindow();
-            }
-          }
+          acquireSample(batch[i], batchTimesUs[i]);
         }
       }
+      // A batch still waits for samples if reads stalled
+      flushStaleSensorBatch();
 
       // Small delay to prevent busy-waiting
       delay(1);
@@ -516,6 +1248,9 @@ void loop() {
     DEBUG_PRINTLN(central.address());
   }
 
-  // Small delay when not connected
+  // Small delay when not connected (a save the host left behind still
+  // finishes)
+  handleSerialCommand();
+  continueModelSave();
   delay(10);
 }
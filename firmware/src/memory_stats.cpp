@@ -0,0 +1,117 @@
+#include "memory_stats.h"
+#include <Arduino.h>
+#include "sampler.h"
+
+static MemoryStats memoryStats;
+
+void paintStackRegion(uint32_t* bottom, uint32_t* end) {
+    for (volatile uint32_t* word = bottom; word < end; word++) {
+        *word = STACK_PAINT_WORD;
+    }
+}
+
+size_t unusedStackBytes(const uint32_t* bottom, const uint32_t* end) {
+    const uint32_t* word = bottom;
+    while (word < end && *word == STACK_PAINT_WORD) {
+        word++;
+    }
+    return (size_t)(word - bottom) * sizeof(uint32_t);
+}
+
+// ============================================================================
+// Platform
+// ============================================================================
+
+#if defined(ARDUINO_ARCH_MBED)
+#include <malloc.h>
+#include <unistd.h>
+#include <rtos.h>
+#include "rtx_os.h"
+
+// Heap bounds set up by mbed_sdk_init() from the linker script
+extern "C" unsigned char* mbed_heap_start;
+extern "C" uint32_t mbed_heap_size;
+
+static uint32_t* mainStackBottom = nullptr;
+static uint32_t* mainStackEnd = nullptr;
+
+static void paintMainStack() {
+    const osRtxThread_t* thread = (const osRtxThread_t*)osThreadGetId();
+    if (thread == nullptr || thread->stack_mem == nullptr) {
+        return;
+    }
+    // Word 0 is RTX's overflow canary: leave it alone
+    mainStackBottom = (uint32_t*)thread->stack_mem + 1;
+    mainStackEnd = (uint32_t*)((uint8_t*)thread->stack_mem + thread->stack_size);
+    memoryStats.stackSize = thread->stack_size;
+
+    uint32_t marker = 0;
+    uint32_t* paintEnd = &marker - STACK_PAINT_GUARD_WORDS;
+    if (paintEnd > mainStackBottom) {
+        paintStackRegion(mainStackBottom, paintEnd);
+    }
+}
+
+static void measureStacks() {
+    if (mainStackBottom != nullptr) {
+        memoryStats.stackPeakBytes =
+            memoryStats.stackSize - sizeof(uint32_t) -
+            (uint32_t)unusedStackBytes(mainStackBottom, mainStackEnd);
+    }
+    getSamplerStackUsage(&memoryStats.samplerStackSize, &memoryStats.samplerStackPeakBytes);
+}
+
+static uint32_t measureHeapFree() {
+    const unsigned char* heapEnd = mbed_heap_start + mbed_heap_size;
+    const unsigned char* brk = (const unsigned char*)sbrk(0);
+    const struct mallinfo info = mallinfo();
+    return (uint32_t)(heapEnd - brk) + (uint32_t)info.fordblks;
+}
+
+#else
+
+static void paintMainStack() {}
+
+static void measureStacks() {
+    getSamplerStackUsage(&memoryStats.samplerStackSize, &memoryStats.samplerStackPeakBytes);
+}
+
+static uint32_t measureHeapFree() {
+    return 0;
+}
+
+#endif
+
+// ============================================================================
+// Tracking
+// ============================================================================
+
+void beginMemoryStats() {
+    memset(&memoryStats, 0, sizeof(memoryStats));
+    paintMainStack();
+    memoryStats.heapMinFreeBytes = UINT32_MAX;
+    updateMemoryStats();
+}
+
+void updateMemoryStats() {
+    measureStacks();
+
+    const uint32_t heapFree = measureHeapFree();
+    memoryStats.heapFreeBytes = heapFree;
+    if (heapFree == 0) {
+        memoryStats.heapMinFreeBytes = 0;  // Not measurable here
+        return;
+    }
+    if (heapFree < memoryStats.heapMinFreeBytes) {
+        memoryStats.heapMinFreeBytes = heapFree;
+    }
+    if (!memoryStats.heapLow && memoryStats.heapMinFreeBytes < MIN_FREE_HEAP_BYTES) {
+        memoryStats.heapLow = true;
+        DEBUG_PRINT("WARNING: free heap below MIN_FREE_HEAP_BYTES: ");
+        DEBUG_PRINTLN(memoryStats.heapMinFreeBytes);
+    }
+}
+
+const MemoryStats& getMemoryStats() {
+    return memoryStats;
+}
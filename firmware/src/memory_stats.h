@@ -0,0 +1,58 @@
+#ifndef MEMORY_STATS_H
+#define MEMORY_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================================
+// Runtime RAM Telemetry
+// ============================================================================
+//
+// Static RAM (the model buffers, sample windows, BLE tables) is fixed at link
+// time; scripts/ram_report.py breaks it down per module after every board
+// build. What is left is shared by the heap and the thread stacks, and that
+// is what this module watches at runtime:
+//
+// - Stack: beginMemoryStats() paints the unused part of the main thread's
+//   stack with STACK_PAINT_WORD. The deepest word no longer holding the
+//   pattern is the high-water mark, so a 2.4 KB array in a rarely-taken
+//   path still shows up once it has run. The sampler thread's stack is
+//   pre-filled by mbed and measured the same way.
+// - Heap: free = untouched heap above the break + free malloc chunks. The
+//   minimum is tracked over updateMemoryStats() calls (once a second), so
+//   a short-lived peak between samples can be missed.
+//
+// Falling below MIN_FREE_HEAP_BYTES is logged once and latched in heapLow.
+// Stack and heap read 0 where they cannot be measured (native env).
+// ============================================================================
+
+#define STACK_PAINT_WORD 0xA5A5A5A5u
+#define STACK_PAINT_GUARD_WORDS 64  // Left unpainted below the caller's frame
+
+struct MemoryStats {
+    uint32_t stackSize;            // Main thread stack
+    uint32_t stackPeakBytes;       // Deepest main stack use since boot
+    uint32_t samplerStackSize;
+    uint32_t samplerStackPeakBytes;
+    uint32_t heapFreeBytes;
+    uint32_t heapMinFreeBytes;
+    bool heapLow;                  // heapMinFreeBytes < MIN_FREE_HEAP_BYTES
+};
+
+// Paint the main stack; call first thing in setup()
+void beginMemoryStats();
+
+// Re-measure heap and stacks
+void updateMemoryStats();
+
+const MemoryStats& getMemoryStats();
+
+// Fill [bottom, end) with STACK_PAINT_WORD
+void paintStackRegion(uint32_t* bottom, uint32_t* end);
+
+// Bytes from bottom that still hold the paint, i.e. were never used by a
+// stack growing down towards bottom
+size_t unusedStackBytes(const uint32_t* bottom, const uint32_t* end);
+
+#endif // MEMORY_STATS_H
@@ -0,0 +1,262 @@
+#include "model_codec.h"
+#include <string.h>
+
+#define RANGE_TOP (1u << 24)
+#define PROB_ONE (1u << MODEL_CODEC_PROB_BITS)
+#define PROB_INITIAL (PROB_ONE / 2)
+
+static void resetProbabilities(uint16_t probs[MODEL_CODEC_LANES][256]) {
+    for (uint32_t lane = 0; lane < MODEL_CODEC_LANES; lane++) {
+        for (uint32_t node = 0; node < 256; node++) {
+            probs[lane][node] = PROB_INITIAL;
+        }
+    }
+}
+
+// ============================================================================
+// Decoder
+// ============================================================================
+
+ModelUploadDecoder::ModelUploadDecoder() {
+    begin(nullptr);
+}
+
+void ModelUploadDecoder::begin(StoredModelData* target, uint32_t baseSize) {
+    wireDecoder.begin(target, baseSize);
+    stage = STAGE_MAGIC;
+    packed = false;
+    memset(header, 0, sizeof(header));
+    headerBytes = 0;
+    unpackedSize = 0;
+    payloadBytes = 0;
+    range = 0xFFFFFFFF;
+    code = 0;
+    initBytes = 0;
+    treeNode = 1;
+    trailingBytes = 0;
+    resetProbabilities(probs);
+    outCount = 0;
+}
+
+bool ModelUploadDecoder::write(const uint8_t* data, uint32_t length) {
+    // The magic decides between packed and plain; a plain payload's first
+    // word goes to the wire decoder like the rest of it
+    while (length > 0 && (stage == STAGE_MAGIC || stage == STAGE_HEADER)) {
+        ((uint8_t*)header)[headerBytes++] = *data++;
+        length--;
+        if (stage == STAGE_MAGIC && headerBytes == sizeof(uint32_t)) {
+            if (header[0] == MODEL_PACKED_MAGIC) {
+                packed = true;
+                stage = STAGE_HEADER;
+            } else {
+                stage = STAGE_PLAIN;
+                payloadBytes = sizeof(uint32_t);
+                if (!wireDecoder.write((const uint8_t*)header, sizeof(uint32_t))) {
+                    stage = STAGE_FAILED;
+                    return false;
+                }
+            }
+        } else if (stage == STAGE_HEADER && headerBytes == MODEL_PACKED_HEADER_SIZE) {
+            unpackedSize = header[1];
+            if (unpackedSize < sizeof(uint32_t) || unpackedSize > sizeof(StoredModelData)) {
+                stage = STAGE_FAILED;
+                return false;
+            }
+            stage = STAGE_CODER_INIT;
+        }
+    }
+
+    switch (stage) {
+    case STAGE_PLAIN:
+        if (length > 0 && !wireDecoder.write(data, length)) {
+            stage = STAGE_FAILED;
+            return false;
+        }
+        payloadBytes += length;
+        return true;
+
+    case STAGE_CODER_INIT:
+    case STAGE_BITS:
+        if (!decodeBits(data, length) || !flushOutput()) {
+            stage = STAGE_FAILED;
+            return false;
+        }
+        return true;
+
+    case STAGE_DONE:
+        return acceptFlushBytes(length);
+
+    case STAGE_MAGIC:
+    case STAGE_HEADER:
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool ModelUploadDecoder::decodeBits(const uint8_t*& data, uint32_t& length) {
+    while (stage == STAGE_CODER_INIT && length > 0) {
+        code = (code << 8) | *data++;
+        length--;
+        if (++initBytes == 5) {
+            stage = STAGE_BITS;
+        }
+    }
+
+    while (stage == STAGE_BITS) {
+        // Normalise before each bit, so a bit never waits for input halfway
+        if (range < RANGE_TOP) {
+            if (length == 0) {
+                return true;  // Resume with the next chunk
+            }
+            range <<= 8;
+            code = (code << 8) | *data++;
+            length--;
+        }
+
+        uint16_t& prob = probs[(payloadBytes + outCount) % MODEL_CODEC_LANES][treeNode];
+        const uint32_t bound = (range >> MODEL_CODEC_PROB_BITS) * prob;
+        if (code < bound) {
+            range = bound;
+            prob += (PROB_ONE - prob) >> MODEL_CODEC_MOVE_BITS;
+            treeNode <<= 1;
+        } else {
+            range -= bound;
+            code -= bound;
+            prob -= prob >> MODEL_CODEC_MOVE_BITS;
+            treeNode = (treeNode << 1) | 1;
+        }
+
+        if (treeNode >= 256) {
+            outBuffer[outCount++] = (uint8_t)(treeNode - 256);
+            treeNode = 1;
+            if (outCount == MODEL_CODEC_OUT_BUFFER && !flushOutput()) {
+                return false;
+            }
+            if (payloadBytes + outCount == unpackedSize) {
+                stage = STAGE_DONE;
+            }
+        }
+    }
+
+    return stage != STAGE_DONE || acceptFlushBytes(length);
+}
+
+// The encoder flushes 5 bytes but the last bits only need some of them:
+// the rest arrive after the payload is complete and are ignored
+bool ModelUploadDecoder::acceptFlushBytes(uint32_t length) {
+    trailingBytes += length;
+    return trailingBytes <= MODEL_CODEC_MAX_TRAILING;
+}
+
+bool ModelUploadDecoder::flushOutput() {
+    if (outCount == 0) {
+        return true;
+    }
+    const bool ok = wireDecoder.write(outBuffer, outCount);
+    payloadBytes += outCount;
+    outCount = 0;
+    return ok;
+}
+
+bool ModelUploadDecoder::isComplete() const {
+    return (packed ? stage == STAGE_DONE : stage == STAGE_PLAIN) && wireDecoder.isComplete();
+}
+
+// ============================================================================
+// Reference Encoder
+// ============================================================================
+
+namespace {
+
+class RangeEncoder {
+public:
+    RangeEncoder(uint8_t* out, uint32_t capacity)
+        : out(out), capacity(capacity), size(0), low(0), range(0xFFFFFFFF),
+          cache(0), cacheSize(1) {}
+
+    void encodeBit(uint16_t& prob, uint32_t bit) {
+        const uint32_t bound = (range >> MODEL_CODEC_PROB_BITS) * prob;
+        if (bit == 0) {
+            range = bound;
+            prob += (PROB_ONE - prob) >> MODEL_CODEC_MOVE_BITS;
+        } else {
+            low += bound;
+            range -= bound;
+            prob -= prob >> MODEL_CODEC_MOVE_BITS;
+        }
+        while (range < RANGE_TOP) {
+            range <<= 8;
+            shiftLow();
+        }
+    }
+
+    void flush() {
+        for (int i = 0; i < 5; i++) {
+            shiftLow();
+        }
+    }
+
+    // 0 if the output did not fit
+    uint32_t getSize() const { return size <= capacity ? size : 0; }
+
+private:
+    uint8_t* out;
+    uint32_t capacity;
+    uint32_t size;
+    uint64_t low;
+    uint32_t range;
+    uint8_t cache;
+    uint64_t cacheSize;
+
+    void emit(uint8_t value) {
+        if (size < capacity) {
+            out[size] = value;
+        }
+        size++;
+    }
+
+    // Bytes are held back while a carry could still change them
+    void shiftLow() {
+        if ((uint32_t)low < 0xFF000000u || (low >> 32) != 0) {
+            const uint8_t carry = (uint8_t)(low >> 32);
+            uint8_t pending = cache;
+            do {
+                emit((uint8_t)(pending + carry));
+                pending = 0xFF;
+            } while (--cacheSize != 0);
+            cache = (uint8_t)((uint32_t)low >> 24);
+        }
+        cacheSize++;
+        low = (uint32_t)low << 8;
+    }
+};
+
+}  // namespace
+
+uint32_t packModelPayload(const uint8_t* payload, uint32_t size, uint8_t* out, uint32_t capacity) {
+    if (capacity < MODEL_PACKED_HEADER_SIZE) {
+        return 0;
+    }
+    const uint32_t header[2] = {MODEL_PACKED_MAGIC, size};
+    memcpy(out, header, sizeof(header));
+
+    uint16_t probs[MODEL_CODEC_LANES][256];
+    resetProbabilities(probs);
+
+    RangeEncoder encoder(out + MODEL_PACKED_HEADER_SIZE, capacity - MODEL_PACKED_HEADER_SIZE);
+    for (uint32_t i = 0; i < size; i++) {
+        uint16_t* tree = probs[i % MODEL_CODEC_LANES];
+        uint32_t node = 1;
+        for (int bit = 7; bit >= 0; bit--) {
+            const uint32_t value = (payload[i] >> bit) & 1;
+            encoder.encodeBit(tree[node], value);
+            node = (node << 1) | value;
+        }
+    }
+    encoder.flush();
+
+    const uint32_t packedSize = encoder.getSize();
+    return packedSize == 0 ? 0 : MODEL_PACKED_HEADER_SIZE + packedSize;
+}
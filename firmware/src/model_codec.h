@@ -0,0 +1,123 @@
+#ifndef MODEL_CODEC_H
+#define MODEL_CODEC_H
+
+#include <stdint.h>
+#include "model_format.h"
+
+// ============================================================================
+// Packed (Entropy-Coded) Model Uploads
+// ============================================================================
+//
+// A FULL, COMPACT or DELTA payload (model_format.h) can be sent packed:
+//
+//   u32 magic "SNNZ", u32 unpackedSize, range-coded bytes
+//
+// The coder is LZMA's adaptive binary range coder: each byte is coded as
+// 8 bits down a 255-node bit tree, with one tree per byte lane (payload
+// offset % 4). Floats in the payload are 4-byte aligned, so the lanes are
+// the byte planes of a byte-shuffle: the sign/exponent lane codes in about
+// 2 bits, the mantissa lanes stay close to 8. No tables are sent; both
+// sides adapt from the same starting probabilities.
+//
+// Float weights are mostly mantissa noise, so lossless packing saves about
+// 17% (1.2x) on a trained model. Zero padding in FULL payloads packs to
+// almost nothing, but COMPACT payloads do not have any.
+//
+// ModelUploadDecoder unpacks in receiveModelChunk order with a fixed
+// working set (MODEL_CODEC_STATE_BYTES): the bit trees, the coder state
+// and a small output buffer. The packed bytes are never stored. Uploads
+// that are not packed go straight to the ModelWireDecoder.
+// ============================================================================
+
+// "SNNZ" (Simple Neural Network, Zipped)
+#define MODEL_PACKED_MAGIC 0x5A4E4E53
+#define MODEL_PACKED_HEADER_SIZE (2 * sizeof(uint32_t))
+
+#define MODEL_CODEC_LANES 4
+#define MODEL_CODEC_PROB_BITS 11
+#define MODEL_CODEC_MOVE_BITS 5
+#define MODEL_CODEC_OUT_BUFFER 64
+#define MODEL_CODEC_MAX_TRAILING 4  // Unread coder flush bytes
+
+// Probabilities never pass (2048 - 31) / 2048, so every coded bit costs
+// more than 1/64 of a bit and every payload byte more than 1/64 of a byte
+#define MODEL_PACKED_MIN_SIZE (MODEL_PACKED_HEADER_SIZE + SIMPLE_NN_COMPACT_MIN_SIZE / 64)
+
+// Smallest upload of any format: a DELTA without patches can pack down to
+// the packed header and the coder's 5 initial bytes
+#define MODEL_UPLOAD_MIN_SIZE (MODEL_PACKED_HEADER_SIZE + 5)
+
+class ModelUploadDecoder {
+public:
+    ModelUploadDecoder();
+
+    /**
+     * Start a new upload into target, which holds a base model of baseSize
+     * bytes for DELTA payloads (see ModelWireDecoder::begin)
+     */
+    void begin(StoredModelData* target, uint32_t baseSize = 0);
+
+    /**
+     * Consume the next upload bytes, unpacking them if needed.
+     * @return false once the upload is malformed
+     */
+    bool write(const uint8_t* data, uint32_t length);
+
+    bool isPacked() const { return packed; }
+
+    /**
+     * True when the payload (unpacked if needed) is complete
+     */
+    bool isComplete() const;
+
+    /**
+     * Payload bytes handed to the wire decoder so far
+     */
+    uint32_t getPayloadSize() const { return payloadBytes; }
+
+    const ModelWireDecoder& getWireDecoder() const { return wireDecoder; }
+
+private:
+    enum Stage {
+        STAGE_MAGIC,
+        STAGE_PLAIN,           // Not packed: pass through
+        STAGE_HEADER,
+        STAGE_CODER_INIT,      // First 5 coder bytes
+        STAGE_BITS,
+        STAGE_DONE,
+        STAGE_FAILED
+    };
+
+    ModelWireDecoder wireDecoder;
+    Stage stage;
+    bool packed;
+    uint32_t header[2];
+    uint32_t headerBytes;
+    uint32_t unpackedSize;
+    uint32_t payloadBytes;     // Unpacked bytes produced (or passed through)
+
+    // Range decoder (resumable between chunks)
+    uint32_t range;
+    uint32_t code;
+    uint32_t initBytes;
+    uint32_t treeNode;         // 1..255 inside the current byte's bit tree
+    uint32_t trailingBytes;
+    uint16_t probs[MODEL_CODEC_LANES][256];
+
+    uint8_t outBuffer[MODEL_CODEC_OUT_BUFFER];
+    uint32_t outCount;
+
+    bool decodeBits(const uint8_t*& data, uint32_t& length);
+    bool flushOutput();
+    bool acceptFlushBytes(uint32_t length);
+};
+
+#define MODEL_CODEC_STATE_BYTES (sizeof(uint16_t) * MODEL_CODEC_LANES * 256 + MODEL_CODEC_OUT_BUFFER)
+
+/**
+ * Reference encoder: pack a FULL, COMPACT or DELTA payload. Returns the packed
+ * size, or 0 if capacity is too small.
+ */
+uint32_t packModelPayload(const uint8_t* payload, uint32_t size, uint8_t* out, uint32_t capacity);
+
+#endif // MODEL_CODEC_H
@@ -0,0 +1,440 @@
+#include "model_format.h"
+#include <stddef.h>
+#include <string.h>
+
+static_assert(SIMPLE_NN_DELTA_HEADER_SIZE >= SIMPLE_NN_COMPACT_HEADER_SIZE,
+              "The decoder keeps every header in one buffer");
+
+bool getModelTensorRange(uint32_t tensor, uint32_t* start, uint32_t* size) {
+    switch (tensor) {
+    case MODEL_TENSOR_HEADER:
+        *start = 0;
+        *size = offsetof(SimpleNNModel, hiddenWeights);
+        return true;
+    case MODEL_TENSOR_HIDDEN_WEIGHTS:
+        *start = offsetof(SimpleNNModel, hiddenWeights);
+        *size = sizeof(SimpleNNModel::hiddenWeights);
+        return true;
+    case MODEL_TENSOR_HIDDEN_BIAS:
+        *start = offsetof(SimpleNNModel, hiddenBias);
+        *size = sizeof(SimpleNNModel::hiddenBias);
+        return true;
+    case MODEL_TENSOR_OUTPUT_WEIGHTS:
+        *start = offsetof(SimpleNNModel, outputWeights);
+        *size = sizeof(SimpleNNModel::outputWeights);
+        return true;
+    case MODEL_TENSOR_OUTPUT_BIAS:
+        *start = offsetof(SimpleNNModel, outputBias);
+        *size = sizeof(SimpleNNModel::outputBias);
+        return true;
+    case MODEL_TENSOR_LABELS:
+        *start = offsetof(SimpleNNModel, labels);
+        *size = sizeof(SimpleNNModel::labels);
+        return true;
+    case MODEL_TENSOR_EXTRA_HEADS:
+        *start = offsetof(StoredModelData, extraHeads);
+        *size = sizeof(SimpleNNExtraHeads);
+        return true;
+    default:
+        return false;
+    }
+}
+
+ModelWireDecoder::ModelWireDecoder() {
+    begin(nullptr);
+}
+
+void ModelWireDecoder::begin(StoredModelData* model, uint32_t baseBytes) {
+    target = model;
+    baseSize = baseBytes;
+    resultSize = 0;
+    resultCrc = 0;
+    patchesLeft = 0;
+    baseMismatch = false;
+    targetWritten = false;
+    format = MODEL_WIRE_UNKNOWN;
+    rawBytes = 0;
+    numExtraHeads = 0;
+    head = 0;
+    labelIndex = 0;
+    labelLength = 0;
+    memset(header, 0, sizeof(header));
+    startSegment(STAGE_MAGIC, header, sizeof(uint32_t));
+}
+
+void ModelWireDecoder::startSegment(Stage next, void* destination, uint32_t length) {
+    stage = next;
+    dst = (uint8_t*)destination;
+    remaining = length;
+}
+
+bool ModelWireDecoder::write(const uint8_t* data, uint32_t length) {
+    while (length > 0) {
+        if (stage == STAGE_FAILED || stage == STAGE_DONE) {
+            stage = STAGE_FAILED;  // Bytes past the end of the payload
+            return false;
+        }
+        if (stage == STAGE_LABELS) {
+            if (!writeLabelByte(*data)) {
+                stage = STAGE_FAILED;
+                return false;
+            }
+            data++;
+            length--;
+            continue;
+        }
+
+        const uint32_t n = length < remaining ? length : remaining;
+        memcpy(dst, data, n);
+        dst += n;
+        remaining -= n;
+        data += n;
+        length -= n;
+        if (stage == STAGE_RAW) {
+            rawBytes += n;
+        }
+
+        if (remaining == 0 && !finishSegment()) {
+            stage = STAGE_FAILED;
+            return false;
+        }
+    }
+    return stage != STAGE_FAILED;
+}
+
+bool ModelWireDecoder::finishSegment() {
+    const uint32_t floatsPerClass = NN_HIDDEN_SIZE * sizeof(float);
+
+    switch (stage) {
+    case STAGE_MAGIC:
+        if (header[0] == SIMPLE_NN_COMPACT_MAGIC) {
+            format = MODEL_WIRE_COMPACT;
+            targetWritten = true;
+            memset(target, 0, sizeof(StoredModelData));
+            startSegment(STAGE_COMPACT_HEADER, &header[1],
+                         SIMPLE_NN_COMPACT_HEADER_SIZE - sizeof(uint32_t));
+            return true;
+        }
+        if (header[0] == SIMPLE_NN_DELTA_MAGIC) {
+            format = MODEL_WIRE_DELTA;
+            startSegment(STAGE_DELTA_HEADER, &header[1],
+                         SIMPLE_NN_DELTA_HEADER_SIZE - sizeof(uint32_t));
+            return true;
+        }
+        // Anything else is copied as is; a bad magic is reported by the
+        // model validation after the CRC check, as before
+        format = MODEL_WIRE_FULL;
+        targetWritten = true;
+        memset(target, 0, sizeof(StoredModelData));
+        memcpy(target, header, sizeof(uint32_t));
+        rawBytes = sizeof(uint32_t);
+        startSegment(STAGE_RAW, (uint8_t*)target + sizeof(uint32_t),
+                     sizeof(StoredModelData) - sizeof(uint32_t));
+        return true;
+
+    case STAGE_RAW:
+        // StoredModelData is full: any further byte is an error
+        stage = STAGE_DONE;
+        return true;
+
+    case STAGE_COMPACT_HEADER: {
+        const uint32_t numClasses = header[1];
+        numExtraHeads = header[4];
+        if (numClasses < 1 || numClasses > NN_MAX_CLASSES ||
+            header[2] != NN_INPUT_SIZE || header[3] != NN_HIDDEN_SIZE ||
+            numExtraHeads >= NN_MAX_HEADS) {
+            return false;
+        }
+        target->model.magic = SIMPLE_NN_MAGIC;
+        target->model.numClasses = numClasses;
+        target->model.inputSize = NN_INPUT_SIZE;
+        target->model.hiddenSize = NN_HIDDEN_SIZE;
+        if (numExtraHeads > 0) {
+            target->extraHeads.magic = SIMPLE_NN_HEADS_MAGIC;
+            target->extraHeads.numExtraHeads = numExtraHeads;
+        }
+        startSegment(STAGE_HIDDEN_WEIGHTS, target->model.hiddenWeights,
+                     sizeof(target->model.hiddenWeights));
+        return true;
+    }
+
+    case STAGE_HIDDEN_WEIGHTS:
+        startSegment(STAGE_HIDDEN_BIAS, target->model.hiddenBias,
+                     sizeof(target->model.hiddenBias));
+        return true;
+
+    case STAGE_HIDDEN_BIAS:
+        startSegment(STAGE_OUTPUT_WEIGHTS, target->model.outputWeights,
+                     target->model.numClasses * floatsPerClass);
+        return true;
+
+    case STAGE_OUTPUT_WEIGHTS:
+        startSegment(STAGE_OUTPUT_BIAS, target->model.outputBias,
+                     target->model.numClasses * sizeof(float));
+        return true;
+
+    case STAGE_OUTPUT_BIAS:
+        startHeadOrLabels();
+        return true;
+
+    case STAGE_HEAD_CLASSES: {
+        SimpleNNHead& current = target->extraHeads.heads[head];
+        if (current.numClasses < 1 || current.numClasses > NN_MAX_CLASSES) {
+            return false;
+        }
+        startSegment(STAGE_HEAD_WEIGHTS, current.outputWeights,
+                     current.numClasses * floatsPerClass);
+        return true;
+    }
+
+    case STAGE_HEAD_WEIGHTS: {
+        SimpleNNHead& current = target->extraHeads.heads[head];
+        startSegment(STAGE_HEAD_BIAS, current.outputBias,
+                     current.numClasses * sizeof(float));
+        return true;
+    }
+
+    case STAGE_HEAD_BIAS:
+        head++;
+        startHeadOrLabels();
+        return true;
+
+    case STAGE_DELTA_HEADER:
+        return startDelta();
+
+    case STAGE_PATCH_HEADER:
+        return startPatch();
+
+    case STAGE_PATCH_DATA:
+        patchesLeft--;
+        startPatchOrDone();
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+void ModelWireDecoder::startHeadOrLabels() {
+    if (head < numExtraHeads) {
+        SimpleNNHead& next = target->extraHeads.heads[head];
+        startSegment(STAGE_HEAD_CLASSES, &next.numClasses, sizeof(next.numClasses));
+    } else {
+        startSegment(STAGE_LABELS, nullptr, 0);
+    }
+}
+
+// Header: baseCrc, baseSize, resultSize, resultCrc, patchCount
+bool ModelWireDecoder::startDelta() {
+    if (header[2] == 0 || header[2] != baseSize ||
+        calculateCrc32((const uint8_t*)target, baseSize) != header[1]) {
+        baseMismatch = true;
+        return false;
+    }
+    resultSize = header[3];
+    resultCrc = header[4];
+    patchesLeft = header[5];
+    if (resultSize < sizeof(SimpleNNModel) || resultSize > sizeof(StoredModelData)) {
+        return false;
+    }
+    // Whatever the result does not patch past the base reads as zeros, and
+    // a shorter result leaves nothing of the base behind it
+    const uint32_t kept = baseSize < resultSize ? baseSize : resultSize;
+    targetWritten = true;
+    memset((uint8_t*)target + kept, 0, sizeof(StoredModelData) - kept);
+    startPatchOrDone();
+    return true;
+}
+
+// Patch header: tensor, offset, length
+bool ModelWireDecoder::startPatch() {
+    uint32_t start;
+    uint32_t size;
+    const uint32_t offset = header[1];
+    const uint32_t length = header[2];
+    if (!getModelTensorRange(header[0], &start, &size) ||
+        length == 0 || offset > size || length > size - offset ||
+        start + offset + length > resultSize) {
+        return false;
+    }
+    startSegment(STAGE_PATCH_DATA, (uint8_t*)target + start + offset, length);
+    return true;
+}
+
+void ModelWireDecoder::startPatchOrDone() {
+    if (patchesLeft == 0) {
+        stage = STAGE_DONE;
+    } else {
+        startSegment(STAGE_PATCH_HEADER, header, SIMPLE_NN_PATCH_HEADER_SIZE);
+    }
+}
+
+uint32_t ModelWireDecoder::totalLabels() const {
+    uint32_t total = target->model.numClasses;
+    for (uint32_t h = 0; h < numExtraHeads; h++) {
+        total += target->extraHeads.heads[h].numClasses;
+    }
+    return total;
+}
+
+char* ModelWireDecoder::labelSlot(uint32_t index) {
+    if (index < target->model.numClasses) {
+        return target->model.labels[index];
+    }
+    index -= target->model.numClasses;
+    for (uint32_t h = 0; h < numExtraHeads; h++) {
+        SimpleNNHead& current = target->extraHeads.heads[h];
+        if (index < current.numClasses) {
+            return current.labels[index];
+        }
+        index -= current.numClasses;
+    }
+    return nullptr;
+}
+
+bool ModelWireDecoder::writeLabelByte(uint8_t value) {
+    char* label = labelSlot(labelIndex);
+    if (label == nullptr) {
+        return false;
+    }
+    if (value == 0) {
+        labelIndex++;
+        labelLength = 0;
+        if (labelIndex == totalLabels()) {
+            stage = STAGE_DONE;
+        }
+        return true;
+    }
+    // Longer labels are cut to fit; the zeroed target terminates them
+    if (labelLength < LABEL_MAX_LEN - 1) {
+        label[labelLength] = (char)value;
+    }
+    labelLength++;
+    return true;
+}
+
+bool ModelWireDecoder::isComplete() const {
+    return stage == STAGE_DONE || (format == MODEL_WIRE_FULL && stage == STAGE_RAW);
+}
+
+uint32_t ModelWireDecoder::getStoredSize() const {
+    if (format == MODEL_WIRE_FULL) {
+        return rawBytes;
+    }
+    if (format == MODEL_WIRE_DELTA) {
+        return resultSize;
+    }
+    return SIMPLE_NN_UPLOAD_SIZE(numExtraHeads);
+}
+
+// ============================================================================
+// Reference Encoder
+// ============================================================================
+
+uint32_t encodeCompactModel(const StoredModelData& model, uint32_t storedSize,
+                            uint8_t* out, uint32_t capacity) {
+    const uint32_t extraHeads =
+        storedSize > sizeof(SimpleNNModel) ? model.extraHeads.numExtraHeads : 0;
+    if (model.model.numClasses > NN_MAX_CLASSES || extraHeads >= NN_MAX_HEADS) {
+        return 0;
+    }
+    for (uint32_t h = 0; h < extraHeads; h++) {
+        if (model.extraHeads.heads[h].numClasses > NN_MAX_CLASSES) {
+            return 0;
+        }
+    }
+    uint32_t size = 0;
+    bool fits = true;
+
+    auto append = [&](const void* data, uint32_t length) {
+        if (!fits || size + length > capacity) {
+            fits = false;
+            return;
+        }
+        memcpy(&out[size], data, length);
+        size += length;
+    };
+    auto appendLabels = [&](const char (*labels)[LABEL_MAX_LEN], uint32_t count) {
+        for (uint32_t i = 0; i < count; i++) {
+            append(labels[i], (uint32_t)strnlen(labels[i], LABEL_MAX_LEN - 1));
+            append("", 1);
+        }
+    };
+
+    const uint32_t header[5] = {SIMPLE_NN_COMPACT_MAGIC, model.model.numClasses,
+                                model.model.inputSize, model.model.hiddenSize, extraHeads};
+    append(header, sizeof(header));
+    append(model.model.hiddenWeights, sizeof(model.model.hiddenWeights));
+    append(model.model.hiddenBias, sizeof(model.model.hiddenBias));
+    append(model.model.outputWeights, model.model.numClasses * NN_HIDDEN_SIZE * sizeof(float));
+    append(model.model.outputBias, model.model.numClasses * sizeof(float));
+    for (uint32_t h = 0; h < extraHeads; h++) {
+        const SimpleNNHead& current = model.extraHeads.heads[h];
+        append(&current.numClasses, sizeof(current.numClasses));
+        append(current.outputWeights, current.numClasses * NN_HIDDEN_SIZE * sizeof(float));
+        append(current.outputBias, current.numClasses * sizeof(float));
+    }
+    appendLabels(model.model.labels, model.model.numClasses);
+    for (uint32_t h = 0; h < extraHeads; h++) {
+        appendLabels(model.extraHeads.heads[h].labels, model.extraHeads.heads[h].numClasses);
+    }
+    return fits ? size : 0;
+}
+
+uint32_t encodeModelDelta(const StoredModelData& base, uint32_t baseSize,
+                          const StoredModelData& result, uint32_t resultSize,
+                          uint8_t* out, uint32_t capacity) {
+    const uint8_t* before = (const uint8_t*)&base;
+    const uint8_t* after = (const uint8_t*)&result;
+    uint32_t size = SIMPLE_NN_DELTA_HEADER_SIZE;
+    uint32_t patchCount = 0;
+    bool fits = size <= capacity;
+
+    auto append = [&](const void* data, uint32_t length) {
+        if (!fits || size + length > capacity) {
+            fits = false;
+            return;
+        }
+        memcpy(&out[size], data, length);
+        size += length;
+    };
+    // Past the base the decoder starts from zeros
+    auto changed = [&](uint32_t pos) {
+        return after[pos] != (pos < baseSize ? before[pos] : 0);
+    };
+
+    for (uint32_t tensor = 0; tensor < MODEL_TENSOR_COUNT; tensor++) {
+        uint32_t start;
+        uint32_t tensorSize;
+        getModelTensorRange(tensor, &start, &tensorSize);
+        const uint32_t end = start + tensorSize < resultSize ? start + tensorSize : resultSize;
+
+        uint32_t pos = start;
+        while (pos < end) {
+            if (!changed(pos)) {
+                pos++;
+                continue;
+            }
+            // Extend over unchanged gaps cheaper to resend than to split at
+            uint32_t last = pos;
+            for (uint32_t next = pos + 1; next < end && next <= last + SIMPLE_NN_PATCH_HEADER_SIZE; next++) {
+                if (changed(next)) {
+                    last = next;
+                }
+            }
+            const uint32_t patch[3] = {tensor, pos - start, last + 1 - pos};
+            append(patch, sizeof(patch));
+            append(&after[pos], patch[2]);
+            patchCount++;
+            pos = last + 1;
+        }
+    }
+
+    if (!fits) {
+        return 0;
+    }
+    const uint32_t header[6] = {SIMPLE_NN_DELTA_MAGIC, calculateCrc32(before, baseSize), baseSize,
+                                resultSize, calculateCrc32(after, resultSize), patchCount};
+    memcpy(out, header, sizeof(header));
+    return size;
+}
@@ -0,0 +1,199 @@
+#ifndef MODEL_FORMAT_H
+#define MODEL_FORMAT_H
+
+#include <stdint.h>
+#include "flash_storage.h"
+
+// ============================================================================
+// Model Wire Formats
+// ============================================================================
+//
+// Three payloads can follow an upload START, told apart by their first word:
+//
+// FULL (SIMPLE_NN_MAGIC, or anything that is not the compact magic):
+// StoredModelData byte for byte, i.e. SimpleNNModel
+// with output layers and labels padded to NN_MAX_CLASSES, optionally
+// followed by the extra heads block (SIMPLE_NN_UPLOAD_SIZE).
+//
+// COMPACT (SIMPLE_NN_COMPACT_MAGIC): only what the model actually uses,
+// sized by the dimensions in its own header. All values little-endian:
+//
+//   u32 magic, numClasses, inputSize, hiddenSize, numExtraHeads
+//   f32 hiddenWeights[hiddenSize * inputSize], hiddenBias[hiddenSize]
+//   f32 outputWeights[numClasses * hiddenSize], outputBias[numClasses]
+//   per extra head: u32 numClasses, f32 weights[numClasses * hiddenSize],
+//                   f32 bias[numClasses]
+//   labels: one NUL-terminated string per class, primary head first
+//
+// DELTA (SIMPLE_NN_DELTA_MAGIC): patches against the model already on the
+// board (the base), so a retrained model only sends the tensors that
+// changed. Offsets are in the padded StoredModelData layout, whatever
+// format the base arrived in:
+//
+//   u32 magic, baseCrc, baseSize, resultSize, resultCrc, patchCount
+//   per patch: u32 tensor (ModelTensor), offset, length, u8 data[length]
+//
+// baseCrc / baseSize must match the base's stored bytes, or the upload is
+// refused before anything is written (isBaseMismatch: send a whole model
+// instead). Bytes past the base up to resultSize start as zeros. resultCrc
+// covers the patched stored bytes and is checked by the caller at the end.
+//
+// ModelWireDecoder consumes any format in order, a chunk at a time, and
+// writes straight into the padded StoredModelData that SimpleNN runs from.
+// It never holds more than one header of the payload itself.
+// ============================================================================
+
+// "SNNC" (Simple Neural Network, Compact)
+#define SIMPLE_NN_COMPACT_MAGIC 0x434E4E53
+#define SIMPLE_NN_COMPACT_HEADER_SIZE (5 * sizeof(uint32_t))
+
+// Smallest possible compact payload: one class, one 1-character label
+#define SIMPLE_NN_COMPACT_MIN_SIZE                                             \
+    (SIMPLE_NN_COMPACT_HEADER_SIZE +                                           \
+     sizeof(float) * (NN_HIDDEN_SIZE * NN_INPUT_SIZE + 2 * NN_HIDDEN_SIZE + 1) + 2)
+
+// "SNND" (Simple Neural Network, Delta)
+#define SIMPLE_NN_DELTA_MAGIC 0x444E4E53
+#define SIMPLE_NN_DELTA_HEADER_SIZE (6 * sizeof(uint32_t))
+#define SIMPLE_NN_PATCH_HEADER_SIZE (3 * sizeof(uint32_t))
+
+enum ModelWireFormat {
+    MODEL_WIRE_UNKNOWN = 0,  // First word not seen yet
+    MODEL_WIRE_FULL = 1,
+    MODEL_WIRE_COMPACT = 2,
+    MODEL_WIRE_DELTA = 3
+};
+
+// What a delta patch offset is relative to (a patch never crosses tensors)
+enum ModelTensor {
+    MODEL_TENSOR_HEADER = 0,          // magic, numClasses, inputSize, hiddenSize
+    MODEL_TENSOR_HIDDEN_WEIGHTS = 1,
+    MODEL_TENSOR_HIDDEN_BIAS = 2,
+    MODEL_TENSOR_OUTPUT_WEIGHTS = 3,  // All NN_MAX_CLASSES slots
+    MODEL_TENSOR_OUTPUT_BIAS = 4,
+    MODEL_TENSOR_LABELS = 5,
+    MODEL_TENSOR_EXTRA_HEADS = 6,     // The whole SimpleNNExtraHeads block
+    MODEL_TENSOR_COUNT
+};
+
+/**
+ * Where a tensor lives in StoredModelData
+ * @return false for an unknown tensor
+ */
+bool getModelTensorRange(uint32_t tensor, uint32_t* start, uint32_t* size);
+
+class ModelWireDecoder {
+public:
+    ModelWireDecoder();
+
+    /**
+     * Start a new payload. FULL and COMPACT payloads clear the target
+     * first; a DELTA payload patches the model already in its first
+     * baseSize bytes (0: none, and every delta is refused).
+     */
+    void begin(StoredModelData* target, uint32_t baseSize = 0);
+
+    /**
+     * Decode the next bytes of the payload.
+     * @return false once the payload is malformed (bad header, too many
+     *         bytes); every later call fails too
+     */
+    bool write(const uint8_t* data, uint32_t length);
+
+    ModelWireFormat getFormat() const { return format; }
+
+    /**
+     * True when the payload ended exactly where its format says it should
+     * (FULL payloads are size-checked by the caller instead)
+     */
+    bool isComplete() const;
+
+    /**
+     * Bytes of the target now in use, in SIMPLE_NN_UPLOAD_SIZE terms
+     */
+    uint32_t getStoredSize() const;
+
+    /**
+     * DELTA: CRC32 the stored bytes must have once patched
+     */
+    uint32_t getResultCrc() const { return resultCrc; }
+
+    /**
+     * True when a DELTA payload was refused because it was made against a
+     * different base model than the target holds
+     */
+    bool isBaseMismatch() const { return baseMismatch; }
+
+    /**
+     * True once the payload has changed the target: FULL and COMPACT
+     * payloads at their first word, DELTA ones once the base checked out.
+     * Until then the target still holds the model it held at begin().
+     */
+    bool hasWrittenTarget() const { return targetWritten; }
+
+private:
+    enum Stage {
+        STAGE_MAGIC,
+        STAGE_RAW,             // FULL: straight copy
+        STAGE_COMPACT_HEADER,
+        STAGE_HIDDEN_WEIGHTS,
+        STAGE_HIDDEN_BIAS,
+        STAGE_OUTPUT_WEIGHTS,
+        STAGE_OUTPUT_BIAS,
+        STAGE_HEAD_CLASSES,
+        STAGE_HEAD_WEIGHTS,
+        STAGE_HEAD_BIAS,
+        STAGE_LABELS,
+        STAGE_DELTA_HEADER,
+        STAGE_PATCH_HEADER,
+        STAGE_PATCH_DATA,
+        STAGE_DONE,
+        STAGE_FAILED
+    };
+
+    StoredModelData* target;
+    ModelWireFormat format;
+    Stage stage;
+    uint8_t* dst;          // Where the current fixed-size segment goes
+    uint32_t remaining;    // Bytes left in it
+    uint32_t rawBytes;     // FULL: bytes copied so far
+    uint32_t header[SIMPLE_NN_DELTA_HEADER_SIZE / sizeof(uint32_t)];  // Any header
+    uint32_t numExtraHeads;
+    uint32_t head;         // Extra head being decoded (0-based)
+    uint32_t labelIndex;   // Across all heads, primary first
+    uint32_t labelLength;
+    uint32_t baseSize;     // DELTA: stored bytes of the model in target
+    uint32_t resultSize;
+    uint32_t resultCrc;
+    uint32_t patchesLeft;
+    bool baseMismatch;
+    bool targetWritten;
+
+    void startSegment(Stage next, void* destination, uint32_t length);
+    bool finishSegment();
+    void startHeadOrLabels();
+    bool startDelta();
+    bool startPatch();
+    void startPatchOrDone();
+    bool writeLabelByte(uint8_t value);
+    char* labelSlot(uint32_t index);
+    uint32_t totalLabels() const;
+};
+
+/**
+ * Reference encoder: the compact payload for a stored model. Returns its
+ * size, or 0 if capacity is too small or the model is malformed.
+ */
+uint32_t encodeCompactModel(const StoredModelData& model, uint32_t storedSize,
+                            uint8_t* out, uint32_t capacity);
+
+/**
+ * Reference encoder: the delta payload that turns base into result.
+ * Changed bytes closer together than a patch header share one patch.
+ * Returns its size, or 0 if capacity is too small.
+ */
+uint32_t encodeModelDelta(const StoredModelData& base, uint32_t baseSize,
+                          const StoredModelData& result, uint32_t resultSize,
+                          uint8_t* out, uint32_t capacity);
+
+#endif // MODEL_FORMAT_H
@@ -0,0 +1,180 @@
+#include "model_slots.h"
+#include <string.h>
+#include "crc32.h"
+
+static uint32_t slotSize(const FlashRegion& flash) {
+    // Whole pages per slot, so erasing one slot never touches the other
+    const uint32_t pages = flash.size() / flash.pageSize();
+    return (pages / MODEL_SLOT_COUNT) * flash.pageSize();
+}
+
+uint32_t getModelSlotCapacity(const FlashRegion& flash) {
+    const uint32_t size = slotSize(flash);
+    return size > sizeof(ModelSlotHeader) ? size - sizeof(ModelSlotHeader) : 0;
+}
+
+static uint32_t headerCrc(const ModelSlotHeader& header) {
+    return calculateCrc32((const uint8_t*)&header, offsetof(ModelSlotHeader, headerCrc));
+}
+
+// Header of a slot whose save ran to completion (the payload CRC is only
+// checked when the payload is read)
+static bool readSlotHeader(FlashRegion& flash, int slot, ModelSlotHeader* header) {
+    if (!flash.read(slot * slotSize(flash), header, sizeof(*header))) {
+        return false;
+    }
+    return header->magic == MODEL_SLOT_MAGIC &&
+           header->headerCrc == headerCrc(*header) &&
+           header->payloadSize <= getModelSlotCapacity(flash);
+}
+
+bool findModelSlotPayload(FlashRegion& flash, int slot, uint32_t* offset, uint32_t* size) {
+    ModelSlotHeader header;
+    if (slot < 0 || slot >= MODEL_SLOT_COUNT || !readSlotHeader(flash, slot, &header)) {
+        return false;
+    }
+    *offset = slot * slotSize(flash) + sizeof(ModelSlotHeader);
+    *size = header.payloadSize;
+    return true;
+}
+
+bool loadNewestModelSlot(FlashRegion& flash, uint8_t* out, uint32_t capacity,
+                         ModelSlotInfo* info) {
+    ModelSlotHeader headers[MODEL_SLOT_COUNT];
+    bool candidate[MODEL_SLOT_COUNT];
+    for (int slot = 0; slot < MODEL_SLOT_COUNT; slot++) {
+        candidate[slot] = readSlotHeader(flash, slot, &headers[slot]) &&
+                          headers[slot].payloadSize <= capacity;
+    }
+
+    // Newest first; a payload that fails its CRC drops to the next one
+    while (true) {
+        int newest = -1;
+        for (int slot = 0; slot < MODEL_SLOT_COUNT; slot++) {
+            if (candidate[slot] &&
+                (newest < 0 || headers[slot].sequence > headers[newest].sequence)) {
+                newest = slot;
+            }
+        }
+        if (newest < 0) {
+            break;
+        }
+        candidate[newest] = false;
+
+        const ModelSlotHeader& header = headers[newest];
+        const uint32_t payloadOffset = newest * slotSize(flash) + sizeof(ModelSlotHeader);
+        if (flash.read(payloadOffset, out, header.payloadSize) &&
+            calculateCrc32(out, header.payloadSize) == header.payloadCrc) {
+            if (info != nullptr) {
+                info->slot = newest;
+                info->sequence = header.sequence;
+                info->payloadSize = header.payloadSize;
+            }
+            return true;
+        }
+    }
+
+    if (info != nullptr) {
+        info->slot = -1;
+        info->sequence = 0;
+        info->payloadSize = 0;
+    }
+    return false;
+}
+
+bool beginModelSlotSave(FlashRegion& flash, const uint8_t* payload, uint32_t size,
+                        ModelSlotSave* save) {
+    if (size > getModelSlotCapacity(flash)) {
+        return false;
+    }
+
+    // Target the slot not holding the newest complete save
+    int newest = -1;
+    uint32_t newestSequence = 0;
+    for (int slot = 0; slot < MODEL_SLOT_COUNT; slot++) {
+        ModelSlotHeader header;
+        if (readSlotHeader(flash, slot, &header) &&
+            (newest < 0 || header.sequence > newestSequence)) {
+            newest = slot;
+            newestSequence = header.sequence;
+        }
+    }
+    save->payload = payload;
+    save->size = size;
+    save->payloadCrc = calculateCrc32(payload, size);
+    save->sequence = newestSequence + 1;
+    save->slot = newest < 0 ? 0 : (newest + 1) % MODEL_SLOT_COUNT;
+    save->erased = 0;
+    save->programmed = 0;
+    return true;
+}
+
+ModelSlotStep stepModelSlotSave(FlashRegion& flash, ModelSlotSave* save,
+                                ModelSlotInfo* info) {
+    const uint32_t base = save->slot * slotSize(flash);
+    const uint32_t pageSize = flash.pageSize();
+
+    // 1. Erase: from the first page on the target slot is invalid
+    if (save->erased < sizeof(ModelSlotHeader) + save->size) {
+        if (!flash.erasePage(base + save->erased)) {
+            return MODEL_SLOT_STEP_FAILED;
+        }
+        save->erased += pageSize;
+        return MODEL_SLOT_STEP_BUSY;
+    }
+
+    // 2. Payload, whole words; a partial last word is padded with 0xFF
+    const uint32_t wholeWords = save->size & ~3u;
+    const uint32_t payloadBase = base + sizeof(ModelSlotHeader);
+    if (save->programmed < wholeWords) {
+        const uint32_t remaining = wholeWords - save->programmed;
+        const uint32_t length = remaining < pageSize ? remaining : pageSize;
+        if (!flash.program(payloadBase + save->programmed,
+                           &save->payload[save->programmed], length)) {
+            return MODEL_SLOT_STEP_FAILED;
+        }
+        save->programmed += length;
+        return MODEL_SLOT_STEP_BUSY;
+    }
+    if (save->programmed < save->size) {
+        uint8_t tail[4] = {0xFF, 0xFF, 0xFF, 0xFF};
+        memcpy(tail, &save->payload[wholeWords], save->size - wholeWords);
+        if (!flash.program(payloadBase + wholeWords, tail, 4)) {
+            return MODEL_SLOT_STEP_FAILED;
+        }
+        save->programmed = save->size;
+        return MODEL_SLOT_STEP_BUSY;
+    }
+
+    // 3. Header last: the slot only becomes valid once this lands
+    ModelSlotHeader header;
+    header.magic = MODEL_SLOT_MAGIC;
+    header.sequence = save->sequence;
+    header.payloadSize = save->size;
+    header.payloadCrc = save->payloadCrc;
+    header.reserved = 0xFFFFFFFF;
+    header.headerCrc = headerCrc(header);
+    if (!flash.program(base, &header, sizeof(header))) {
+        return MODEL_SLOT_STEP_FAILED;
+    }
+
+    if (info != nullptr) {
+        info->slot = save->slot;
+        info->sequence = save->sequence;
+        info->payloadSize = save->size;
+    }
+    return MODEL_SLOT_STEP_DONE;
+}
+
+bool saveModelSlot(FlashRegion& flash, const uint8_t* payload, uint32_t size,
+                   ModelSlotInfo* info) {
+    ModelSlotSave save;
+    if (!beginModelSlotSave(flash, payload, size, &save)) {
+        return false;
+    }
+    ModelSlotStep step;
+    do {
+        step = stepModelSlotSave(flash, &save, info);
+    } while (step == MODEL_SLOT_STEP_BUSY);
+    return step == MODEL_SLOT_STEP_DONE;
+}
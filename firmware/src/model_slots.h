@@ -0,0 +1,95 @@
+#ifndef MODEL_SLOTS_H
+#define MODEL_SLOTS_H
+
+#include <stdint.h>
+#include "flash_region.h"
+
+// ============================================================================
+// A/B Model Slots
+// ============================================================================
+//
+// The flash region is split into MODEL_SLOT_COUNT equal slots, each holding
+// one model payload behind a small header:
+//
+//   [ModelSlotHeader][payload][erased...]
+//
+// A save always goes to the slot that does NOT hold the newest model: erase
+// its pages, program the payload, and program the header last. The header
+// carries a sequence number (highest intact slot wins at boot) and CRCs of
+// itself and of the payload. Power lost at any point of a save leaves that
+// slot with an erased or torn header, or a payload that fails its CRC, so
+// boot falls back to the previous model instead of loading garbage.
+// ============================================================================
+
+#define MODEL_SLOT_COUNT 2
+#define MODEL_SLOT_MAGIC 0x544F4C53  // "SLOT"
+
+struct ModelSlotHeader {
+    uint32_t magic;
+    uint32_t sequence;     // +1 on every save
+    uint32_t payloadSize;  // Bytes, as uploaded
+    uint32_t payloadCrc;   // calculateCrc32 of the payload
+    uint32_t reserved;     // Left erased (0xFFFFFFFF)
+    uint32_t headerCrc;    // calculateCrc32 of the fields above
+};
+
+struct ModelSlotInfo {
+    int slot;              // -1 if none
+    uint32_t sequence;
+    uint32_t payloadSize;
+};
+
+// Largest payload one slot can hold
+uint32_t getModelSlotCapacity(const FlashRegion& flash);
+
+// Copy the newest intact payload (at most capacity bytes) into out.
+// Returns false if no slot holds one.
+bool loadNewestModelSlot(FlashRegion& flash, uint8_t* out, uint32_t capacity,
+                         ModelSlotInfo* info);
+
+// Where a slot's payload starts in the region and how long it is, if the
+// slot holds a complete save (the payload CRC is not checked)
+bool findModelSlotPayload(FlashRegion& flash, int slot, uint32_t* offset, uint32_t* size);
+
+// Write payload to the older slot as the new newest model. Returns false if
+// it does not fit or the flash reports an error; the other slot is never
+// touched either way. Blocks until done: see ModelSlotSave to spread the
+// same save over many calls.
+bool saveModelSlot(FlashRegion& flash, const uint8_t* payload, uint32_t size,
+                   ModelSlotInfo* info);
+
+// ----------------------------------------------------------------------------
+// Incremental save
+// ----------------------------------------------------------------------------
+// The same save as saveModelSlot(), one page at a time: each step erases
+// one page of the target slot or programs up to one page of payload, and
+// the last one programs the header. On the nRF52840 a page erase takes up
+// to 85 ms and a page of word writes about 42 ms, so a caller stepping once
+// per loop pass never stalls longer than that. The payload must not change
+// until the save ends.
+
+enum ModelSlotStep {
+    MODEL_SLOT_STEP_BUSY = 0,   // Call step again
+    MODEL_SLOT_STEP_DONE = 1,   // Header programmed: the save is the newest
+    MODEL_SLOT_STEP_FAILED = 2  // The target slot is left invalid
+};
+
+struct ModelSlotSave {
+    const uint8_t* payload;
+    uint32_t size;
+    uint32_t payloadCrc;
+    uint32_t sequence;     // Of the new save
+    int slot;              // Target
+    uint32_t erased;       // Bytes of the slot erased so far
+    uint32_t programmed;   // Payload bytes programmed so far
+};
+
+// Pick the target slot. Returns false if the payload does not fit.
+bool beginModelSlotSave(FlashRegion& flash, const uint8_t* payload, uint32_t size,
+                        ModelSlotSave* save);
+
+// Next erase or program of a save begun above; info is filled in on DONE
+ModelSlotStep stepModelSlotSave(FlashRegion& flash, ModelSlotSave* save,
+                                ModelSlotInfo* info);
+
+#endif // MODEL_SLOTS_H
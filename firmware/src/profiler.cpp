@@ -0,0 +1,205 @@
+#include "profiler.h"
+#include <string.h>
+
+// ============================================================================
+// Histogram
+// ============================================================================
+
+void ProfileHistogram::reset() {
+    count = 0;
+    minTicks = UINT32_MAX;
+    maxTicks = 0;
+    sumTicks = 0;
+    memset(bins, 0, sizeof(bins));
+}
+
+// Values below 4 get a bin each; above that, power-of-two octave e is split
+// into 4 equal bins selected by the two bits under the leading one
+int ProfileHistogram::binIndex(uint32_t ticks) {
+    if (ticks < 4) {
+        return (int)ticks;
+    }
+    const int octave = 31 - __builtin_clz(ticks);
+    const int bin = (octave - 1) * 4 + (int)((ticks >> (octave - 2)) & 3);
+    return bin < PROFILE_HISTOGRAM_BINS ? bin : PROFILE_HISTOGRAM_BINS - 1;
+}
+
+uint32_t ProfileHistogram::binUpperEdge(int bin) {
+    if (bin < 4) {
+        return (uint32_t)bin;
+    }
+    const int octave = bin / 4 + 1;
+    const uint32_t lower = (uint32_t)(4 + bin % 4) << (octave - 2);
+    return lower + (1u << (octave - 2)) - 1;
+}
+
+void ProfileHistogram::record(uint32_t ticks) {
+    count++;
+    sumTicks += ticks;
+    if (ticks < minTicks) minTicks = ticks;
+    if (ticks > maxTicks) maxTicks = ticks;
+    bins[binIndex(ticks)]++;
+}
+
+uint32_t ProfileHistogram::getPercentile(uint8_t percent) const {
+    if (count == 0) {
+        return 0;
+    }
+    const uint64_t rank = ((uint64_t)count * percent + 99) / 100;
+    uint64_t seen = 0;
+    for (int bin = 0; bin < PROFILE_HISTOGRAM_BINS - 1; bin++) {
+        seen += bins[bin];
+        if (seen >= rank && seen > 0) {
+            const uint32_t edge = binUpperEdge(bin);
+            return edge < maxTicks ? edge : maxTicks;
+        }
+    }
+    return maxTicks;  // Overflow bin has no upper edge
+}
+
+// ============================================================================
+// Report
+// ============================================================================
+
+static const char* const STAGE_NAMES[PROFILE_STAGE_COUNT] = {
+    "addSample",
+    "runInference",
+    "dense 600x32",
+    "dense 32xN",
+    "dense head",
+    "softmax",
+    "write sensor",
+    "write inference",
+    "write status",
+    "write info",
+    "write config",
+};
+
+const char* getProfileStageName(ProfileStage stage) {
+    return stage < PROFILE_STAGE_COUNT ? STAGE_NAMES[stage] : "?";
+}
+
+static void writeU32LE(uint8_t* out, uint32_t value) {
+    out[0] = (uint8_t)value;
+    out[1] = (uint8_t)(value >> 8);
+    out[2] = (uint8_t)(value >> 16);
+    out[3] = (uint8_t)(value >> 24);
+}
+
+size_t encodeProfileReport(const ProfileHistogram* stages, int stageCount, uint32_t tickHz,
+                           uint8_t* out, size_t maxLength) {
+    const size_t length = PROFILE_REPORT_HEADER_SIZE + (size_t)stageCount * PROFILE_REPORT_STAGE_SIZE;
+    if (stageCount < 0 || stageCount > 255 || length > maxLength) {
+        return 0;
+    }
+
+    out[0] = PROFILE_REPORT_VERSION;
+    out[1] = (uint8_t)stageCount;
+    out[2] = 0;
+    out[3] = 0;
+    writeU32LE(&out[4], tickHz);
+
+    uint8_t* entry = &out[PROFILE_REPORT_HEADER_SIZE];
+    for (int i = 0; i < stageCount; i++) {
+        writeU32LE(&entry[0], stages[i].getCount());
+        writeU32LE(&entry[4], stages[i].getMin());
+        writeU32LE(&entry[8], stages[i].getAverage());
+        writeU32LE(&entry[12], stages[i].getMax());
+        writeU32LE(&entry[16], stages[i].getPercentile(99));
+        entry += PROFILE_REPORT_STAGE_SIZE;
+    }
+    return length;
+}
+
+#if PROFILING_ENABLED
+
+#include <Arduino.h>
+
+static ProfileHistogram stageHistograms[PROFILE_STAGE_COUNT];
+
+// ============================================================================
+// Tick Source
+// ============================================================================
+
+#if defined(ARDUINO_ARCH_MBED)
+
+void profilerBegin() {
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+uint32_t profileNow() {
+    return DWT->CYCCNT;
+}
+
+uint32_t getProfileTickHz() {
+    return SystemCoreClock;
+}
+
+#else
+
+#include <chrono>
+
+void profilerBegin() {}
+
+// Wraps every ~4.3 s; scopes are far shorter, so differences stay exact
+uint32_t profileNow() {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+uint32_t getProfileTickHz() {
+    return 1000000000UL;
+}
+
+#endif
+
+// ============================================================================
+// Tables
+// ============================================================================
+
+void profileRecord(ProfileStage stage, uint32_t ticks) {
+    stageHistograms[stage].record(ticks);
+}
+
+const ProfileHistogram& getProfileHistogram(ProfileStage stage) {
+    return stageHistograms[stage];
+}
+
+void resetProfile() {
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        stageHistograms[i].reset();
+    }
+}
+
+size_t buildProfileReport(uint8_t* out, size_t maxLength) {
+    return encodeProfileReport(stageHistograms, PROFILE_STAGE_COUNT, getProfileTickHz(), out,
+                               maxLength);
+}
+
+// "123.4" microseconds without float printf (not linked on every core)
+static void formatMicros(char* out, size_t size, uint32_t ticks) {
+    const uint64_t tenths = (uint64_t)ticks * 10000000ULL / getProfileTickHz();
+    snprintf(out, size, "%lu.%lu", (unsigned long)(tenths / 10), (unsigned long)(tenths % 10));
+}
+
+void printProfile() {
+    char line[96];
+    char minUs[16], avgUs[16], maxUs[16], p99Us[16];
+    Serial.println("Stage                count     min us     avg us     max us     p99 us");
+    for (int i = 0; i < PROFILE_STAGE_COUNT; i++) {
+        const ProfileHistogram& h = stageHistograms[i];
+        formatMicros(minUs, sizeof(minUs), h.getMin());
+        formatMicros(avgUs, sizeof(avgUs), h.getAverage());
+        formatMicros(maxUs, sizeof(maxUs), h.getMax());
+        formatMicros(p99Us, sizeof(p99Us), h.getPercentile(99));
+        snprintf(line, sizeof(line), "%-16s %9lu %10s %10s %10s %10s",
+                 getProfileStageName((ProfileStage)i), (unsigned long)h.getCount(), minUs, avgUs,
+                 maxUs, p99Us);
+        Serial.println(line);
+    }
+}
+
+#endif // PROFILING_ENABLED
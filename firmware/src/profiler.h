@@ -0,0 +1,127 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================================
+// Stage Profiler
+// ============================================================================
+//
+// PROFILE_SCOPE(stage) times the rest of the enclosing block and adds the
+// duration to that stage's histogram. Ticks are CPU cycles from the Cortex-M4
+// DWT counter on the board (SystemCoreClock Hz) and nanoseconds from
+// std::chrono::steady_clock in the native env, so host numbers are real CPU
+// time even when the firmware runs in virtual time.
+//
+// Each histogram keeps exact count/min/max/sum plus log-linear bins (4 per
+// power of two, ≤ 25% wide) for the p99. Stages are recorded from loop()
+// only: there is no locking, so the native_eval worker threads must not run
+// with profiling on.
+//
+// With PROFILING_ENABLED 0 the scopes expand to nothing and no tables exist;
+// only ProfileHistogram and the report encoder (plain code, unit tested)
+// remain, and the linker drops them.
+//
+// Report (diagnostics characteristic), little-endian:
+//   [version u8, stages u8, reserved u16, tick_hz u32]
+//   then per stage: [count u32, min u32, avg u32, max u32, p99 u32] ticks
+// ============================================================================
+
+#define PROFILE_REPORT_VERSION 1
+#define PROFILE_HISTOGRAM_BINS 96  // Covers < 2^25 ticks; longer ones land in the last bin
+#define PROFILE_REPORT_HEADER_SIZE 8
+#define PROFILE_REPORT_STAGE_SIZE 20
+
+enum ProfileStage {
+    PROFILE_ADD_SAMPLE = 0,
+    PROFILE_RUN_INFERENCE,
+    PROFILE_DENSE_HIDDEN,     // 600 → 32 ReLU
+    PROFILE_DENSE_OUTPUT,     // 32 → N, primary head
+    PROFILE_DENSE_HEAD,       // 32 → N, each extra head
+    PROFILE_SOFTMAX,
+    PROFILE_WRITE_SENSOR,     // writeValue per characteristic
+    PROFILE_WRITE_INFERENCE,
+    PROFILE_WRITE_STATUS,
+    PROFILE_WRITE_INFO,
+    PROFILE_WRITE_CONFIG,
+    PROFILE_STAGE_COUNT
+};
+
+#define PROFILE_REPORT_SIZE \
+    (PROFILE_REPORT_HEADER_SIZE + PROFILE_STAGE_COUNT * PROFILE_REPORT_STAGE_SIZE)
+
+class ProfileHistogram {
+public:
+    ProfileHistogram() { reset(); }
+
+    void reset();
+    void record(uint32_t ticks);
+
+    uint32_t getCount() const { return count; }
+    uint32_t getMin() const { return count > 0 ? minTicks : 0; }
+    uint32_t getMax() const { return maxTicks; }
+    uint32_t getAverage() const { return count > 0 ? (uint32_t)(sumTicks / count) : 0; }
+
+    // Upper edge of the bin holding the given percentile (0-100), capped at
+    // the exact max: never under-reports
+    uint32_t getPercentile(uint8_t percent) const;
+
+    static int binIndex(uint32_t ticks);
+    static uint32_t binUpperEdge(int bin);
+
+private:
+    uint32_t count;
+    uint32_t minTicks;
+    uint32_t maxTicks;
+    uint64_t sumTicks;
+    uint32_t bins[PROFILE_HISTOGRAM_BINS];
+};
+
+const char* getProfileStageName(ProfileStage stage);
+
+// Serialize stageCount histograms in the report layout above. Returns the
+// bytes written, or 0 if maxLength is too small.
+size_t encodeProfileReport(const ProfileHistogram* stages, int stageCount, uint32_t tickHz,
+                           uint8_t* out, size_t maxLength);
+
+#if PROFILING_ENABLED
+
+// Start the cycle counter; call once from setup()
+void profilerBegin();
+
+uint32_t profileNow();
+uint32_t getProfileTickHz();
+
+void profileRecord(ProfileStage stage, uint32_t ticks);
+const ProfileHistogram& getProfileHistogram(ProfileStage stage);
+void resetProfile();
+
+// Full report for the diagnostics characteristic (PROFILE_REPORT_SIZE bytes)
+size_t buildProfileReport(uint8_t* out, size_t maxLength);
+
+// Human-readable table on Serial, in microseconds
+void printProfile();
+
+class ProfileScope {
+public:
+    explicit ProfileScope(ProfileStage stage) : stage(stage), start(profileNow()) {}
+    ~ProfileScope() { profileRecord(stage, profileNow() - start); }
+
+private:
+    ProfileStage stage;
+    uint32_t start;
+};
+
+#define PROFILE_SCOPE_NAME2(line) profileScope##line
+#define PROFILE_SCOPE_NAME(line) PROFILE_SCOPE_NAME2(line)
+#define PROFILE_SCOPE(stage) ProfileScope PROFILE_SCOPE_NAME(__LINE__)(stage)
+
+#else
+
+#define PROFILE_SCOPE(stage) do {} while (0)
+
+#endif // PROFILING_ENABLED
+
+#endif // PROFILER_H
@@ -0,0 +1,110 @@
+#include "resampler.h"
+#include <math.h>
+#include <string.h>
+
+UniformResampler::UniformResampler() {
+    periodUs = 0;
+    begin(40000);
+}
+
+void UniformResampler::begin(uint32_t nominalPeriodUs) {
+    periodUs = nominalPeriodUs > 0 ? nominalPeriodUs : 1;
+    reset();
+    resetJitterStats();
+}
+
+void UniformResampler::reset() {
+    havePrevious = false;
+    previousTimeUs = 0;
+    nextGridTimeUs = 0;
+    lastGridTimeUs = 0;
+    memset(previous, 0, sizeof(previous));
+}
+
+void UniformResampler::resetJitterStats() {
+    statIntervals = 0;
+    statGaps = 0;
+    statMinUs = 0xFFFFFFFFu;
+    statMaxUs = 0;
+    statMaxJitterUs = 0;
+    statSumUs = 0.0;
+    statSumSqJitterUs = 0.0;
+}
+
+void UniformResampler::recordInterval(uint32_t intervalUs) {
+    statIntervals++;
+    statSumUs += intervalUs;
+    if (intervalUs < statMinUs) statMinUs = intervalUs;
+    if (intervalUs > statMaxUs) statMaxUs = intervalUs;
+
+    const uint32_t jitter = intervalUs > periodUs ? intervalUs - periodUs : periodUs - intervalUs;
+    if (jitter > statMaxJitterUs) statMaxJitterUs = jitter;
+    statSumSqJitterUs += (double)jitter * (double)jitter;
+}
+
+JitterStats UniformResampler::getJitterStats() const {
+    JitterStats stats;
+    stats.intervals = statIntervals;
+    stats.gaps = statGaps;
+    stats.minIntervalUs = statIntervals > 0 ? statMinUs : 0;
+    stats.maxIntervalUs = statMaxUs;
+    stats.maxJitterUs = statMaxJitterUs;
+    stats.meanIntervalUs = statIntervals > 0 ? (float)(statSumUs / statIntervals) : 0.0f;
+    stats.rmsJitterUs = statIntervals > 0 ? (float)sqrt(statSumSqJitterUs / statIntervals) : 0.0f;
+    return stats;
+}
+
+int UniformResampler::push(uint32_t timestampUs,
+                           const int16_t input[RESAMPLER_AXES],
+                           int16_t output[][RESAMPLER_AXES],
+                           int maxOutputs) {
+    if (maxOutputs <= 0) {
+        return 0;
+    }
+
+    int written = 0;
+
+    if (havePrevious) {
+        // Unsigned subtraction handles micros() wrap-around
+        const uint32_t intervalUs = timestampUs - previousTimeUs;
+
+        if (intervalUs > periodUs * RESAMPLER_MAX_GAP_PERIODS) {
+            statGaps++;
+            havePrevious = false;
+        } else if (intervalUs > 0) {
+            recordInterval(intervalUs);
+
+            // Emit every grid point in (previousTime, timestamp]
+            while (written < maxOutputs &&
+                   (int32_t)(timestampUs - nextGridTimeUs) >= 0) {
+                const uint32_t offsetUs = nextGridTimeUs - previousTimeUs;
+                for (int a = 0; a < RESAMPLER_AXES; a++) {
+                    const int32_t delta = (int32_t)input[a] - (int32_t)previous[a];
+                    // Rounded linear interpolation in integer math
+                    const int64_t scaled = (int64_t)delta * offsetUs;
+                    const int64_t half = (int64_t)(intervalUs / 2);
+                    const int32_t step = (int32_t)((scaled >= 0 ? scaled + half : scaled - half) / intervalUs);
+                    output[written][a] = (int16_t)(previous[a] + step);
+                }
+                lastGridTimeUs = nextGridTimeUs;
+                nextGridTimeUs += periodUs;
+                written++;
+            }
+        }
+    }
+
+    if (!havePrevious) {
+        // (Re)start the grid exactly on this sample
+        for (int a = 0; a < RESAMPLER_AXES; a++) {
+            output[0][a] = input[a];
+        }
+        lastGridTimeUs = timestampUs;
+        nextGridTimeUs = timestampUs + periodUs;
+        written = 1;
+        havePrevious = true;
+    }
+
+    previousTimeUs = timestampUs;
+    memcpy(previous, input, sizeof(previous));
+    return written;
+}
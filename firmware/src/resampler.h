@@ -0,0 +1,95 @@
+#ifndef RESAMPLER_H
+#define RESAMPLER_H
+
+#include <stdint.h>
+
+// ============================================================================
+// Uniform-Time Resampler
+// ============================================================================
+//
+// The main loop reads the IMU whenever it gets around to it, so the real
+// spacing between samples wanders with BLE traffic and inference work. The
+// model was trained on a perfectly uniform grid, so this stage takes samples
+// stamped with a precise time (micros()) and linearly interpolates them onto
+// the nominal grid before they reach the sliding window.
+//
+// It also keeps jitter statistics on the incoming intervals so we can see
+// how far the real timing strays from nominal.
+// ============================================================================
+
+#define RESAMPLER_AXES 6
+
+// Intervals longer than this many periods are treated as a sampling gap
+// (e.g. paused during model upload): the grid restarts instead of
+// interpolating a straight line across the gap.
+#define RESAMPLER_MAX_GAP_PERIODS 4
+
+struct JitterStats {
+    uint32_t intervals;        // Number of intervals measured
+    uint32_t gaps;             // Intervals that exceeded the gap limit
+    uint32_t minIntervalUs;
+    uint32_t maxIntervalUs;
+    float meanIntervalUs;
+    float rmsJitterUs;         // RMS deviation from the nominal period
+    uint32_t maxJitterUs;      // Largest |interval - period|
+};
+
+class UniformResampler {
+public:
+    UniformResampler();
+
+    /**
+     * Set the nominal grid period and clear state and statistics.
+     */
+    void begin(uint32_t periodUs);
+
+    /**
+     * Forget the previous sample; the next push restarts the grid.
+     * Statistics are kept.
+     */
+    void reset();
+
+    /**
+     * Push one timestamped sample.
+     * @param timestampUs Acquisition time in microseconds (wraps at 2^32)
+     * @param input       Raw axes
+     * @param output      Receives the grid samples covered by this input
+     * @param maxOutputs  Capacity of output
+     * @return Number of grid samples written (usually 0 or 1)
+     */
+    int push(uint32_t timestampUs,
+             const int16_t input[RESAMPLER_AXES],
+             int16_t output[][RESAMPLER_AXES],
+             int maxOutputs);
+
+    /**
+     * Time of the most recent grid sample written by push()
+     */
+    uint32_t getLastGridTimeUs() const { return lastGridTimeUs; }
+
+    uint32_t getPeriodUs() const { return periodUs; }
+
+    JitterStats getJitterStats() const;
+    void resetJitterStats();
+
+private:
+    uint32_t periodUs;
+    bool havePrevious;
+    uint32_t previousTimeUs;
+    int16_t previous[RESAMPLER_AXES];
+    uint32_t nextGridTimeUs;
+    uint32_t lastGridTimeUs;
+
+    // Running interval statistics
+    uint32_t statIntervals;
+    uint32_t statGaps;
+    uint32_t statMinUs;
+    uint32_t statMaxUs;
+    uint32_t statMaxJitterUs;
+    double statSumUs;
+    double statSumSqJitterUs;
+
+    void recordInterval(uint32_t intervalUs);
+};
+
+#endif // RESAMPLER_H
@@ -0,0 +1,80 @@
+#include "sampler.h"
+
+static SampleRing sampleRing;
+static bool samplerRunning = false;
+
+SampleRing& getSampleRing() {
+    return sampleRing;
+}
+
+bool isSamplerRunning() {
+    return samplerRunning;
+}
+
+#if SAMPLE_INTERRUPT_DRIVEN && defined(ARDUINO_ARCH_MBED)
+#include <mbed.h>
+#include <rtos.h>
+
+#define SAMPLE_TICK_FLAG 0x01
+
+static SensorReader* samplerSensor = nullptr;
+static mbed::Ticker sampleTicker;
+static rtos::EventFlags sampleFlags;
+static rtos::Thread samplerThread(osPriorityHigh, SAMPLER_THREAD_STACK_BYTES,
+                                  nullptr, "sampler");
+
+// Ticker ISR: just wake the sampling thread
+static void onSampleTick() {
+    sampleFlags.set(SAMPLE_TICK_FLAG);
+}
+
+static void samplerMain() {
+    SensorPacket batch[SENSOR_BATCH_MAX_SAMPLES];
+    uint32_t batchTimesUs[SENSOR_BATCH_MAX_SAMPLES];
+
+    while (true) {
+        sampleFlags.wait_any(SAMPLE_TICK_FLAG);
+
+        const int count = samplerSensor->readBatch(batch, batchTimesUs,
+                                                   SENSOR_BATCH_MAX_SAMPLES);
+        for (int i = 0; i < count; i++) {
+            TimedSample sample;
+            sample.packet = batch[i];
+            sample.timestampUs = batchTimesUs[i];
+            sampleRing.push(sample);  // Counts an overrun if loop() fell behind
+        }
+    }
+}
+
+bool startSampler(SensorReader* sensor) {
+    if (samplerRunning) {
+        return true;
+    }
+    samplerSensor = sensor;
+    if (samplerThread.start(mbed::callback(samplerMain)) != osOK) {
+        return false;
+    }
+    sampleTicker.attach(mbed::callback(onSampleTick),
+                        std::chrono::milliseconds(sensor->getPollIntervalMs()));
+    samplerRunning = true;
+    return true;
+}
+
+void getSamplerStackUsage(uint32_t* size, uint32_t* peakUsed) {
+    *size = samplerRunning ? samplerThread.stack_size() : 0;
+    *peakUsed = samplerRunning ? samplerThread.max_stack() : 0;
+}
+
+#else
+
+bool startSampler(SensorReader* sensor) {
+    (void)sensor;
+    return false;
+}
+
+void getSamplerStackUsage(uint32_t* size, uint32_t* peakUsed) {
+    *size = 0;
+    *peakUsed = 0;
+}
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SAMPLER_H
+#define SAMPLER_H
+
+#include "sensor_reader.h"
+#include "spsc_ring.h"
+
+// ============================================================================
+// Interrupt-Driven Sampler
+// ============================================================================
+//
+// A hardware ticker fires every sensor->getPollIntervalMs(). I2C cannot run
+// in interrupt context on mbed, so the tick only wakes a high-priority
+// thread, which calls readBatch() and pushes each sample with its micros()
+// timestamp into a lock-free SPSC ring. loop() is the only consumer.
+//
+// Once started, the sampler thread owns the sensor: nothing else may call
+// its read methods.
+// ============================================================================
+
+struct TimedSample {
+    SensorPacket packet;
+    uint32_t timestampUs;
+};
+
+typedef SpscRing<TimedSample, SAMPLE_RING_CAPACITY> SampleRing;
+
+// Start the ticker + sampling thread. Returns false if interrupt-driven
+// sampling is disabled or unsupported, in which case the caller polls.
+bool startSampler(SensorReader* sensor);
+
+bool isSamplerRunning();
+
+// Consumer end of the ring (main loop only)
+SampleRing& getSampleRing();
+
+// Sampler thread stack size and deepest use so far (mbed pre-fills thread
+// stacks with a pattern). Both 0 when the thread is not running.
+void getSamplerStackUsage(uint32_t* size, uint32_t* peakUsed);
+
+#endif // SAMPLER_H
@@ -1,7 +1,36 @@
 #ifdef USE_BMI270
 
 #include "sensor_reader.h"
+#include "bmi270_fifo.h"
 #include <Arduino_BMI270_BMM150.h>
+#include <Wire.h>
+
+// ============================================================================
+// Register Access (internal Wire1 bus)
+// ============================================================================
+static bool bmi270WriteRegister(uint8_t reg, uint8_t value) {
+    Wire1.beginTransmission(BMI270_I2C_ADDRESS);
+    Wire1.write(reg);
+    Wire1.write(value);
+    bool ok = Wire1.endTransmission() == 0;
+    delay(1);  // Config writes need > 450 us to settle
+    return ok;
+}
+
+static bool bmi270ReadRegisters(uint8_t reg, uint8_t* buffer, size_t length) {
+    Wire1.beginTransmission(BMI270_I2C_ADDRESS);
+    Wire1.write(reg);
+    if (Wire1.endTransmission(false) != 0) {
+        return false;
+    }
+    if (Wire1.requestFrom(BMI270_I2C_ADDRESS, length) != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = (uint8_t)Wire1.read();
+    }
+    return true;
+}
 
 // ============================================================================
 // BMI270 Sensor Reader (Arduino Nano 33 BLE Sense Rev2)
@@ -19,6 +48,26 @@ public:
     }
 
     bool read(SensorPacket& packet) override {
+#if IMU_DIRECT_REGISTERS
+        // Status + accel + gyro in one burst, scaled with integer math
+        uint8_t regs[BMI270_DATA_BURST_BYTES];
+        if (!bmi270ReadRegisters(BMI270_REG_STATUS, regs, sizeof(regs))) {
+            return false;
+        }
+        const uint8_t ready = BMI270_STATUS_DRDY_ACC | BMI270_STATUS_DRDY_GYR;
+        if ((regs[0] & ready) != ready) {
+            return false;
+        }
+
+        const uint8_t* acc = &regs[BMI270_REG_DATA_ACC_X - BMI270_REG_STATUS];
+        const uint8_t* gyr = &regs[BMI270_REG_DATA_GYR_X - BMI270_REG_STATUS];
+        int16_t rawAcc[3], rawGyr[3];
+        for (int axis = 0; axis < 3; axis++) {
+            rawAcc[axis] = readImuInt16LE(&acc[axis * 2]);
+            rawGyr[axis] = readImuInt16LE(&gyr[axis * 2]);
+        }
+        packRaw(packet, rawAcc, rawGyr);
+#else
         // Check if new data is available
         if (!IMU.accelerationAvailable() || !IMU.gyroscopeAvailable()) {
             return false;
@@ -36,6 +85,7 @@ public:
         packet.gx = scaleGyro(gx);
         packet.gy = scaleGyro(gy);
         packet.gz = scaleGyro(gz);
+#endif
 
         // Add metadata
         packet.sequence = _sequence++;
@@ -56,9 +106,150 @@ public:
     }
 };
 
+#if BMI270_USE_FIFO
+// ============================================================================
+// BMI270 FIFO Reader (batch acquisition through the hardware FIFO)
+// ============================================================================
+//
+// The chip samples on its own clock at IMU_SAMPLE_RATE_HZ and queues frames
+// in its 6 KB FIFO. Each readBatch() drains everything buffered with a few
+// burst reads of FIFO_DATA instead of two I2C transactions per sample, so
+// BLE or inference stalls of up to a couple of seconds lose nothing.
+// ============================================================================
+class BMI270FifoReader : public BMI270Reader {
+public:
+    bool begin() override {
+        // The Arduino library uploads the BMI270 config blob for us
+        if (!BMI270Reader::begin()) {
+            return false;
+        }
+
+        const uint8_t odr = bmi270OdrCode(IMU_SAMPLE_RATE_HZ);
+        if (odr == 0) {
+            DEBUG_PRINTLN("ERROR: IMU_SAMPLE_RATE_HZ is not a BMI270 output data rate");
+            return false;
+        }
+        _periodUs = 1000000UL / IMU_SAMPLE_RATE_HZ;
+
+        // Normal filter mode at the target ODR, ranges matching ACCEL_SCALE /
+        // GYRO_SCALE, then header-mode FIFO with accel + gyro frames.
+        bool ok = bmi270WriteRegister(BMI270_REG_ACC_CONF, 0xA0 | odr) &&
+                  bmi270WriteRegister(BMI270_REG_ACC_RANGE, BMI270_ACC_RANGE_4G) &&
+                  bmi270WriteRegister(BMI270_REG_GYR_CONF, 0xE0 | odr) &&
+                  bmi270WriteRegister(BMI270_REG_GYR_RANGE, BMI270_GYR_RANGE_2000) &&
+                  bmi270WriteRegister(BMI270_REG_FIFO_CONFIG_0, BMI270_FIFO_CONFIG_0_TIME_EN) &&
+                  bmi270WriteRegister(BMI270_REG_FIFO_CONFIG_1, BMI270_FIFO_CONFIG_1_GYR_ACC_HEADER) &&
+                  bmi270WriteRegister(BMI270_REG_CMD, BMI270_CMD_FIFO_FLUSH);
+        if (!ok) {
+            DEBUG_PRINTLN("ERROR: BMI270 FIFO configuration failed!");
+            return false;
+        }
+
+        DEBUG_PRINT("BMI270 FIFO enabled at ");
+        DEBUG_PRINT(IMU_SAMPLE_RATE_HZ);
+        DEBUG_PRINTLN(" Hz");
+        return true;
+    }
+
+    bool read(SensorPacket& packet) override {
+        uint32_t timestampUs;
+        return readBatch(&packet, &timestampUs, 1) == 1;
+    }
+
+    int readBatch(SensorPacket* packets, uint32_t* timestampsUs, int maxPackets) override {
+        const uint32_t nowUs = micros();
+        int total = 0;
+
+        while (total < maxPackets) {
+            uint8_t lengthBytes[2];
+            if (!bmi270ReadRegisters(BMI270_REG_FIFO_LENGTH_0, lengthBytes, 2)) {
+                break;
+            }
+            size_t level = ((size_t)lengthBytes[0] | ((size_t)lengthBytes[1] << 8)) &
+                           BMI270_FIFO_LENGTH_MASK;
+            if (level == 0) {
+                break;
+            }
+
+            // Never pull more bytes out of the chip than we have room to keep
+            size_t room = (size_t)(maxPackets - total) * BMI270_FIFO_GYR_ACC_FRAME_BYTES;
+            size_t burst = level;
+            if (burst > BMI270_FIFO_BURST_BYTES) burst = BMI270_FIFO_BURST_BYTES;
+            if (burst > room) burst = room;
+
+            uint8_t buffer[BMI270_FIFO_BURST_BYTES];
+            if (!bmi270ReadRegisters(BMI270_REG_FIFO_DATA, buffer, burst)) {
+                break;
+            }
+
+            Bmi270FifoFrame frames[BMI270_FIFO_BURST_BYTES / BMI270_FIFO_GYR_ACC_FRAME_BYTES];
+            Bmi270FifoParseResult result = parseBmi270Fifo(
+                buffer, burst, frames, maxPackets - total);
+            _droppedSamples += result.skippedFrames;
+
+            for (int i = 0; i < result.frames; i++) {
+                SensorPacket& packet = packets[total++];
+                packRaw(packet, frames[i].acc, frames[i].gyr);
+                packet.sequence = _sequence++;
+            }
+
+            if (result.frames == 0 || result.bytesConsumed < burst) {
+                break;
+            }
+        }
+
+        if (total == 0) {
+            return 0;
+        }
+
+        // Frames are exactly one ODR period apart on the IMU's clock. Continue
+        // the previous batch's timeline and nudge it toward micros() so the
+        // two clocks cannot drift apart; re-anchor after an overflow gap.
+        uint32_t newestUs = _clockUs + (uint32_t)total * _periodUs;
+        int32_t error = (int32_t)(nowUs - _periodUs / 2 - newestUs);
+        if (!_clockValid || error > (int32_t)(4 * _periodUs) || error < -(int32_t)(4 * _periodUs)) {
+            newestUs = nowUs;
+            _clockValid = true;
+        } else {
+            newestUs += error / 16;
+        }
+        _clockUs = newestUs;
+
+        for (int i = 0; i < total; i++) {
+            timestampsUs[i] = newestUs - (uint32_t)(total - 1 - i) * _periodUs;
+            packets[i].timestamp = (uint16_t)((timestampsUs[i] / 1000) & 0xFFFF);
+            packets[i].crc = crc8((uint8_t*)&packets[i], 16);
+        }
+        return total;
+    }
+
+    uint32_t getDroppedSamples() override {
+        return _droppedSamples;
+    }
+
+    uint32_t getPollIntervalMs() override {
+        return BMI270_FIFO_DRAIN_INTERVAL_MS;
+    }
+
+    const char* getChipName() override {
+        return "BMI270 FIFO (Rev2)";
+    }
+
+private:
+    uint32_t _periodUs = 0;
+    uint32_t _clockUs = 0;
+    bool _clockValid = false;
+    uint32_t _droppedSamples = 0;
+};
+#endif // BMI270_USE_FIFO
+
 // Factory function implementation for BMI270
 SensorReader* createSensorReader() {
+#if BMI270_USE_FIFO
+    return new BMI270FifoReader();
+#else
     return new BMI270Reader();
+#endif
 }
 
 #endif // USE_BMI270
@@ -0,0 +1,325 @@
+#ifdef USE_HOST_SENSOR
+
+#include "sensor_host.h"
+#include <ctype.h>
+
+#define HOST_SAMPLE_PERIOD_US (1000000ULL / IMU_SAMPLE_RATE_HZ)
+
+// ============================================================================
+// Pacing (shared)
+// ============================================================================
+
+bool HostSensorReader::read(SensorPacket& packet) {
+    uint32_t timestampUs;
+    return readBatch(&packet, &timestampUs, 1) == 1;
+}
+
+int HostSensorReader::readBatch(SensorPacket* packets, uint32_t* timestampsUs, int maxPackets) {
+    const uint64_t now = hostMicros64();
+    int count = 0;
+    uint64_t dueUs;
+
+    while (count < maxPackets && nextSampleDueUs(&dueUs) && _startUs + dueUs <= now) {
+        const uint64_t sampleUs = _startUs + dueUs;
+        int16_t axes[6];
+        takeSample(axes);
+
+        SensorPacket& packet = packets[count];
+        packet.ax = axes[0];
+        packet.ay = axes[1];
+        packet.az = axes[2];
+        packet.gx = axes[3];
+        packet.gy = axes[4];
+        packet.gz = axes[5];
+        packet.sequence = _sequence++;
+        packet.timestamp = (uint16_t)((sampleUs / 1000) & 0xFFFF);
+        packet.crc = crc8((uint8_t*)&packet, 16);
+
+        timestampsUs[count] = (uint32_t)sampleUs;
+        count++;
+    }
+    return count;
+}
+
+// ============================================================================
+// Replay
+// ============================================================================
+
+ReplaySensorReader::ReplaySensorReader(const char* path, bool loop)
+    : _path(path), _loop(loop) {}
+
+static bool hasCsvExtension(const std::string& path) {
+    if (path.size() < 4) {
+        return false;
+    }
+    std::string ext = path.substr(path.size() - 4);
+    for (size_t i = 0; i < ext.size(); i++) {
+        ext[i] = (char)tolower((unsigned char)ext[i]);
+    }
+    return ext == ".csv";
+}
+
+bool ReplaySensorReader::begin() {
+    DEBUG_PRINT("Opening replay file ");
+    DEBUG_PRINTLN(_path.c_str());
+
+    FILE* file = fopen(_path.c_str(), "rb");
+    if (file == nullptr) {
+        DEBUG_PRINTLN("ERROR: cannot open replay file");
+        return false;
+    }
+
+    _samples.clear();
+    _corruptRecords = 0;
+    const bool loaded = hasCsvExtension(_path) ? loadCsv(file) : loadPackets(file);
+    fclose(file);
+
+    if (!loaded || _samples.empty()) {
+        DEBUG_PRINTLN("ERROR: replay file holds no samples");
+        return false;
+    }
+
+    _next = 0;
+    _loopOffsetUs = 0;
+    _startUs = hostMicros64();
+
+    DEBUG_PRINT("Replaying ");
+    DEBUG_PRINT(_samples.size());
+    DEBUG_PRINTLN(" samples");
+    return true;
+}
+
+bool ReplaySensorReader::loadCsv(FILE* file) {
+    char line[256];
+    bool haveFirstTime = false;
+    double firstTimeMs = 0.0;
+
+    while (fgets(line, sizeof(line), file) != nullptr) {
+        // Parse leading numeric columns; stop at the first non-number
+        double values[7];
+        int columns = 0;
+        char* cursor = line;
+        while (columns < 7) {
+            char* end;
+            const double value = strtod(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+            values[columns++] = value;
+            while (*end == ' ' || *end == '\t') end++;
+            if (*end != ',') {
+                break;
+            }
+            cursor = end + 1;
+        }
+        if (columns < 6) {
+            continue;  // Header, comment or blank line
+        }
+
+        const double* imu = columns == 7 ? &values[1] : &values[0];
+        ReplaySample sample;
+        for (int axis = 0; axis < 3; axis++) {
+            sample.axes[axis] = scaleAccel((float)imu[axis]);
+            sample.axes[axis + 3] = scaleGyro((float)imu[axis + 3]);
+        }
+
+        if (columns == 7) {
+            if (!haveFirstTime) {
+                firstTimeMs = values[0];
+                haveFirstTime = true;
+            }
+            const double offsetMs = values[0] - firstTimeMs;
+            sample.offsetUs = offsetMs > 0.0 ? (uint64_t)(offsetMs * 1000.0 + 0.5) : 0;
+        } else {
+            sample.offsetUs = (uint64_t)_samples.size() * HOST_SAMPLE_PERIOD_US;
+        }
+        _samples.push_back(sample);
+    }
+    return true;
+}
+
+bool ReplaySensorReader::loadPackets(FILE* file) {
+    SensorPacket packet;
+    uint64_t offsetMs = 0;
+    uint16_t lastTimestamp = 0;
+
+    while (fread(&packet, 1, SENSOR_PACKET_SIZE, file) == SENSOR_PACKET_SIZE) {
+        if (crc8((const uint8_t*)&packet, 16) != packet.crc) {
+            _corruptRecords++;
+            continue;
+        }
+        if (!_samples.empty()) {
+            offsetMs += (uint16_t)(packet.timestamp - lastTimestamp);  // Unwrap mod 65536
+        }
+        lastTimestamp = packet.timestamp;
+
+        ReplaySample sample;
+        sample.axes[0] = packet.ax;
+        sample.axes[1] = packet.ay;
+        sample.axes[2] = packet.az;
+        sample.axes[3] = packet.gx;
+        sample.axes[4] = packet.gy;
+        sample.axes[5] = packet.gz;
+        sample.offsetUs = offsetMs * 1000;
+        _samples.push_back(sample);
+    }
+    return true;
+}
+
+bool ReplaySensorReader::nextSampleDueUs(uint64_t* dueUs) {
+    if (_next >= _samples.size()) {
+        if (!_loop || _samples.empty()) {
+            return false;
+        }
+        // Start the next pass one nominal period after the last sample
+        _loopOffsetUs += _samples.back().offsetUs + HOST_SAMPLE_PERIOD_US;
+        _next = 0;
+    }
+    *dueUs = _loopOffsetUs + _samples[_next].offsetUs;
+    return true;
+}
+
+void ReplaySensorReader::takeSample(int16_t axes[6]) {
+    memcpy(axes, _samples[_next].axes, sizeof(_samples[_next].axes));
+    _next++;
+}
+
+// ============================================================================
+// Synthetic Gestures
+// ============================================================================
+
+SyntheticGestureConfig defaultSyntheticGesture(SyntheticGesture gesture) {
+    SyntheticGestureConfig config;
+    config.gesture = gesture;
+    config.accelNoiseG = 0.005f;
+    config.gyroNoiseDps = 0.3f;
+    config.seed = 1;
+
+    switch (gesture) {
+        case SYNTH_WAVE:
+            config.frequencyHz = 1.0f;
+            config.accelAmplitudeG = 0.5f;
+            config.gyroAmplitudeDps = 120.0f;
+            break;
+        case SYNTH_SHAKE:
+            config.frequencyHz = 4.0f;
+            config.accelAmplitudeG = 1.5f;
+            config.gyroAmplitudeDps = 300.0f;
+            break;
+        case SYNTH_CIRCLE:
+            config.frequencyHz = 0.75f;
+            config.accelAmplitudeG = 0.4f;
+            config.gyroAmplitudeDps = 90.0f;
+            break;
+        case SYNTH_IDLE:
+        default:
+            config.frequencyHz = 0.0f;
+            config.accelAmplitudeG = 0.0f;
+            config.gyroAmplitudeDps = 0.0f;
+            break;
+    }
+    return config;
+}
+
+bool parseSyntheticGesture(const char* name, SyntheticGesture* gesture) {
+    static const struct {
+        const char* name;
+        SyntheticGesture gesture;
+    } names[] = {
+        {"idle", SYNTH_IDLE},
+        {"wave", SYNTH_WAVE},
+        {"shake", SYNTH_SHAKE},
+        {"circle", SYNTH_CIRCLE},
+    };
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strcmp(name, names[i].name) == 0) {
+            *gesture = names[i].gesture;
+            return true;
+        }
+    }
+    return false;
+}
+
+SyntheticSensorReader::SyntheticSensorReader(const SyntheticGestureConfig& config)
+    : _config(config) {}
+
+bool SyntheticSensorReader::begin() {
+    _index = 0;
+    _rngState = _config.seed != 0 ? _config.seed : 1;  // xorshift state must be non-zero
+    _startUs = hostMicros64();
+    return true;
+}
+
+bool SyntheticSensorReader::nextSampleDueUs(uint64_t* dueUs) {
+    *dueUs = _index * 1000000ULL / IMU_SAMPLE_RATE_HZ;
+    return true;
+}
+
+// Standard normal deviate from xorshift32 + Box-Muller
+float SyntheticSensorReader::nextGaussian() {
+    float u[2];
+    for (int i = 0; i < 2; i++) {
+        _rngState ^= _rngState << 13;
+        _rngState ^= _rngState >> 17;
+        _rngState ^= _rngState << 5;
+        u[i] = ((_rngState >> 8) + 1) * (1.0f / 16777217.0f);  // (0, 1]
+    }
+    return sqrtf(-2.0f * logf(u[0])) * cosf(6.28318531f * u[1]);
+}
+
+void SyntheticSensorReader::takeSample(int16_t axes[6]) {
+    const float t = (float)((double)_index / IMU_SAMPLE_RATE_HZ);
+    const float phase = 6.28318531f * _config.frequencyHz * t;
+    const float a = _config.accelAmplitudeG;
+    const float g = _config.gyroAmplitudeDps;
+
+    // Board lying flat: gravity on +z
+    float accel[3] = {0.0f, 0.0f, 1.0f};
+    float gyro[3] = {0.0f, 0.0f, 0.0f};
+
+    switch (_config.gesture) {
+        case SYNTH_WAVE:
+            accel[0] = a * sinf(phase);
+            gyro[2] = g * cosf(phase);
+            break;
+        case SYNTH_SHAKE:
+            accel[2] += a * sinf(phase);
+            gyro[1] = g * cosf(phase);
+            break;
+        case SYNTH_CIRCLE:
+            accel[0] = a * sinf(phase);
+            accel[1] = a * cosf(phase);
+            gyro[2] = g;
+            break;
+        case SYNTH_IDLE:
+        default:
+            break;
+    }
+
+    for (int axis = 0; axis < 3; axis++) {
+        axes[axis] = scaleAccel(accel[axis] + _config.accelNoiseG * nextGaussian());
+        axes[axis + 3] = scaleGyro(gyro[axis] + _config.gyroNoiseDps * nextGaussian());
+    }
+    _index++;
+}
+
+// ============================================================================
+// Factory
+// ============================================================================
+
+SensorReader* createSensorReader() {
+    const char* replayPath = getenv("SEVERN_REPLAY_FILE");
+    if (replayPath != nullptr && replayPath[0] != '\0') {
+        return new ReplaySensorReader(replayPath, true);
+    }
+
+    SyntheticGesture gesture = SYNTH_WAVE;
+    const char* gestureName = getenv("SEVERN_SYNTH_GESTURE");
+    if (gestureName != nullptr && !parseSyntheticGesture(gestureName, &gesture)) {
+        DEBUG_PRINT("Unknown SEVERN_SYNTH_GESTURE, using wave: ");
+        DEBUG_PRINTLN(gestureName);
+    }
+    return new SyntheticSensorReader(defaultSyntheticGesture(gesture));
+}
+
+#endif // USE_HOST_SENSOR
@@ -0,0 +1,134 @@
+#ifndef SENSOR_HOST_H
+#define SENSOR_HOST_H
+
+#include <string>
+#include <vector>
+#include "sensor_reader.h"
+
+// ============================================================================
+// Host Sensor Readers (native env only)
+// ============================================================================
+//
+// Stand-ins for the IMU when the firmware modules run on Linux against the
+// host Arduino shim (src/host/). Both readers behave like a sensor with a
+// FIFO: a sample becomes readable once the virtual clock reaches its
+// acquisition time, and readBatch() returns everything due, stamped with
+// that time. Advancing the clock in big steps therefore pushes data through
+// the sample → window → SimpleNN pipeline much faster than real time.
+//
+// createSensorReader() on the host replays SEVERN_REPLAY_FILE when that
+// environment variable is set, otherwise it synthesizes the gesture named by
+// SEVERN_SYNTH_GESTURE (idle, wave, shake, circle; default wave).
+// ============================================================================
+
+#define SENSOR_CHIP_HOST 0xFF
+
+// Common pacing for host readers: subclasses only say when the next sample
+// is due and what it contains.
+class HostSensorReader : public SensorReader {
+public:
+    bool read(SensorPacket& packet) override;
+    int readBatch(SensorPacket* packets, uint32_t* timestampsUs, int maxPackets) override;
+    uint8_t getChipType() override { return SENSOR_CHIP_HOST; }
+
+protected:
+    uint64_t _startUs = 0;  // Virtual time of begin(); sample times are relative
+
+    // Time of the next sample in µs after _startUs; false when exhausted
+    virtual bool nextSampleDueUs(uint64_t* dueUs) = 0;
+    // Consume the next sample as packet-scaled int16 axes
+    virtual void takeSample(int16_t axes[6]) = 0;
+};
+
+// ============================================================================
+// Replay
+// ============================================================================
+//
+// Recorded sessions in either of two formats:
+//   *.csv  One sample per line: [t_ms,]ax,ay,az,gx,gy,gz in g and dps (the
+//          web app's units). Header/comment lines and trailing non-numeric
+//          columns (e.g. a label) are ignored. Without t_ms, samples are
+//          spaced at IMU_SAMPLE_RATE_HZ.
+//   other  Raw 17-byte SensorPackets as streamed over BLE. Records with a
+//          bad CRC are skipped and reported by getDroppedSamples(); the
+//          16-bit millisecond timestamps are unwrapped for pacing.
+class ReplaySensorReader : public HostSensorReader {
+public:
+    explicit ReplaySensorReader(const char* path, bool loop = false);
+
+    bool begin() override;
+    uint32_t getDroppedSamples() override { return _corruptRecords; }
+    const char* getChipName() override { return "Replay"; }
+
+    size_t getSampleCount() const { return _samples.size(); }
+    // Loaded sample as packet-scaled int16 [ax, ay, az, gx, gy, gz]
+    const int16_t* getSampleAxes(size_t index) const { return _samples[index].axes; }
+    bool isFinished() const { return !_loop && _next >= _samples.size(); }
+
+protected:
+    bool nextSampleDueUs(uint64_t* dueUs) override;
+    void takeSample(int16_t axes[6]) override;
+
+private:
+    struct ReplaySample {
+        int16_t axes[6];
+        uint64_t offsetUs;
+    };
+
+    bool loadCsv(FILE* file);
+    bool loadPackets(FILE* file);
+
+    std::string _path;
+    bool _loop;
+    std::vector<ReplaySample> _samples;
+    size_t _next = 0;
+    uint64_t _loopOffsetUs = 0;   // Added to offsets on every pass after the first
+    uint32_t _corruptRecords = 0;
+};
+
+// ============================================================================
+// Synthetic Gestures
+// ============================================================================
+enum SyntheticGesture {
+    SYNTH_IDLE = 0,    // Gravity + sensor noise only
+    SYNTH_WAVE = 1,    // Side-to-side sway (ax, gz)
+    SYNTH_SHAKE = 2,   // Fast up-down shake (az, gy)
+    SYNTH_CIRCLE = 3   // Horizontal circle (ax, ay, gz)
+};
+
+struct SyntheticGestureConfig {
+    SyntheticGesture gesture;
+    float frequencyHz;       // Motion frequency
+    float accelAmplitudeG;   // Peak acceleration on the moving axes
+    float gyroAmplitudeDps;  // Peak rotation rate on the moving axes
+    float accelNoiseG;       // Gaussian noise (standard deviation), all axes
+    float gyroNoiseDps;
+    uint32_t seed;           // Same seed → identical sample stream
+};
+
+// Typical handheld values for each gesture
+SyntheticGestureConfig defaultSyntheticGesture(SyntheticGesture gesture);
+
+// "idle", "wave", "shake" or "circle" → gesture; false if unknown
+bool parseSyntheticGesture(const char* name, SyntheticGesture* gesture);
+
+class SyntheticSensorReader : public HostSensorReader {
+public:
+    explicit SyntheticSensorReader(const SyntheticGestureConfig& config);
+
+    bool begin() override;
+    const char* getChipName() override { return "Synthetic"; }
+
+protected:
+    bool nextSampleDueUs(uint64_t* dueUs) override;
+    void takeSample(int16_t axes[6]) override;
+
+private:
+    float nextGaussian();
+
+    SyntheticGestureConfig _config;
+    uint64_t _index = 0;
+    uint32_t _rngState = 1;
+};
+
+#endif // SENSOR_HOST_H
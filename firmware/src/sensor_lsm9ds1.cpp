@@ -2,6 +2,33 @@
 
 #include "sensor_reader.h"
 #include <Arduino_LSM9DS1.h>
+#include <Wire.h>
+
+// Accel/gyro core registers (the Arduino library leaves it at ±4 g / ±2000 dps)
+#define LSM9DS1_AG_I2C_ADDRESS 0x6B
+#define LSM9DS1_REG_STATUS_G 0x17  // STATUS_REG mirror ahead of the gyro outputs
+#define LSM9DS1_REG_OUT_X_L_G 0x18
+#define LSM9DS1_REG_OUT_X_L_XL 0x28
+#define LSM9DS1_STATUS_XLDA 0x01
+#define LSM9DS1_STATUS_GDA 0x02
+// One burst from the status through accel Z (IF_ADD_INC is on by default).
+// The status must come first: reading the outputs clears XLDA/GDA.
+#define LSM9DS1_DATA_BURST_BYTES (LSM9DS1_REG_OUT_X_L_XL + 6 - LSM9DS1_REG_STATUS_G)
+
+static bool lsm9ds1ReadRegisters(uint8_t reg, uint8_t* buffer, size_t length) {
+    Wire1.beginTransmission(LSM9DS1_AG_I2C_ADDRESS);
+    Wire1.write(reg);
+    if (Wire1.endTransmission(false) != 0) {
+        return false;
+    }
+    if (Wire1.requestFrom(LSM9DS1_AG_I2C_ADDRESS, length) != length) {
+        return false;
+    }
+    for (size_t i = 0; i < length; i++) {
+        buffer[i] = (uint8_t)Wire1.read();
+    }
+    return true;
+}
 
 // ============================================================================
 // LSM9DS1 Sensor Reader (Arduino Nano 33 BLE Sense Rev1)
@@ -19,6 +46,26 @@ public:
     }
 
     bool read(SensorPacket& packet) override {
+#if IMU_DIRECT_REGISTERS
+        // Status, gyro and accel in one burst, scaled with integer math
+        uint8_t regs[LSM9DS1_DATA_BURST_BYTES];
+        if (!lsm9ds1ReadRegisters(LSM9DS1_REG_STATUS_G, regs, sizeof(regs))) {
+            return false;
+        }
+        const uint8_t ready = LSM9DS1_STATUS_XLDA | LSM9DS1_STATUS_GDA;
+        if ((regs[0] & ready) != ready) {
+            return false;
+        }
+
+        const uint8_t* gyr = &regs[LSM9DS1_REG_OUT_X_L_G - LSM9DS1_REG_STATUS_G];
+        const uint8_t* acc = &regs[LSM9DS1_REG_OUT_X_L_XL - LSM9DS1_REG_STATUS_G];
+        int16_t rawAcc[3], rawGyr[3];
+        for (int axis = 0; axis < 3; axis++) {
+            rawAcc[axis] = readImuInt16LE(&acc[axis * 2]);
+            rawGyr[axis] = readImuInt16LE(&gyr[axis * 2]);
+        }
+        packRaw(packet, rawAcc, rawGyr);
+#else
         // Check if new data is available
         if (!IMU.accelerationAvailable() || !IMU.gyroscopeAvailable()) {
             return false;
@@ -36,6 +83,7 @@ public:
         packet.gx = scaleGyro(gx);
         packet.gy = scaleGyro(gy);
         packet.gz = scaleGyro(gz);
+#endif
 
         // Add metadata
         packet.sequence = _sequence++;
@@ -3,23 +3,8 @@
 
 #include <Arduino.h>
 #include "config.h"
-
-// ============================================================================
-// CRC-8/MAXIM Implementation (for packet validation)
-// ============================================================================
-inline uint8_t crc8(const uint8_t* data, size_t len) {
-    uint8_t crc = 0x00;
-    while (len--) {
-        uint8_t byte = *data++;
-        for (uint8_t i = 0; i < 8; i++) {
-            uint8_t mix = (crc ^ byte) & 0x01;
-            crc >>= 1;
-            if (mix) crc ^= 0x8C;
-            byte >>= 1;
-        }
-    }
-    return crc;
-}
+#include "crc8.h"
+#include "imu_scaling.h"
 
 // ============================================================================
 // Sensor Packet Structure (17 bytes)
@@ -44,6 +29,28 @@ public:
     // Returns true if new data available, false otherwise
     virtual bool read(SensorPacket& packet) = 0;
 
+    // Read every sample buffered since the last call (up to maxPackets),
+    // with the acquisition time of each in micros().
+    // Polled sensors return at most one sample stamped "now"; readers
+    // backed by a hardware FIFO return a whole batch.
+    virtual int readBatch(SensorPacket* packets, uint32_t* timestampsUs, int maxPackets) {
+        if (maxPackets < 1 || !read(packets[0])) {
+            return 0;
+        }
+        timestampsUs[0] = micros();
+        return 1;
+    }
+
+    // Samples lost before they could be read (e.g. hardware FIFO overflow)
+    virtual uint32_t getDroppedSamples() {
+        return 0;
+    }
+
+    // How often the main loop should call readBatch()
+    virtual uint32_t getPollIntervalMs() {
+        return 1000 / IMU_SAMPLE_RATE_HZ;
+    }
+
     // Get human-readable chip name
     virtual const char* getChipName() = 0;
 
@@ -70,6 +77,18 @@ protected:
         if (scaled < -32768.0f) return -32768;
         return (int16_t)scaled;
     }
+
+    // Integer path for raw ±4 g / ±2000 dps register values (see imu_scaling.h)
+    void packRaw(SensorPacket& packet, const int16_t acc[3], const int16_t gyr[3]) {
+        int16_t scaled[6];
+        scaleRawImu(acc, gyr, scaled);
+        packet.ax = scaled[0];
+        packet.ay = scaled[1];
+        packet.az = scaled[2];
+        packet.gx = scaled[3];
+        packet.gy = scaled[4];
+        packet.gz = scaled[5];
+    }
 };
 
 // Factory function - creates correct sensor reader for hardware
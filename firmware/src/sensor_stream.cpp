@@ -0,0 +1,307 @@
+#include "sensor_stream.h"
+#include "crc8.h"
+
+static inline void writeU16LE(uint8_t* out, uint16_t value) {
+    out[0] = (uint8_t)(value & 0xFF);
+    out[1] = (uint8_t)(value >> 8);
+}
+
+static inline uint16_t readU16LE(const uint8_t* bytes) {
+    return (uint16_t)((uint16_t)bytes[0] | ((uint16_t)bytes[1] << 8));
+}
+
+SensorBatchEncoder::SensorBatchEncoder() {
+    begin(SENSOR_STREAM_MAX_BATCH, 40000);
+}
+
+void SensorBatchEncoder::begin(uint8_t samples, uint16_t sampleIntervalUs) {
+    if (samples < 1) samples = 1;
+    if (samples > SENSOR_STREAM_MAX_BATCH) samples = SENSOR_STREAM_MAX_BATCH;
+    maxSamples = samples;
+    intervalUs = sampleIntervalUs;
+    reset();
+}
+
+void SensorBatchEncoder::reset() {
+    count = 0;
+    baseSequence = 0;
+    baseTimestamp = 0;
+}
+
+bool SensorBatchEncoder::canAppend(uint16_t sequence) const {
+    if (count == 0) {
+        return true;
+    }
+    return count < maxSamples && sequence == (uint16_t)(baseSequence + count);
+}
+
+void SensorBatchEncoder::append(const int16_t axes[6], uint16_t sequence,
+                                uint16_t timestamp) {
+    if (count == 0) {
+        baseSequence = sequence;
+        baseTimestamp = timestamp;
+    }
+    uint8_t* out = &buffer[SENSOR_BATCH_HEADER_SIZE + count * SENSOR_BATCH_SAMPLE_SIZE];
+    for (int axis = 0; axis < 6; axis++) {
+        writeU16LE(&out[axis * 2], (uint16_t)axes[axis]);
+    }
+    count++;
+}
+
+size_t SensorBatchEncoder::finish(uint8_t* out) {
+    if (count == 0) {
+        return 0;
+    }
+
+    buffer[0] = SENSOR_STREAM_BATCHED;
+    buffer[1] = count;
+    writeU16LE(&buffer[2], baseSequence);
+    writeU16LE(&buffer[4], baseTimestamp);
+    writeU16LE(&buffer[6], intervalUs);
+
+    const size_t payload = SENSOR_BATCH_HEADER_SIZE + (size_t)count * SENSOR_BATCH_SAMPLE_SIZE;
+    buffer[payload] = crc8(buffer, payload);
+
+    for (size_t i = 0; i <= payload; i++) {
+        out[i] = buffer[i];
+    }
+    count = 0;
+    return payload + 1;
+}
+
+int decodeSensorBatch(const uint8_t* data, size_t length,
+                      StreamSample* samples, int maxSamples) {
+    if (length < SENSOR_BATCH_HEADER_SIZE + 1 || data[0] != SENSOR_STREAM_BATCHED) {
+        return -1;
+    }
+    const int count = data[1];
+    if (length != SENSOR_BATCH_MAX_SIZE((size_t)count) || count > maxSamples) {
+        return -1;
+    }
+    if (crc8(data, length - 1) != data[length - 1]) {
+        return -1;
+    }
+
+    const uint16_t baseSequence = readU16LE(&data[2]);
+    const uint16_t baseTimestamp = readU16LE(&data[4]);
+    const uint32_t intervalUs = readU16LE(&data[6]);
+
+    for (int i = 0; i < count; i++) {
+        const uint8_t* in = &data[SENSOR_BATCH_HEADER_SIZE + i * SENSOR_BATCH_SAMPLE_SIZE];
+        for (int axis = 0; axis < 6; axis++) {
+            samples[i].axes[axis] = (int16_t)readU16LE(&in[axis * 2]);
+        }
+        samples[i].sequence = (uint16_t)(baseSequence + i);
+        samples[i].timestamp = (uint16_t)(baseTimestamp + ((uint32_t)i * intervalUs + 500) / 1000);
+    }
+    return count;
+}
+
+// ============================================================================
+// Delta-Compressed Stream
+// ============================================================================
+
+static inline uint32_t zigzagEncode(int32_t value) {
+    return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+static inline int32_t zigzagDecode(uint32_t value) {
+    return (int32_t)(value >> 1) ^ -(int32_t)(value & 1);
+}
+
+static size_t writeVarint(uint8_t* out, uint32_t value) {
+    size_t n = 0;
+    while (value >= 0x80) {
+        out[n++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[n++] = (uint8_t)value;
+    return n;
+}
+
+// Returns bytes read, 0 if the varint runs past end or is longer than 3 bytes
+static size_t readVarint(const uint8_t* in, const uint8_t* end, uint32_t* value) {
+    uint32_t result = 0;
+    for (size_t n = 0; n < 3 && in + n < end; n++) {
+        result |= (uint32_t)(in[n] & 0x7F) << (7 * n);
+        if ((in[n] & 0x80) == 0) {
+            *value = result;
+            return n + 1;
+        }
+    }
+    return 0;
+}
+
+SensorDeltaEncoder::SensorDeltaEncoder() {
+    begin(0, 40000, SENSOR_DELTA_DEFAULT_KEYFRAME_INTERVAL);
+}
+
+void SensorDeltaEncoder::begin(uint8_t samples, uint16_t sampleIntervalUs,
+                               uint8_t keyframePeriod) {
+    if (samples == 0 || samples > SENSOR_DELTA_MAX_SAMPLES) {
+        samples = SENSOR_DELTA_MAX_SAMPLES;
+    }
+    maxSamples = samples;
+    intervalUs = sampleIntervalUs;
+    keyframeInterval = keyframePeriod > 0 ? keyframePeriod : 1;
+    reset();
+}
+
+void SensorDeltaEncoder::reset() {
+    used = 0;
+    count = 0;
+    flags = 0;
+    sinceKeyframe = 0;
+    baseSequence = 0;
+    baseTimestamp = 0;
+    haveLast = false;
+    lastSequence = 0;
+    for (int axis = 0; axis < 6; axis++) {
+        last[axis] = 0;
+    }
+}
+
+bool SensorDeltaEncoder::isFull() const {
+    return count >= maxSamples ||
+           SENSOR_DELTA_HEADER_SIZE + used + SENSOR_DELTA_MAX_SAMPLE_BYTES + 1 >
+               SENSOR_NOTIFY_MAX_SIZE;
+}
+
+bool SensorDeltaEncoder::canAppend(uint16_t sequence) const {
+    if (count == 0) {
+        return true;
+    }
+    return count < maxSamples && sequence == (uint16_t)(lastSequence + 1);
+}
+
+bool SensorDeltaEncoder::append(const int16_t axes[6], uint16_t sequence,
+                                uint16_t timestamp) {
+    bool keyframe = false;
+    if (count == 0) {
+        keyframe = !haveLast || sequence != (uint16_t)(lastSequence + 1) ||
+                   sinceKeyframe >= keyframeInterval;
+    } else if (!canAppend(sequence)) {
+        return false;
+    }
+
+    uint8_t coded[SENSOR_DELTA_MAX_SAMPLE_BYTES];
+    size_t codedLength = 0;
+    for (int axis = 0; axis < 6; axis++) {
+        const int32_t reference = keyframe ? 0 : last[axis];
+        codedLength += writeVarint(&coded[codedLength],
+                                   zigzagEncode((int32_t)axes[axis] - reference));
+    }
+    if (SENSOR_DELTA_HEADER_SIZE + used + codedLength + 1 > SENSOR_NOTIFY_MAX_SIZE) {
+        return false;
+    }
+
+    if (count == 0) {
+        flags = keyframe ? SENSOR_DELTA_FLAG_KEYFRAME : 0;
+        baseSequence = sequence;
+        baseTimestamp = timestamp;
+    }
+    for (size_t i = 0; i < codedLength; i++) {
+        payload[SENSOR_DELTA_HEADER_SIZE + used + i] = coded[i];
+    }
+    used += codedLength;
+    count++;
+
+    for (int axis = 0; axis < 6; axis++) {
+        last[axis] = axes[axis];
+    }
+    lastSequence = sequence;
+    haveLast = true;
+    return true;
+}
+
+size_t SensorDeltaEncoder::finish(uint8_t* out) {
+    if (count == 0) {
+        return 0;
+    }
+
+    payload[0] = SENSOR_STREAM_COMPRESSED;
+    payload[1] = count;
+    payload[2] = flags;
+    writeU16LE(&payload[3], baseSequence);
+    writeU16LE(&payload[5], baseTimestamp);
+    writeU16LE(&payload[7], intervalUs);
+
+    const size_t length = SENSOR_DELTA_HEADER_SIZE + used;
+    payload[length] = crc8(payload, length);
+    for (size_t i = 0; i <= length; i++) {
+        out[i] = payload[i];
+    }
+
+    sinceKeyframe = (flags & SENSOR_DELTA_FLAG_KEYFRAME) ? 1 : sinceKeyframe + 1;
+    used = 0;
+    count = 0;
+    return length + 1;
+}
+
+SensorDeltaDecoder::SensorDeltaDecoder() {
+    reset();
+}
+
+void SensorDeltaDecoder::reset() {
+    synced = false;
+    expectedSequence = 0;
+    for (int axis = 0; axis < 6; axis++) {
+        last[axis] = 0;
+    }
+}
+
+int SensorDeltaDecoder::decode(const uint8_t* data, size_t length,
+                               StreamSample* samples, int maxSamples) {
+    if (length < SENSOR_DELTA_HEADER_SIZE + 1 || data[0] != SENSOR_STREAM_COMPRESSED ||
+        crc8(data, length - 1) != data[length - 1]) {
+        return SENSOR_DECODE_CORRUPT;
+    }
+
+    const int count = data[1];
+    const bool keyframe = (data[2] & SENSOR_DELTA_FLAG_KEYFRAME) != 0;
+    const uint16_t baseSequence = readU16LE(&data[3]);
+    const uint16_t baseTimestamp = readU16LE(&data[5]);
+    const uint32_t intervalUs = readU16LE(&data[7]);
+    if (count > maxSamples) {
+        return SENSOR_DECODE_CORRUPT;
+    }
+
+    if (!keyframe && (!synced || baseSequence != expectedSequence)) {
+        synced = false;
+        return SENSOR_DECODE_NEED_KEYFRAME;
+    }
+
+    int32_t values[6];
+    for (int axis = 0; axis < 6; axis++) {
+        values[axis] = keyframe ? 0 : last[axis];
+    }
+
+    const uint8_t* in = &data[SENSOR_DELTA_HEADER_SIZE];
+    const uint8_t* end = &data[length - 1];
+    for (int i = 0; i < count; i++) {
+        for (int axis = 0; axis < 6; axis++) {
+            uint32_t zigzag;
+            const size_t n = readVarint(in, end, &zigzag);
+            if (n == 0) {
+                synced = false;
+                return SENSOR_DECODE_CORRUPT;
+            }
+            in += n;
+            values[axis] += zigzagDecode(zigzag);
+            samples[i].axes[axis] = (int16_t)values[axis];
+        }
+        samples[i].sequence = (uint16_t)(baseSequence + i);
+        samples[i].timestamp = (uint16_t)(baseTimestamp + ((uint32_t)i * intervalUs + 500) / 1000);
+    }
+    if (in != end) {
+        synced = false;
+        return SENSOR_DECODE_CORRUPT;
+    }
+
+    for (int axis = 0; axis < 6; axis++) {
+        last[axis] = (int16_t)values[axis];
+    }
+    expectedSequence = (uint16_t)(baseSequence + count);
+    synced = true;
+    return count;
+}
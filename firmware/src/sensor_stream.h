@@ -0,0 +1,187 @@
+#ifndef SENSOR_STREAM_H
+#define SENSOR_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "config.h"
+
+// ============================================================================
+// Batched Sensor Stream
+// ============================================================================
+//
+// Packs consecutive samples into one notification so streaming at 100 Hz+
+// is not capped by one 17-byte notification per connection event.
+//
+// Layout (little-endian):
+//   [0]      format (SENSOR_STREAM_BATCHED)
+//   [1]      sample count N
+//   [2..3]   sequence of sample 0 (sample i has sequence base + i)
+//   [4..5]   timestamp of sample 0 (ms mod 65536)
+//   [6..7]   sample interval in microseconds
+//   [8..]    N × [ax, ay, az, gx, gy, gz] int16
+//   [last]   CRC-8 of every preceding byte
+//
+// Sample i's timestamp is base + round(i × interval / 1000) ms.
+// ============================================================================
+
+#define SENSOR_BATCH_HEADER_SIZE 8
+#define SENSOR_BATCH_SAMPLE_SIZE 12
+#define SENSOR_BATCH_MAX_SIZE(n) \
+    (SENSOR_BATCH_HEADER_SIZE + (n) * SENSOR_BATCH_SAMPLE_SIZE + 1)
+#define SENSOR_STREAM_MAX_BATCH \
+    ((SENSOR_NOTIFY_MAX_SIZE - SENSOR_BATCH_HEADER_SIZE - 1) / SENSOR_BATCH_SAMPLE_SIZE)
+
+struct StreamSample {
+    int16_t axes[6];    // ax, ay, az, gx, gy, gz
+    uint16_t sequence;
+    uint16_t timestamp; // ms mod 65536
+};
+
+class SensorBatchEncoder {
+public:
+    SensorBatchEncoder();
+
+    /**
+     * Configure the batch size (clamped to 1..SENSOR_STREAM_MAX_BATCH) and
+     * the nominal sample interval. Drops any pending samples.
+     */
+    void begin(uint8_t maxSamples, uint16_t intervalUs);
+    void reset();
+
+    // A sample can join the pending batch only if its sequence follows on
+    bool canAppend(uint16_t sequence) const;
+    void append(const int16_t axes[6], uint16_t sequence, uint16_t timestamp);
+
+    /**
+     * Write header + CRC into the pending batch, copy it to out (at least
+     * SENSOR_BATCH_MAX_SIZE(getMaxSamples()) bytes) and start a new one.
+     * @return Bytes written, 0 if nothing was pending
+     */
+    size_t finish(uint8_t* out);
+
+    uint8_t getCount() const { return count; }
+    uint8_t getMaxSamples() const { return maxSamples; }
+    bool isFull() const { return count >= maxSamples; }
+
+private:
+    uint8_t buffer[SENSOR_BATCH_MAX_SIZE(SENSOR_STREAM_MAX_BATCH)];
+    uint8_t count;
+    uint8_t maxSamples;
+    uint16_t intervalUs;
+    uint16_t baseSequence;
+    uint16_t baseTimestamp;
+};
+
+/**
+ * Reference decoder for one batched notification.
+ * @return Samples written, or -1 if the format, length or CRC is wrong
+ */
+int decodeSensorBatch(const uint8_t* data, size_t length,
+                      StreamSample* samples, int maxSamples);
+
+// ============================================================================
+// Delta-Compressed Sensor Stream
+// ============================================================================
+//
+// Consecutive samples differ by little, so each axis is sent as the zigzag
+// varint of its change from the previous sample: 1 byte for |delta| < 64,
+// 2 bytes below 8192, 3 bytes worst case.
+//
+// Layout (little-endian):
+//   [0]      format (SENSOR_STREAM_COMPRESSED)
+//   [1]      sample count N
+//   [2]      flags (SENSOR_DELTA_FLAG_KEYFRAME)
+//   [3..4]   sequence of sample 0 (sample i has sequence base + i)
+//   [5..6]   timestamp of sample 0 (ms mod 65536)
+//   [7..8]   sample interval in microseconds
+//   [9..]    N × 6 zigzag varints (ax, ay, az, gx, gy, gz)
+//   [last]   CRC-8 of every preceding byte
+//
+// A keyframe's first sample is coded against zero; any other notification
+// continues from the last sample of the one before it. Keyframes are sent
+// every keyframeInterval notifications and after any sequence gap, so a lost
+// notification costs at most that many notifications before the decoder
+// resynchronises.
+// ============================================================================
+
+#define SENSOR_DELTA_HEADER_SIZE 9
+#define SENSOR_DELTA_FLAG_KEYFRAME 0x01
+#define SENSOR_DELTA_MAX_SAMPLE_BYTES 18 // 6 axes × 3-byte varint
+#define SENSOR_DELTA_MAX_SAMPLES \
+    ((SENSOR_NOTIFY_MAX_SIZE - SENSOR_DELTA_HEADER_SIZE - 1) / 6)
+#define SENSOR_DELTA_DEFAULT_KEYFRAME_INTERVAL 4
+
+// decode() results besides a sample count
+#define SENSOR_DECODE_CORRUPT -1
+#define SENSOR_DECODE_NEED_KEYFRAME -2
+
+class SensorDeltaEncoder {
+public:
+    SensorDeltaEncoder();
+
+    /**
+     * Configure the sample cap per notification (0 or more than
+     * SENSOR_DELTA_MAX_SAMPLES = as many as fit) and the keyframe period.
+     * The next notification is a keyframe.
+     */
+    void begin(uint8_t maxSamples, uint16_t intervalUs, uint8_t keyframeInterval);
+    void reset();
+
+    // A sample can join the pending notification only if its sequence follows on
+    bool canAppend(uint16_t sequence) const;
+
+    /**
+     * Append one sample. Returns false without changing state if it does
+     * not fit; finish() the pending notification and append again.
+     */
+    bool append(const int16_t axes[6], uint16_t sequence, uint16_t timestamp);
+
+    /**
+     * Close the pending notification into out (SENSOR_NOTIFY_MAX_SIZE bytes).
+     * @return Bytes written, 0 if nothing was pending
+     */
+    size_t finish(uint8_t* out);
+
+    uint8_t getCount() const { return count; }
+    uint8_t getMaxSamples() const { return maxSamples; }
+    bool isFull() const;
+
+private:
+    uint8_t payload[SENSOR_NOTIFY_MAX_SIZE];
+    size_t used;           // Varint bytes in payload
+    uint8_t count;
+    uint8_t flags;
+    uint8_t maxSamples;
+    uint8_t keyframeInterval;
+    uint8_t sinceKeyframe; // Notifications finished since the last keyframe
+    uint16_t intervalUs;
+    uint16_t baseSequence;
+    uint16_t baseTimestamp;
+    bool haveLast;
+    uint16_t lastSequence;
+    int16_t last[6];
+};
+
+/**
+ * Reference decoder. Keeps the previous sample between notifications.
+ */
+class SensorDeltaDecoder {
+public:
+    SensorDeltaDecoder();
+    void reset();
+
+    /**
+     * Decode one notification.
+     * @return Samples written, SENSOR_DECODE_CORRUPT (bad format, length or
+     *         CRC) or SENSOR_DECODE_NEED_KEYFRAME (a notification was lost and
+     *         this one continues from it)
+     */
+    int decode(const uint8_t* data, size_t length, StreamSample* samples, int maxSamples);
+
+private:
+    bool synced;
+    uint16_t expectedSequence;
+    int16_t last[6];
+};
+
+#endif // SENSOR_STREAM_H
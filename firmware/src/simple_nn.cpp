@@ -11,6 +11,7 @@
 
 #include "simple_nn.h"
 #include "nn_math.h"
+#include "profiler.h"
 
 // ============================================================================
 // CONSTRUCTOR
@@ -18,7 +19,10 @@
 
 SimpleNN::SimpleNN() {
     modelLoaded = false;
+    hiddenValid = false;
     numClasses = 0;
+    numHeads = 0;
+    extraHeads = nullptr;
     hiddenWeights = nullptr;
     hiddenBias = nullptr;
     outputWeights = nullptr;
@@ -34,7 +38,8 @@ SimpleNN::SimpleNN() {
 // MODEL LOADING
 // ============================================================================
 
-bool SimpleNN::loadModel(const SimpleNNModel* modelData) {
+bool SimpleNN::loadModel(const SimpleNNModel* modelData,
+                         const SimpleNNExtraHeads* extraHeadData) {
     // Validate magic number
     if (modelData->magic != SIMPLE_NN_MAGIC) {
         DEBUG_PRINTLN("SimpleNN: Invalid magic number");
@@ -68,8 +73,31 @@ bool SimpleNN::loadModel(const SimpleNNModel* modelData) {
         return false;
     }
     
+    // Validate optional extra heads
+    if (extraHeadData != nullptr) {
+        if (extraHeadData->magic != SIMPLE_NN_HEADS_MAGIC ||
+            extraHeadData->numExtraHeads < 1 ||
+            extraHeadData->numExtraHeads > NN_MAX_HEADS - 1) {
+            DEBUG_PRINTLN("SimpleNN: Invalid extra heads block");
+            modelLoaded = false;
+            return false;
+        }
+        for (uint32_t h = 0; h < extraHeadData->numExtraHeads; h++) {
+            const uint32_t headClasses = extraHeadData->heads[h].numClasses;
+            if (headClasses < 1 || headClasses > NN_MAX_CLASSES) {
+                DEBUG_PRINT("SimpleNN: Invalid number of classes in head ");
+                DEBUG_PRINTLN(h + 1);
+                modelLoaded = false;
+                return false;
+            }
+        }
+    }
+
     // Store pointers to weight data
     numClasses = modelData->numClasses;
+    extraHeads = extraHeadData;
+    numHeads = 1 + (extraHeadData != nullptr ? extraHeadData->numExtraHeads : 0);
+    hiddenValid = false;
     hiddenWeights = modelData->hiddenWeights;
     hiddenBias = modelData->hiddenBias;
     outputWeights = modelData->outputWeights;
@@ -85,10 +113,25 @@ bool SimpleNN::loadModel(const SimpleNNModel* modelData) {
     DEBUG_PRINTLN(modelData->inputSize);
     DEBUG_PRINT("  Hidden size: ");
     DEBUG_PRINTLN(modelData->hiddenSize);
+    DEBUG_PRINT("  Output heads: ");
+    DEBUG_PRINTLN(numHeads);
     
     return true;
 }
 
+void SimpleNN::unloadModel() {
+    modelLoaded = false;
+    hiddenValid = false;
+    numClasses = 0;
+    numHeads = 0;
+    extraHeads = nullptr;
+    hiddenWeights = nullptr;
+    hiddenBias = nullptr;
+    outputWeights = nullptr;
+    outputBias = nullptr;
+    labels = nullptr;
+}
+
 const char* SimpleNN::getLabel(uint8_t classIndex) const {
     if (!modelLoaded || classIndex >= numClasses) {
         return "Unknown";
@@ -96,6 +139,27 @@ const char* SimpleNN::getLabel(uint8_t classIndex) const {
     return labels[classIndex];
 }
 
+uint32_t SimpleNN::getHeadNumClasses(uint8_t head) const {
+    if (!modelLoaded || head >= numHeads) {
+        return 0;
+    }
+    if (head == 0) {
+        return numClasses;
+    }
+    return extraHeads->heads[head - 1].numClasses;
+}
+
+const char* SimpleNN::getHeadLabel(uint8_t head, uint8_t classIndex) const {
+    if (head == 0) {
+        return getLabel(classIndex);
+    }
+    if (!modelLoaded || head >= numHeads ||
+        classIndex >= extraHeads->heads[head - 1].numClasses) {
+        return "Unknown";
+    }
+    return extraHeads->heads[head - 1].labels[classIndex];
+}
+
 // ============================================================================
 // INFERENCE - The Main Event!
 // ============================================================================
@@ -119,15 +183,19 @@ int SimpleNN::predict(const float* input, float* outputProbabilities) {
     // This is where the network "looks for patterns" in the sensor data!
     // ========================================================================
     
-    denseLayer(
-        input,              // 600 input values (sensor data)
-        hiddenOutput,       // 32 output values (pattern activations)
-        hiddenWeights,      // 32 × 600 = 19,200 weights
-        hiddenBias,         // 32 biases
-        NN_INPUT_SIZE,      // 600
-        NN_HIDDEN_SIZE,     // 32
-        true                // Use ReLU activation
-    );
+    {
+        PROFILE_SCOPE(PROFILE_DENSE_HIDDEN);
+        denseLayer(
+            input,              // 600 input values (sensor data)
+            hiddenOutput,       // 32 output values (pattern activations)
+            hiddenWeights,      // 32 × 600 = 19,200 weights
+            hiddenBias,         // 32 biases
+            NN_INPUT_SIZE,      // 600
+            NN_HIDDEN_SIZE,     // 32
+            true                // Use ReLU activation
+        );
+    }
+    hiddenValid = true;
     
     // ========================================================================
     // LAYER 2: Hidden → Output
@@ -141,15 +209,18 @@ int SimpleNN::predict(const float* input, float* outputProbabilities) {
     // No ReLU here - we'll apply softmax after to get probabilities
     // ========================================================================
     
-    denseLayer(
-        hiddenOutput,           // 32 hidden neuron outputs
-        outputProbabilities,    // N class scores
-        outputWeights,          // N × 32 weights
-        outputBias,             // N biases
-        NN_HIDDEN_SIZE,         // 32
-        numClasses,             // Number of output classes
-        false                   // No ReLU - raw scores for softmax
-    );
+    {
+        PROFILE_SCOPE(PROFILE_DENSE_OUTPUT);
+        denseLayer(
+            hiddenOutput,           // 32 hidden neuron outputs
+            outputProbabilities,    // N class scores
+            outputWeights,          // N × 32 weights
+            outputBias,             // N biases
+            NN_HIDDEN_SIZE,         // 32
+            numClasses,             // Number of output classes
+            false                   // No ReLU - raw scores for softmax
+        );
+    }
     
     // ========================================================================
     // SOFTMAX: Convert to Probabilities
@@ -174,6 +245,40 @@ int SimpleNN::predict(const float* input, float* outputProbabilities) {
     return prediction;
 }
 
+// ============================================================================
+// EXTRA HEADS - Same hidden layer, different question
+// ============================================================================
+
+int SimpleNN::predictHead(uint8_t head, float* outputProbabilities, float* confidence) {
+    if (!modelLoaded || !hiddenValid || head == 0 || head >= numHeads) {
+        *confidence = 0.0f;
+        return -1;
+    }
+
+    const SimpleNNHead& outputHead = extraHeads->heads[head - 1];
+    const int headClasses = (int)outputHead.numClasses;
+
+    // Hidden → this head's outputs (hiddenOutput is reused, not recomputed)
+    {
+        PROFILE_SCOPE(PROFILE_DENSE_HEAD);
+        denseLayer(
+            hiddenOutput,
+            outputProbabilities,
+            outputHead.outputWeights,
+            outputHead.outputBias,
+            NN_HIDDEN_SIZE,
+            headClasses,
+            false
+        );
+    }
+
+    softmax(outputProbabilities, headClasses);
+
+    int prediction = argmax(outputProbabilities, headClasses);
+    *confidence = outputProbabilities[prediction];
+    return prediction;
+}
+
 // ============================================================================
 // DENSE LAYER - The Core Neural Network Operation
 // ============================================================================
@@ -215,6 +320,7 @@ void SimpleNN::denseLayer(
 // ============================================================================
 
 void SimpleNN::softmax(float* values, int size) {
+    PROFILE_SCOPE(PROFILE_SOFTMAX);
     softmaxInPlace(values, size);
 }
 
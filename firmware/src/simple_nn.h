@@ -71,6 +71,42 @@ struct SimpleNNModel {
 // Magic number: "SNNN" (Simple Neural Network)
 #define SIMPLE_NN_MAGIC 0x4E4E4E53
 
+// ============================================================================
+// EXTRA OUTPUT HEADS (optional)
+// ============================================================================
+
+/**
+ * One additional output layer that reads the same 32 hidden neurons.
+ *
+ * A multi-head model answers several questions about one window (e.g.
+ * "which gesture?" and "how hard?") while the expensive 600 × 32 hidden
+ * layer runs only once.
+ */
+struct SimpleNNHead {
+    uint32_t numClasses;                                   // 1-8
+    float outputWeights[NN_MAX_CLASSES * NN_HIDDEN_SIZE]; // 8 × 32 = 256
+    float outputBias[NN_MAX_CLASSES];                      // 8
+    char labels[NN_MAX_CLASSES][LABEL_MAX_LEN];            // 8 labels × 16 chars
+};
+
+/**
+ * Block appended directly after SimpleNNModel for multi-head models.
+ * Only numExtraHeads entries of heads[] are sent over BLE.
+ */
+struct SimpleNNExtraHeads {
+    uint32_t magic;                          // SIMPLE_NN_HEADS_MAGIC
+    uint32_t numExtraHeads;                  // 1 to NN_MAX_HEADS - 1
+    SimpleNNHead heads[NN_MAX_HEADS - 1];
+};
+
+// Magic number: "SNNH" (Simple Neural Network Heads)
+#define SIMPLE_NN_HEADS_MAGIC 0x484E4E53
+
+// Bytes on the wire for a model with the given number of extra heads
+#define SIMPLE_NN_UPLOAD_SIZE(extraHeads)                                      \
+    (sizeof(SimpleNNModel) +                                                   \
+     ((extraHeads) > 0 ? 2 * sizeof(uint32_t) + (extraHeads) * sizeof(SimpleNNHead) : 0))
+
 // ============================================================================
 // SIMPLE NEURAL NETWORK CLASS
 // ============================================================================
@@ -81,10 +117,17 @@ public:
     
     /**
      * Load model weights from a buffer
-     * @param modelData Pointer to SimpleNNModel structure
+     * @param modelData Pointer to SimpleNNModel structure (primary head)
+     * @param extraHeads Optional extra output heads (nullptr = single head)
      * @return true if model loaded successfully
      */
-    bool loadModel(const SimpleNNModel* modelData);
+    bool loadModel(const SimpleNNModel* modelData,
+                   const SimpleNNExtraHeads* extraHeads = nullptr);
+    
+    /**
+     * Drop the pointers into the model buffer (before it is overwritten)
+     */
+    void unloadModel();
     
     /**
      * Check if a valid model is loaded
@@ -100,6 +143,17 @@ public:
      * Get class label by index
      */
     const char* getLabel(uint8_t classIndex) const;
+
+    /**
+     * Number of output heads (1 for a classic single-head model)
+     */
+    uint8_t getNumHeads() const { return numHeads; }
+
+    /**
+     * Number of classes / label for a given head (head 0 = primary)
+     */
+    uint32_t getHeadNumClasses(uint8_t head) const;
+    const char* getHeadLabel(uint8_t head, uint8_t classIndex) const;
     
     /**
      * Run inference on input data
@@ -109,6 +163,19 @@ public:
      * @return Predicted class index (0 to numClasses-1)
      */
     int predict(const float* input, float* outputProbabilities);
+
+    /**
+     * Run an extra output head on the hidden layer from the last predict()
+     *
+     * The hidden activations are reused, so each extra head only costs
+     * 32 × N multiply-adds plus its own softmax.
+     *
+     * @param head Head index (1 to getNumHeads() - 1)
+     * @param outputProbabilities Array to store this head's probabilities
+     * @param confidence Output: probability of the winning class
+     * @return Predicted class index for this head, or -1
+     */
+    int predictHead(uint8_t head, float* outputProbabilities, float* confidence);
     
     /**
      * Get the confidence of the last prediction
@@ -118,7 +185,10 @@ public:
 private:
     // Model state
     bool modelLoaded;
+    bool hiddenValid;   // hiddenOutput holds the last predict() window
     uint32_t numClasses;
+    uint8_t numHeads;
+    const SimpleNNExtraHeads* extraHeads;
     
     // Pointers to weight data (stored in model structure)
     const float* hiddenWeights;
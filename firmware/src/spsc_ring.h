@@ -0,0 +1,80 @@
+#ifndef SPSC_RING_H
+#define SPSC_RING_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+// ============================================================================
+// Lock-Free Single-Producer / Single-Consumer Ring
+// ============================================================================
+//
+// Hands samples from the sampling interrupt/thread (producer) to the main
+// loop (consumer) without disabling interrupts or taking a mutex. Exactly one
+// context may call push() and exactly one other may call pop()/clear().
+//
+// head is written only by the producer and tail only by the consumer; each
+// side publishes with a release store and observes the other with an acquire
+// load, so the element copy is visible before the index that exposes it.
+// Indices run freely and wrap at 2^32, which is why N must be a power of two.
+//
+// A full ring drops the NEW item (the producer cannot safely discard the
+// consumer's oldest one) and counts it as an overrun.
+// ============================================================================
+
+template <typename T, size_t N>
+class SpscRing {
+    static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing capacity must be a power of two");
+
+public:
+    SpscRing() : head(0), tail(0), overruns(0) {}
+
+    // Producer side. Returns false (and counts an overrun) if full.
+    bool push(const T& item) {
+        const uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) >= N) {
+            overruns.store(overruns.load(std::memory_order_relaxed) + 1,
+                           std::memory_order_relaxed);
+            return false;
+        }
+        items[h & (N - 1)] = item;
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if empty.
+    bool pop(T& item) {
+        const uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) {
+            return false;
+        }
+        item = items[t & (N - 1)];
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: drop everything currently queued
+    void clear() {
+        tail.store(head.load(std::memory_order_acquire), std::memory_order_release);
+    }
+
+    // Safe from either side (a snapshot while the other side runs). tail is
+    // loaded first so a concurrent pop can never make it pass head.
+    size_t size() const {
+        const uint32_t t = tail.load(std::memory_order_acquire);
+        return (size_t)(head.load(std::memory_order_acquire) - t);
+    }
+
+    bool empty() const { return size() == 0; }
+    static constexpr size_t capacity() { return N; }
+
+    uint32_t getOverruns() const { return overruns.load(std::memory_order_relaxed); }
+
+private:
+    T items[N];
+    std::atomic<uint32_t> head;
+    std::atomic<uint32_t> tail;
+    std::atomic<uint32_t> overruns; // Written by the producer only
+};
+
+#endif // SPSC_RING_H
@@ -0,0 +1,124 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <filesystem>
+#include "batch_eval.h"
+#include "flash_storage.h"
+#include "inference.h"
+#include "sensor_host.h"
+#include "test_models.h"
+
+static SimpleNNModel testModel;
+static char sessionRoot[64];
+
+static const char* const kLabels[] = {"Idle", "Wave", "Shake"};
+
+// Small random weights so predictions vary from window to window
+static void buildModel() {
+    buildTestModel(testModel, 3, 12345, 0.2f, kLabels);
+}
+
+static void writeSession(const char* label, int index, float frequencyHz, float amplitude, int samples) {
+    char path[160];
+    snprintf(path, sizeof(path), "%s/%s", sessionRoot, label);
+    std::filesystem::create_directories(path);
+    snprintf(path, sizeof(path), "%s/%s/session%d.csv", sessionRoot, label, index);
+    FILE* file = fopen(path, "w");
+    fprintf(file, "ax,ay,az,gx,gy,gz\n");
+    for (int n = 0; n < samples; n++) {
+        const float t = n / 25.0f + index * 0.37f;
+        const float s = sinf(6.2831853f * frequencyHz * t);
+        fprintf(file, "%.4f,%.4f,%.4f,%.2f,%.2f,%.2f\n", amplitude * s, 0.1f * amplitude * s,
+                1.0f + 0.2f * amplitude * s, 100 * amplitude * s, 0.0f, -50 * amplitude * s);
+    }
+    fclose(file);
+}
+
+static void setUpSessions() {
+    snprintf(sessionRoot, sizeof(sessionRoot), "/tmp/severn_eval_%d", (int)getpid());
+    for (int i = 0; i < 3; i++) {
+        writeSession("Idle", i, 0.0f, 0.0f, 180 + i * 40);
+        writeSession("Wave", i, 1.0f, 0.6f, 250);
+        writeSession("Shake", i, 4.0f, 1.5f, 300 + i);
+    }
+    writeSession("Jump", 0, 2.0f, 1.0f, 200);  // Not a model class
+    writeSession("Short", 0, 2.0f, 1.0f, 50);  // Label unknown as well
+}
+
+void test_window_count_matches_firmware_stride() {
+    TEST_ASSERT_EQUAL_UINT32(0, evalWindowCount(WINDOW_SIZE - 1));
+    TEST_ASSERT_EQUAL_UINT32(1, evalWindowCount(WINDOW_SIZE));
+    TEST_ASSERT_EQUAL_UINT32(1, evalWindowCount(WINDOW_SIZE + WINDOW_STRIDE - 1));
+    TEST_ASSERT_EQUAL_UINT32(2, evalWindowCount(WINDOW_SIZE + WINDOW_STRIDE));
+}
+
+void test_rejects_truncated_model() {
+    std::vector<uint8_t> bytes((const uint8_t*)&testModel, (const uint8_t*)&testModel + 1000);
+    std::string error;
+    TEST_ASSERT_FALSE(loadEvalModel(bytes, &error));
+    TEST_ASSERT_TRUE(error.find("rejected") != std::string::npos);
+}
+
+// The parallel evaluator must agree window for window with the firmware's
+// addSample / runInference / slideWindow path
+void test_matches_firmware_pipeline() {
+    std::vector<uint8_t> bytes((const uint8_t*)&testModel, (const uint8_t*)&testModel + sizeof(testModel));
+    std::string error;
+    TEST_ASSERT_TRUE(loadEvalModel(bytes, &error));
+
+    std::vector<EvalSession> sessions;
+    std::vector<std::string> skipped;
+    TEST_ASSERT_TRUE(loadEvalSessions(sessionRoot, &sessions, &skipped, &error));
+    TEST_ASSERT_EQUAL_UINT32(9, sessions.size());
+    TEST_ASSERT_EQUAL_UINT32(2, skipped.size());
+
+    EvalResult result;
+    evaluateSessions(sessions, 4, &result);
+    TEST_ASSERT_EQUAL_INT(4, result.threads);
+
+    uint32_t expected[NN_MAX_CLASSES][NN_MAX_CLASSES] = {{0}};
+    uint64_t windows = 0;
+    TEST_ASSERT_TRUE(reloadModel());
+    for (size_t s = 0; s < sessions.size(); s++) {
+        resetInferenceWindow();
+        const std::vector<int16_t>& samples = sessions[s].samples;
+        for (size_t i = 0; i < samples.size(); i += 6) {
+            addSample(samples[i], samples[i + 1], samples[i + 2], samples[i + 3], samples[i + 4], samples[i + 5]);
+            if (isWindowReady()) {
+                float confidence;
+                expected[sessions[s].trueClass][runInference(&confidence)]++;
+                windows++;
+                slideWindow();
+            }
+        }
+    }
+
+    TEST_ASSERT_EQUAL_UINT32(windows, result.windows);
+    TEST_ASSERT_EQUAL_MEMORY(expected, result.confusion, sizeof(expected));
+    TEST_ASSERT_EQUAL_UINT32(3, result.sessions[0]);
+    TEST_ASSERT_EQUAL_STRING("Shake", result.labels[2]);
+
+    // Still windows: the idle override wins unless the model is confident
+    const uint32_t idleWindows = result.confusion[0][0] + result.confusion[0][1] + result.confusion[0][2];
+    TEST_ASSERT_TRUE(idleWindows > 0);
+    TEST_ASSERT_TRUE(result.detectedSessions[0] <= result.sessions[0]);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    Serial.setOutput(nullptr);
+    buildModel();
+    setUpSessions();
+
+    UNITY_BEGIN();
+    RUN_TEST(test_window_count_matches_firmware_stride);
+    RUN_TEST(test_rejects_truncated_model);
+    RUN_TEST(test_matches_firmware_pipeline);
+    const int failures = UNITY_END();
+
+    std::filesystem::remove_all(sessionRoot);
+    return failures;
+}
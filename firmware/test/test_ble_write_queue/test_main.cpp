@@ -0,0 +1,76 @@
+#include <unity.h>
+#include <string.h>
+#include "ble_write_queue.h"
+
+void test_writes_come_out_in_arrival_order() {
+    BleWriteQueue queue;
+    const uint8_t mode = 1;
+    const uint8_t config[7] = {25, 0, 100, 0, 2, 0, 1};
+    const uint8_t chunk[5] = {0x02, 0, 0, 0, 0};
+    TEST_ASSERT_TRUE(queue.push(BLE_WRITE_UPLOAD, chunk, sizeof(chunk)));
+    TEST_ASSERT_TRUE(queue.push(BLE_WRITE_MODE, &mode, 1));
+    TEST_ASSERT_TRUE(queue.push(BLE_WRITE_CONFIG, config, sizeof(config)));
+    TEST_ASSERT_EQUAL_UINT32(3, queue.depth());
+
+    BleWrite write;
+    TEST_ASSERT_TRUE(queue.pop(write));
+    TEST_ASSERT_EQUAL_UINT8(BLE_WRITE_UPLOAD, write.source);
+    TEST_ASSERT_EQUAL_UINT8(sizeof(chunk), write.length);
+    TEST_ASSERT_EQUAL_MEMORY(chunk, write.data, sizeof(chunk));
+    TEST_ASSERT_TRUE(queue.pop(write));
+    TEST_ASSERT_EQUAL_UINT8(BLE_WRITE_MODE, write.source);
+    TEST_ASSERT_EQUAL_UINT8(1, write.data[0]);
+    TEST_ASSERT_TRUE(queue.pop(write));
+    TEST_ASSERT_EQUAL_UINT8(BLE_WRITE_CONFIG, write.source);
+    TEST_ASSERT_EQUAL_MEMORY(config, write.data, sizeof(config));
+    TEST_ASSERT_FALSE(queue.pop(write));
+}
+
+void test_full_queue_drops_are_counted_per_source() {
+    BleWriteQueue queue;
+    const uint8_t chunk[1] = {0x02};
+    for (size_t i = 0; i < BleWriteQueue::capacity(); i++) {
+        TEST_ASSERT_TRUE(queue.push(BLE_WRITE_UPLOAD, chunk, 1));
+    }
+    TEST_ASSERT_FALSE(queue.push(BLE_WRITE_UPLOAD, chunk, 1));
+    TEST_ASSERT_FALSE(queue.push(BLE_WRITE_UPLOAD, chunk, 1));
+    TEST_ASSERT_FALSE(queue.push(BLE_WRITE_MODE, chunk, 1));
+    TEST_ASSERT_EQUAL_UINT32(3, queue.getDrops());
+    TEST_ASSERT_EQUAL_UINT32(2, queue.getDrops(BLE_WRITE_UPLOAD));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.getDrops(BLE_WRITE_MODE));
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getDrops(BLE_WRITE_CONFIG));
+
+    // The peak counts the write that did not fit
+    TEST_ASSERT_EQUAL_UINT32(BleWriteQueue::capacity() + 1, queue.getPeakDepth());
+}
+
+void test_peak_depth_and_truncation() {
+    BleWriteQueue queue;
+    uint8_t big[BLE_WRITE_MAX_SIZE + 20];
+    memset(big, 0xAB, sizeof(big));
+    TEST_ASSERT_TRUE(queue.push(BLE_WRITE_UPLOAD, big, sizeof(big)));
+    TEST_ASSERT_TRUE(queue.push(BLE_WRITE_UPLOAD, big, 10));
+
+    BleWrite write;
+    TEST_ASSERT_TRUE(queue.pop(write));
+    TEST_ASSERT_EQUAL_UINT8(BLE_WRITE_MAX_SIZE, write.length);
+    TEST_ASSERT_TRUE(queue.pop(write));
+    TEST_ASSERT_EQUAL_UINT8(10, write.length);
+
+    // Draining does not lower the high-water mark
+    TEST_ASSERT_TRUE(queue.push(BLE_WRITE_MODE, big, 1));
+    TEST_ASSERT_EQUAL_UINT32(1, queue.depth());
+    TEST_ASSERT_EQUAL_UINT32(2, queue.getPeakDepth());
+    TEST_ASSERT_EQUAL_UINT32(0, queue.getDrops());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_writes_come_out_in_arrival_order);
+    RUN_TEST(test_full_queue_drops_are_counted_per_source);
+    RUN_TEST(test_peak_depth_and_truncation);
+    return UNITY_END();
+}
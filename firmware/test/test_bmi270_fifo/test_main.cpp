@@ -0,0 +1,132 @@
+#include <unity.h>
+#include <string.h>
+#include "bmi270_fifo.h"
+
+// Append one header-mode gyro + accel frame to buf, returns bytes written
+static size_t putFrame(uint8_t* buf, uint8_t header,
+                       int16_t gx, int16_t gy, int16_t gz,
+                       int16_t ax, int16_t ay, int16_t az) {
+    const int16_t values[6] = {gx, gy, gz, ax, ay, az};
+    buf[0] = header;
+    for (int i = 0; i < 6; i++) {
+        buf[1 + i * 2] = (uint8_t)(values[i] & 0xFF);
+        buf[2 + i * 2] = (uint8_t)(((uint16_t)values[i] >> 8) & 0xFF);
+    }
+    return BMI270_FIFO_GYR_ACC_FRAME_BYTES;
+}
+
+void test_parses_gyro_then_accel_order() {
+    uint8_t buf[64];
+    size_t len = putFrame(buf, BMI270_FIFO_HEADER_GYR_ACC, 1, -2, 3, 8192, -8192, 16384);
+
+    Bmi270FifoFrame frames[4];
+    const Bmi270FifoParseResult result = parseBmi270Fifo(buf, len, frames, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, result.frames);
+    TEST_ASSERT_EQUAL_UINT32(len, result.bytesConsumed);
+    TEST_ASSERT_EQUAL_INT16(1, frames[0].gyr[0]);
+    TEST_ASSERT_EQUAL_INT16(-2, frames[0].gyr[1]);
+    TEST_ASSERT_EQUAL_INT16(3, frames[0].gyr[2]);
+    TEST_ASSERT_EQUAL_INT16(8192, frames[0].acc[0]);
+    TEST_ASSERT_EQUAL_INT16(-8192, frames[0].acc[1]);
+    TEST_ASSERT_EQUAL_INT16(16384, frames[0].acc[2]);
+}
+
+void test_parses_burst_and_stops_at_over_read() {
+    uint8_t buf[128];
+    size_t len = 0;
+    for (int i = 0; i < 5; i++) {
+        len += putFrame(&buf[len], BMI270_FIFO_HEADER_GYR_ACC,
+                        (int16_t)i, 0, 0, (int16_t)(100 + i), 0, 0);
+    }
+    // Reading past the fill level returns the over-read marker
+    const size_t filled = len;
+    memset(&buf[len], BMI270_FIFO_HEADER_OVER_READ, 10);
+    len += 10;
+
+    Bmi270FifoFrame frames[8];
+    const Bmi270FifoParseResult result = parseBmi270Fifo(buf, len, frames, 8);
+
+    TEST_ASSERT_EQUAL_INT(5, result.frames);
+    TEST_ASSERT_EQUAL_UINT32(filled, result.bytesConsumed);
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL_INT16(i, frames[i].gyr[0]);
+        TEST_ASSERT_EQUAL_INT16(100 + i, frames[i].acc[0]);
+    }
+}
+
+void test_truncated_trailing_frame_is_left_for_next_read() {
+    uint8_t buf[64];
+    size_t len = putFrame(buf, BMI270_FIFO_HEADER_GYR_ACC, 1, 1, 1, 1, 1, 1);
+    len += putFrame(&buf[len], BMI270_FIFO_HEADER_GYR_ACC, 2, 2, 2, 2, 2, 2);
+
+    Bmi270FifoFrame frames[4];
+    const Bmi270FifoParseResult result = parseBmi270Fifo(buf, len - 5, frames, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, result.frames);
+    TEST_ASSERT_EQUAL_UINT32(BMI270_FIFO_GYR_ACC_FRAME_BYTES, result.bytesConsumed);
+}
+
+void test_control_frames_and_tags() {
+    uint8_t buf[64];
+    size_t len = 0;
+    buf[len++] = BMI270_FIFO_HEADER_SKIP;
+    buf[len++] = 7;  // 7 frames dropped on overflow
+    buf[len++] = BMI270_FIFO_HEADER_INPUT_CONFIG;
+    len += 4;
+    // Accel-only frame right after a config change is ignored
+    buf[len++] = BMI270_FIFO_HEADER_ACC;
+    len += 6;
+    // Interrupt-tagged regular frame still parses
+    len += putFrame(&buf[len], BMI270_FIFO_HEADER_GYR_ACC | 0x01, 5, 0, 0, 6, 0, 0);
+    buf[len++] = BMI270_FIFO_HEADER_SENSORTIME;
+    buf[len++] = 0x56;
+    buf[len++] = 0x34;
+    buf[len++] = 0x12;
+
+    Bmi270FifoFrame frames[4];
+    const Bmi270FifoParseResult result = parseBmi270Fifo(buf, len, frames, 4);
+
+    TEST_ASSERT_EQUAL_INT(1, result.frames);
+    TEST_ASSERT_EQUAL_INT16(5, frames[0].gyr[0]);
+    TEST_ASSERT_EQUAL_INT16(6, frames[0].acc[0]);
+    TEST_ASSERT_EQUAL_UINT32(7, result.skippedFrames);
+    TEST_ASSERT_TRUE(result.sensorTimeValid);
+    TEST_ASSERT_EQUAL_HEX32(0x123456, result.sensorTime);
+    TEST_ASSERT_EQUAL_UINT32(len, result.bytesConsumed);
+}
+
+void test_respects_max_frames() {
+    uint8_t buf[64];
+    size_t len = 0;
+    for (int i = 0; i < 4; i++) {
+        len += putFrame(&buf[len], BMI270_FIFO_HEADER_GYR_ACC, 0, 0, 0, 0, 0, 0);
+    }
+
+    Bmi270FifoFrame frames[2];
+    const Bmi270FifoParseResult result = parseBmi270Fifo(buf, len, frames, 2);
+
+    TEST_ASSERT_EQUAL_INT(2, result.frames);
+    TEST_ASSERT_EQUAL_UINT32(2 * BMI270_FIFO_GYR_ACC_FRAME_BYTES, result.bytesConsumed);
+}
+
+void test_odr_codes() {
+    TEST_ASSERT_EQUAL_UINT8(0x06, bmi270OdrCode(25));
+    TEST_ASSERT_EQUAL_UINT8(0x08, bmi270OdrCode(100));
+    TEST_ASSERT_EQUAL_UINT8(0x09, bmi270OdrCode(200));
+    TEST_ASSERT_EQUAL_UINT8(0, bmi270OdrCode(75));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_parses_gyro_then_accel_order);
+    RUN_TEST(test_parses_burst_and_stops_at_over_read);
+    RUN_TEST(test_truncated_trailing_frame_is_left_for_next_read);
+    RUN_TEST(test_control_frames_and_tags);
+    RUN_TEST(test_respects_max_frames);
+    RUN_TEST(test_odr_codes);
+    return UNITY_END();
+}
@@ -0,0 +1,169 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <chrono>
+#include "decimator.h"
+
+static const float PI_F = 3.14159265358979f;
+
+// Feed a sine on every axis at the oversampled rate and return the peak
+// output amplitude after the filter has settled.
+static float decimatedSineAmplitude(int factor, float inputRateHz, float toneHz, float amplitude) {
+    PolyphaseDecimator decimator;
+    decimator.begin(factor);
+
+    const int totalInputs = 4000;
+    const int settleInputs = factor * DECIMATOR_TAPS_PER_PHASE * 2;
+    float peak = 0.0f;
+    int16_t input[DECIMATOR_AXES];
+    int16_t output[DECIMATOR_AXES];
+
+    for (int n = 0; n < totalInputs; n++) {
+        const float value = amplitude * sinf(2.0f * PI_F * toneHz * (float)n / inputRateHz);
+        for (int a = 0; a < DECIMATOR_AXES; a++) {
+            input[a] = (int16_t)lroundf(value);
+        }
+        if (decimator.push(input, output) && n >= settleInputs) {
+            const float magnitude = fabsf((float)output[0]);
+            if (magnitude > peak) peak = magnitude;
+        }
+    }
+    return peak;
+}
+
+void test_factor_one_is_passthrough() {
+    PolyphaseDecimator decimator;
+    TEST_ASSERT_TRUE(decimator.begin(1));
+
+    const int16_t input[DECIMATOR_AXES] = {1, -2, 3, -4, 5, -32768};
+    int16_t output[DECIMATOR_AXES] = {0};
+    TEST_ASSERT_TRUE(decimator.push(input, output));
+    for (int a = 0; a < DECIMATOR_AXES; a++) {
+        TEST_ASSERT_EQUAL_INT16(input[a], output[a]);
+    }
+}
+
+void test_rejects_out_of_range_factor() {
+    PolyphaseDecimator decimator;
+    TEST_ASSERT_FALSE(decimator.begin(0));
+    TEST_ASSERT_FALSE(decimator.begin(DECIMATOR_MAX_FACTOR + 1));
+}
+
+void test_emits_one_output_per_factor_inputs() {
+    PolyphaseDecimator decimator;
+    decimator.begin(4);
+
+    const int16_t input[DECIMATOR_AXES] = {0};
+    int16_t output[DECIMATOR_AXES];
+    int outputs = 0;
+    for (int n = 0; n < 400; n++) {
+        if (decimator.push(input, output)) outputs++;
+    }
+    TEST_ASSERT_EQUAL_INT(100, outputs);
+}
+
+void test_coefficients_are_symmetric_with_unity_dc_gain() {
+    PolyphaseDecimator decimator;
+    decimator.begin(4);
+
+    const int numTaps = decimator.getNumTaps();
+    int32_t sum = 0;
+    for (int n = 0; n < numTaps; n++) {
+        sum += decimator.getCoefficient(n);
+    }
+    TEST_ASSERT_EQUAL_INT32(32768, sum);
+
+    // Linear phase: symmetric except for the DC rounding fix on the center tap
+    for (int n = 0; n < numTaps / 2 - 1; n++) {
+        TEST_ASSERT_EQUAL_INT16(decimator.getCoefficient(n),
+                                decimator.getCoefficient(numTaps - 1 - n));
+    }
+}
+
+void test_dc_input_passes_exactly() {
+    PolyphaseDecimator decimator;
+    decimator.begin(4);
+
+    const int16_t input[DECIMATOR_AXES] = {8192, -8192, 100, 16, -1, 0};
+    int16_t output[DECIMATOR_AXES] = {0};
+    for (int n = 0; n < 200; n++) {
+        decimator.push(input, output);
+    }
+    for (int a = 0; a < DECIMATOR_AXES; a++) {
+        TEST_ASSERT_INT_WITHIN(1, input[a], output[a]);
+    }
+}
+
+void test_passband_tone_is_preserved() {
+    // 2 Hz gesture motion sampled at 100 Hz, decimated to 25 Hz
+    const float peak = decimatedSineAmplitude(4, 100.0f, 2.0f, 10000.0f);
+    TEST_ASSERT_FLOAT_WITHIN(500.0f, 10000.0f, peak);
+}
+
+void test_stopband_tone_is_attenuated() {
+    // 20 Hz shake would alias to 5 Hz at 25 Hz output; require > 40 dB rejection
+    const float peak4 = decimatedSineAmplitude(4, 100.0f, 20.0f, 10000.0f);
+    TEST_ASSERT_TRUE(peak4 < 100.0f);
+
+    // Same check at 200 Hz input (factor 8) with a 40 Hz shake
+    const float peak8 = decimatedSineAmplitude(8, 200.0f, 40.0f, 10000.0f);
+    TEST_ASSERT_TRUE(peak8 < 100.0f);
+}
+
+void test_full_scale_step_saturates_instead_of_wrapping() {
+    PolyphaseDecimator decimator;
+    decimator.begin(4);
+
+    int16_t input[DECIMATOR_AXES];
+    int16_t output[DECIMATOR_AXES] = {0};
+    for (int n = 0; n < 200; n++) {
+        const int16_t value = (n < 100) ? -32768 : 32767;
+        for (int a = 0; a < DECIMATOR_AXES; a++) input[a] = value;
+        if (decimator.push(input, output)) {
+            // Overshoot at the step must clamp, never flip sign
+            if (n >= 140) TEST_ASSERT_TRUE(output[0] > 30000);
+        }
+    }
+}
+
+void test_benchmark_per_sample_cost() {
+    PolyphaseDecimator decimator;
+    decimator.begin(4);
+
+    const int iterations = 200000;
+    int16_t input[DECIMATOR_AXES] = {0};
+    int16_t output[DECIMATOR_AXES] = {0};
+    int32_t checksum = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < iterations; n++) {
+        for (int a = 0; a < DECIMATOR_AXES; a++) input[a] = (int16_t)(n * (a + 1));
+        if (decimator.push(input, output)) checksum += output[0];
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const double nsPerSample =
+        (double)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() / iterations;
+
+    char message[96];
+    snprintf(message, sizeof(message), "decimator x4: %.1f ns per 6-axis input sample (checksum %ld)",
+             nsPerSample, (long)checksum);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(nsPerSample > 0.0);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_factor_one_is_passthrough);
+    RUN_TEST(test_rejects_out_of_range_factor);
+    RUN_TEST(test_emits_one_output_per_factor_inputs);
+    RUN_TEST(test_coefficients_are_symmetric_with_unity_dc_gain);
+    RUN_TEST(test_dc_input_passes_exactly);
+    RUN_TEST(test_passband_tone_is_preserved);
+    RUN_TEST(test_stopband_tone_is_attenuated);
+    RUN_TEST(test_full_scale_step_saturates_instead_of_wrapping);
+    RUN_TEST(test_benchmark_per_sample_cost);
+    return UNITY_END();
+}
@@ -0,0 +1,710 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "firmware_sim.h"
+#include "config.h"
+#include "crc8.h"
+#include "file_flash.h"
+#include "flash_storage.h"
+#include "model_format.h"
+#include "test_models.h"
+
+// Zero weights; the output bias makes "Wave" the (weak) winner for any
+// moving window, while still windows fall to the idle override.
+static SimpleNNModel testModel;
+
+static const char* const kLabels[] = {"Idle", "Wave", "Shake"};
+
+static void buildModel() {
+    buildTestModel(testModel, 3, 0, 0.0f, kLabels);
+    testModel.outputBias[1] = 0.5f;
+}
+
+void test_upload_then_infer() {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+    buildModel();
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t finishMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    // Give the loop time to drain samples the reader buffered during upload
+    const uint32_t inferMs = finishMs + 1000;
+    const uint8_t inference = MODE_INFERENCE;
+    sim.write(inferMs, MODE_CHAR_UUID, &inference, 1);
+    sim.read(inferMs + 100, DEVICE_INFO_UUID);
+    sim.end(inferMs + 60000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+    TEST_ASSERT_EQUAL_UINT32(0, sim.lostWrites());
+
+    // Upload ends with SUCCESS; device info reports the model
+    int lastStatus = -1;
+    int waves = 0;
+    int results = 0;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0) {
+            lastStatus = record.data[2];
+        } else if (strcmp(record.uuid, INFERENCE_CHAR_UUID) == 0) {
+            results++;
+            waves += record.data[0] == 1 ? 1 : 0;
+        } else if (record.isRead && strcmp(record.uuid, DEVICE_INFO_UUID) == 0) {
+            TEST_ASSERT_EQUAL_UINT8(1, record.data[20]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, lastStatus);
+
+    // 60 s at 25 Hz: first window after 100 samples, then one per stride
+    const int expected = (60 * DEFAULT_SAMPLE_RATE_HZ - WINDOW_SIZE) / WINDOW_STRIDE + 1;
+    TEST_ASSERT_INT_WITHIN(2, expected, results);
+    TEST_ASSERT_EQUAL_INT(results, waves);
+}
+
+void test_inference_timing_block() {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+    buildModel();
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t finishMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    const uint8_t config[CONFIG_CHAR_SIZE] = {25, 0, 100, 0, SENSOR_STREAM_LEGACY, 0,
+                                              CONFIG_INFERENCE_TIMING};
+    sim.write(finishMs + 500, CONFIG_CHAR_UUID, config, sizeof(config));
+    const uint32_t inferMs = finishMs + 1000;
+    const uint8_t inference = MODE_INFERENCE;
+    sim.write(inferMs, MODE_CHAR_UUID, &inference, 1);
+    sim.end(finishMs + 20000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+
+    int results = 0;
+    int previousSequence = -1;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        // The firmware keeps its mode from the previous test's connection
+        if (strcmp(record.uuid, INFERENCE_CHAR_UUID) != 0 || record.timeUs <= inferMs * 1000ULL) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT32(4 + INFERENCE_TIMING_SIZE, record.data.size());
+        TEST_ASSERT_TRUE((record.data[2] & INFERENCE_STATUS_TIMING) != 0);
+
+        // One result per stride, tagged with the sample that completed it
+        const int sequence = record.data[4] | (record.data[5] << 8);
+        if (previousSequence >= 0) {
+            TEST_ASSERT_EQUAL_INT(WINDOW_STRIDE, (uint16_t)(sequence - previousSequence));
+        }
+        previousSequence = sequence;
+
+        // Host reads are due every poll interval, so none waits much longer
+        uint32_t queuedUs;
+        memcpy(&queuedUs, &record.data[6], 4);
+        TEST_ASSERT_TRUE(queuedUs < 100000);
+        results++;
+    }
+    TEST_ASSERT_TRUE(results > 50);
+}
+
+// Primary head as testModel, plus a 2-class head whose bias alone picks
+// class 1 with softmax([0, 1])[1] = 73%
+void test_multi_head_packet_layout() {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+    buildModel();
+    static StoredModelData twoHeads;
+    memset(&twoHeads, 0, sizeof(twoHeads));
+    twoHeads.model = testModel;
+    twoHeads.extraHeads.magic = SIMPLE_NN_HEADS_MAGIC;
+    twoHeads.extraHeads.numExtraHeads = 1;
+    twoHeads.extraHeads.heads[0].numClasses = 2;
+    twoHeads.extraHeads.heads[0].outputBias[1] = 1.0f;
+    strcpy(twoHeads.extraHeads.heads[0].labels[0], "Soft");
+    strcpy(twoHeads.extraHeads.heads[0].labels[1], "Hard");
+    const uint32_t size = SIMPLE_NN_UPLOAD_SIZE(1);
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t finishMs = sim.upload(2000, (const uint8_t*)&twoHeads, size);
+    const uint32_t inferMs = finishMs + 1000;
+    const uint8_t inference = MODE_INFERENCE;
+    sim.write(inferMs, MODE_CHAR_UUID, &inference, 1);
+    const uint32_t timingMs = inferMs + 15000;
+    const uint8_t config[CONFIG_CHAR_SIZE] = {25, 0, 100, 0, SENSOR_STREAM_LEGACY, 0,
+                                              CONFIG_INFERENCE_TIMING};
+    sim.write(timingMs, CONFIG_CHAR_UUID, config, sizeof(config));
+    sim.end(timingMs + 10000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+
+    int plain = 0;
+    int timed = 0;
+    int previousSequence = -1;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, INFERENCE_CHAR_UUID) != 0 || record.timeUs <= inferMs * 1000ULL) {
+            continue;
+        }
+        // [primary 4 bytes][head 1: prediction, confidence][timing block]
+        TEST_ASSERT_EQUAL_UINT8(1, record.data[0]);
+        TEST_ASSERT_EQUAL_UINT8(1, record.data[4]);
+        TEST_ASSERT_EQUAL_UINT8(73, record.data[5]);
+        if (record.timeUs <= timingMs * 1000ULL) {
+            TEST_ASSERT_EQUAL_UINT32(6, record.data.size());
+            TEST_ASSERT_EQUAL_HEX8(INFERENCE_STATUS_MULTI_HEAD, record.data[2]);
+            plain++;
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT32(6 + INFERENCE_TIMING_SIZE, record.data.size());
+        TEST_ASSERT_EQUAL_HEX8(INFERENCE_STATUS_MULTI_HEAD | INFERENCE_STATUS_TIMING, record.data[2]);
+        const int sequence = record.data[6] | (record.data[7] << 8);
+        if (previousSequence >= 0) {
+            TEST_ASSERT_EQUAL_INT(WINDOW_STRIDE, (uint16_t)(sequence - previousSequence));
+        }
+        previousSequence = sequence;
+        uint32_t queuedUs;
+        memcpy(&queuedUs, &record.data[8], 4);
+        TEST_ASSERT_TRUE(queuedUs < 100000);
+        timed++;
+    }
+    TEST_ASSERT_TRUE(plain > 40);
+    TEST_ASSERT_TRUE(timed > 40);
+
+    // A heads block with the wrong magic is refused at FINISH
+    twoHeads.extraHeads.magic = SIMPLE_NN_MAGIC;
+    FirmwareSimulator bad;
+    bad.connect(0);
+    bad.upload(2000, (const uint8_t*)&twoHeads, size);
+    bad.end(30000);
+    TEST_ASSERT_TRUE(bad.run(10 * 60 * 1000));
+    int lastStatus = -1;
+    for (size_t i = 0; i < bad.records().size(); i++) {
+        if (strcmp(bad.records()[i].uuid, MODEL_STATUS_UUID) == 0) {
+            lastStatus = bad.records()[i].data[2];
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_ERROR_FORMAT, lastStatus);
+}
+
+void test_upload_overwrites_model_in_place() {
+    setenv("SEVERN_SYNTH_GESTURE", "idle", 1);
+    buildModel();
+    SimpleNNModel badModel = testModel;
+    badModel.magic = 0;
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    uint32_t timeMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+
+    // A START with an impossible size is rejected before anything is
+    // overwritten, so the model survives
+    const uint8_t badStart[10] = {0x01, 0x04, 0, 0, 0, 0, 0, 0, 0, 3};
+    sim.write(timeMs + 500, MODEL_UPLOAD_UUID, badStart, sizeof(badStart));
+    sim.read(timeMs + 600, DEVICE_INFO_UUID);
+
+    // A payload that fails validation has already replaced the old model
+    timeMs = sim.upload(timeMs + 1000, (const uint8_t*)&badModel, sizeof(badModel));
+    sim.read(timeMs + 500, DEVICE_INFO_UUID);
+
+    timeMs = sim.upload(timeMs + 1000, (const uint8_t*)&testModel, sizeof(testModel));
+    sim.read(timeMs + 500, DEVICE_INFO_UUID);
+    sim.end(timeMs + 1000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+
+    std::vector<uint8_t> hasModel;
+    std::vector<uint8_t> statuses;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (record.isRead && strcmp(record.uuid, DEVICE_INFO_UUID) == 0) {
+            hasModel.push_back(record.data[20]);
+        } else if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0 && record.data[2] >= STATUS_SUCCESS) {
+            statuses.push_back(record.data[2]);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(3, hasModel.size());
+    TEST_ASSERT_EQUAL_UINT8(1, hasModel[0]);
+    TEST_ASSERT_EQUAL_UINT8(0, hasModel[1]);
+    TEST_ASSERT_EQUAL_UINT8(1, hasModel[2]);
+    TEST_ASSERT_EQUAL_UINT32(4, statuses.size());
+    TEST_ASSERT_EQUAL_UINT8(STATUS_SUCCESS, statuses[0]);
+    TEST_ASSERT_EQUAL_UINT8(STATUS_ERROR_SIZE, statuses[1]);
+    TEST_ASSERT_EQUAL_UINT8(STATUS_ERROR_FORMAT, statuses[2]);
+    TEST_ASSERT_EQUAL_UINT8(STATUS_SUCCESS, statuses[3]);
+}
+
+// Virtual µs from START to the SUCCESS notification (0 if none)
+static uint64_t uploadDurationUs(const FirmwareSimulator& sim, uint32_t startMs) {
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (!record.isRead && strcmp(record.uuid, MODEL_STATUS_UUID) == 0 &&
+            record.data[2] == STATUS_SUCCESS && record.timeUs >= (uint64_t)startMs * 1000) {
+            return record.timeUs - (uint64_t)startMs * 1000;
+        }
+    }
+    return 0;
+}
+
+void test_credit_upload_throughput() {
+    setenv("SEVERN_SYNTH_GESTURE", "idle", 1);
+    buildModel();
+
+    // Paced: one write every SIM_UPLOAD_INTERVAL_MS, like acknowledged writes
+    FirmwareSimulator paced;
+    paced.connect(0);
+    const uint32_t finishMs = paced.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    paced.end(finishMs + 5000);
+    TEST_ASSERT_TRUE(paced.run(10 * 60 * 1000));
+    const uint64_t pacedUs = uploadDurationUs(paced, 2000);
+
+    // Credits: as many writes in flight as the status trailer allows
+    FirmwareSimulator credited;
+    credited.connect(0);
+    credited.creditUpload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    credited.end(2000 + 30000);
+    TEST_ASSERT_TRUE(credited.run(10 * 60 * 1000));
+    const uint64_t creditUs = uploadDurationUs(credited, 2000);
+
+    TEST_ASSERT_TRUE(pacedUs > 0);
+    TEST_ASSERT_TRUE(creditUs > 0);
+    TEST_ASSERT_EQUAL_UINT32(0, paced.lostWrites());
+    TEST_ASSERT_EQUAL_UINT32(0, credited.lostWrites());
+    TEST_ASSERT_TRUE(credited.maxWritesInFlight() > 1);
+    TEST_ASSERT_TRUE(credited.maxWritesInFlight() <= MODEL_UPLOAD_CREDITS);
+
+    char message[128];
+    snprintf(message, sizeof(message), "paced %.2f s (%.1f KB/s), credits %.2f s (%.1f KB/s), max in flight %u",
+             pacedUs / 1e6, sizeof(testModel) / 1024.0 / (pacedUs / 1e6),
+             creditUs / 1e6, sizeof(testModel) / 1024.0 / (creditUs / 1e6),
+             (unsigned)credited.maxWritesInFlight());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(creditUs * 2 < pacedUs);
+}
+
+void test_delta_reupload_time() {
+    setenv("SEVERN_SYNTH_GESTURE", "idle", 1);
+    buildModel();
+    StoredModelData base;
+    memset(&base, 0, sizeof(base));
+    base.model = testModel;
+
+    // Retrained output layer: only those weights go over the air
+    StoredModelData retrained = base;
+    for (uint32_t i = 0; i < 3 * NN_HIDDEN_SIZE; i++) {
+        retrained.model.outputWeights[i] = 0.01f * (float)(i % 7);
+    }
+    retrained.model.outputBias[2] = 0.25f;
+    static uint8_t deltaPayload[sizeof(StoredModelData)];
+    const uint32_t deltaSize = encodeModelDelta(base, sizeof(SimpleNNModel), retrained,
+                                                sizeof(SimpleNNModel), deltaPayload,
+                                                sizeof(deltaPayload));
+    TEST_ASSERT_TRUE(deltaSize > 0);
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t fullMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    const uint32_t deltaStartMs = fullMs + 1000;
+    const uint32_t deltaMs = sim.upload(deltaStartMs, deltaPayload, deltaSize);
+    sim.end(deltaMs + 2000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+
+    const uint64_t fullUs = uploadDurationUs(sim, 2000);
+    const uint64_t deltaUs = uploadDurationUs(sim, deltaStartMs);
+    TEST_ASSERT_TRUE(fullUs > 0);
+    TEST_ASSERT_TRUE(deltaUs > 0);
+
+    char message[96];
+    snprintf(message, sizeof(message), "full %u bytes %.2f s, delta %u bytes %.2f s",
+             (unsigned)sizeof(testModel), fullUs / 1e6, (unsigned)deltaSize, deltaUs / 1e6);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(deltaUs < 1000000);
+}
+
+void test_refused_upload_keeps_model_running() {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+    buildModel();
+
+    // A delta made against a model this board never had, and a START whose
+    // label runs off the end of the write
+    StoredModelData other;
+    memset(&other, 0, sizeof(other));
+    other.model = testModel;
+    other.model.outputBias[0] = 0.125f;
+    StoredModelData retrained = other;
+    retrained.model.outputBias[2] = 0.75f;
+    static uint8_t deltaPayload[sizeof(StoredModelData)];
+    const uint32_t deltaSize = encodeModelDelta(other, sizeof(SimpleNNModel), retrained,
+                                                sizeof(SimpleNNModel), deltaPayload,
+                                                sizeof(deltaPayload));
+    TEST_ASSERT_TRUE(deltaSize > 0);
+    const uint8_t badLabel[12] = {0x01, 0x30, 0x31, 0x01, 0x00, 0, 0, 0, 0, 1, 'A', 'B'};
+
+    // No flash: nothing could serve the model during an upload, so these go
+    // in while collecting (inference would refuse them at START)
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t finishMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    const uint32_t deltaStartMs = finishMs + 1000;
+    const uint32_t deltaMs = sim.upload(deltaStartMs, deltaPayload, deltaSize);
+    sim.write(deltaMs + 1000, MODEL_UPLOAD_UUID, badLabel, sizeof(badLabel));
+    const uint32_t inferMs = deltaMs + 2000;
+    const uint8_t inference = MODE_INFERENCE;
+    sim.write(inferMs, MODE_CHAR_UUID, &inference, 1);
+    sim.end(inferMs + 10000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+
+    bool refused = false;
+    int badStarts = 0;
+    int results = 0;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0 && record.timeUs > deltaStartMs * 1000ULL) {
+            refused = refused || record.data[2] == STATUS_ERROR_BASE;
+            badStarts += record.timeUs >= (deltaMs + 1000) * 1000ULL &&
+                         record.data[2] == STATUS_ERROR_FORMAT;
+        } else if (strcmp(record.uuid, INFERENCE_CHAR_UUID) == 0) {
+            // The first model is still the one running: every window is a "Wave"
+            TEST_ASSERT_EQUAL_UINT8(0, record.data[2] & INFERENCE_STATUS_NO_MODEL);
+            TEST_ASSERT_EQUAL_UINT8(1, record.data[0]);
+            results++;
+        }
+    }
+    TEST_ASSERT_TRUE(refused);
+    TEST_ASSERT_EQUAL_INT(1, badStarts);
+    // First window after WINDOW_SIZE samples, then one per stride
+    const int samples = 10 * DEFAULT_SAMPLE_RATE_HZ;
+    TEST_ASSERT_INT_WITHIN(2, (samples - WINDOW_SIZE) / WINDOW_STRIDE + 1, results);
+}
+
+void test_collect_mode_streams_valid_packets() {
+    setenv("SEVERN_SYNTH_GESTURE", "idle", 1);
+
+    FirmwareSimulator sim;
+    const uint8_t collect = MODE_COLLECT;
+    sim.connect(0);
+    sim.write(1500, MODE_CHAR_UUID, &collect, 1);
+    sim.end(1500 + 10000);
+    TEST_ASSERT_TRUE(sim.run(60000));
+
+    int packets = 0;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, SENSOR_CHAR_UUID) != 0 || record.timeUs < 1600000) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT32(SENSOR_PACKET_SIZE, record.data.size());
+        TEST_ASSERT_EQUAL_UINT8(crc8(record.data.data(), 16), record.data[16]);
+        packets++;
+    }
+    TEST_ASSERT_INT_WITHIN(2, 10 * STREAM_SAMPLE_RATE_HZ, packets);
+}
+
+// Collect mode in a batched format with the largest batches the host can
+// ask for: batches go out by age, not once full
+static void checkBatchLatency(uint8_t format) {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+
+    FirmwareSimulator sim;
+    const uint8_t collect = MODE_COLLECT;
+    const uint8_t config[CONFIG_CHAR_SIZE] = {0, 0, 0, 0, format, 0, 0};
+    sim.connect(0);
+    sim.write(1500, MODE_CHAR_UUID, &collect, 1);
+    sim.write(1500, CONFIG_CHAR_UUID, config, sizeof(config));
+    sim.end(1500 + 10000);
+    TEST_ASSERT_TRUE(sim.run(60000));
+
+    const uint32_t intervalMs = 1000 / STREAM_SAMPLE_RATE_HZ;
+    const int maxSamples = SENSOR_BATCH_MAX_AGE_MS / intervalMs + 1;
+    int samples = 0;
+    uint64_t lastUs = 0;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, SENSOR_CHAR_UUID) != 0 || record.timeUs < 1600000) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT8(format, record.data[0]);
+        TEST_ASSERT_LESS_OR_EQUAL(maxSamples, record.data[1]);
+        if (lastUs != 0) {
+            TEST_ASSERT_LESS_OR_EQUAL((SENSOR_BATCH_MAX_AGE_MS + intervalMs) * 1000,
+                                      (uint32_t)(record.timeUs - lastUs));
+        }
+        lastUs = record.timeUs;
+        samples += record.data[1];
+    }
+    TEST_ASSERT_INT_WITHIN(maxSamples + 2, 10 * STREAM_SAMPLE_RATE_HZ, samples);
+}
+
+void test_batched_stream_latency_is_bounded() {
+    checkBatchLatency(SENSOR_STREAM_BATCHED);
+}
+
+void test_compressed_stream_latency_is_bounded() {
+    checkBatchLatency(SENSOR_STREAM_COMPRESSED);
+}
+
+void test_collect_mode_streams_during_upload() {
+    setenv("SEVERN_SYNTH_GESTURE", "idle", 1);
+    buildModel();
+
+    FirmwareSimulator sim;
+    const uint8_t collect = MODE_COLLECT;
+    sim.connect(0);
+    sim.write(1500, MODE_CHAR_UUID, &collect, 1);
+    const uint32_t finishMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    sim.read(finishMs + 500, DEVICE_INFO_UUID);
+    sim.end(finishMs + 1000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+    TEST_ASSERT_EQUAL_UINT32(0, sim.lostWrites());
+
+    // Writes are queued, so the loop keeps sampling while chunks arrive
+    int packets = 0;
+    int lastStatus = -1;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0) {
+            lastStatus = record.data[2];
+        } else if (strcmp(record.uuid, SENSOR_CHAR_UUID) == 0 && record.timeUs >= 2100000 &&
+                   record.timeUs < finishMs * 1000ULL) {
+            packets++;
+        } else if (record.isRead && strcmp(record.uuid, DEVICE_INFO_UUID) == 0) {
+            TEST_ASSERT_EQUAL_UINT32(DEVICE_INFO_SIZE, record.data.size());
+            TEST_ASSERT_TRUE(record.data[44] >= 1);
+            TEST_ASSERT_EQUAL_UINT8(BLE_WRITE_QUEUE_DEPTH, record.data[45]);
+            TEST_ASSERT_EQUAL_UINT8(0, record.data[46]);
+            TEST_ASSERT_EQUAL_UINT8(0, record.data[47]);
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, lastStatus);
+    const int expected = (int)((finishMs - 2100) * STREAM_SAMPLE_RATE_HZ / 1000);
+    TEST_ASSERT_INT_WITHIN(expected / 20 + 2, expected, packets);
+}
+
+void test_inference_continues_during_upload() {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+    buildModel();
+    SimpleNNModel shakeModel = testModel;
+    shakeModel.outputBias[1] = 0.0f;
+    shakeModel.outputBias[2] = 0.5f;
+
+    // Persistence on, so the first model is saved and can be served from
+    // flash while the second streams over RAM
+    char flashPath[64];
+    snprintf(flashPath, sizeof(flashPath), "/tmp/severn_sim_flash_%d.bin", (int)getpid());
+    remove(flashPath);
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+    setModelFlashRegion(&flash);
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t firstMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    const uint8_t inference = MODE_INFERENCE;
+    sim.write(firstMs + 1000, MODE_CHAR_UUID, &inference, 1);
+    const uint32_t secondStartMs = firstMs + 25000;
+    const uint32_t secondMs = sim.upload(secondStartMs, (const uint8_t*)&shakeModel, sizeof(shakeModel));
+    sim.end(secondMs + 5000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+    setModelFlashRegion(nullptr);
+    remove(flashPath);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.lostWrites());
+
+    // Every result is a prediction: "Wave" up to the second FINISH, then
+    // "Shake" from the next window on
+    int during = 0;
+    int after = 0;
+    uint64_t savingUs = 0;
+    uint64_t savedUs = 0;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0 && record.timeUs >= secondMs * 1000ULL) {
+            if (record.data[2] == STATUS_SAVING) {
+                savingUs = record.timeUs;
+            } else if (record.data[2] == STATUS_SUCCESS) {
+                savedUs = record.timeUs;
+            }
+        }
+        if (strcmp(record.uuid, INFERENCE_CHAR_UUID) != 0 || record.timeUs < (firstMs + 1000) * 1000ULL) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT8(0, record.data[2] & INFERENCE_STATUS_NO_MODEL);
+        if (record.timeUs > secondStartMs * 1000ULL && record.timeUs <= secondMs * 1000ULL) {
+            TEST_ASSERT_EQUAL_UINT8(1, record.data[0]);
+            during++;
+        } else if (record.timeUs > (secondMs + 500) * 1000ULL) {
+            TEST_ASSERT_EQUAL_UINT8(2, record.data[0]);
+            after++;
+        }
+    }
+    const int expected = (int)((secondMs - secondStartMs) * DEFAULT_SAMPLE_RATE_HZ / 1000 / WINDOW_STRIDE);
+    TEST_ASSERT_INT_WITHIN(2, expected, during);
+    TEST_ASSERT_TRUE(after > 10);
+
+    // The save after FINISH ran one page per loop pass (1 ms apart here)
+    TEST_ASSERT_TRUE(savingUs > 0);
+    TEST_ASSERT_TRUE(savedUs >= savingUs + 40000);
+}
+
+// The board's internal flash as far as the loop can tell: a page erase
+// stalls it for 85 ms and every word write for 41 µs. The first failErases
+// erases fail, like a save that went wrong.
+class StallingFlash : public FlashRegion {
+public:
+    StallingFlash(FileFlashRegion& flash, int failErases) : flash(flash), failErases(failErases) {}
+
+    uint32_t pageSize() const override { return flash.pageSize(); }
+    uint32_t size() const override { return flash.size(); }
+    const uint8_t* mapped() const override { return flash.mapped(); }
+
+    bool read(uint32_t offset, void* out, uint32_t length) override {
+        return flash.read(offset, out, length);
+    }
+    bool erasePage(uint32_t offset) override {
+        delay(85);
+        if (failErases > 0) {
+            failErases--;
+            return false;
+        }
+        return flash.erasePage(offset);
+    }
+    bool program(uint32_t offset, const void* data, uint32_t length) override {
+        delayMicroseconds(length / 4 * 41);
+        return flash.program(offset, data, length);
+    }
+
+private:
+    FileFlashRegion& flash;
+    int failErases;
+};
+
+void test_inference_continues_without_saved_copy() {
+    setenv("SEVERN_SYNTH_GESTURE", "wave", 1);
+    buildModel();
+    SimpleNNModel shakeModel = testModel;
+    shakeModel.outputBias[1] = 0.0f;
+    shakeModel.outputBias[2] = 0.5f;
+
+    // The first model's save fails: it runs, but no slot holds it
+    char flashPath[64];
+    snprintf(flashPath, sizeof(flashPath), "/tmp/severn_sim_flash_%d.bin", (int)getpid());
+    remove(flashPath);
+    FileFlashRegion file(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(file.open());
+    StallingFlash flash(file, 1);
+    setModelFlashRegion(&flash);
+
+    FirmwareSimulator sim;
+    sim.connect(0);
+    const uint32_t firstMs = sim.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    const uint8_t inference = MODE_INFERENCE;
+    sim.write(firstMs + 1000, MODE_CHAR_UUID, &inference, 1);
+    const uint32_t secondStartMs = firstMs + 20000;
+    sim.creditUpload(secondStartMs, (const uint8_t*)&shakeModel, sizeof(shakeModel));
+    sim.end(secondStartMs + 20000);
+    TEST_ASSERT_TRUE(sim.run(10 * 60 * 1000));
+    setModelFlashRegion(nullptr);
+    remove(flashPath);
+    TEST_ASSERT_EQUAL_UINT32(0, sim.lostWrites());
+    const uint64_t secondFinishUs = sim.creditFinishUs();
+    TEST_ASSERT_TRUE(secondFinishUs > secondStartMs * 1000ULL);
+
+    // START saves the running model first (~2.5 s of page erases and
+    // writes, with the first chunks held back), then serves it from there
+    std::vector<uint8_t> statuses;
+    int during = 0;
+    int after = 0;
+    for (size_t i = 0; i < sim.records().size(); i++) {
+        const SimRecord& record = sim.records()[i];
+        if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0) {
+            if (statuses.empty() || statuses.back() != record.data[2]) {
+                statuses.push_back(record.data[2]);
+            }
+            continue;
+        }
+        if (strcmp(record.uuid, INFERENCE_CHAR_UUID) != 0 || record.timeUs < (firstMs + 1000) * 1000ULL) {
+            continue;
+        }
+        TEST_ASSERT_EQUAL_UINT8(0, record.data[2] & INFERENCE_STATUS_NO_MODEL);
+        if (record.timeUs > secondStartMs * 1000ULL && record.timeUs <= secondFinishUs) {
+            TEST_ASSERT_EQUAL_UINT8(1, record.data[0]);
+            during++;
+        } else if (record.timeUs > secondFinishUs + 500000) {
+            TEST_ASSERT_EQUAL_UINT8(2, record.data[0]);
+            after++;
+        }
+    }
+    const uint8_t expected[] = {STATUS_RECEIVING, STATUS_VALIDATING, STATUS_SAVING, STATUS_ERROR_FLASH,
+                                STATUS_SAVING, STATUS_RECEIVING, STATUS_VALIDATING, STATUS_SAVING,
+                                STATUS_SUCCESS};
+    TEST_ASSERT_EQUAL_UINT32(sizeof(expected), statuses.size());
+    TEST_ASSERT_EQUAL_UINT8_ARRAY(expected, statuses.data(), sizeof(expected));
+    const int windows = (int)((secondFinishUs / 1000 - secondStartMs) * DEFAULT_SAMPLE_RATE_HZ / 1000 / WINDOW_STRIDE);
+    TEST_ASSERT_TRUE(windows >= 2);
+    TEST_ASSERT_INT_WITHIN(2, windows, during);
+    TEST_ASSERT_TRUE(after > 10);
+
+    // Without flash nothing could serve it, so START is refused while
+    // inference runs, and the model keeps predicting
+    FirmwareSimulator bare;
+    bare.connect(0);
+    const uint32_t bareMs = bare.upload(2000, (const uint8_t*)&testModel, sizeof(testModel));
+    bare.write(bareMs + 1000, MODE_CHAR_UUID, &inference, 1);
+    bare.upload(bareMs + 6000, (const uint8_t*)&shakeModel, sizeof(shakeModel));
+    bare.end(bareMs + 20000);
+    TEST_ASSERT_TRUE(bare.run(10 * 60 * 1000));
+    bool inUse = false;
+    int results = 0;
+    for (size_t i = 0; i < bare.records().size(); i++) {
+        const SimRecord& record = bare.records()[i];
+        if (strcmp(record.uuid, MODEL_STATUS_UUID) == 0 && record.timeUs >= (bareMs + 6000) * 1000ULL) {
+            inUse = inUse || record.data[2] == STATUS_ERROR_IN_USE;
+            TEST_ASSERT_TRUE(record.data[2] != STATUS_SUCCESS);
+        } else if (strcmp(record.uuid, INFERENCE_CHAR_UUID) == 0) {
+            TEST_ASSERT_EQUAL_UINT8(0, record.data[2] & INFERENCE_STATUS_NO_MODEL);
+            TEST_ASSERT_EQUAL_UINT8(1, record.data[0]);
+            results++;
+        }
+    }
+    TEST_ASSERT_TRUE(inUse);
+    TEST_ASSERT_TRUE(results > 30);
+}
+
+void test_script_file_parsing() {
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/severn_sim_%d.txt", (int)getpid());
+    FILE* file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "# comment\n\n0 connect\n1500 write mode 01\n1600 read config\n2000 end\n");
+    fclose(file);
+
+    FirmwareSimulator sim;
+    std::string error;
+    TEST_ASSERT_TRUE(sim.loadScript(path, &error));
+    TEST_ASSERT_TRUE(sim.run(10000));
+    TEST_ASSERT_TRUE(sim.elapsedUs() <= 2100000);
+
+    file = fopen(path, "w");
+    fprintf(file, "0 connect\n100 write gyro 01\n");
+    fclose(file);
+    FirmwareSimulator bad;
+    TEST_ASSERT_FALSE(bad.loadScript(path, &error));
+    TEST_ASSERT_TRUE(error.find(":2:") != std::string::npos);
+    remove(path);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    Serial.setOutput(nullptr);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_upload_then_infer);
+    RUN_TEST(test_inference_timing_block);
+    RUN_TEST(test_multi_head_packet_layout);
+    RUN_TEST(test_upload_overwrites_model_in_place);
+    RUN_TEST(test_credit_upload_throughput);
+    RUN_TEST(test_delta_reupload_time);
+    RUN_TEST(test_refused_upload_keeps_model_running);
+    RUN_TEST(test_collect_mode_streams_valid_packets);
+    RUN_TEST(test_batched_stream_latency_is_bounded);
+    RUN_TEST(test_compressed_stream_latency_is_bounded);
+    RUN_TEST(test_collect_mode_streams_during_upload);
+    RUN_TEST(test_inference_continues_during_upload);
+    RUN_TEST(test_inference_continues_without_saved_copy);
+    RUN_TEST(test_script_file_parsing);
+    return UNITY_END();
+}
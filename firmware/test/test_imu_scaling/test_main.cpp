@@ -0,0 +1,84 @@
+#include <unity.h>
+#include "imu_scaling.h"
+
+// Golden vectors: raw ±2000 dps register value → packet gyro value
+// (raw * 2000/32768 dps * 16.4, truncated toward zero, clamped to int16)
+static const int16_t GYRO_GOLDEN[][2] = {
+    {0, 0},
+    {1, 1},
+    {-1, -1},
+    {1000, 1000},        // 1000.98 → 1000
+    {1023, 1023},        // 1023.999 → 1023
+    {1024, 1025},
+    {-1024, -1025},
+    {-2047, -2048},      // -2048.999 → -2048
+    {16384, 16400},      // 1000 dps
+    {-16384, -16400},
+    {32735, 32766},
+    {32736, 32767},
+    {32767, 32767},      // 32798.99 clamps
+    {-32768, -32768},    // -32800 clamps
+};
+
+void test_gyro_golden_vectors() {
+    const int count = sizeof(GYRO_GOLDEN) / sizeof(GYRO_GOLDEN[0]);
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_INT16(GYRO_GOLDEN[i][1], scaleRawGyro(GYRO_GOLDEN[i][0]));
+    }
+}
+
+void test_accel_is_identity_at_4g() {
+    const int16_t raw[] = {0, 1, -1, 8192, -8192, 12345, 32767, -32768};
+    for (unsigned i = 0; i < sizeof(raw) / sizeof(raw[0]); i++) {
+        TEST_ASSERT_EQUAL_INT16(raw[i], scaleRawAccel(raw[i]));
+    }
+}
+
+// The integer path must agree with the old library float → scaleGyro()
+// round trip for every raw value (float rounding may differ by one count
+// where the exact result is a whole number).
+void test_matches_float_path_exhaustively() {
+    int mismatches = 0;
+    for (int32_t raw = -32768; raw <= 32767; raw++) {
+        const float dps = (float)raw * 2000.0f / 32768.0f;
+        float scaled = dps * GYRO_SCALE;
+        if (scaled > 32767.0f) scaled = 32767.0f;
+        if (scaled < -32768.0f) scaled = -32768.0f;
+        const int16_t viaFloat = (int16_t)scaled;
+        const int16_t viaInt = scaleRawGyro((int16_t)raw);
+        TEST_ASSERT_INT_WITHIN(1, viaFloat, viaInt);
+        if (viaFloat != viaInt) mismatches++;
+
+        const float g = (float)raw * 4.0f / 32768.0f;
+        TEST_ASSERT_EQUAL_INT16((int16_t)(g * ACCEL_SCALE), scaleRawAccel((int16_t)raw));
+    }
+    TEST_ASSERT_TRUE(mismatches < 64);
+}
+
+void test_burst_bytes_to_packet_axes() {
+    // Little-endian register bytes as read from either chip
+    const uint8_t accBytes[6] = {0x00, 0x20, 0x00, 0xE0, 0x39, 0x30};  // 8192, -8192, 12345
+    const uint8_t gyrBytes[6] = {0x00, 0x04, 0x00, 0xFC, 0xFF, 0x7F};  // 1024, -1024, 32767
+
+    int16_t acc[3], gyr[3], out[6];
+    for (int axis = 0; axis < 3; axis++) {
+        acc[axis] = readImuInt16LE(&accBytes[axis * 2]);
+        gyr[axis] = readImuInt16LE(&gyrBytes[axis * 2]);
+    }
+    scaleRawImu(acc, gyr, out);
+
+    const int16_t expected[6] = {8192, -8192, 12345, 1025, -1025, 32767};
+    TEST_ASSERT_EQUAL_INT16_ARRAY(expected, out, 6);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_gyro_golden_vectors);
+    RUN_TEST(test_accel_is_identity_at_4g);
+    RUN_TEST(test_matches_float_path_exhaustively);
+    RUN_TEST(test_burst_bytes_to_packet_axes);
+    return UNITY_END();
+}
@@ -32,6 +32,34 @@ void test_motion_score_dynamic_window_is_above_threshold() {
     TEST_ASSERT_TRUE(motion > MOTION_STILL_THRESHOLD);
 }
 
+void test_idle_label_match_ignores_case() {
+    TEST_ASSERT_TRUE(isIdleLabel("Idle"));
+    TEST_ASSERT_TRUE(isIdleLabel("IDLE"));
+    TEST_ASSERT_FALSE(isIdleLabel("Idler"));
+    TEST_ASSERT_FALSE(isIdleLabel("Idl"));
+}
+
+void test_idle_override_only_replaces_weak_predictions() {
+    const float still = MOTION_STILL_THRESHOLD * 0.5f;
+
+    float confidence = 0.55f;
+    TEST_ASSERT_EQUAL_INT(0, applyIdleOverride(2, &confidence, 0, still));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.86f, confidence);
+
+    confidence = 0.75f;
+    TEST_ASSERT_EQUAL_INT(2, applyIdleOverride(2, &confidence, 0, still));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.75f, confidence);
+
+    confidence = 0.40f;  // Idle already: confidence raised to the still level
+    TEST_ASSERT_EQUAL_INT(0, applyIdleOverride(0, &confidence, 0, 0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.92f, confidence);
+
+    confidence = 0.30f;  // Moving, or no Idle class: untouched
+    TEST_ASSERT_EQUAL_INT(2, applyIdleOverride(2, &confidence, 0, MOTION_STILL_THRESHOLD));
+    TEST_ASSERT_EQUAL_INT(2, applyIdleOverride(2, &confidence, -1, 0.0f));
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, 0.30f, confidence);
+}
+
 int main(int argc, char** argv) {
     (void)argc;
     (void)argv;
@@ -40,5 +68,7 @@ int main(int argc, char** argv) {
     RUN_TEST(test_normalization_pipeline_matches_constants);
     RUN_TEST(test_motion_score_static_window_is_below_threshold);
     RUN_TEST(test_motion_score_dynamic_window_is_above_threshold);
+    RUN_TEST(test_idle_label_match_ignores_case);
+    RUN_TEST(test_idle_override_only_replaces_weak_predictions);
     return UNITY_END();
 }
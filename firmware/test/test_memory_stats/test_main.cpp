@@ -0,0 +1,44 @@
+#include <unity.h>
+#include <string.h>
+#include "memory_stats.h"
+
+void test_untouched_stack_is_all_unused() {
+    uint32_t stack[64];
+    paintStackRegion(stack, stack + 64);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(stack), unusedStackBytes(stack, stack + 64));
+}
+
+void test_high_water_is_the_deepest_write() {
+    uint32_t stack[64];
+    paintStackRegion(stack, stack + 64);
+
+    // A stack growing down from the top, reaching word 40 at its deepest...
+    for (int i = 63; i >= 40; i--) {
+        stack[i] = (uint32_t)i;
+    }
+    // ...then unwinding: the paint stays broken, so the peak is remembered
+    stack[50] = STACK_PAINT_WORD;
+
+    TEST_ASSERT_EQUAL_UINT32(40 * sizeof(uint32_t), unusedStackBytes(stack, stack + 64));
+}
+
+void test_native_memory_stats_report_unmeasured() {
+    beginMemoryStats();
+    updateMemoryStats();
+    const MemoryStats& stats = getMemoryStats();
+    TEST_ASSERT_EQUAL_UINT32(0, stats.stackSize);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.heapFreeBytes);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.heapMinFreeBytes);
+    TEST_ASSERT_FALSE(stats.heapLow);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_untouched_stack_is_all_unused);
+    RUN_TEST(test_high_water_is_the_deepest_write);
+    RUN_TEST(test_native_memory_stats_report_unmeasured);
+    return UNITY_END();
+}
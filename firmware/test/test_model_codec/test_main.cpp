@@ -0,0 +1,169 @@
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "crc32.h"
+#include "flash_storage.h"
+#include "model_codec.h"
+#include "test_models.h"
+
+static StoredModelData source;
+static StoredModelData decoded;
+
+// Weights spread like a trained model, so packing ratios are realistic
+static uint32_t buildModel(uint32_t numClasses, unsigned seed) {
+    return buildTestModel(source, numClasses, 0, seed, TEST_MODEL_GLOROT_LIMIT);
+}
+
+static std::vector<uint8_t> compactPayload(uint32_t storedSize) {
+    std::vector<uint8_t> payload(sizeof(StoredModelData));
+    payload.resize(encodeCompactModel(source, storedSize, payload.data(), (uint32_t)payload.size()));
+    return payload;
+}
+
+static std::vector<uint8_t> pack(const std::vector<uint8_t>& payload) {
+    std::vector<uint8_t> packed(payload.size() + 64);
+    packed.resize(packModelPayload(payload.data(), (uint32_t)payload.size(),
+                                   packed.data(), (uint32_t)packed.size()));
+    return packed;
+}
+
+static bool decodeAll(ModelUploadDecoder& decoder, const std::vector<uint8_t>& upload,
+                      uint32_t chunkSize) {
+    memset(&decoded, 0, sizeof(decoded));
+    decoder.begin(&decoded);
+    for (uint32_t offset = 0; offset < upload.size(); offset += chunkSize) {
+        const uint32_t remaining = (uint32_t)upload.size() - offset;
+        if (!decoder.write(&upload[offset], remaining < chunkSize ? remaining : chunkSize)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void test_packed_compact_payload_round_trips() {
+    const uint32_t storedSize = buildModel(3, 1);
+    const std::vector<uint8_t> payload = compactPayload(storedSize);
+    const std::vector<uint8_t> packed = pack(payload);
+    TEST_ASSERT_TRUE(packed.size() > 0);
+
+    // Every chunking has to resume the coder mid-byte somewhere
+    const uint32_t chunkSizes[] = {1, 7, 239, 4096};
+    for (uint32_t i = 0; i < 4; i++) {
+        ModelUploadDecoder decoder;
+        TEST_ASSERT_TRUE(decodeAll(decoder, packed, chunkSizes[i]));
+        TEST_ASSERT_TRUE(decoder.isPacked());
+        TEST_ASSERT_TRUE(decoder.isComplete());
+        TEST_ASSERT_EQUAL_UINT32(payload.size(), decoder.getPayloadSize());
+        TEST_ASSERT_EQUAL_MEMORY(&source, &decoded, storedSize);
+    }
+
+    // Mantissas are noise: about 1.2x is all lossless coding can get
+    char message[96];
+    snprintf(message, sizeof(message), "compact %u -> packed %u bytes (%.2fx)",
+             (unsigned)payload.size(), (unsigned)packed.size(),
+             (double)payload.size() / (double)packed.size());
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(packed.size() * 115 < payload.size() * 100);
+}
+
+void test_packed_full_payload_drops_the_padding() {
+    const uint32_t storedSize = buildModel(2, 2);
+    const std::vector<uint8_t> full((const uint8_t*)&source, (const uint8_t*)&source + storedSize);
+    const std::vector<uint8_t> packedFull = pack(full);
+    const std::vector<uint8_t> compact = compactPayload(storedSize);
+    const std::vector<uint8_t> packedCompact = pack(compact);
+
+    ModelUploadDecoder decoder;
+    TEST_ASSERT_TRUE(decodeAll(decoder, packedFull, 239));
+    TEST_ASSERT_TRUE(decoder.isComplete());
+    TEST_ASSERT_EQUAL_INT(MODEL_WIRE_FULL, decoder.getWireDecoder().getFormat());
+    TEST_ASSERT_EQUAL_MEMORY(&source, &decoded, storedSize);
+
+    // The zeros in the six unused class slots cost a fraction once packed
+    TEST_ASSERT_TRUE((packedFull.size() - packedCompact.size()) * 4 < full.size() - compact.size());
+}
+
+void test_plain_payload_passes_through() {
+    const uint32_t storedSize = buildModel(4, 3);
+    const std::vector<uint8_t> payload = compactPayload(storedSize);
+
+    ModelUploadDecoder decoder;
+    TEST_ASSERT_TRUE(decodeAll(decoder, payload, 3));
+    TEST_ASSERT_FALSE(decoder.isPacked());
+    TEST_ASSERT_TRUE(decoder.isComplete());
+    TEST_ASSERT_EQUAL_UINT32(payload.size(), decoder.getPayloadSize());
+    TEST_ASSERT_EQUAL_MEMORY(&source, &decoded, storedSize);
+}
+
+void test_malformed_packed_uploads_are_rejected() {
+    const uint32_t storedSize = buildModel(3, 4);
+    const std::vector<uint8_t> packed = pack(compactPayload(storedSize));
+    ModelUploadDecoder decoder;
+
+    // Unpacked size larger than any model
+    std::vector<uint8_t> upload = packed;
+    const uint32_t tooBig = sizeof(StoredModelData) + 1;
+    memcpy(&upload[4], &tooBig, sizeof(tooBig));
+    TEST_ASSERT_FALSE(decodeAll(decoder, upload, 239));
+
+    // Cut short: never complete
+    upload.assign(packed.begin(), packed.end() - 16);
+    TEST_ASSERT_TRUE(decodeAll(decoder, upload, 239));
+    TEST_ASSERT_FALSE(decoder.isComplete());
+
+    // More than the coder flush after the last byte
+    upload = packed;
+    upload.insert(upload.end(), MODEL_CODEC_MAX_TRAILING + 1, 0);
+    TEST_ASSERT_FALSE(decodeAll(decoder, upload, 239));
+
+    // A flipped bit decodes to a different payload: the CRC of the packed
+    // bytes is what catches it, but it must not run past the model buffer
+    upload = packed;
+    upload[upload.size() / 2] ^= 0x10;
+    decodeAll(decoder, upload, 239);
+    TEST_ASSERT_TRUE(decoder.getPayloadSize() <= sizeof(StoredModelData));
+}
+
+void test_packed_upload_through_flash_storage() {
+    const uint32_t storedSize = buildModel(3, 5);
+    const std::vector<uint8_t> packed = pack(compactPayload(storedSize));
+
+    initFlashStorage();
+    beginModelUpload((uint32_t)packed.size(), 3);
+    TEST_ASSERT_EQUAL_INT(UPLOAD_RECEIVING, getUploadState());
+    for (uint32_t offset = 0; offset < packed.size(); offset += 239) {
+        const uint32_t remaining = (uint32_t)packed.size() - offset;
+        TEST_ASSERT_TRUE(receiveModelChunk(&packed[offset], remaining < 239 ? remaining : 239, offset));
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS,
+                          finalizeModelUpload(calculateCrc32(packed.data(), (uint32_t)packed.size())));
+    TEST_ASSERT_TRUE(hasStoredModel());
+    TEST_ASSERT_EQUAL_UINT32(storedSize, getStoredModelSize());
+    TEST_ASSERT_EQUAL_MEMORY(&source.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+
+    // Even an all-zero model packs to more than the START size floor
+    memset(&source, 0, sizeof(source));
+    source.model.numClasses = 1;
+    source.model.inputSize = NN_INPUT_SIZE;
+    source.model.hiddenSize = NN_HIDDEN_SIZE;
+    strcpy(source.model.labels[0], "A");
+    const std::vector<uint8_t> zeros = pack(compactPayload(sizeof(SimpleNNModel)));
+    TEST_ASSERT_TRUE(zeros.size() >= MODEL_PACKED_MIN_SIZE);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_packed_compact_payload_round_trips);
+    RUN_TEST(test_packed_full_payload_drops_the_padding);
+    RUN_TEST(test_plain_payload_passes_through);
+    RUN_TEST(test_malformed_packed_uploads_are_rejected);
+    RUN_TEST(test_packed_upload_through_flash_storage);
+    return UNITY_END();
+}
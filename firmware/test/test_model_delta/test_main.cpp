@@ -0,0 +1,235 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "crc32.h"
+#include "flash_storage.h"
+#include "model_codec.h"
+#include "model_format.h"
+#include "test_models.h"
+
+static StoredModelData base;
+static StoredModelData result;
+static StoredModelData decoded;
+
+// "Train More" on the output layer only: every output weight moves
+static void retrainOutputLayer(StoredModelData& model) {
+    for (uint32_t i = 0; i < model.model.numClasses * NN_HIDDEN_SIZE; i++) {
+        model.model.outputWeights[i] *= 1.01f;
+    }
+    for (uint32_t c = 0; c < model.model.numClasses; c++) {
+        model.model.outputBias[c] += 0.01f;
+    }
+}
+
+static std::vector<uint8_t> delta(uint32_t baseSize, uint32_t resultSize) {
+    std::vector<uint8_t> payload(2 * sizeof(StoredModelData));
+    payload.resize(encodeModelDelta(base, baseSize, result, resultSize,
+                                    payload.data(), (uint32_t)payload.size()));
+    return payload;
+}
+
+static void installBase(uint32_t size) {
+    initFlashStorage();
+    beginModelUpload(size, base.model.numClasses);
+    for (uint32_t offset = 0; offset < size; offset += 239) {
+        const uint32_t remaining = size - offset;
+        receiveModelChunk((const uint8_t*)&base + offset, remaining < 239 ? remaining : 239, offset);
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS,
+                          finalizeModelUpload(calculateCrc32((const uint8_t*)&base, size)));
+}
+
+// Stops at the first chunk that fails the upload
+static bool sendUpload(const std::vector<uint8_t>& upload) {
+    beginModelUpload((uint32_t)upload.size(), 0);
+    for (uint32_t offset = 0; offset < upload.size(); offset += 239) {
+        const uint32_t remaining = (uint32_t)upload.size() - offset;
+        if (!receiveModelChunk(&upload[offset], remaining < 239 ? remaining : 239, offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static UploadStatus finish(const std::vector<uint8_t>& upload) {
+    return finalizeModelUpload(calculateCrc32(upload.data(), (uint32_t)upload.size()));
+}
+
+void test_delta_sends_only_changed_tensors() {
+    buildTestModel(base, 3, 0, 1);
+    result = base;
+    retrainOutputLayer(result);
+    installBase(sizeof(SimpleNNModel));
+
+    const std::vector<uint8_t> upload = delta(sizeof(SimpleNNModel), sizeof(SimpleNNModel));
+    TEST_ASSERT_TRUE(upload.size() > 0);
+    TEST_ASSERT_TRUE(sendUpload(upload));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish(upload));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(SimpleNNModel), getStoredModelSize());
+    TEST_ASSERT_EQUAL_MEMORY(&result.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+
+    // At most two patches: the used output weights and biases
+    const uint32_t expected = SIMPLE_NN_DELTA_HEADER_SIZE + 2 * SIMPLE_NN_PATCH_HEADER_SIZE +
+                              3 * (NN_HIDDEN_SIZE + 1) * sizeof(float);
+    TEST_ASSERT_TRUE(upload.size() <= expected);
+
+    char message[80];
+    snprintf(message, sizeof(message), "full %u -> delta %u bytes",
+             (unsigned)sizeof(SimpleNNModel), (unsigned)upload.size());
+    TEST_MESSAGE(message);
+
+    // Sending the same model again is just the header
+    base = result;
+    const std::vector<uint8_t> same = delta(sizeof(SimpleNNModel), sizeof(SimpleNNModel));
+    TEST_ASSERT_EQUAL_UINT32(SIMPLE_NN_DELTA_HEADER_SIZE, same.size());
+    TEST_ASSERT_TRUE(sendUpload(same));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish(same));
+    TEST_ASSERT_EQUAL_MEMORY(&result.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+}
+
+void test_delta_for_another_base_is_refused() {
+    buildTestModel(base, 3, 0, 2);
+    installBase(sizeof(SimpleNNModel));
+
+    // Made against a model the board never had
+    StoredModelData onBoard = base;
+    buildTestModel(base, 3, 0, 3);
+    result = base;
+    retrainOutputLayer(result);
+    const std::vector<uint8_t> upload = delta(sizeof(SimpleNNModel), sizeof(SimpleNNModel));
+    TEST_ASSERT_FALSE(sendUpload(upload));
+    TEST_ASSERT_EQUAL_INT(UPLOAD_ERROR, getUploadState());
+    TEST_ASSERT_EQUAL_INT(STATUS_ERROR_BASE, getUploadError());
+
+    // ...and the model on the board was never retired
+    TEST_ASSERT_TRUE(hasStoredModel());
+    TEST_ASSERT_EQUAL_MEMORY(&onBoard.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+    cancelModelUpload();
+    TEST_ASSERT_TRUE(hasStoredModel());
+
+    // A whole model retires it at its first chunk
+    beginModelUpload(sizeof(SimpleNNModel), 3);
+    TEST_ASSERT_TRUE(hasStoredModel());
+    TEST_ASSERT_TRUE(receiveModelChunk((const uint8_t*)&base, 239, 0));
+    TEST_ASSERT_FALSE(hasStoredModel());
+    cancelModelUpload();
+
+    // Nothing was patched: the buffer still holds the model on the board
+    ModelWireDecoder decoder;
+    decoded = onBoard;
+    decoder.begin(&decoded, sizeof(SimpleNNModel));
+    TEST_ASSERT_FALSE(decoder.write(upload.data(), (uint32_t)upload.size()));
+    TEST_ASSERT_TRUE(decoder.isBaseMismatch());
+    TEST_ASSERT_EQUAL_MEMORY(&onBoard, &decoded, sizeof(SimpleNNModel));
+
+    // Without any model there is nothing to patch
+    cancelModelUpload();
+    clearStoredModel();
+    TEST_ASSERT_FALSE(sendUpload(upload));
+    TEST_ASSERT_EQUAL_INT(STATUS_ERROR_BASE, getUploadError());
+    cancelModelUpload();
+}
+
+void test_patched_model_crc_is_checked() {
+    buildTestModel(base, 2, 0, 4);
+    result = base;
+    retrainOutputLayer(result);
+    installBase(sizeof(SimpleNNModel));
+
+    // Intact on the wire, but not the model the delta promises
+    std::vector<uint8_t> upload = delta(sizeof(SimpleNNModel), sizeof(SimpleNNModel));
+    upload[4 * sizeof(uint32_t)] ^= 0x01;
+    TEST_ASSERT_TRUE(sendUpload(upload));
+    TEST_ASSERT_EQUAL_INT(STATUS_ERROR_CRC, finish(upload));
+    TEST_ASSERT_FALSE(hasStoredModel());
+}
+
+void test_malformed_patches_are_rejected() {
+    buildTestModel(base, 2, 0, 5);
+    result = base;
+    retrainOutputLayer(result);
+    const std::vector<uint8_t> good = delta(sizeof(SimpleNNModel), sizeof(SimpleNNModel));
+    const uint32_t firstPatch = SIMPLE_NN_DELTA_HEADER_SIZE;
+
+    auto rejected = [&](const std::vector<uint8_t>& upload) {
+        ModelWireDecoder decoder;
+        decoded = base;
+        decoder.begin(&decoded, sizeof(SimpleNNModel));
+        const bool ok = decoder.write(upload.data(), (uint32_t)upload.size());
+        return !ok && !decoder.isBaseMismatch();
+    };
+    auto withWord = [&](uint32_t offset, uint32_t value) {
+        std::vector<uint8_t> upload = good;
+        memcpy(&upload[offset], &value, sizeof(value));
+        return upload;
+    };
+
+    // Unknown tensor, zero length, past the end of its tensor
+    TEST_ASSERT_TRUE(rejected(withWord(firstPatch, MODEL_TENSOR_COUNT)));
+    TEST_ASSERT_TRUE(rejected(withWord(firstPatch + 8, 0)));
+    TEST_ASSERT_TRUE(rejected(withWord(firstPatch + 4, sizeof(result.model.outputWeights) - 4)));
+    TEST_ASSERT_TRUE(rejected(withWord(firstPatch + 4, 0xFFFFFFF0)));
+
+    // Result smaller than a model, or larger than the buffer
+    TEST_ASSERT_TRUE(rejected(withWord(12, sizeof(SimpleNNModel) - 4)));
+    TEST_ASSERT_TRUE(rejected(withWord(12, sizeof(StoredModelData) + 4)));
+
+    // Bytes after the last patch
+    std::vector<uint8_t> upload = good;
+    upload.push_back(0);
+    TEST_ASSERT_TRUE(rejected(upload));
+}
+
+void test_packed_delta_adds_a_head() {
+    buildTestModel(base, 3, 0, 6);
+    result = base;
+    retrainOutputLayer(result);
+    result.extraHeads.magic = SIMPLE_NN_HEADS_MAGIC;
+    result.extraHeads.numExtraHeads = 1;
+    result.extraHeads.heads[0].numClasses = 2;
+    result.extraHeads.heads[0].outputWeights[0] = 0.5f;
+    strcpy(result.extraHeads.heads[0].labels[0], "Soft");
+    strcpy(result.extraHeads.heads[0].labels[1], "Hard");
+    const uint32_t resultSize = SIMPLE_NN_UPLOAD_SIZE(1);
+
+    // Stale bytes past the base must not survive into the new head
+    installBase(sizeof(SimpleNNModel));
+    const std::vector<uint8_t> payload = delta(sizeof(SimpleNNModel), resultSize);
+    std::vector<uint8_t> packed(payload.size() + 64);
+    packed.resize(packModelPayload(payload.data(), (uint32_t)payload.size(),
+                                   packed.data(), (uint32_t)packed.size()));
+    TEST_ASSERT_TRUE(packed.size() > 0);
+
+    TEST_ASSERT_TRUE(sendUpload(packed));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish(packed));
+    TEST_ASSERT_EQUAL_UINT32(resultSize, getStoredModelSize());
+    TEST_ASSERT_EQUAL_MEMORY(&result.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+    TEST_ASSERT_EQUAL_MEMORY(&result.extraHeads, getStoredExtraHeads(),
+                             resultSize - sizeof(SimpleNNModel));
+
+    // And back to a single head: the heads block is cleared
+    base = result;
+    buildTestModel(result, 3, 0, 6);
+    const std::vector<uint8_t> shrink = delta(resultSize, sizeof(SimpleNNModel));
+    TEST_ASSERT_TRUE(sendUpload(shrink));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish(shrink));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(SimpleNNModel), getStoredModelSize());
+    TEST_ASSERT_NULL(getStoredExtraHeads());
+    TEST_ASSERT_EQUAL_MEMORY(&result.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_delta_sends_only_changed_tensors);
+    RUN_TEST(test_delta_for_another_base_is_refused);
+    RUN_TEST(test_patched_model_crc_is_checked);
+    RUN_TEST(test_malformed_patches_are_rejected);
+    RUN_TEST(test_packed_delta_adds_a_head);
+    return UNITY_END();
+}
@@ -0,0 +1,167 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+#include "config.h"
+#include "crc32.h"
+#include "flash_storage.h"
+#include "model_format.h"
+#include "test_models.h"
+
+static StoredModelData source;
+static StoredModelData decoded;
+
+static std::vector<uint8_t> encode(uint32_t storedSize) {
+    std::vector<uint8_t> payload(sizeof(StoredModelData));
+    const uint32_t size = encodeCompactModel(source, storedSize, payload.data(), (uint32_t)payload.size());
+    payload.resize(size);
+    return payload;
+}
+
+// Feed the payload in uneven chunks, as BLE would
+static bool decodeAll(ModelWireDecoder& decoder, const std::vector<uint8_t>& payload) {
+    memset(&decoded, 0, sizeof(decoded));
+    decoder.begin(&decoded);
+    const uint32_t chunkSizes[] = {1, 3, 244, 17, 509};
+    uint32_t offset = 0;
+    for (uint32_t i = 0; offset < payload.size(); i++) {
+        uint32_t length = chunkSizes[i % 5];
+        if (length > payload.size() - offset) {
+            length = (uint32_t)payload.size() - offset;
+        }
+        if (!decoder.write(&payload[offset], length)) {
+            return false;
+        }
+        offset += length;
+    }
+    return true;
+}
+
+void test_compact_round_trip_matches_padded_layout() {
+    const uint32_t storedSize = buildTestModel(source, 3, 0, 1);
+    const std::vector<uint8_t> payload = encode(storedSize);
+
+    // Header + hidden layer + 3 of NN_MAX_CLASSES output rows + labels
+    const uint32_t expected = SIMPLE_NN_COMPACT_HEADER_SIZE +
+        sizeof(float) * (NN_HIDDEN_SIZE * NN_INPUT_SIZE + NN_HIDDEN_SIZE + 3 * NN_HIDDEN_SIZE + 3) +
+        3 * sizeof("Gesture0");
+    TEST_ASSERT_EQUAL_UINT32(expected, payload.size());
+    TEST_ASSERT_TRUE(payload.size() < sizeof(SimpleNNModel));
+
+    ModelWireDecoder decoder;
+    TEST_ASSERT_TRUE(decodeAll(decoder, payload));
+    TEST_ASSERT_EQUAL_INT(MODEL_WIRE_COMPACT, decoder.getFormat());
+    TEST_ASSERT_TRUE(decoder.isComplete());
+    TEST_ASSERT_EQUAL_UINT32(storedSize, decoder.getStoredSize());
+    TEST_ASSERT_EQUAL_MEMORY(&source, &decoded, storedSize);
+}
+
+void test_compact_round_trip_with_extra_heads() {
+    const uint32_t storedSize = buildTestModel(source, NN_MAX_CLASSES, NN_MAX_HEADS - 1, 2);
+    const std::vector<uint8_t> payload = encode(storedSize);
+    TEST_ASSERT_TRUE(payload.size() > 0);
+
+    ModelWireDecoder decoder;
+    TEST_ASSERT_TRUE(decodeAll(decoder, payload));
+    TEST_ASSERT_TRUE(decoder.isComplete());
+    TEST_ASSERT_EQUAL_UINT32(storedSize, decoder.getStoredSize());
+    TEST_ASSERT_EQUAL_MEMORY(&source, &decoded, storedSize);
+}
+
+void test_full_payload_passes_through() {
+    const uint32_t storedSize = buildTestModel(source, 2, 1, 3);
+    const std::vector<uint8_t> payload((const uint8_t*)&source, (const uint8_t*)&source + storedSize);
+
+    ModelWireDecoder decoder;
+    TEST_ASSERT_TRUE(decodeAll(decoder, payload));
+    TEST_ASSERT_EQUAL_INT(MODEL_WIRE_FULL, decoder.getFormat());
+    TEST_ASSERT_EQUAL_UINT32(storedSize, decoder.getStoredSize());
+    TEST_ASSERT_EQUAL_MEMORY(&source, &decoded, storedSize);
+}
+
+void test_malformed_compact_payloads_are_rejected() {
+    const uint32_t storedSize = buildTestModel(source, 3, 0, 4);
+    ModelWireDecoder decoder;
+
+    // Dimensions the firmware was not built for
+    std::vector<uint8_t> payload = encode(storedSize);
+    payload[8] = 0x10;  // inputSize
+    TEST_ASSERT_FALSE(decodeAll(decoder, payload));
+    TEST_ASSERT_FALSE(decoder.isComplete());
+
+    // Too many classes
+    payload = encode(storedSize);
+    payload[4] = NN_MAX_CLASSES + 1;
+    TEST_ASSERT_FALSE(decodeAll(decoder, payload));
+
+    // Bytes after the last label
+    payload = encode(storedSize);
+    payload.push_back('X');
+    TEST_ASSERT_FALSE(decodeAll(decoder, payload));
+
+    // Cut short in the labels: accepted so far, but not complete
+    payload = encode(storedSize);
+    payload.resize(payload.size() - 2);
+    TEST_ASSERT_TRUE(decodeAll(decoder, payload));
+    TEST_ASSERT_FALSE(decoder.isComplete());
+}
+
+void test_long_labels_are_truncated() {
+    const uint32_t storedSize = buildTestModel(source, 1, 0, 5);
+    std::vector<uint8_t> payload = encode(storedSize);
+    payload.resize(payload.size() - sizeof("Gesture0"));
+    const char longLabel[] = "AVeryLongGestureNameThatDoesNotFit";
+    payload.insert(payload.end(), longLabel, longLabel + sizeof(longLabel));
+
+    ModelWireDecoder decoder;
+    TEST_ASSERT_TRUE(decodeAll(decoder, payload));
+    TEST_ASSERT_TRUE(decoder.isComplete());
+    TEST_ASSERT_EQUAL_UINT32(LABEL_MAX_LEN - 1, strlen(decoded.model.labels[0]));
+    TEST_ASSERT_EQUAL_INT(0, strncmp(longLabel, decoded.model.labels[0], LABEL_MAX_LEN - 1));
+}
+
+void test_compact_upload_through_flash_storage() {
+    const uint32_t storedSize = buildTestModel(source, 4, 0, 6);
+    const std::vector<uint8_t> payload = encode(storedSize);
+
+    initFlashStorage();
+    beginModelUpload((uint32_t)payload.size(), 4);
+    TEST_ASSERT_EQUAL_INT(UPLOAD_RECEIVING, getUploadState());
+    for (uint32_t offset = 0; offset < payload.size(); offset += 240) {
+        const uint32_t remaining = (uint32_t)payload.size() - offset;
+        TEST_ASSERT_TRUE(receiveModelChunk(&payload[offset], remaining < 240 ? remaining : 240, offset));
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS,
+                          finalizeModelUpload(calculateCrc32(payload.data(), (uint32_t)payload.size())));
+    TEST_ASSERT_TRUE(hasStoredModel());
+    TEST_ASSERT_EQUAL_UINT32(sizeof(SimpleNNModel), getStoredModelSize());
+    TEST_ASSERT_EQUAL_UINT32(4, getStoredModelNumClasses());
+    TEST_ASSERT_EQUAL_STRING("Gesture3", getStoredModelLabel(3));
+    TEST_ASSERT_EQUAL_MEMORY(&source.model, getStoredSimpleNNModel(), sizeof(SimpleNNModel));
+
+    // A compact payload that stops early fails the size check
+    beginModelUpload((uint32_t)payload.size() - 1, 4);
+    TEST_ASSERT_TRUE(receiveModelChunk(payload.data(), 200, 0));
+    for (uint32_t offset = 200; offset < payload.size() - 1; offset += 240) {
+        const uint32_t remaining = (uint32_t)payload.size() - 1 - offset;
+        TEST_ASSERT_TRUE(receiveModelChunk(&payload[offset], remaining < 240 ? remaining : 240, offset));
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_ERROR_SIZE,
+                          finalizeModelUpload(calculateCrc32(payload.data(), (uint32_t)payload.size() - 1)));
+    TEST_ASSERT_FALSE(hasStoredModel());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_compact_round_trip_matches_padded_layout);
+    RUN_TEST(test_compact_round_trip_with_extra_heads);
+    RUN_TEST(test_full_payload_passes_through);
+    RUN_TEST(test_malformed_compact_payloads_are_rejected);
+    RUN_TEST(test_long_labels_are_truncated);
+    RUN_TEST(test_compact_upload_through_flash_storage);
+    return UNITY_END();
+}
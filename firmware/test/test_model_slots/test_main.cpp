@@ -0,0 +1,345 @@
+#include <unity.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "config.h"
+#include "crc32.h"
+#include "file_flash.h"
+#include "flash_storage.h"
+#include "model_slots.h"
+
+static char flashPath[64];
+
+static std::vector<uint8_t> makePayload(uint32_t size, unsigned seed) {
+    std::vector<uint8_t> payload(size);
+    srand(seed);
+    for (uint32_t i = 0; i < size; i++) {
+        payload[i] = (uint8_t)(rand() & 0xFF);
+    }
+    return payload;
+}
+
+// A freshly erased part
+static void eraseFlashFile() {
+    remove(flashPath);
+}
+
+static bool loadMatches(FileFlashRegion& flash, const std::vector<uint8_t>& expected) {
+    std::vector<uint8_t> out(getModelSlotCapacity(flash));
+    ModelSlotInfo info;
+    return loadNewestModelSlot(flash, out.data(), (uint32_t)out.size(), &info) &&
+           info.payloadSize == expected.size() &&
+           memcmp(out.data(), expected.data(), expected.size()) == 0;
+}
+
+void test_empty_flash_has_no_model() {
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+
+    uint8_t out[64];
+    ModelSlotInfo info;
+    TEST_ASSERT_FALSE(loadNewestModelSlot(flash, out, sizeof(out), &info));
+    TEST_ASSERT_EQUAL_INT(-1, info.slot);
+    TEST_ASSERT_TRUE(getModelSlotCapacity(flash) >= sizeof(StoredModelData));
+}
+
+void test_saves_alternate_slots_and_survive_reopen() {
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+
+    ModelSlotInfo info;
+    for (uint32_t save = 1; save <= 3; save++) {
+        // Odd size exercises the padded last word
+        const std::vector<uint8_t> payload = makePayload(sizeof(SimpleNNModel) + save, save);
+        TEST_ASSERT_TRUE(saveModelSlot(flash, payload.data(), (uint32_t)payload.size(), &info));
+        TEST_ASSERT_EQUAL_INT((save - 1) % 2, info.slot);
+        TEST_ASSERT_EQUAL_UINT32(save, info.sequence);
+    }
+
+    // "Reboot": a new region object only sees what reached the file
+    FileFlashRegion rebooted(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(rebooted.open());
+    TEST_ASSERT_TRUE(loadMatches(rebooted, makePayload(sizeof(SimpleNNModel) + 3, 3)));
+
+    const std::vector<uint8_t> tooBig = makePayload(getModelSlotCapacity(flash) + 1, 9);
+    TEST_ASSERT_FALSE(saveModelSlot(rebooted, tooBig.data(), (uint32_t)tooBig.size(), &info));
+}
+
+void test_power_loss_during_save_keeps_previous_model() {
+    const std::vector<uint8_t> oldModel = makePayload(sizeof(SimpleNNModel), 1);
+    const std::vector<uint8_t> newModel = makePayload(sizeof(SimpleNNModel), 2);
+
+    // Operations in one complete save (the second save of the part)
+    eraseFlashFile();
+    FileFlashRegion counter(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(counter.open());
+    TEST_ASSERT_TRUE(saveModelSlot(counter, oldModel.data(), (uint32_t)oldModel.size(), nullptr));
+    const uint32_t before = counter.operationCount();
+    TEST_ASSERT_TRUE(saveModelSlot(counter, newModel.data(), (uint32_t)newModel.size(), nullptr));
+    const uint32_t total = counter.operationCount() - before;
+    const uint32_t erases = (sizeof(ModelSlotHeader) + (uint32_t)newModel.size() +
+                             MODEL_FLASH_PAGE_SIZE - 1) / MODEL_FLASH_PAGE_SIZE;
+    const uint32_t headerWords = sizeof(ModelSlotHeader) / 4;
+
+    // Cut power in every erase, across the payload, and in every header word
+    std::vector<uint32_t> cuts;
+    for (uint32_t i = 0; i <= erases; i++) {
+        cuts.push_back(i);
+    }
+    for (uint32_t i = erases; i < total - headerWords; i += 2503) {
+        cuts.push_back(i);
+    }
+    for (uint32_t i = total - headerWords - 1; i < total; i++) {
+        cuts.push_back(i);
+    }
+
+    for (size_t c = 0; c < cuts.size(); c++) {
+        eraseFlashFile();
+        FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+        TEST_ASSERT_TRUE(flash.open());
+        TEST_ASSERT_TRUE(saveModelSlot(flash, oldModel.data(), (uint32_t)oldModel.size(), nullptr));
+
+        flash.failAfter(cuts[c]);
+        TEST_ASSERT_FALSE(saveModelSlot(flash, newModel.data(), (uint32_t)newModel.size(), nullptr));
+        TEST_ASSERT_TRUE(flash.powerLost());
+
+        TEST_ASSERT_TRUE(flash.open());
+        TEST_ASSERT_TRUE(loadMatches(flash, oldModel));
+
+        // The next save after power returns goes through normally
+        TEST_ASSERT_TRUE(saveModelSlot(flash, newModel.data(), (uint32_t)newModel.size(), nullptr));
+        TEST_ASSERT_TRUE(loadMatches(flash, newModel));
+    }
+
+    // One more operation and the save completes
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+    TEST_ASSERT_TRUE(saveModelSlot(flash, oldModel.data(), (uint32_t)oldModel.size(), nullptr));
+    flash.failAfter(total);
+    TEST_ASSERT_TRUE(saveModelSlot(flash, newModel.data(), (uint32_t)newModel.size(), nullptr));
+    TEST_ASSERT_TRUE(loadMatches(flash, newModel));
+}
+
+void test_incremental_save_takes_one_page_per_step() {
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+    const std::vector<uint8_t> oldModel = makePayload(sizeof(SimpleNNModel), 1);
+    const std::vector<uint8_t> newModel = makePayload(sizeof(SimpleNNModel) + 1, 2);
+    TEST_ASSERT_TRUE(saveModelSlot(flash, oldModel.data(), (uint32_t)oldModel.size(), nullptr));
+
+    ModelSlotSave save;
+    TEST_ASSERT_TRUE(beginModelSlotSave(flash, newModel.data(), (uint32_t)newModel.size(), &save));
+    TEST_ASSERT_EQUAL_INT(1, save.slot);
+
+    // Each step is one page erase or at most a page of words, and the old
+    // model stays the newest until the header lands
+    ModelSlotInfo info;
+    ModelSlotStep step = MODEL_SLOT_STEP_BUSY;
+    uint32_t steps = 0;
+    while (step == MODEL_SLOT_STEP_BUSY) {
+        const uint32_t before = flash.operationCount();
+        step = stepModelSlotSave(flash, &save, &info);
+        TEST_ASSERT_TRUE(flash.operationCount() - before <= MODEL_FLASH_PAGE_SIZE / 4);
+        if (step == MODEL_SLOT_STEP_BUSY) {
+            TEST_ASSERT_TRUE(loadMatches(flash, oldModel));
+        }
+        steps++;
+    }
+    TEST_ASSERT_EQUAL_INT(MODEL_SLOT_STEP_DONE, step);
+    TEST_ASSERT_EQUAL_INT(1, info.slot);
+    TEST_ASSERT_EQUAL_UINT32(2, info.sequence);
+    TEST_ASSERT_TRUE(loadMatches(flash, newModel));
+
+    // Erases, payload pages, the padded tail word, the header
+    const uint32_t pages = (sizeof(ModelSlotHeader) + (uint32_t)newModel.size() +
+                            MODEL_FLASH_PAGE_SIZE - 1) / MODEL_FLASH_PAGE_SIZE;
+    const uint32_t payloadPages = (sizeof(SimpleNNModel) + MODEL_FLASH_PAGE_SIZE - 1) / MODEL_FLASH_PAGE_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(pages + payloadPages + 2, steps);
+
+    // A cut between steps leaves the previous model
+    TEST_ASSERT_TRUE(beginModelSlotSave(flash, oldModel.data(), (uint32_t)oldModel.size(), &save));
+    for (int i = 0; i < 30; i++) {
+        TEST_ASSERT_EQUAL_INT(MODEL_SLOT_STEP_BUSY, stepModelSlotSave(flash, &save, nullptr));
+    }
+    TEST_ASSERT_TRUE(flash.open());
+    TEST_ASSERT_TRUE(loadMatches(flash, newModel));
+}
+
+void test_corrupt_newest_payload_falls_back() {
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+    const std::vector<uint8_t> oldModel = makePayload(4000, 1);
+    const std::vector<uint8_t> newModel = makePayload(4000, 2);
+    ModelSlotInfo info;
+    TEST_ASSERT_TRUE(saveModelSlot(flash, oldModel.data(), (uint32_t)oldModel.size(), &info));
+    TEST_ASSERT_TRUE(saveModelSlot(flash, newModel.data(), (uint32_t)newModel.size(), &info));
+
+    // Clear a word in the middle of the newest payload (bits can only drop)
+    const uint32_t zero = 0;
+    const uint32_t slotBytes = MODEL_FLASH_SIZE / 2;
+    flash.program(info.slot * slotBytes + sizeof(ModelSlotHeader) + 2000, &zero, 4);
+    TEST_ASSERT_TRUE(loadMatches(flash, oldModel));
+}
+
+void test_flash_storage_reloads_model_at_boot() {
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+    setModelFlashRegion(&flash);
+
+    static SimpleNNModel model;
+    memset(&model, 0, sizeof(model));
+    model.magic = SIMPLE_NN_MAGIC;
+    model.numClasses = 2;
+    model.inputSize = NN_INPUT_SIZE;
+    model.hiddenSize = NN_HIDDEN_SIZE;
+    strcpy(model.labels[1], "Wave");
+    const uint8_t* bytes = (const uint8_t*)&model;
+
+    initFlashStorage();
+    TEST_ASSERT_FALSE(hasStoredModel());
+    beginModelUpload(sizeof(model), 2);
+    for (uint32_t offset = 0; offset < sizeof(model); offset += 4096) {
+        const uint32_t remaining = sizeof(model) - offset;
+        TEST_ASSERT_TRUE(receiveModelChunk(&bytes[offset], remaining < 4096 ? remaining : 4096, offset));
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finalizeModelUpload(calculateCrc32(bytes, sizeof(model))));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, saveStoredModel());
+
+    // Reboot
+    initFlashStorage();
+    TEST_ASSERT_TRUE(hasStoredModel());
+    TEST_ASSERT_EQUAL_STRING("Wave", getStoredModelLabel(1));
+
+    // An abandoned upload overwrote RAM; the saved model comes back
+    beginModelUpload(sizeof(model), 2);
+    cancelModelUpload();
+    TEST_ASSERT_TRUE(restoreSavedModel());
+    TEST_ASSERT_FALSE(isServingSavedModel());
+    TEST_ASSERT_EQUAL_UINT32(sizeof(model), getStoredModelSize());
+
+    setModelFlashRegion(nullptr);
+}
+
+static SimpleNNModel hotModel;
+
+static void uploadHotModel(const char* label, float bias) {
+    memset(&hotModel, 0, sizeof(hotModel));
+    hotModel.magic = SIMPLE_NN_MAGIC;
+    hotModel.numClasses = 2;
+    hotModel.inputSize = NN_INPUT_SIZE;
+    hotModel.hiddenSize = NN_HIDDEN_SIZE;
+    hotModel.outputBias[1] = bias;
+    strcpy(hotModel.labels[1], label);
+    const uint8_t* bytes = (const uint8_t*)&hotModel;
+    beginModelUpload(sizeof(hotModel), 2);
+    for (uint32_t offset = 0; offset < sizeof(hotModel); offset += 4096) {
+        const uint32_t remaining = sizeof(hotModel) - offset;
+        TEST_ASSERT_TRUE(receiveModelChunk(&bytes[offset], remaining < 4096 ? remaining : 4096, offset));
+    }
+}
+
+void test_upload_serves_saved_model_until_finalize() {
+    eraseFlashFile();
+    FileFlashRegion flash(flashPath, MODEL_FLASH_SIZE, MODEL_FLASH_PAGE_SIZE);
+    TEST_ASSERT_TRUE(flash.open());
+    setModelFlashRegion(&flash);
+    initFlashStorage();
+
+    // Nothing saved yet: the first upload has nothing to serve
+    uploadHotModel("Wave", 0.5f);
+    TEST_ASSERT_FALSE(hasStoredModel());
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finalizeModelUpload(calculateCrc32((const uint8_t*)&hotModel, sizeof(hotModel))));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, saveStoredModel());
+
+    // While the next one streams over RAM, the first is read from flash
+    uploadHotModel("Shake", 0.25f);
+    TEST_ASSERT_TRUE(isServingSavedModel());
+    const SimpleNNModel* serving = getStoredSimpleNNModel();
+    TEST_ASSERT_TRUE((const uint8_t*)serving >= flash.mapped() &&
+                     (const uint8_t*)serving < flash.mapped() + MODEL_FLASH_SIZE);
+    TEST_ASSERT_EQUAL_STRING("Wave", getStoredModelLabel(1));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, serving->outputBias[1]);
+
+    // A failed finalize keeps serving it; restoring copies it back to RAM
+    TEST_ASSERT_EQUAL_INT(STATUS_ERROR_CRC, finalizeModelUpload(0));
+    TEST_ASSERT_TRUE(hasStoredModel());
+    TEST_ASSERT_EQUAL_STRING("Wave", getStoredModelLabel(1));
+    TEST_ASSERT_TRUE(restoreSavedModel());
+    TEST_ASSERT_FALSE(isServingSavedModel());
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, getStoredSimpleNNModel()->outputBias[1]);
+
+    // Success swaps to the new model in RAM, and the save leaves the served
+    // slot alone
+    uploadHotModel("Shake", 0.25f);
+    TEST_ASSERT_TRUE(isServingSavedModel());
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finalizeModelUpload(calculateCrc32((const uint8_t*)&hotModel, sizeof(hotModel))));
+    TEST_ASSERT_FALSE(isServingSavedModel());
+    TEST_ASSERT_EQUAL_STRING("Shake", getStoredModelLabel(1));
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, serving->outputBias[1]);
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, saveStoredModel());
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, serving->outputBias[1]);
+
+    // The loop's save: STATUS_SAVING one page at a time, serving the new
+    // model from RAM meanwhile. An upload started before it ends finishes
+    // it first, then serves the saved copy.
+    uploadHotModel("Wave", 1.0f);
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finalizeModelUpload(calculateCrc32((const uint8_t*)&hotModel, sizeof(hotModel))));
+    TEST_ASSERT_EQUAL_INT(STATUS_SAVING, beginSaveStoredModel());
+    for (int i = 0; i < 10; i++) {
+        TEST_ASSERT_EQUAL_INT(STATUS_SAVING, continueSaveStoredModel());
+    }
+    TEST_ASSERT_TRUE(isSavingStoredModel());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, getStoredSimpleNNModel()->outputBias[1]);
+    uploadHotModel("Shake", 0.25f);
+    TEST_ASSERT_FALSE(isSavingStoredModel());
+    TEST_ASSERT_TRUE(isServingSavedModel());
+    TEST_ASSERT_EQUAL_FLOAT(1.0f, getStoredSimpleNNModel()->outputBias[1]);
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finalizeModelUpload(calculateCrc32((const uint8_t*)&hotModel, sizeof(hotModel))));
+    TEST_ASSERT_EQUAL_INT(STATUS_SAVING, beginSaveStoredModel());
+    int steps = 1;
+    UploadStatus saved;
+    while ((saved = continueSaveStoredModel()) == STATUS_SAVING) {
+        steps++;
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, saved);
+    TEST_ASSERT_TRUE(steps > 20);
+    initFlashStorage();
+    TEST_ASSERT_EQUAL_FLOAT(0.25f, getStoredSimpleNNModel()->outputBias[1]);
+
+    // A model that never reached flash cannot be served from it
+    clearStoredModel();
+    uploadHotModel("Wave", 0.75f);
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finalizeModelUpload(calculateCrc32((const uint8_t*)&hotModel, sizeof(hotModel))));
+    uploadHotModel("Shake", 0.25f);
+    TEST_ASSERT_FALSE(hasStoredModel());
+    cancelModelUpload();
+
+    setModelFlashRegion(nullptr);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    snprintf(flashPath, sizeof(flashPath), "/tmp/severn_flash_%d.bin", (int)getpid());
+
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_flash_has_no_model);
+    RUN_TEST(test_saves_alternate_slots_and_survive_reopen);
+    RUN_TEST(test_power_loss_during_save_keeps_previous_model);
+    RUN_TEST(test_incremental_save_takes_one_page_per_step);
+    RUN_TEST(test_corrupt_newest_payload_falls_back);
+    RUN_TEST(test_flash_storage_reloads_model_at_boot);
+    RUN_TEST(test_upload_serves_saved_model_until_finalize);
+    int failures = UNITY_END();
+    remove(flashPath);
+    return failures;
+}
@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include "flash_storage.h"
+#include "simple_nn.h"
+
+// Primary head: 3 classes, extra head: 2 classes. Hidden neuron 0 copies
+// input[0], so each head's logits are a straight line in that one input.
+static StoredModelData model;
+static float input[NN_INPUT_SIZE];
+
+static void buildTwoHeadModel() {
+    memset(&model, 0, sizeof(model));
+    model.model.magic = SIMPLE_NN_MAGIC;
+    model.model.numClasses = 3;
+    model.model.inputSize = NN_INPUT_SIZE;
+    model.model.hiddenSize = NN_HIDDEN_SIZE;
+    model.model.hiddenWeights[0] = 1.0f;
+    model.model.outputWeights[0 * NN_HIDDEN_SIZE] = -1.0f;
+    model.model.outputWeights[2 * NN_HIDDEN_SIZE] = 1.0f;
+    model.model.outputBias[1] = 0.5f;
+    strcpy(model.model.labels[0], "Left");
+    strcpy(model.model.labels[1], "Still");
+    strcpy(model.model.labels[2], "Right");
+
+    model.extraHeads.magic = SIMPLE_NN_HEADS_MAGIC;
+    model.extraHeads.numExtraHeads = 1;
+    SimpleNNHead& head = model.extraHeads.heads[0];
+    head.numClasses = 2;
+    head.outputWeights[1 * NN_HIDDEN_SIZE] = 2.0f;
+    head.outputBias[0] = 1.0f;
+    strcpy(head.labels[0], "Soft");
+    strcpy(head.labels[1], "Hard");
+}
+
+// Softmax probability of `winner` among `count` logits
+static float softmaxOf(const float* logits, int count, int winner) {
+    float sum = 0.0f;
+    for (int i = 0; i < count; i++) {
+        sum += expf(logits[i] - logits[winner]);
+    }
+    return 1.0f / sum;
+}
+
+void test_each_head_predicts_from_its_own_layer() {
+    buildTwoHeadModel();
+    SimpleNN nn;
+    TEST_ASSERT_TRUE(nn.loadModel(&model.model, &model.extraHeads));
+    TEST_ASSERT_EQUAL_UINT8(2, nn.getNumHeads());
+    TEST_ASSERT_EQUAL_UINT32(2, nn.getHeadNumClasses(1));
+    TEST_ASSERT_EQUAL_STRING("Hard", nn.getHeadLabel(1, 1));
+
+    float probabilities[NN_MAX_CLASSES];
+    float confidence;
+
+    // input[0] = 2: primary logits [-2, 0.5, 2], head logits [1, 4]
+    memset(input, 0, sizeof(input));
+    input[0] = 2.0f;
+    TEST_ASSERT_EQUAL_INT(2, nn.predict(input, probabilities));
+    const float primary[3] = {-2.0f, 0.5f, 2.0f};
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, softmaxOf(primary, 3, 2), nn.getLastConfidence());
+    TEST_ASSERT_EQUAL_INT(1, nn.predictHead(1, probabilities, &confidence));
+    const float hard[2] = {1.0f, 4.0f};
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, softmaxOf(hard, 2, 1), confidence);
+
+    // input[0] = 0.25: primary [-0.25, 0.5, 0.25], head [1, 0.5]
+    input[0] = 0.25f;
+    TEST_ASSERT_EQUAL_INT(1, nn.predict(input, probabilities));
+    TEST_ASSERT_EQUAL_INT(0, nn.predictHead(1, probabilities, &confidence));
+    const float soft[2] = {1.0f, 0.5f};
+    TEST_ASSERT_FLOAT_WITHIN(1e-5f, softmaxOf(soft, 2, 0), confidence);
+
+    // Only head 1 exists
+    TEST_ASSERT_EQUAL_INT(-1, nn.predictHead(0, probabilities, &confidence));
+    TEST_ASSERT_EQUAL_INT(-1, nn.predictHead(2, probabilities, &confidence));
+}
+
+void test_head_reuses_the_last_hidden_layer() {
+    buildTwoHeadModel();
+    SimpleNN nn;
+    TEST_ASSERT_TRUE(nn.loadModel(&model.model, &model.extraHeads));
+
+    float probabilities[NN_MAX_CLASSES];
+    float confidence;
+
+    // Nothing to reuse before the first window
+    TEST_ASSERT_EQUAL_INT(-1, nn.predictHead(1, probabilities, &confidence));
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, confidence);
+
+    memset(input, 0, sizeof(input));
+    input[0] = 2.0f;
+    nn.predict(input, probabilities);
+
+    // The head reads the cached activations, not the hidden weights: it
+    // still says "Hard" with the trunk zeroed under it
+    model.model.hiddenWeights[0] = 0.0f;
+    TEST_ASSERT_EQUAL_INT(1, nn.predictHead(1, probabilities, &confidence));
+
+    // ...until the next window runs the trunk again
+    nn.predict(input, probabilities);
+    TEST_ASSERT_EQUAL_INT(0, nn.predictHead(1, probabilities, &confidence));
+
+    // Reloading drops the cache
+    TEST_ASSERT_TRUE(nn.loadModel(&model.model, &model.extraHeads));
+    TEST_ASSERT_EQUAL_INT(-1, nn.predictHead(1, probabilities, &confidence));
+}
+
+void test_bad_heads_block_is_rejected() {
+    SimpleNN nn;
+
+    buildTwoHeadModel();
+    model.extraHeads.magic = SIMPLE_NN_MAGIC;
+    TEST_ASSERT_FALSE(nn.loadModel(&model.model, &model.extraHeads));
+    TEST_ASSERT_FALSE(nn.isModelLoaded());
+
+    buildTwoHeadModel();
+    model.extraHeads.numExtraHeads = 0;
+    TEST_ASSERT_FALSE(nn.loadModel(&model.model, &model.extraHeads));
+
+    buildTwoHeadModel();
+    model.extraHeads.numExtraHeads = NN_MAX_HEADS;
+    TEST_ASSERT_FALSE(nn.loadModel(&model.model, &model.extraHeads));
+
+    buildTwoHeadModel();
+    model.extraHeads.heads[0].numClasses = 0;
+    TEST_ASSERT_FALSE(nn.loadModel(&model.model, &model.extraHeads));
+
+    buildTwoHeadModel();
+    model.extraHeads.heads[0].numClasses = NN_MAX_CLASSES + 1;
+    TEST_ASSERT_FALSE(nn.loadModel(&model.model, &model.extraHeads));
+
+    // A rejected block also drops a model that was loaded before
+    buildTwoHeadModel();
+    TEST_ASSERT_TRUE(nn.loadModel(&model.model, &model.extraHeads));
+    model.extraHeads.magic = 0;
+    TEST_ASSERT_FALSE(nn.loadModel(&model.model, &model.extraHeads));
+    TEST_ASSERT_FALSE(nn.isModelLoaded());
+
+    // Without the block the primary head loads on its own
+    TEST_ASSERT_TRUE(nn.loadModel(&model.model));
+    TEST_ASSERT_EQUAL_UINT8(1, nn.getNumHeads());
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_each_head_predicts_from_its_own_layer);
+    RUN_TEST(test_head_reuses_the_last_hidden_layer);
+    RUN_TEST(test_bad_heads_block_is_rejected);
+    return UNITY_END();
+}
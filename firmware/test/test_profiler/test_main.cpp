@@ -0,0 +1,97 @@
+#include <unity.h>
+#include <string.h>
+#include "profiler.h"
+
+static uint32_t readU32(const uint8_t* bytes) {
+    return (uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8) | ((uint32_t)bytes[2] << 16) |
+           ((uint32_t)bytes[3] << 24);
+}
+
+void test_bins_cover_every_value_in_order() {
+    int previous = -1;
+    for (uint32_t ticks = 0; ticks < 100000; ticks++) {
+        const int bin = ProfileHistogram::binIndex(ticks);
+        TEST_ASSERT_TRUE(bin == previous || bin == previous + 1);
+        TEST_ASSERT_TRUE(ticks <= ProfileHistogram::binUpperEdge(bin));
+        if (bin > 0) {
+            TEST_ASSERT_TRUE(ticks > ProfileHistogram::binUpperEdge(bin - 1));
+        }
+        previous = bin;
+    }
+    TEST_ASSERT_EQUAL_INT(PROFILE_HISTOGRAM_BINS - 1, ProfileHistogram::binIndex(0xFFFFFFFFu));
+}
+
+void test_exact_statistics() {
+    ProfileHistogram histogram;
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getMin());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getPercentile(99));
+
+    histogram.record(100);
+    histogram.record(300);
+    histogram.record(200);
+
+    TEST_ASSERT_EQUAL_UINT32(3, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(100, histogram.getMin());
+    TEST_ASSERT_EQUAL_UINT32(200, histogram.getAverage());
+    TEST_ASSERT_EQUAL_UINT32(300, histogram.getMax());
+
+    histogram.reset();
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getCount());
+    TEST_ASSERT_EQUAL_UINT32(0, histogram.getMax());
+}
+
+void test_p99_finds_the_tail_within_bin_width() {
+    ProfileHistogram histogram;
+    for (int i = 0; i < 990; i++) {
+        histogram.record(1000);
+    }
+    for (int i = 0; i < 10; i++) {
+        histogram.record(50000);
+    }
+
+    // Rank 990 is the last fast sample; one more slow one moves p99 up
+    const uint32_t p99 = histogram.getPercentile(99);
+    TEST_ASSERT_TRUE(p99 >= 1000 && p99 <= 1250);
+
+    histogram.record(50000);
+    const uint32_t tail = histogram.getPercentile(99);
+    TEST_ASSERT_EQUAL_UINT32(50000, tail);  // Bin edge capped at the exact max
+}
+
+void test_report_layout() {
+    ProfileHistogram stages[2];
+    stages[1].record(64);
+    stages[1].record(128);
+
+    uint8_t report[PROFILE_REPORT_HEADER_SIZE + 2 * PROFILE_REPORT_STAGE_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(0, encodeProfileReport(stages, 2, 1000, report, sizeof(report) - 1));
+    TEST_ASSERT_EQUAL_UINT32(sizeof(report), encodeProfileReport(stages, 2, 64000000, report,
+                                                                 sizeof(report)));
+
+    TEST_ASSERT_EQUAL_UINT8(PROFILE_REPORT_VERSION, report[0]);
+    TEST_ASSERT_EQUAL_UINT8(2, report[1]);
+    TEST_ASSERT_EQUAL_UINT32(64000000, readU32(&report[4]));
+
+    const uint8_t* empty = &report[PROFILE_REPORT_HEADER_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(0, readU32(&empty[0]));
+    TEST_ASSERT_EQUAL_UINT32(0, readU32(&empty[4]));
+
+    const uint8_t* stage = empty + PROFILE_REPORT_STAGE_SIZE;
+    TEST_ASSERT_EQUAL_UINT32(2, readU32(&stage[0]));
+    TEST_ASSERT_EQUAL_UINT32(64, readU32(&stage[4]));
+    TEST_ASSERT_EQUAL_UINT32(96, readU32(&stage[8]));
+    TEST_ASSERT_EQUAL_UINT32(128, readU32(&stage[12]));
+    TEST_ASSERT_EQUAL_UINT32(128, readU32(&stage[16]));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_bins_cover_every_value_in_order);
+    RUN_TEST(test_exact_statistics);
+    RUN_TEST(test_p99_finds_the_tail_within_bin_width);
+    RUN_TEST(test_report_layout);
+    return UNITY_END();
+}
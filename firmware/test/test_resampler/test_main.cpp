@@ -0,0 +1,129 @@
+#include <unity.h>
+#include <stdlib.h>
+#include "resampler.h"
+
+static const uint32_t PERIOD_US = 40000;  // 25 Hz
+
+static void fillAxes(int16_t axes[RESAMPLER_AXES], int16_t value) {
+    for (int a = 0; a < RESAMPLER_AXES; a++) {
+        axes[a] = (int16_t)(value * (a + 1));
+    }
+}
+
+void test_uniform_input_passes_through() {
+    UniformResampler resampler;
+    resampler.begin(PERIOD_US);
+
+    int16_t input[RESAMPLER_AXES];
+    int16_t output[4][RESAMPLER_AXES];
+    for (int n = 0; n < 20; n++) {
+        fillAxes(input, (int16_t)(n * 10));
+        const int count = resampler.push(1000 + n * PERIOD_US, input, output, 4);
+        TEST_ASSERT_EQUAL_INT(1, count);
+        TEST_ASSERT_EQUAL_INT16(input[0], output[0][0]);
+        TEST_ASSERT_EQUAL_INT16(input[5], output[0][5]);
+    }
+
+    const JitterStats stats = resampler.getJitterStats();
+    TEST_ASSERT_EQUAL_UINT32(19, stats.intervals);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.maxJitterUs);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, stats.rmsJitterUs);
+}
+
+void test_jittered_ramp_lands_on_grid() {
+    UniformResampler resampler;
+    resampler.begin(PERIOD_US);
+
+    // A ramp of 1 count per millisecond, read with +/- 9 ms of jitter
+    const int32_t jitterUs[] = {0, 7000, -9000, 3000, 9000, -4000, 1000, -8000, 5000, 0};
+    int16_t input[RESAMPLER_AXES];
+    int16_t output[4][RESAMPLER_AXES];
+    int gridIndex = 0;
+
+    for (int n = 0; n < 10; n++) {
+        const uint32_t t = (uint32_t)(n * (int32_t)PERIOD_US + jitterUs[n]) + 100000;
+        fillAxes(input, (int16_t)((t - 100000) / 1000));
+        const int count = resampler.push(t, input, output, 4);
+        for (int k = 0; k < count; k++) {
+            // Grid starts at the first sample (t = 100000 → value 0)
+            const int16_t expected = (int16_t)(gridIndex * (PERIOD_US / 1000));
+            TEST_ASSERT_INT_WITHIN(1, expected, output[k][0]);
+            TEST_ASSERT_INT_WITHIN(6, expected * 6, output[k][5]);
+            gridIndex++;
+        }
+    }
+
+    // Grid points strictly inside the input span are all produced
+    TEST_ASSERT_EQUAL_INT(10, gridIndex);
+}
+
+void test_jitter_statistics() {
+    UniformResampler resampler;
+    resampler.begin(PERIOD_US);
+
+    int16_t input[RESAMPLER_AXES] = {0};
+    int16_t output[4][RESAMPLER_AXES];
+    resampler.push(0, input, output, 4);
+    resampler.push(38000, input, output, 4);   // -2000
+    resampler.push(80000, input, output, 4);   // +2000
+    resampler.push(120000, input, output, 4);  //     0
+    resampler.push(170000, input, output, 4);  // +10000
+
+    const JitterStats stats = resampler.getJitterStats();
+    TEST_ASSERT_EQUAL_UINT32(4, stats.intervals);
+    TEST_ASSERT_EQUAL_UINT32(38000, stats.minIntervalUs);
+    TEST_ASSERT_EQUAL_UINT32(50000, stats.maxIntervalUs);
+    TEST_ASSERT_EQUAL_UINT32(10000, stats.maxJitterUs);
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, 42500.0f, stats.meanIntervalUs);
+    // sqrt((4e6 + 4e6 + 0 + 1e8) / 4) = 5196
+    TEST_ASSERT_FLOAT_WITHIN(2.0f, 5196.15f, stats.rmsJitterUs);
+}
+
+void test_gap_restarts_grid() {
+    UniformResampler resampler;
+    resampler.begin(PERIOD_US);
+
+    int16_t input[RESAMPLER_AXES];
+    int16_t output[4][RESAMPLER_AXES];
+    fillAxes(input, 0);
+    resampler.push(0, input, output, 4);
+    fillAxes(input, 100);
+    TEST_ASSERT_EQUAL_INT(1, resampler.push(PERIOD_US, input, output, 4));
+
+    // 2 seconds later (e.g. after an upload pause): no interpolated ramp
+    fillAxes(input, 500);
+    TEST_ASSERT_EQUAL_INT(1, resampler.push(PERIOD_US + 2000000, input, output, 4));
+    TEST_ASSERT_EQUAL_INT16(500, output[0][0]);
+    TEST_ASSERT_EQUAL_UINT32(PERIOD_US + 2000000, resampler.getLastGridTimeUs());
+    TEST_ASSERT_EQUAL_UINT32(1, resampler.getJitterStats().gaps);
+}
+
+void test_micros_wraparound() {
+    UniformResampler resampler;
+    resampler.begin(PERIOD_US);
+
+    int16_t input[RESAMPLER_AXES];
+    int16_t output[4][RESAMPLER_AXES];
+    const uint32_t start = 0xFFFFFFFFu - 50000;
+    int total = 0;
+    for (int n = 0; n < 5; n++) {
+        fillAxes(input, (int16_t)n);
+        total += resampler.push(start + (uint32_t)n * PERIOD_US, input, output, 4);
+        TEST_ASSERT_EQUAL_INT16(n, output[0][0]);
+    }
+    TEST_ASSERT_EQUAL_INT(5, total);
+    TEST_ASSERT_EQUAL_UINT32(0, resampler.getJitterStats().gaps);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_uniform_input_passes_through);
+    RUN_TEST(test_jittered_ramp_lands_on_grid);
+    RUN_TEST(test_jitter_statistics);
+    RUN_TEST(test_gap_restarts_grid);
+    RUN_TEST(test_micros_wraparound);
+    return UNITY_END();
+}
@@ -0,0 +1,153 @@
+#include <unity.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <vector>
+#include "config.h"
+#include "crc32.h"
+#include "flash_storage.h"
+#include "test_models.h"
+
+// Block-aligned chunks, as the web app sends them to firmware 1.4+
+#define CHUNK_DATA_SIZE (9 * MODEL_UPLOAD_BLOCK_SIZE)
+
+static SimpleNNModel model;
+
+static const uint8_t* modelBytes() {
+    return (const uint8_t*)&model;
+}
+
+static void buildModel() {
+    buildTestModel(model, 3, 7);
+}
+
+static void beginUpload() {
+    buildModel();
+    initFlashStorage();
+    beginModelUpload(sizeof(model), model.numClasses);
+    TEST_ASSERT_EQUAL_INT(UPLOAD_RECEIVING, getUploadState());
+}
+
+static bool sendChunk(uint32_t offset) {
+    const uint32_t remaining = sizeof(model) - offset;
+    return receiveModelChunk(&modelBytes()[offset],
+                             remaining < CHUNK_DATA_SIZE ? remaining : CHUNK_DATA_SIZE, offset);
+}
+
+static UploadStatus finish() {
+    return finalizeModelUpload(calculateCrc32(modelBytes(), sizeof(model)));
+}
+
+void test_reordered_chunks_within_the_window() {
+    beginUpload();
+
+    // Swap neighbours: every other chunk arrives ahead of the frontier
+    std::vector<uint32_t> offsets;
+    for (uint32_t offset = 0; offset < sizeof(model); offset += CHUNK_DATA_SIZE) {
+        offsets.push_back(offset);
+    }
+    for (size_t i = 0; i + 1 < offsets.size(); i += 2) {
+        std::swap(offsets[i], offsets[i + 1]);
+    }
+    for (size_t i = 0; i < offsets.size(); i++) {
+        TEST_ASSERT_TRUE(sendChunk(offsets[i]));
+    }
+
+    UploadRange ranges[MODEL_MISSING_RANGES_MAX];
+    TEST_ASSERT_EQUAL_UINT32(0, getMissingUploadRanges(ranges, MODEL_MISSING_RANGES_MAX));
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish());
+    TEST_ASSERT_EQUAL_MEMORY(&model, getStoredSimpleNNModel(), sizeof(model));
+}
+
+void test_lost_chunks_are_reported_and_resent() {
+    beginUpload();
+
+    // Lose two chunks inside the window and one far past it
+    const uint32_t lostA = 2 * CHUNK_DATA_SIZE;
+    const uint32_t lostB = 5 * CHUNK_DATA_SIZE;
+    for (uint32_t offset = 0; offset < sizeof(model); offset += CHUNK_DATA_SIZE) {
+        if (offset != lostA && offset != lostB) {
+            TEST_ASSERT_TRUE(sendChunk(offset));
+        }
+    }
+
+    // Everything after the window was dropped and is missing too
+    UploadRange ranges[MODEL_MISSING_RANGES_MAX];
+    uint32_t count = getMissingUploadRanges(ranges, MODEL_MISSING_RANGES_MAX);
+    TEST_ASSERT_EQUAL_UINT32(3, count);
+    TEST_ASSERT_EQUAL_UINT32(lostA, ranges[0].offset);
+    TEST_ASSERT_EQUAL_UINT32(CHUNK_DATA_SIZE, ranges[0].length);
+    TEST_ASSERT_EQUAL_UINT32(lostB, ranges[1].offset);
+    TEST_ASSERT_EQUAL_UINT32(CHUNK_DATA_SIZE, ranges[1].length);
+    TEST_ASSERT_EQUAL_UINT32(sizeof(model), ranges[2].offset + ranges[2].length);
+    TEST_ASSERT_TRUE(ranges[2].offset <= lostA + MODEL_UPLOAD_WINDOW);
+
+    // At most maxRanges, in offset order
+    TEST_ASSERT_EQUAL_UINT32(1, getMissingUploadRanges(ranges, 1));
+    TEST_ASSERT_EQUAL_UINT32(lostA, ranges[0].offset);
+
+    // Finishing with gaps fails the size check
+    TEST_ASSERT_TRUE(sendChunk(lostA));
+    TEST_ASSERT_TRUE(sendChunk(lostB));
+    count = getMissingUploadRanges(ranges, MODEL_MISSING_RANGES_MAX);
+    TEST_ASSERT_EQUAL_UINT32(1, count);
+    TEST_ASSERT_TRUE(getUploadProgress() < 100);
+
+    // Resend whatever is still missing, round by round
+    for (int round = 0; round < 100 && count > 0; round++) {
+        for (uint32_t offset = ranges[0].offset; offset < ranges[0].offset + ranges[0].length;
+             offset += CHUNK_DATA_SIZE) {
+            TEST_ASSERT_TRUE(sendChunk(offset));
+        }
+        count = getMissingUploadRanges(ranges, MODEL_MISSING_RANGES_MAX);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, count);
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish());
+    TEST_ASSERT_EQUAL_MEMORY(&model, getStoredSimpleNNModel(), sizeof(model));
+}
+
+void test_duplicates_and_overlaps_are_ignored() {
+    beginUpload();
+
+    TEST_ASSERT_TRUE(sendChunk(0));
+    TEST_ASSERT_TRUE(sendChunk(2 * CHUNK_DATA_SIZE));
+    TEST_ASSERT_TRUE(sendChunk(2 * CHUNK_DATA_SIZE));  // Held twice
+    TEST_ASSERT_TRUE(sendChunk(0));                    // Already decoded
+
+    // Legacy unaligned in-order chunk that overlaps what was decoded
+    TEST_ASSERT_TRUE(receiveModelChunk(&modelBytes()[100], 155, 100));
+    TEST_ASSERT_TRUE(sendChunk(CHUNK_DATA_SIZE));
+    for (uint32_t offset = 3 * CHUNK_DATA_SIZE; offset < sizeof(model); offset += CHUNK_DATA_SIZE) {
+        TEST_ASSERT_TRUE(sendChunk(offset));
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS, finish());
+    TEST_ASSERT_EQUAL_MEMORY(&model, getStoredSimpleNNModel(), sizeof(model));
+}
+
+void test_unaligned_chunk_ahead_is_an_error() {
+    beginUpload();
+
+    // In order, an unaligned chunk is fine (firmware 1.3 web apps send 155)
+    TEST_ASSERT_TRUE(receiveModelChunk(modelBytes(), 155, 0));
+
+    // Ahead of the frontier it cannot be placed in the block map
+    TEST_ASSERT_FALSE(receiveModelChunk(&modelBytes()[1000], 155, 1000));
+    TEST_ASSERT_EQUAL_INT(UPLOAD_ERROR, getUploadState());
+
+    // Nothing is missing once the upload has failed
+    UploadRange ranges[MODEL_MISSING_RANGES_MAX];
+    TEST_ASSERT_EQUAL_UINT32(0, getMissingUploadRanges(ranges, MODEL_MISSING_RANGES_MAX));
+    cancelModelUpload();
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_reordered_chunks_within_the_window);
+    RUN_TEST(test_lost_chunks_are_reported_and_resent);
+    RUN_TEST(test_duplicates_and_overlaps_are_ignored);
+    RUN_TEST(test_unaligned_chunk_ahead_is_an_error);
+    return UNITY_END();
+}
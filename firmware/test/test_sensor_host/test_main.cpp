@@ -0,0 +1,227 @@
+#include <unity.h>
+#include <stdio.h>
+#include <unistd.h>
+#include "sensor_host.h"
+#include "flash_storage.h"
+#include "inference.h"
+
+#define PERIOD_US (1000000UL / IMU_SAMPLE_RATE_HZ)
+
+static void tempPath(char* path, size_t length, const char* suffix) {
+    snprintf(path, length, "/tmp/severn_replay_%d%s", (int)getpid(), suffix);
+}
+
+// Step the virtual clock one sample period at a time and drain the reader
+static int drainReader(SensorReader& reader, SensorPacket* packets, uint32_t* times, int maxPackets) {
+    int total = 0;
+    for (int step = 0; step < maxPackets * 4 && total < maxPackets; step++) {
+        total += reader.readBatch(&packets[total], &times[total], maxPackets - total);
+        hostAdvanceMicros(PERIOD_US);
+    }
+    return total;
+}
+
+void test_csv_replay_scales_and_paces() {
+    char path[64];
+    tempPath(path, sizeof(path), ".csv");
+    FILE* file = fopen(path, "w");
+    TEST_ASSERT_NOT_NULL(file);
+    fprintf(file, "t_ms,ax,ay,az,gx,gy,gz,label\n");
+    fprintf(file, "1000,0.5,-0.25,1.0,10,-20,250,Wave\n");
+    fprintf(file, "1040,0,0,1,0,0,0,Wave\n");
+    fprintf(file, "1100,-1,0,1,0,0,-250,Wave\n");
+    fclose(file);
+
+    hostResetClock();
+    ReplaySensorReader reader(path);
+    TEST_ASSERT_TRUE(reader.begin());
+    remove(path);
+    TEST_ASSERT_EQUAL_UINT32(3, reader.getSampleCount());
+
+    SensorPacket packets[4];
+    uint32_t times[4];
+    TEST_ASSERT_EQUAL_INT(1, reader.readBatch(packets, times, 4));  // t=0 is due
+    TEST_ASSERT_EQUAL_INT16(4096, packets[0].ax);
+    TEST_ASSERT_EQUAL_INT16(-2048, packets[0].ay);
+    TEST_ASSERT_EQUAL_INT16(8192, packets[0].az);
+    TEST_ASSERT_INT_WITHIN(1, 164, packets[0].gx);  // Float scaling truncates
+    TEST_ASSERT_INT_WITHIN(1, 4100, packets[0].gz);
+    TEST_ASSERT_EQUAL_UINT8(crc8((uint8_t*)&packets[0], 16), packets[0].crc);
+
+    hostAdvanceMicros(39999);
+    TEST_ASSERT_EQUAL_INT(0, reader.readBatch(packets, times, 4));
+    hostAdvanceMicros(100000);
+    TEST_ASSERT_EQUAL_INT(2, reader.readBatch(packets, times, 4));
+    TEST_ASSERT_EQUAL_UINT32(40000, times[0]);
+    TEST_ASSERT_EQUAL_UINT32(100000, times[1]);
+    TEST_ASSERT_EQUAL_UINT16(2, packets[1].sequence);
+    TEST_ASSERT_EQUAL_UINT16(100, packets[1].timestamp);
+    TEST_ASSERT_TRUE(reader.isFinished());
+}
+
+void test_packet_replay_skips_corrupt_and_loops() {
+    char path[64];
+    tempPath(path, sizeof(path), ".bin");
+    FILE* file = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(file);
+    for (int i = 0; i < 4; i++) {
+        SensorPacket packet = {};
+        packet.ax = (int16_t)(i * 100);
+        packet.sequence = (uint16_t)i;
+        packet.timestamp = (uint16_t)(65500 + i * 40);  // Wraps after the first
+        packet.crc = crc8((uint8_t*)&packet, 16);
+        if (i == 2) {
+            packet.crc ^= 0x5A;
+        }
+        fwrite(&packet, 1, SENSOR_PACKET_SIZE, file);
+    }
+    fclose(file);
+
+    hostResetClock();
+    ReplaySensorReader reader(path, true);
+    TEST_ASSERT_TRUE(reader.begin());
+    remove(path);
+    TEST_ASSERT_EQUAL_UINT32(3, reader.getSampleCount());
+    TEST_ASSERT_EQUAL_UINT32(1, reader.getDroppedSamples());
+
+    SensorPacket packets[6];
+    uint32_t times[6];
+    TEST_ASSERT_EQUAL_INT(6, drainReader(reader, packets, times, 6));
+    const int16_t expectedAx[6] = {0, 100, 300, 0, 100, 300};
+    // Second pass starts one nominal period after the last sample
+    const uint32_t expectedUs[6] = {0, 40000, 120000, 120000 + PERIOD_US,
+                                    160000 + PERIOD_US, 240000 + PERIOD_US};
+    for (int i = 0; i < 6; i++) {
+        TEST_ASSERT_EQUAL_INT16(expectedAx[i], packets[i].ax);
+        TEST_ASSERT_EQUAL_UINT32(expectedUs[i], times[i]);
+    }
+    TEST_ASSERT_FALSE(reader.isFinished());
+}
+
+void test_missing_replay_file_fails() {
+    ReplaySensorReader reader("/nonexistent/severn_replay.csv");
+    TEST_ASSERT_FALSE(reader.begin());
+}
+
+void test_synthetic_is_deterministic_per_seed() {
+    SyntheticGestureConfig config = defaultSyntheticGesture(SYNTH_SHAKE);
+    hostResetClock();
+    SyntheticSensorReader first(config);
+    SyntheticSensorReader second(config);
+    config.seed = 7;
+    SyntheticSensorReader reseeded(config);
+    TEST_ASSERT_TRUE(first.begin());
+    TEST_ASSERT_TRUE(second.begin());
+    TEST_ASSERT_TRUE(reseeded.begin());
+
+    hostAdvanceMicros(10 * PERIOD_US);
+    SensorPacket a[16], b[16], c[16];
+    uint32_t times[16];
+    TEST_ASSERT_EQUAL_INT(11, first.readBatch(a, times, 16));
+    TEST_ASSERT_EQUAL_INT(11, second.readBatch(b, times, 16));
+    TEST_ASSERT_EQUAL_INT(11, reseeded.readBatch(c, times, 16));
+    TEST_ASSERT_EQUAL_MEMORY(a, b, sizeof(SensorPacket) * 11);
+    TEST_ASSERT_TRUE(memcmp(a, c, sizeof(SensorPacket) * 11) != 0);
+    TEST_ASSERT_EQUAL_UINT32(10 * PERIOD_US, times[10]);
+}
+
+void test_synthetic_gesture_names() {
+    SyntheticGesture gesture = SYNTH_IDLE;
+    TEST_ASSERT_TRUE(parseSyntheticGesture("circle", &gesture));
+    TEST_ASSERT_EQUAL_INT(SYNTH_CIRCLE, gesture);
+    TEST_ASSERT_FALSE(parseSyntheticGesture("juggle", &gesture));
+    TEST_ASSERT_EQUAL_INT(SYNTH_CIRCLE, gesture);
+}
+
+// ============================================================================
+// End to end: reader → sliding window → SimpleNN (+ idle override)
+// ============================================================================
+
+static SimpleNNModel testModel;
+
+// Zero weights with biases that make "Wave" a weak favourite, so only the
+// idle override can turn a still window into "Idle".
+static void uploadWeakWaveModel() {
+    memset(&testModel, 0, sizeof(testModel));
+    testModel.magic = SIMPLE_NN_MAGIC;
+    testModel.numClasses = 3;
+    testModel.inputSize = NN_INPUT_SIZE;
+    testModel.hiddenSize = NN_HIDDEN_SIZE;
+    testModel.outputBias[1] = 0.5f;
+    strcpy(testModel.labels[0], "Idle");
+    strcpy(testModel.labels[1], "Wave");
+    strcpy(testModel.labels[2], "Shake");
+
+    const uint8_t* bytes = (const uint8_t*)&testModel;
+    beginModelUpload(sizeof(testModel), 3);
+    for (uint32_t offset = 0; offset < sizeof(testModel); offset += MODEL_CHUNK_SIZE) {
+        uint32_t length = sizeof(testModel) - offset;
+        if (length > MODEL_CHUNK_SIZE) length = MODEL_CHUNK_SIZE;
+        receiveModelChunk(&bytes[offset], (uint16_t)length, offset);
+    }
+    TEST_ASSERT_EQUAL_INT(STATUS_SUCCESS,
+                          finalizeModelUpload(calculateCrc32(bytes, sizeof(testModel))));
+    TEST_ASSERT_TRUE(reloadModel());
+}
+
+// Run `seconds` of the gesture through the pipeline; returns windows run
+static void runPipeline(SyntheticGesture gesture, int seconds, int* windows, int* predictions) {
+    hostResetClock();
+    resetInferenceWindow();
+    SyntheticSensorReader reader(defaultSyntheticGesture(gesture));
+    TEST_ASSERT_TRUE(reader.begin());
+
+    *windows = 0;
+    memset(predictions, 0, 3 * sizeof(int));
+    SensorPacket packets[SENSOR_BATCH_MAX_SAMPLES];
+    uint32_t times[SENSOR_BATCH_MAX_SAMPLES];
+
+    for (int ms = 0; ms < seconds * 1000; ms += 100) {
+        hostAdvanceMicros(100000);  // 100 ms of virtual time per step
+        const int count = reader.readBatch(packets, times, SENSOR_BATCH_MAX_SAMPLES);
+        for (int i = 0; i < count; i++) {
+            const SensorPacket& p = packets[i];
+            addSample(p.ax, p.ay, p.az, p.gx, p.gy, p.gz);
+            if (isWindowReady()) {
+                float confidence;
+                const int prediction = runInference(&confidence);
+                TEST_ASSERT_TRUE(prediction >= 0 && prediction < 3);
+                predictions[prediction]++;
+                (*windows)++;
+                slideWindow();
+            }
+        }
+    }
+}
+
+void test_pipeline_runs_on_synthetic_data() {
+    TEST_ASSERT_TRUE(setupInference());
+    uploadWeakWaveModel();
+
+    int windows;
+    int predictions[3];
+    runPipeline(SYNTH_IDLE, 60, &windows, predictions);
+    const int expectedWindows = (60 * IMU_SAMPLE_RATE_HZ - WINDOW_SIZE) / WINDOW_STRIDE + 1;
+    TEST_ASSERT_EQUAL_INT(expectedWindows, windows);
+    TEST_ASSERT_EQUAL_INT(windows, predictions[0]);  // Still → Idle override
+
+    runPipeline(SYNTH_WAVE, 60, &windows, predictions);
+    TEST_ASSERT_EQUAL_INT(expectedWindows, windows);
+    TEST_ASSERT_EQUAL_INT(windows, predictions[1]);  // Moving → model's pick
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    Serial.setOutput(nullptr);  // Keep firmware DEBUG_PRINT chatter out of the report
+
+    UNITY_BEGIN();
+    RUN_TEST(test_csv_replay_scales_and_paces);
+    RUN_TEST(test_packet_replay_skips_corrupt_and_loops);
+    RUN_TEST(test_missing_replay_file_fails);
+    RUN_TEST(test_synthetic_is_deterministic_per_seed);
+    RUN_TEST(test_synthetic_gesture_names);
+    RUN_TEST(test_pipeline_runs_on_synthetic_data);
+    return UNITY_END();
+}
@@ -0,0 +1,267 @@
+#include <unity.h>
+#include <stdio.h>
+#include "sensor_stream.h"
+
+static void makeAxes(int16_t axes[6], int n) {
+    for (int axis = 0; axis < 6; axis++) {
+        axes[axis] = (int16_t)(n * 100 - axis * 3000);
+    }
+}
+
+void test_max_batch_fits_one_notification() {
+    TEST_ASSERT_TRUE(SENSOR_STREAM_MAX_BATCH >= 12);
+    TEST_ASSERT_TRUE(SENSOR_BATCH_MAX_SIZE(SENSOR_STREAM_MAX_BATCH) <= SENSOR_NOTIFY_MAX_SIZE);
+}
+
+void test_round_trip_full_batch() {
+    SensorBatchEncoder encoder;
+    encoder.begin(SENSOR_STREAM_MAX_BATCH, 10000);  // 100 Hz
+
+    int16_t axes[6];
+    for (int n = 0; n < SENSOR_STREAM_MAX_BATCH; n++) {
+        TEST_ASSERT_TRUE(encoder.canAppend((uint16_t)(65530 + n)));
+        makeAxes(axes, n);
+        encoder.append(axes, (uint16_t)(65530 + n), (uint16_t)(65500 + n * 10));
+    }
+    TEST_ASSERT_TRUE(encoder.isFull());
+    TEST_ASSERT_FALSE(encoder.canAppend((uint16_t)(65530 + SENSOR_STREAM_MAX_BATCH)));
+
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+    const size_t length = encoder.finish(notification);
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_BATCH_MAX_SIZE(SENSOR_STREAM_MAX_BATCH), length);
+    TEST_ASSERT_EQUAL_UINT8(0, encoder.getCount());
+
+    StreamSample samples[SENSOR_STREAM_MAX_BATCH];
+    const int count = decodeSensorBatch(notification, length, samples, SENSOR_STREAM_MAX_BATCH);
+    TEST_ASSERT_EQUAL_INT(SENSOR_STREAM_MAX_BATCH, count);
+    for (int n = 0; n < count; n++) {
+        makeAxes(axes, n);
+        TEST_ASSERT_EQUAL_INT16_ARRAY(axes, samples[n].axes, 6);
+        // Sequence and timestamp wrap at 16 bits
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(65530 + n), samples[n].sequence);
+        TEST_ASSERT_EQUAL_UINT16((uint16_t)(65500 + n * 10), samples[n].timestamp);
+    }
+}
+
+void test_sequence_gap_starts_new_batch() {
+    SensorBatchEncoder encoder;
+    encoder.begin(12, 40000);
+
+    int16_t axes[6] = {0};
+    encoder.append(axes, 10, 0);
+    encoder.append(axes, 11, 40);
+    TEST_ASSERT_TRUE(encoder.canAppend(12));
+    TEST_ASSERT_FALSE(encoder.canAppend(14));
+
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+    TEST_ASSERT_EQUAL_UINT32(SENSOR_BATCH_MAX_SIZE(2), encoder.finish(notification));
+    TEST_ASSERT_TRUE(encoder.canAppend(14));
+    TEST_ASSERT_EQUAL_UINT32(0, encoder.finish(notification));
+}
+
+void test_fractional_interval_timestamps() {
+    SensorBatchEncoder encoder;
+    encoder.begin(4, 2500);  // 400 Hz
+
+    int16_t axes[6] = {0};
+    for (int n = 0; n < 4; n++) {
+        encoder.append(axes, (uint16_t)n, 1000);
+    }
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+    const size_t length = encoder.finish(notification);
+
+    StreamSample samples[4];
+    TEST_ASSERT_EQUAL_INT(4, decodeSensorBatch(notification, length, samples, 4));
+    TEST_ASSERT_EQUAL_UINT16(1000, samples[0].timestamp);
+    TEST_ASSERT_EQUAL_UINT16(1003, samples[1].timestamp);  // 2.5 ms rounds up
+    TEST_ASSERT_EQUAL_UINT16(1005, samples[2].timestamp);
+    TEST_ASSERT_EQUAL_UINT16(1008, samples[3].timestamp);
+}
+
+void test_decoder_rejects_corruption() {
+    SensorBatchEncoder encoder;
+    encoder.begin(3, 40000);
+    int16_t axes[6] = {1, 2, 3, 4, 5, 6};
+    for (int n = 0; n < 3; n++) {
+        encoder.append(axes, (uint16_t)n, 0);
+    }
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+    const size_t length = encoder.finish(notification);
+    StreamSample samples[4];
+
+    notification[10] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(-1, decodeSensorBatch(notification, length, samples, 4));
+    notification[10] ^= 0x01;
+    TEST_ASSERT_EQUAL_INT(-1, decodeSensorBatch(notification, length - 1, samples, 4));
+    TEST_ASSERT_EQUAL_INT(-1, decodeSensorBatch(notification, length, samples, 2));
+    TEST_ASSERT_EQUAL_INT(3, decodeSensorBatch(notification, length, samples, 4));
+}
+
+
+// ----------------------------------------------------------------------------
+// Delta-compressed stream
+// ----------------------------------------------------------------------------
+
+// Slow motion + sensor noise: small deltas, like holding or tilting the board
+static void quietSample(int n, int16_t axes[6]) {
+    static uint32_t lcg = 12345;
+    for (int axis = 0; axis < 6; axis++) {
+        lcg = lcg * 1103515245u + 12345u;
+        const int noise = (int)((lcg >> 16) % 41) - 20;
+        const int base = axis == 2 ? 8192 : (int)((n % 200) - 100) * (axis + 1);
+        axes[axis] = (int16_t)(base + noise);
+    }
+}
+
+// Finish the pending notification and check it decodes to the originals
+static void sendPending(SensorDeltaEncoder& encoder, SensorDeltaDecoder& decoder,
+                        int16_t history[][6], int* checked) {
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+    StreamSample decoded[SENSOR_DELTA_MAX_SAMPLES];
+    const size_t length = encoder.finish(notification);
+    const int count = decoder.decode(notification, length, decoded, SENSOR_DELTA_MAX_SAMPLES);
+    TEST_ASSERT_TRUE(count > 0);
+    for (int i = 0; i < count; i++) {
+        TEST_ASSERT_EQUAL_INT16_ARRAY(history[decoded[i].sequence], decoded[i].axes, 6);
+        (*checked)++;
+    }
+}
+
+// Stream every sample through encoder → decoder, count notifications sent
+static void streamThrough(SensorDeltaEncoder& encoder, SensorDeltaDecoder& decoder,
+                          int16_t history[][6], int total, int* notifications) {
+    int checked = 0;
+    *notifications = 0;
+    for (int n = 0; n < total; n++) {
+        if (!encoder.append(history[n], (uint16_t)n, (uint16_t)(n * 40))) {
+            sendPending(encoder, decoder, history, &checked);
+            (*notifications)++;
+            TEST_ASSERT_TRUE(encoder.append(history[n], (uint16_t)n, (uint16_t)(n * 40)));
+        }
+        if (encoder.isFull()) {
+            sendPending(encoder, decoder, history, &checked);
+            (*notifications)++;
+        }
+    }
+    if (encoder.getCount() > 0) {
+        sendPending(encoder, decoder, history, &checked);
+        (*notifications)++;
+    }
+    TEST_ASSERT_EQUAL_INT(total, checked);
+}
+
+void test_delta_round_trip_and_ratio() {
+    static int16_t history[2000][6];
+    for (int n = 0; n < 2000; n++) {
+        quietSample(n, history[n]);
+    }
+
+    SensorDeltaEncoder encoder;
+    encoder.begin(0, 40000, SENSOR_DELTA_DEFAULT_KEYFRAME_INTERVAL);
+    SensorDeltaDecoder decoder;
+    int notifications = 0;
+    streamThrough(encoder, decoder, history, 2000, &notifications);
+
+    // Uncompressed batching needs ceil(2000 / SENSOR_STREAM_MAX_BATCH)
+    const int batched = (2000 + SENSOR_STREAM_MAX_BATCH - 1) / SENSOR_STREAM_MAX_BATCH;
+    char message[96];
+    snprintf(message, sizeof(message), "quiet data: %d batched vs %d compressed notifications",
+             batched, notifications);
+    TEST_MESSAGE(message);
+    TEST_ASSERT_TRUE(notifications * 18 <= batched * 10);  // >= 1.8x samples per notification
+}
+
+void test_delta_worst_case_deltas() {
+    // Full-scale swings every sample: 3-byte varints, still lossless
+    static int16_t history[200][6];
+    for (int n = 0; n < 200; n++) {
+        for (int axis = 0; axis < 6; axis++) {
+            history[n][axis] = (n + axis) % 2 ? 32767 : -32768;
+        }
+    }
+    SensorDeltaEncoder encoder;
+    encoder.begin(0, 10000, 2);
+    SensorDeltaDecoder decoder;
+    int notifications = 0;
+    streamThrough(encoder, decoder, history, 200, &notifications);
+    TEST_ASSERT_TRUE(notifications >= 200 / 12);
+}
+
+void test_delta_recovers_after_lost_notification() {
+    static int16_t history[600][6];
+    for (int n = 0; n < 600; n++) {
+        quietSample(n, history[n]);
+    }
+
+    SensorDeltaEncoder encoder;
+    encoder.begin(20, 40000, 3);
+    SensorDeltaDecoder decoder;
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+    StreamSample decoded[SENSOR_DELTA_MAX_SAMPLES];
+    int results[40];
+    int sent = 0;
+
+    for (int n = 0; n < 600 && sent < 40; n++) {
+        encoder.append(history[n], (uint16_t)n, 0);
+        if (encoder.isFull()) {
+            const size_t length = encoder.finish(notification);
+            // Notification 4 is lost; 5 continues from it, 6 is a keyframe
+            results[sent] = sent == 4 ? 0 : decoder.decode(notification, length, decoded,
+                                                           SENSOR_DELTA_MAX_SAMPLES);
+            if (results[sent] > 0) {
+                TEST_ASSERT_EQUAL_INT16_ARRAY(history[decoded[0].sequence], decoded[0].axes, 6);
+            }
+            sent++;
+        }
+    }
+
+    TEST_ASSERT_EQUAL_INT(20, results[3]);
+    TEST_ASSERT_EQUAL_INT(SENSOR_DECODE_NEED_KEYFRAME, results[5]);
+    TEST_ASSERT_EQUAL_INT(20, results[6]);  // Keyframe every 3rd notification
+    TEST_ASSERT_EQUAL_INT(20, results[7]);
+}
+
+void test_delta_sequence_gap_forces_keyframe() {
+    SensorDeltaEncoder encoder;
+    encoder.begin(0, 40000, 100);
+    int16_t axes[6] = {100, 200, 300, 400, 500, 600};
+    uint8_t notification[SENSOR_NOTIFY_MAX_SIZE];
+
+    encoder.append(axes, 1, 0);
+    encoder.finish(notification);
+    TEST_ASSERT_TRUE(notification[2] & SENSOR_DELTA_FLAG_KEYFRAME);
+
+    encoder.append(axes, 2, 0);
+    TEST_ASSERT_FALSE(encoder.canAppend(9));
+    TEST_ASSERT_FALSE(encoder.append(axes, 9, 0));
+    encoder.finish(notification);
+    TEST_ASSERT_FALSE(notification[2] & SENSOR_DELTA_FLAG_KEYFRAME);
+
+    encoder.append(axes, 9, 0);
+    const size_t length = encoder.finish(notification);
+    TEST_ASSERT_TRUE(notification[2] & SENSOR_DELTA_FLAG_KEYFRAME);
+
+    SensorDeltaDecoder decoder;
+    StreamSample decoded[4];
+    TEST_ASSERT_EQUAL_INT(1, decoder.decode(notification, length, decoded, 4));
+    TEST_ASSERT_EQUAL_INT16_ARRAY(axes, decoded[0].axes, 6);
+    notification[length - 1] ^= 0xFF;
+    TEST_ASSERT_EQUAL_INT(SENSOR_DECODE_CORRUPT, decoder.decode(notification, length, decoded, 4));
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_max_batch_fits_one_notification);
+    RUN_TEST(test_round_trip_full_batch);
+    RUN_TEST(test_sequence_gap_starts_new_batch);
+    RUN_TEST(test_fractional_interval_timestamps);
+    RUN_TEST(test_decoder_rejects_corruption);
+    RUN_TEST(test_delta_round_trip_and_ratio);
+    RUN_TEST(test_delta_worst_case_deltas);
+    RUN_TEST(test_delta_recovers_after_lost_notification);
+    RUN_TEST(test_delta_sequence_gap_forces_keyframe);
+    return UNITY_END();
+}
@@ -0,0 +1,120 @@
+#include <unity.h>
+#include <atomic>
+#include <thread>
+#include "spsc_ring.h"
+
+struct Item {
+    uint32_t sequence;
+    uint32_t check;  // ~sequence, catches torn copies
+};
+
+void test_fifo_order_and_empty() {
+    SpscRing<int, 8> ring;
+    int value = 0;
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_FALSE(ring.pop(value));
+
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    TEST_ASSERT_EQUAL_UINT32(5, ring.size());
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(i, value);
+    }
+    TEST_ASSERT_TRUE(ring.empty());
+}
+
+void test_full_ring_counts_overruns() {
+    SpscRing<int, 4> ring;
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+    }
+    TEST_ASSERT_FALSE(ring.push(99));
+    TEST_ASSERT_FALSE(ring.push(100));
+    TEST_ASSERT_EQUAL_UINT32(2, ring.getOverruns());
+
+    // The oldest items survive; the rejected ones are gone
+    int value = -1;
+    TEST_ASSERT_TRUE(ring.pop(value));
+    TEST_ASSERT_EQUAL_INT(0, value);
+    TEST_ASSERT_TRUE(ring.push(4));
+    for (int expected = 1; expected <= 4; expected++) {
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(expected, value);
+    }
+}
+
+void test_index_wraparound_and_clear() {
+    SpscRing<int, 4> ring;
+    int value = 0;
+    // Many laps around the 4-slot buffer
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_TRUE(ring.push(i));
+        TEST_ASSERT_TRUE(ring.push(i + 1));
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(i, value);
+        TEST_ASSERT_TRUE(ring.pop(value));
+        TEST_ASSERT_EQUAL_INT(i + 1, value);
+    }
+
+    ring.push(1);
+    ring.push(2);
+    ring.clear();
+    TEST_ASSERT_TRUE(ring.empty());
+    TEST_ASSERT_FALSE(ring.pop(value));
+    TEST_ASSERT_EQUAL_UINT32(0, ring.getOverruns());
+}
+
+void test_threaded_stress() {
+    static SpscRing<Item, 64> ring;
+    const uint32_t total = 2000000;
+    std::atomic<bool> producerDone(false);
+
+    std::thread producer([&]() {
+        for (uint32_t seq = 0; seq < total; seq++) {
+            Item item = {seq, ~seq};
+            ring.push(item);  // Drops (and counts) when the consumer lags
+        }
+        producerDone.store(true);
+    });
+
+    uint32_t received = 0;
+    uint32_t lastSequence = 0;
+    bool ordered = true;
+    bool intact = true;
+    std::thread consumer([&]() {
+        Item item;
+        while (true) {
+            if (ring.pop(item)) {
+                if (item.check != ~item.sequence) intact = false;
+                if (received > 0 && item.sequence <= lastSequence) ordered = false;
+                lastSequence = item.sequence;
+                received++;
+            } else if (producerDone.load()) {
+                if (ring.empty()) break;
+            }
+        }
+    });
+
+    producer.join();
+    consumer.join();
+
+    TEST_ASSERT_TRUE(intact);
+    TEST_ASSERT_TRUE(ordered);
+    // Every item was either delivered exactly once or counted as an overrun
+    TEST_ASSERT_EQUAL_UINT32(total, received + ring.getOverruns());
+    TEST_ASSERT_TRUE(received > 0);
+}
+
+int main(int argc, char** argv) {
+    (void)argc;
+    (void)argv;
+
+    UNITY_BEGIN();
+    RUN_TEST(test_fifo_order_and_empty);
+    RUN_TEST(test_full_ring_counts_overruns);
+    RUN_TEST(test_index_wraparound_and_clear);
+    RUN_TEST(test_threaded_stress);
+    return UNITY_END();
+}
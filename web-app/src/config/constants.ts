@@ -61,7 +61,31 @@ export const NN_INPUT_SIZE = 600; // 100 samples * 6 axes
 export const NN_HIDDEN_SIZE = 32; // Hidden layer neurons
 export const NN_MAX_CLASSES = 8; // Maximum gesture classes
 export const LABEL_MAX_LEN = 16; // Must match firmware LABEL_MAX_LEN
+export const NN_MAX_HEADS = 3; // Output heads sharing the hidden layer (1 primary + 2)
 export const SIMPLE_NN_MAGIC = 0x4e4e4e53; // "SNNN" in little-endian bytes
+export const SIMPLE_NN_HEADS_MAGIC = 0x484e4e53; // "SNNH": extra heads block after the model
+export const SIMPLE_NN_COMPACT_MAGIC = 0x434e4e53; // "SNNC": compact upload format
+export const SIMPLE_NN_PACKED_MAGIC = 0x5a4e4e53; // "SNNZ": range-coded upload
+export const SIMPLE_NN_DELTA_MAGIC = 0x444e4e53; // "SNND": patches against the model on the board
+export const COMPACT_MODEL_MIN_FIRMWARE = { major: 1, minor: 2 }; // First firmware that decodes it
+export const PACKED_MODEL_MIN_FIRMWARE = { major: 1, minor: 3 };
+export const SELECTIVE_REPEAT_MIN_FIRMWARE = { major: 1, minor: 4 }; // Out-of-order chunks + QUERY
+export const UPLOAD_CREDITS_MIN_FIRMWARE = { major: 1, minor: 5 }; // Flow-control trailer on model status
+export const DELTA_MODEL_MIN_FIRMWARE = { major: 1, minor: 7 };
+export const MODEL_UPLOAD_BLOCK_SIZE = 16; // Out-of-order chunk alignment (firmware config.h)
+
+// ============================================================================
+// Sensor Stream Formats (firmware/src/config.h, negotiated via config char)
+// ============================================================================
+export const SENSOR_STREAM = {
+  LEGACY: 0,  // One 17-byte packet per notification
+  BATCHED: 1, // [format, count, baseSeq, baseTs, intervalUs, N x 6 int16, crc8]
+  COMPRESSED: 2, // Batched zigzag-varint deltas with periodic keyframes
+  CONFIG_SIZE: 6,
+  CONFIG_FLAGS_SIZE: 7, // Firmware that also takes inference_flags (byte 6)
+  CONFIG_INFERENCE_TIMING: 0x01, // inference_flags: append the timing block
+  MAX_BATCH_MS: 200, // Samples per notification the host asks for, in time
+} as const;
 
 // ============================================================================
 // Sensor Scaling
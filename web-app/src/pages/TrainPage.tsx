@@ -12,7 +12,15 @@ import { useState, useEffect, useCallback, useMemo } from 'react';
 import { Sample, GestureLabel, TrainingProgress } from '../types';
 import { TrainingService } from '../services/trainingService';
 import { KidFeedback } from '../components/KidFeedback';
-import { exportForArduino, modelToSimpleNNBytes } from '../services/modelExportService';
+import {
+  exportForArduino,
+  modelToSimpleNNBytes,
+  supportsCompactModel,
+  supportsPackedModel,
+  supportsSelectiveRepeat,
+  supportsUploadCredits,
+  supportsDeltaModel,
+} from '../services/modelExportService';
 import { bleModelUploadService, UploadProgress } from '../services/bleModelUploadService';
 import { getBLEService } from '../services/bleService';
 import { IdleClassBanner } from '../components/IdleClassBanner';
@@ -180,7 +188,6 @@ export function TrainPage({
       const labelNames = labels.length === 1
         ? [...labels.map(l => l.name), 'Idle']
         : labels.map(l => l.name);
-      const modelBytes = modelToSimpleNNBytes(model, labelNames);
       const bleService = getBLEService();
       const server = bleService.getServer();
 
@@ -188,13 +195,27 @@ export function TrainPage({
         throw new Error('Not connected to Arduino. Please connect via Bluetooth first.');
       }
 
+      // Newer firmware takes a smaller upload: without the unused class
+      // slots, then range-coded, or only what changed since the last one
+      const deviceInfo = await bleService.getDeviceInfo().catch(() => null);
+      const fullModel = modelToSimpleNNBytes(model, labelNames);
+      const modelBytes = modelToSimpleNNBytes(model, labelNames, {
+        compact: supportsCompactModel(deviceInfo),
+        packed: supportsPackedModel(deviceInfo),
+      });
+
       const initialized = await bleModelUploadService.initialize(server);
       if (!initialized) {
         throw new Error('Failed to initialize model upload. Make sure your Arduino firmware supports OTA model updates.');
       }
 
-      await bleModelUploadService.uploadModel(modelBytes, labelNames, (progress) => {
+      await bleModelUploadService.uploadModelUpdate(fullModel, modelBytes, labelNames, (progress) => {
         setUploadProgress(progress);
+      }, {
+        selectiveRepeat: supportsSelectiveRepeat(deviceInfo),
+        credits: supportsUploadCredits(deviceInfo),
+        delta: supportsDeltaModel(deviceInfo),
+        packed: supportsPackedModel(deviceInfo),
       });
       addBadge('edge-engineer');
 
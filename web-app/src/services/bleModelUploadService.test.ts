@@ -0,0 +1,393 @@
+/**
+ * Tests for the model upload protocol against a fake Arduino
+ */
+import { describe, it, expect, vi, beforeEach, afterEach } from 'vitest';
+import { BLEModelUploadService, ModelInUseError, parseModelStatus } from './bleModelUploadService';
+import { BLE_UUIDS, MODEL_UPLOAD_BLOCK_SIZE } from '../config/constants';
+
+const STATUS_RECEIVING = 1;
+const STATUS_SAVING = 3;
+const STATUS_SUCCESS = 4;
+const STATUS_ERROR_SIZE = 10;
+const STATUS_ERROR_BASE = 14;
+const STATUS_ERROR_IN_USE = 15;
+
+const PROCESS_MS = 5; // Fake loop: one queued write per pass
+
+// Keeps which bytes arrived and answers QUERY like firmware 1.4
+// (flash_storage.cpp getMissingUploadRanges, without the window limit).
+// With queueDepth it is firmware 1.5: writes wait in a queue of that depth
+// and every status carries the credit trailer.
+class FakeArduino {
+  received: Uint8Array = new Uint8Array(0);
+  data: Uint8Array = new Uint8Array(0);
+  status = new Uint8Array([0, 0, 0, 0]);
+  unacknowledgedWrites = 0;
+  acknowledgedChunks = 0;
+  queries = 0;
+  starts = 0;
+  refuseDeltas = false;
+  inUse = false; // Refuses START (inference on, no flash copy)
+  saveBeforeStartMs = 0; // Saves the running model before START takes effect
+  chunksWhileSaving = 0;
+  overruns = 0;
+  maxQueued = 0;
+  private queue: Uint8Array[] = [];
+  private writesDone = 0;
+  private listeners: Array<(event: Event) => void> = [];
+
+  constructor(
+    private dropEvery = 0,
+    private queueDepth = 0,
+  ) {}
+
+  uploadChar = {
+    writeValueWithResponse: async (value: Uint8Array) => {
+      if (value[0] === 0x02) this.acknowledgedChunks++;
+      this.receive(value);
+    },
+    writeValueWithoutResponse: async (value: Uint8Array) => {
+      this.unacknowledgedWrites++;
+      if (this.dropEvery > 0 && this.unacknowledgedWrites % this.dropEvery === 0) {
+        return; // Lost: overwritten before the loop polled it
+      }
+      this.receive(value);
+    },
+  };
+
+  statusChar = {
+    readValue: async () => new DataView(this.status.slice().buffer),
+    startNotifications: async () => {},
+    addEventListener: (_type: string, listener: (event: Event) => void) => {
+      this.listeners.push(listener);
+    },
+  };
+
+  server = {
+    getPrimaryService: async () => ({
+      getCharacteristic: async (uuid: string) =>
+        uuid === BLE_UUIDS.MODEL_UPLOAD ? this.uploadChar : this.statusChar,
+    }),
+  };
+
+  private receive(value: Uint8Array) {
+    if (this.queueDepth === 0) {
+      this.handle(value);
+      return;
+    }
+    if (this.queue.length === this.queueDepth) {
+      this.overruns++;
+      this.writesDone++;
+      return;
+    }
+    this.queue.push(value.slice());
+    this.maxQueued = Math.max(this.maxQueued, this.queue.length);
+    if (this.queue.length === 1) {
+      setTimeout(() => this.processQueued(), PROCESS_MS);
+    }
+  }
+
+  private processQueued() {
+    const value = this.queue.shift()!;
+    if (value[0] === 0x01) {
+      this.writesDone = 0;
+    } else {
+      this.writesDone++;
+    }
+    this.handle(value);
+    if (this.queue.length > 0) {
+      setTimeout(() => this.processQueued(), PROCESS_MS);
+    }
+  }
+
+  private frontier(): number {
+    const missing = this.received.indexOf(0);
+    return missing < 0 ? this.received.length : missing;
+  }
+
+  private setStatus(statusCode: number, ranges: Array<[number, number]> = []) {
+    const trailer = 4 + 8 * ranges.length;
+    const status = new Uint8Array(trailer + (this.queueDepth > 0 ? 4 : 0));
+    const view = new DataView(status.buffer);
+    status[0] = 1;
+    status[1] = Math.floor((this.frontier() * 100) / this.received.length);
+    status[2] = statusCode;
+    status[3] = ranges.length;
+    ranges.forEach(([offset, length], i) => {
+      view.setUint32(4 + 8 * i, offset, true);
+      view.setUint32(8 + 8 * i, length, true);
+    });
+    if (this.queueDepth > 0) {
+      status[trailer] = this.queueDepth;
+      view.setUint16(trailer + 2, this.writesDone & 0xffff, true);
+    }
+    this.status = status;
+    const event = { target: { value: new DataView(status.slice().buffer) } } as unknown as Event;
+    this.listeners.forEach((listener) => listener(event));
+  }
+
+  private handle(value: Uint8Array) {
+    const view = new DataView(value.buffer, value.byteOffset, value.byteLength);
+    switch (value[0]) {
+      case 0x01:
+        this.starts++;
+        if (this.inUse) {
+          this.setStatus(STATUS_ERROR_IN_USE);
+          break;
+        }
+        this.received = new Uint8Array(view.getUint32(1, true));
+        this.data = new Uint8Array(this.received.length);
+        if (this.saveBeforeStartMs > 0) {
+          this.setStatus(STATUS_SAVING);
+          setTimeout(() => this.setStatus(STATUS_RECEIVING), this.saveBeforeStartMs);
+          break;
+        }
+        this.setStatus(STATUS_RECEIVING);
+        break;
+      case 0x02: {
+        if (this.status[2] === STATUS_SAVING) this.chunksWhileSaving++;
+        const offset = view.getUint32(1, true);
+        const chunk = value.slice(5);
+        // Ahead of the frontier only block-aligned chunks are accepted
+        if (offset > this.frontier() && offset % MODEL_UPLOAD_BLOCK_SIZE !== 0) {
+          this.setStatus(13);
+          break;
+        }
+        this.data.set(chunk, offset);
+        this.received.fill(1, offset, offset + chunk.length);
+        this.setStatus(STATUS_RECEIVING);
+        break;
+      }
+      case 0x03:
+        if (this.refuseDeltas && new TextDecoder().decode(this.data.slice(0, 4)) === 'SNND') {
+          this.setStatus(STATUS_ERROR_BASE);
+          break;
+        }
+        this.setStatus(this.frontier() === this.received.length ? STATUS_SUCCESS : STATUS_ERROR_SIZE);
+        break;
+      case 0x05: {
+        this.queries++;
+        const ranges: Array<[number, number]> = [];
+        let start = -1;
+        for (let i = 0; i <= this.received.length && ranges.length < 8; i++) {
+          const have = i === this.received.length || this.received[i] === 1;
+          if (!have && start < 0) start = i;
+          if (have && start >= 0) {
+            ranges.push([start, i - start]);
+            start = -1;
+          }
+        }
+        this.setStatus(STATUS_RECEIVING, ranges);
+        break;
+      }
+    }
+  }
+}
+
+async function connect(service: BLEModelUploadService, arduino: FakeArduino) {
+  expect(
+    await service.initialize(arduino.server as unknown as BluetoothRemoteGATTServer),
+  ).toBe(true);
+}
+
+function modelBytes(length: number): Uint8Array {
+  const bytes = new Uint8Array(length);
+  for (let i = 0; i < length; i++) bytes[i] = (i * 31 + 7) & 0xff;
+  return bytes;
+}
+
+async function upload(
+  service: BLEModelUploadService,
+  bytes: Uint8Array,
+  selectiveRepeat: boolean,
+  credits = false,
+): Promise<boolean> {
+  const result = service.uploadModel(bytes, ['A', 'B'], undefined, { selectiveRepeat, credits });
+  const settled = result.catch(() => false);
+  await vi.runAllTimersAsync();
+  await settled;
+  return result;
+}
+
+describe('BLEModelUploadService', () => {
+  beforeEach(() => {
+    vi.useFakeTimers();
+    vi.spyOn(console, 'log').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    vi.useRealTimers();
+    vi.restoreAllMocks();
+  });
+
+  it('acknowledges every chunk for older firmware', async () => {
+    const arduino = new FakeArduino();
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const bytes = modelBytes(1000);
+
+    expect(await upload(service, bytes, false)).toBe(true);
+    expect(arduino.unacknowledgedWrites).toBe(0);
+    expect(arduino.acknowledgedChunks).toBe(Math.ceil(1000 / 155));
+    expect(arduino.queries).toBe(0);
+  });
+
+  it('resends what was lost without acknowledgements', async () => {
+    const arduino = new FakeArduino(5);
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const bytes = modelBytes(20000);
+
+    expect(await upload(service, bytes, true)).toBe(true);
+    expect(Array.from(arduino.data)).toEqual(Array.from(bytes));
+    expect(arduino.acknowledgedChunks).toBe(0);
+    expect(arduino.queries).toBeGreaterThan(1);
+  });
+
+  it('asks once when nothing was lost', async () => {
+    const arduino = new FakeArduino();
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+
+    expect(await upload(service, modelBytes(5000), true)).toBe(true);
+    expect(arduino.queries).toBe(1);
+  });
+
+  it('keeps no more writes in flight than the credits allow', async () => {
+    const arduino = new FakeArduino(0, 4);
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const bytes = modelBytes(10000);
+
+    expect(await upload(service, bytes, true, true)).toBe(true);
+    expect(Array.from(arduino.data)).toEqual(Array.from(bytes));
+    expect(arduino.overruns).toBe(0);
+    expect(arduino.maxQueued).toBe(4);
+    expect(arduino.queries).toBe(1);
+  });
+
+  it('waits while the Arduino saves the running model before starting', async () => {
+    const arduino = new FakeArduino();
+    arduino.saveBeforeStartMs = 2500;
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const bytes = modelBytes(5000);
+
+    expect(await upload(service, bytes, true)).toBe(true);
+    expect(arduino.chunksWhileSaving).toBe(0);
+    expect(Array.from(arduino.data)).toEqual(Array.from(bytes));
+  });
+});
+
+describe('uploadModelUpdate', () => {
+  beforeEach(() => {
+    vi.useFakeTimers();
+    vi.spyOn(console, 'log').mockImplementation(() => {});
+    vi.spyOn(console, 'warn').mockImplementation(() => {});
+  });
+
+  afterEach(() => {
+    vi.useRealTimers();
+    vi.restoreAllMocks();
+  });
+
+  async function update(service: BLEModelUploadService, model: Uint8Array): Promise<boolean> {
+    const result = service.uploadModelUpdate(model, model, ['A', 'B'], undefined, {
+      selectiveRepeat: true,
+      delta: true,
+    });
+    const settled = result.catch(() => false);
+    await vi.runAllTimersAsync();
+    await settled;
+    return result;
+  }
+
+  it('sends only the changes after the first upload', async () => {
+    const arduino = new FakeArduino();
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const first = modelBytes(20000);
+
+    expect(await update(service, first)).toBe(true);
+    expect(Array.from(arduino.data)).toEqual(Array.from(first));
+
+    const second = first.slice();
+    second.fill(0x5a, 19000, 19100);
+    expect(await update(service, second)).toBe(true);
+    expect(arduino.starts).toBe(2);
+    expect(arduino.data.length).toBeLessThan(200);
+    expect(new TextDecoder().decode(arduino.data.slice(0, 4))).toBe('SNND');
+  });
+
+  it('falls back to the whole model when the delta is refused', async () => {
+    const arduino = new FakeArduino();
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const first = modelBytes(20000);
+    expect(await update(service, first)).toBe(true);
+
+    // Another model was uploaded to the board in the meantime
+    arduino.refuseDeltas = true;
+    const second = first.slice();
+    second[100] ^= 0xff;
+    expect(await update(service, second)).toBe(true);
+    expect(arduino.starts).toBe(3);
+    expect(Array.from(arduino.data)).toEqual(Array.from(second));
+  });
+
+  it('does not retry a START refused while inference runs', async () => {
+    const arduino = new FakeArduino();
+    const service = new BLEModelUploadService();
+    await connect(service, arduino);
+    const first = modelBytes(20000);
+    expect(await update(service, first)).toBe(true);
+
+    arduino.inUse = true;
+    vi.spyOn(console, 'error').mockImplementation(() => {});
+    const second = first.slice();
+    second[100] ^= 0xff;
+    const result = service.uploadModelUpdate(second, second, ['A', 'B'], undefined, {
+      selectiveRepeat: true,
+      delta: true,
+    });
+    const rejected = expect(result).rejects.toBeInstanceOf(ModelInUseError);
+    await vi.runAllTimersAsync();
+    await rejected;
+    expect(arduino.starts).toBe(2);
+  });
+});
+
+describe('parseModelStatus', () => {
+  it('reads a plain status and a QUERY reply', () => {
+    expect(parseModelStatus(new DataView(new Uint8Array([1, 42, 1, 0]).buffer))).toEqual({
+      state: 1,
+      progress: 42,
+      statusCode: 1,
+      missing: [],
+      credits: 0,
+      writesDone: 0,
+    });
+
+    const reply = new DataView(new ArrayBuffer(4 + 16));
+    reply.setUint8(3, 2);
+    reply.setUint32(4, 288, true);
+    reply.setUint32(8, 144, true);
+    reply.setUint32(12, 4384, true);
+    reply.setUint32(16, 1000, true);
+    expect(parseModelStatus(reply).missing).toEqual([
+      { offset: 288, length: 144 },
+      { offset: 4384, length: 1000 },
+    ]);
+  });
+
+  it('reads the credit trailer after any ranges', () => {
+    const status = new DataView(new ArrayBuffer(4 + 8 + 4));
+    status.setUint8(3, 1);
+    status.setUint8(12, 16);
+    status.setUint16(14, 300, true);
+    const parsed = parseModelStatus(status);
+    expect(parsed.missing).toHaveLength(1);
+    expect(parsed.credits).toBe(16);
+    expect(parsed.writesDone).toBe(300);
+  });
+});
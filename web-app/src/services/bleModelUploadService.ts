@@ -11,17 +11,35 @@
  * See firmware/docs/NEURAL_NETWORK_BASICS.md for how the neural network works.
  */
 
-import { BLE_UUIDS, LABEL_MAX_LEN, NN_MAX_CLASSES } from "../config/constants";
-import { calculateCrc32 } from "./modelExportService";
+import {
+  BLE_UUIDS,
+  LABEL_MAX_LEN,
+  MODEL_UPLOAD_BLOCK_SIZE,
+  NN_MAX_CLASSES,
+  SIMPLE_NN_DELTA_MAGIC,
+  SIMPLE_NN_PACKED_MAGIC,
+} from "../config/constants";
+import { calculateCrc32, encodeModelDelta, packModelBytes } from "./modelExportService";
 
 // Model upload control commands (must match firmware)
 const MODEL_CMD_START = 0x01;
 const MODEL_CMD_CHUNK = 0x02;
 const MODEL_CMD_COMPLETE = 0x03;
 const MODEL_CMD_CANCEL = 0x04;
+const MODEL_CMD_QUERY = 0x05; // Firmware 1.4+: reply lists missing ranges
 
 // Upload status subcodes
+const STATUS_VALIDATING = 0x02;
+const STATUS_SAVING = 0x03;
 const STATUS_SUCCESS = 0x04;
+const STATUS_ERROR_FLASH = 0x0c; // Model runs, but was not saved to flash
+const STATUS_ERROR_IN_USE = 0x0f; // Inference would stop for the upload
+
+// Saving to flash erases ~20 pages; give it time before giving up. START
+// can wait on the same save, when the running model has no copy in flash to
+// keep predicting from during the upload.
+const FINISH_TIMEOUT_MS = 10000;
+const FINISH_POLL_INTERVAL_MS = 250;
 
 // BLE characteristic max write size.
 // Keep this below MTU edge cases to avoid controller/library fragmentation quirks.
@@ -30,6 +48,21 @@ const MAX_CHUNK_SIZE = 160;
 // How many chunks between status checks (fail fast on errors)
 const STATUS_CHECK_INTERVAL = 50;
 
+// Selective repeat (firmware 1.4+): chunks go out without write
+// acknowledgements, block aligned so the Arduino can hold them out of
+// order; whatever got lost is asked for with QUERY and sent again
+const SELECTIVE_CHUNK_DATA_SIZE =
+  Math.floor((MAX_CHUNK_SIZE - 5) / MODEL_UPLOAD_BLOCK_SIZE) * MODEL_UPLOAD_BLOCK_SIZE;
+const SELECTIVE_WRITE_INTERVAL_MS = 20;
+const QUERY_REPLY_DELAY_MS = 100;
+const QUERY_READ_ATTEMPTS = 5;
+const MAX_RESEND_ROUNDS = 20;
+
+// Credits (firmware 1.5+): every status update says how many upload writes
+// may be in flight; writes go out as fast as those credits come back
+const CREDIT_POLL_MS = 2;
+const CREDIT_WAIT_MS = 1000; // Then read the status, and send regardless
+
 export interface UploadProgress {
   state: "idle" | "starting" | "uploading" | "completing" | "success" | "error";
   progress: number;
@@ -40,10 +73,89 @@ export interface UploadProgress {
 
 export type UploadProgressCallback = (progress: UploadProgress) => void;
 
+/**
+ * The Arduino refused START: it is running inference and has no copy of the
+ * model to keep predicting from while the upload overwrites it. Stop
+ * inference and upload again.
+ */
+export class ModelInUseError extends Error {
+  constructor() {
+    super("Stop inference before uploading: this Arduino cannot keep the current model running during an upload");
+    this.name = "ModelInUseError";
+  }
+}
+
+export interface UploadOptions {
+  /** Firmware supports out-of-order chunks and QUERY (supportsSelectiveRepeat) */
+  selectiveRepeat?: boolean;
+  /** Firmware advertises upload credits (supportsUploadCredits); needs selectiveRepeat */
+  credits?: boolean;
+}
+
+export interface UpdateOptions extends UploadOptions {
+  /** Firmware patches the model it holds (supportsDeltaModel) */
+  delta?: boolean;
+  /** Firmware unpacks packed payloads (supportsPackedModel) */
+  packed?: boolean;
+}
+
+export interface MissingRange {
+  offset: number;
+  length: number;
+}
+
+export interface ModelStatus {
+  state: number;
+  progress: number;
+  statusCode: number;
+  missing: MissingRange[]; // Only filled in a QUERY reply
+  credits: number; // Writes allowed in flight; 0 before firmware 1.5
+  writesDone: number; // Upload writes since START handled (wraps at 2^16)
+}
+
+/**
+ * Parse a model status value: [state, progress, status, count,
+ * (offset u32, length u32) x count], then from firmware 1.5 the credit
+ * trailer [credits, reserved, writesDone u16]. Plain status updates have
+ * count 0.
+ */
+export function parseModelStatus(value: DataView): ModelStatus {
+  const count = value.byteLength >= 4 ? value.getUint8(3) : 0;
+  const missing: MissingRange[] = [];
+  for (let i = 0; i < count && 4 + 8 * (i + 1) <= value.byteLength; i++) {
+    missing.push({
+      offset: value.getUint32(4 + 8 * i, true),
+      length: value.getUint32(8 + 8 * i, true),
+    });
+  }
+  const trailer = 4 + 8 * count;
+  const hasCredits = value.byteLength >= trailer + 4;
+  return {
+    state: value.getUint8(0),
+    progress: value.getUint8(1),
+    statusCode: value.getUint8(2),
+    missing,
+    credits: hasCredits ? value.getUint8(trailer) : 0,
+    writesDone: hasCredits ? value.getUint16(trailer + 2, true) : 0,
+  };
+}
+
 export class BLEModelUploadService {
   private modelUploadChar: BluetoothRemoteGATTCharacteristic | null = null;
   private modelStatusChar: BluetoothRemoteGATTCharacteristic | null = null;
   private isUploading = false;
+  private useCredits = false;
+  private writesSinceStart = 0;
+  private latestStatus: ModelStatus | null = null;
+  // weightsToBytes() layout of the last model deployed: the base for a delta
+  private deployedModel: Uint8Array | null = null;
+
+  private onStatusChanged = (event: Event) => {
+    const target = event.target as BluetoothRemoteGATTCharacteristic;
+    if (target.value) {
+      this.latestStatus = parseModelStatus(target.value);
+    }
+  };
 
   async initialize(server: BluetoothRemoteGATTServer): Promise<boolean> {
     try {
@@ -58,6 +170,18 @@ export class BLEModelUploadService {
         BLE_UUIDS.MODEL_STATUS,
       );
 
+      // Credits arrive with status notifications; without them the status
+      // is read when the credits run out
+      try {
+        await this.modelStatusChar.startNotifications();
+        this.modelStatusChar.addEventListener(
+          "characteristicvaluechanged",
+          this.onStatusChanged,
+        );
+      } catch (error) {
+        console.warn("Model status notifications unavailable:", error);
+      }
+
       console.log("Model upload service initialized");
       return true;
     } catch (error) {
@@ -76,11 +200,13 @@ export class BLEModelUploadService {
    * @param modelData - SimpleNN weight data as Uint8Array
    * @param classLabels - Array of class label names
    * @param onProgress - Callback for upload progress updates
+   * @param options - What the connected firmware supports
    */
   async uploadModel(
     modelData: Uint8Array,
     classLabels: string[] = [],
     onProgress?: UploadProgressCallback,
+    options: UploadOptions = {},
   ): Promise<boolean> {
     if (!this.isReady()) {
       throw new Error("Upload service not initialized");
@@ -91,6 +217,8 @@ export class BLEModelUploadService {
     }
 
     this.isUploading = true;
+    this.useCredits = Boolean(options.selectiveRepeat && options.credits);
+    this.latestStatus = null;
     const totalBytes = modelData.length;
 
     const reportProgress = (
@@ -118,8 +246,17 @@ export class BLEModelUploadService {
       const last16Hex = Array.from(modelData.slice(Math.max(0, modelData.length - 16)))
         .map((b) => b.toString(16).padStart(2, "0"))
         .join(" ");
+      // Full and compact payloads carry numClasses after the magic; a
+      // packed payload has its unpacked size there instead, a delta its
+      // base CRC
+      const payloadMagic =
+        modelData.length >= 4
+          ? (modelData[0] | (modelData[1] << 8) | (modelData[2] << 16) | (modelData[3] << 24)) >>> 0
+          : 0;
       const payloadNumClasses =
-        modelData.length >= 8
+        modelData.length >= 8 &&
+        payloadMagic !== SIMPLE_NN_PACKED_MAGIC &&
+        payloadMagic !== SIMPLE_NN_DELTA_MAGIC
           ? (modelData[4] |
               (modelData[5] << 8) |
               (modelData[6] << 16) |
@@ -139,8 +276,18 @@ export class BLEModelUploadService {
       console.log("START command sent");
       await this.delay(300);
 
-      // Verify the Arduino accepted the START command
-      const startStatus = await this.readStatus();
+      // Verify the Arduino accepted the START command. It may save the
+      // running model to flash first, to serve it from there meanwhile.
+      let startStatus = await this.readStatus();
+      const startDeadline = Date.now() + FINISH_TIMEOUT_MS;
+      while (startStatus.statusCode === STATUS_SAVING && Date.now() < startDeadline) {
+        reportProgress("starting", 0, "Saving the current model so it keeps running...");
+        await this.delay(FINISH_POLL_INTERVAL_MS);
+        startStatus = await this.readStatus();
+      }
+      if (startStatus.statusCode === STATUS_ERROR_IN_USE) {
+        throw new ModelInUseError();
+      }
       if (startStatus.statusCode >= 10) {
         throw new Error(
           `Arduino rejected upload start (status: ${startStatus.statusCode})`,
@@ -149,34 +296,14 @@ export class BLEModelUploadService {
 
       // Step 2: Send model data in chunks
       reportProgress("uploading", 0, "Uploading neural network weights...");
-      let offset = 0;
-      let chunkCount = 0;
-      const dataChunkSize = MAX_CHUNK_SIZE - 5;
-
-      while (offset < totalBytes) {
-        const remaining = totalBytes - offset;
-        const chunkSize = Math.min(dataChunkSize, remaining);
-        const chunk = modelData.slice(offset, offset + chunkSize);
-
-        await this.sendChunkCommand(offset, chunk);
-        offset += chunkSize;
-        chunkCount++;
-
-        const pct = Math.round((offset / totalBytes) * 100);
-        reportProgress("uploading", offset, `Uploading... ${pct}%`);
-
-        // Periodic status check to fail fast on errors
-        if (chunkCount % STATUS_CHECK_INTERVAL === 0) {
-          await this.delay(50);
-          const midStatus = await this.readStatus();
-          if (midStatus.statusCode >= 10) {
-            throw new Error(
-              `Upload failed at chunk ${chunkCount} (status: ${midStatus.statusCode})`,
-            );
-          }
-        }
-
-        await this.delay(100);
+      const onSent = (bytesSent: number) => {
+        const pct = Math.round((bytesSent / totalBytes) * 100);
+        reportProgress("uploading", bytesSent, `Uploading... ${pct}%`);
+      };
+      if (options.selectiveRepeat) {
+        await this.sendChunksSelectiveRepeat(modelData, onSent);
+      } else {
+        await this.sendChunksInOrder(modelData, onSent);
       }
 
       console.log("All weight data sent");
@@ -188,7 +315,18 @@ export class BLEModelUploadService {
 
       await this.delay(1000);
 
-      const status = await this.readStatus();
+      // The Arduino validates, then saves the model to flash
+      let status = await this.readStatus();
+      const finishDeadline = Date.now() + FINISH_TIMEOUT_MS;
+      while (
+        (status.statusCode === STATUS_VALIDATING ||
+          status.statusCode === STATUS_SAVING) &&
+        Date.now() < finishDeadline
+      ) {
+        reportProgress("completing", totalBytes, "Saving model on the Arduino...");
+        await this.delay(FINISH_POLL_INTERVAL_MS);
+        status = await this.readStatus();
+      }
       console.log("Final status:", status);
 
       if (status.statusCode === STATUS_SUCCESS) {
@@ -198,6 +336,13 @@ export class BLEModelUploadService {
           "Model deployed! Your Arduino is now smart! ",
         );
         return true;
+      } else if (status.statusCode === STATUS_ERROR_FLASH) {
+        reportProgress(
+          "success",
+          totalBytes,
+          "Model deployed, but it could not be saved: upload again after unplugging the Arduino.",
+        );
+        return true;
       } else {
         throw new Error(`Upload failed with status code: ${status.statusCode}`);
       }
@@ -218,6 +363,51 @@ export class BLEModelUploadService {
     }
   }
 
+  /**
+   * Deploy a model, sending only what changed since the last one when the
+   * firmware takes deltas
+   *
+   * The Arduino identifies the base by its CRC and refuses a delta for any
+   * other model (another board, a model uploaded elsewhere), so a failed
+   * delta is followed by the whole upload.
+   *
+   * @param fullModel - weightsToBytes() layout of the model to deploy
+   * @param modelData - Payload for a whole upload (full, compact or packed)
+   */
+  async uploadModelUpdate(
+    fullModel: Uint8Array,
+    modelData: Uint8Array,
+    classLabels: string[] = [],
+    onProgress?: UploadProgressCallback,
+    options: UpdateOptions = {},
+  ): Promise<boolean> {
+    const base = this.deployedModel;
+    if (options.delta && base) {
+      const delta = encodeModelDelta(base, fullModel);
+      const payload = options.packed ? packModelBytes(delta) : delta;
+      if (payload.length < modelData.length) {
+        try {
+          // A refused delta is not an error to show: the full upload follows
+          const deltaProgress = (progress: UploadProgress) => {
+            if (progress.state !== "error") onProgress?.(progress);
+          };
+          await this.uploadModel(payload, classLabels, deltaProgress, options);
+          this.deployedModel = fullModel;
+          return true;
+        } catch (error) {
+          // The whole model would be refused just the same
+          if (error instanceof ModelInUseError) throw error;
+          console.warn("Delta upload failed, sending the whole model:", error);
+        }
+      }
+    }
+
+    this.deployedModel = null;
+    await this.uploadModel(modelData, classLabels, onProgress, options);
+    this.deployedModel = fullModel;
+    return true;
+  }
+
   async cancelUpload(): Promise<void> {
     if (this.modelUploadChar) {
       await this.sendCancelCommand();
@@ -225,6 +415,133 @@ export class BLEModelUploadService {
     this.isUploading = false;
   }
 
+  /**
+   * One acknowledged write per chunk, strictly in order (any firmware)
+   */
+  private async sendChunksInOrder(
+    modelData: Uint8Array,
+    onSent: (bytesSent: number) => void,
+  ): Promise<void> {
+    const totalBytes = modelData.length;
+    let offset = 0;
+    let chunkCount = 0;
+    const dataChunkSize = MAX_CHUNK_SIZE - 5;
+
+    while (offset < totalBytes) {
+      const remaining = totalBytes - offset;
+      const chunkSize = Math.min(dataChunkSize, remaining);
+      const chunk = modelData.slice(offset, offset + chunkSize);
+
+      await this.sendChunkCommand(offset, chunk);
+      offset += chunkSize;
+      chunkCount++;
+      onSent(offset);
+
+      // Periodic status check to fail fast on errors
+      if (chunkCount % STATUS_CHECK_INTERVAL === 0) {
+        await this.delay(50);
+        const midStatus = await this.readStatus();
+        if (midStatus.statusCode >= 10) {
+          throw new Error(
+            `Upload failed at chunk ${chunkCount} (status: ${midStatus.statusCode})`,
+          );
+        }
+      }
+
+      await this.delay(100);
+    }
+  }
+
+  /**
+   * Unacknowledged writes, then QUERY / resend rounds until the Arduino
+   * has every byte (firmware 1.4+)
+   */
+  private async sendChunksSelectiveRepeat(
+    modelData: Uint8Array,
+    onSent: (bytesSent: number) => void,
+  ): Promise<void> {
+    await this.sendRange(modelData, 0, modelData.length, onSent);
+
+    for (let round = 0; round < MAX_RESEND_ROUNDS; round++) {
+      const missing = await this.queryMissingRanges();
+      if (missing.length === 0) {
+        return;
+      }
+      const missingBytes = missing.reduce((sum, range) => sum + range.length, 0);
+      console.log(`Resend round ${round + 1}: ${missing.length} ranges, ${missingBytes} bytes`);
+      for (const range of missing) {
+        await this.sendRange(modelData, range.offset, range.offset + range.length);
+      }
+    }
+    throw new Error(`Upload incomplete after ${MAX_RESEND_ROUNDS} resend rounds`);
+  }
+
+  private async sendRange(
+    modelData: Uint8Array,
+    start: number,
+    end: number,
+    onSent?: (bytesSent: number) => void,
+  ): Promise<void> {
+    for (let offset = start; offset < end; offset += SELECTIVE_CHUNK_DATA_SIZE) {
+      const chunkEnd = Math.min(offset + SELECTIVE_CHUNK_DATA_SIZE, end, modelData.length);
+      await this.sendChunkCommand(offset, modelData.slice(offset, chunkEnd), false);
+      onSent?.(chunkEnd);
+      if (!this.useCredits) {
+        await this.delay(SELECTIVE_WRITE_INTERVAL_MS);
+      }
+    }
+  }
+
+  /**
+   * Wait until fewer writes are in flight than the Arduino has credits for.
+   * If no credit comes back in time, send anyway: a write the Arduino has
+   * to drop shows up in the next QUERY.
+   */
+  private async waitForCredit(): Promise<void> {
+    const deadline = Date.now() + CREDIT_WAIT_MS;
+    for (;;) {
+      const status = this.latestStatus;
+      if (status && status.statusCode >= 10) {
+        throw new Error(`Upload failed (status: ${status.statusCode})`);
+      }
+      if (
+        status &&
+        status.credits > 0 &&
+        ((this.writesSinceStart - status.writesDone) & 0xffff) < status.credits
+      ) {
+        return;
+      }
+      if (Date.now() >= deadline) {
+        await this.readStatus();
+        return;
+      }
+      await this.delay(CREDIT_POLL_MS);
+    }
+  }
+
+  /**
+   * Ask for the ranges still missing; empty once the upload is complete.
+   * Until the Arduino has handled the QUERY the status still holds a plain
+   * chunk update (no ranges, progress below 100), so read again.
+   */
+  private async queryMissingRanges(): Promise<MissingRange[]> {
+    await this.writeUpload(new Uint8Array([MODEL_CMD_QUERY]));
+    for (let attempt = 0; attempt < QUERY_READ_ATTEMPTS; attempt++) {
+      await this.delay(QUERY_REPLY_DELAY_MS);
+      const status = await this.readStatus();
+      if (status.statusCode >= 10) {
+        throw new Error(`Upload failed (status: ${status.statusCode})`);
+      }
+      if (status.missing.length > 0) {
+        return status.missing;
+      }
+      if (status.progress === 100) {
+        return [];
+      }
+    }
+    throw new Error("Arduino did not report the missing upload ranges");
+  }
+
   private async sendStartCommand(
     modelSize: number,
     crc32: number,
@@ -261,11 +578,13 @@ export class BLEModelUploadService {
     data.set(labelsBytes, 10);
 
     await this.modelUploadChar!.writeValueWithResponse(data);
+    this.writesSinceStart = 0; // The Arduino counts writes after START
   }
 
   private async sendChunkCommand(
     offset: number,
     chunk: Uint8Array,
+    withResponse = true,
   ): Promise<void> {
     const data = new Uint8Array(5 + chunk.length);
     data[0] = MODEL_CMD_CHUNK;
@@ -277,12 +596,25 @@ export class BLEModelUploadService {
 
     data.set(chunk, 5);
 
-    await this.modelUploadChar!.writeValueWithResponse(data);
+    await this.writeUpload(data, withResponse);
   }
 
   private async sendCompleteCommand(): Promise<void> {
     const data = new Uint8Array([MODEL_CMD_COMPLETE]);
-    await this.modelUploadChar!.writeValueWithResponse(data);
+    await this.writeUpload(data);
+  }
+
+  // Every write after START uses one of the Arduino's credits
+  private async writeUpload(data: Uint8Array, withResponse = true): Promise<void> {
+    if (this.useCredits) {
+      await this.waitForCredit();
+    }
+    this.writesSinceStart = (this.writesSinceStart + 1) & 0xffff;
+    if (withResponse) {
+      await this.modelUploadChar!.writeValueWithResponse(data);
+    } else {
+      await this.modelUploadChar!.writeValueWithoutResponse(data);
+    }
   }
 
   private async sendCancelCommand(): Promise<void> {
@@ -290,17 +622,9 @@ export class BLEModelUploadService {
     await this.modelUploadChar!.writeValueWithResponse(data);
   }
 
-  private async readStatus(): Promise<{
-    state: number;
-    progress: number;
-    statusCode: number;
-  }> {
-    const value = await this.modelStatusChar!.readValue();
-    return {
-      state: value.getUint8(0),
-      progress: value.getUint8(1),
-      statusCode: value.getUint8(2),
-    };
+  private async readStatus(): Promise<ModelStatus> {
+    this.latestStatus = parseModelStatus(await this.modelStatusChar!.readValue());
+    return this.latestStatus;
   }
 
   private delay(ms: number): Promise<void> {
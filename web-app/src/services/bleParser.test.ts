@@ -1,5 +1,14 @@
 import { describe, it, expect } from 'vitest';
-import { parseSensorPacket, parseDeviceInfo, parseInferenceResult } from './bleParser';
+import {
+  parseSensorPacket,
+  parseSensorBatch,
+  parseSensorNotification,
+  SensorStreamDecoder,
+  parseDeviceInfo,
+  parseInferenceResult,
+  INFERENCE_STATUS_MULTI_HEAD,
+  INFERENCE_STATUS_TIMING,
+} from './bleParser';
 import { crc8 } from '../utils/crc8';
 
 describe('BLE Parser', () => {
@@ -69,6 +78,123 @@ describe('BLE Parser', () => {
     });
   });
 
+  describe('parseSensorBatch', () => {
+    const buildBatch = (count: number): DataView => {
+      const size = 8 + count * 12 + 1;
+      const buffer = new ArrayBuffer(size);
+      const view = new DataView(buffer);
+      view.setUint8(0, 1); // Batched format
+      view.setUint8(1, count);
+      view.setUint16(2, 65534, true); // Base sequence (wraps)
+      view.setUint16(4, 1000, true); // Base timestamp
+      view.setUint16(6, 2500, true); // 400 Hz
+      for (let i = 0; i < count; i++) {
+        view.setInt16(8 + i * 12, 8192 * (i + 1), true);
+        view.setInt16(8 + i * 12 + 6, -164, true);
+      }
+      const bytes = new Uint8Array(buffer);
+      view.setUint8(size - 1, crc8(bytes.slice(0, size - 1)));
+      return view;
+    };
+
+    it('should expand a batch into per-sample packets', () => {
+      const packets = parseSensorBatch(buildBatch(3));
+
+      expect(packets).not.toBeNull();
+      expect(packets!.length).toBe(3);
+      expect(packets![0].ax).toBeCloseTo(1.0);
+      expect(packets![2].ax).toBeCloseTo(3.0);
+      expect(packets![1].gx).toBeCloseTo(-10.0);
+      expect(packets!.map((p) => p.sequence)).toEqual([65534, 65535, 0]);
+      expect(packets!.map((p) => p.timestamp)).toEqual([1000, 1003, 1005]);
+    });
+
+    it('should reject a batch with a bad CRC or length', () => {
+      const view = buildBatch(2);
+      view.setUint8(9, view.getUint8(9) ^ 0x01);
+      expect(parseSensorBatch(view)).toBeNull();
+
+      const truncated = new DataView(buildBatch(2).buffer, 0, 20);
+      expect(parseSensorBatch(truncated)).toBeNull();
+    });
+
+    it('should accept legacy packets through the notification parser', () => {
+      const buffer = new ArrayBuffer(17);
+      const view = new DataView(buffer);
+      view.setInt16(0, 8192, true);
+      view.setUint16(12, 7, true);
+      view.setUint8(16, crc8(new Uint8Array(buffer).slice(0, 16)));
+
+      const packets = parseSensorNotification(view);
+      expect(packets).not.toBeNull();
+      expect(packets!.length).toBe(1);
+      expect(packets![0].sequence).toBe(7);
+      expect(parseSensorNotification(buildBatch(4))!.length).toBe(4);
+    });
+  });
+
+  describe('SensorStreamDecoder', () => {
+    const buildCompressed = (flags: number, baseSequence: number, varints: number[]): DataView => {
+      const count = varints.length === 0 ? 0 : varints[0];
+      const body = varints.slice(1);
+      const size = 9 + body.length + 1;
+      const bytes = new Uint8Array(size);
+      const view = new DataView(bytes.buffer);
+      bytes[0] = 2; // Compressed format
+      bytes[1] = count;
+      bytes[2] = flags;
+      view.setUint16(3, baseSequence, true);
+      view.setUint16(5, 500, true);
+      view.setUint16(7, 40000, true);
+      bytes.set(body, 9);
+      bytes[size - 1] = crc8(bytes.slice(0, size - 1));
+      return view;
+    };
+
+    it('should decode keyframes and continue deltas across notifications', () => {
+      const decoder = new SensorStreamDecoder();
+      decoder.setFormat(2);
+
+      // Keyframe: [8192, 0, 0, 0, 0, 0] then deltas [-1, +1, 0, 0, 0, 0]
+      const keyframe = buildCompressed(0x01, 10, [
+        2,
+        0x80, 0x80, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+        0x01, 0x02, 0x00, 0x00, 0x00, 0x00,
+      ]);
+      const first = decoder.decode(keyframe);
+      expect(first).not.toBeNull();
+      expect(first!.length).toBe(2);
+      expect(first![0].ax).toBeCloseTo(1.0);
+      expect(first![1].ax).toBeCloseTo(8191 / 8192);
+      expect(first![1].ay).toBeCloseTo(1 / 8192);
+      expect(first!.map((p) => p.timestamp)).toEqual([500, 540]);
+
+      // Continues from sample 11: gx += 164 (zigzag 328 = 0xC8 0x02)
+      const delta = buildCompressed(0x00, 12, [1, 0x00, 0x00, 0x00, 0xc8, 0x02, 0x00, 0x00]);
+      const second = decoder.decode(delta);
+      expect(second).not.toBeNull();
+      expect(second![0].sequence).toBe(12);
+      expect(second![0].ax).toBeCloseTo(8191 / 8192);
+      expect(second![0].gx).toBeCloseTo(10.0);
+    });
+
+    it('should wait for a keyframe after a lost notification', () => {
+      const decoder = new SensorStreamDecoder();
+      decoder.setFormat(2);
+      const keyframe = buildCompressed(0x01, 0, [1, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00]);
+      expect(decoder.decode(keyframe)).not.toBeNull();
+
+      // Sequence 1 was lost; this one starts at 2
+      const skipped = buildCompressed(0x00, 2, [1, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00]);
+      expect(decoder.decode(skipped)).toBeNull();
+
+      const resync = buildCompressed(0x01, 3, [1, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00]);
+      const packets = decoder.decode(resync);
+      expect(packets).not.toBeNull();
+      expect(packets![0].ax).toBeCloseTo(2 / 8192);
+    });
+  });
+
   describe('parseDeviceInfo', () => {
     it('should parse device info correctly', () => {
       const buffer = new ArrayBuffer(20);
@@ -103,6 +229,49 @@ describe('BLE Parser', () => {
       expect(info.uptimeSec).toBe(3600);
       expect(info.totalSamples).toBe(10000);
       expect(info.inferenceCount).toBe(500);
+      expect(info.droppedSamples).toBe(0);
+    });
+
+    it('should parse the dropped sample counter when present', () => {
+      const buffer = new ArrayBuffer(28);
+      const view = new DataView(buffer);
+      view.setUint8(20, 1);
+      view.setUint32(24, 70000, true);
+
+      const info = parseDeviceInfo(view);
+
+      expect(info.hasModel).toBe(true);
+      expect(info.droppedSamples).toBe(70000);
+    });
+
+    it('should parse RAM telemetry from 44-byte device info', () => {
+      const view = new DataView(new ArrayBuffer(44));
+      view.setUint16(28, 5120, true);
+      view.setUint16(30, 32768, true);
+      view.setUint32(32, 61000, true);
+      view.setUint32(36, 59000, true);
+      view.setUint16(40, 700, true);
+      view.setUint16(42, 2048, true);
+
+      expect(parseDeviceInfo(view).memory).toEqual({
+        stackPeak: 5120,
+        stackSize: 32768,
+        heapFree: 61000,
+        heapMinFree: 59000,
+        samplerStackPeak: 700,
+        samplerStackSize: 2048,
+      });
+      expect(parseDeviceInfo(new DataView(new ArrayBuffer(28))).memory).toBeUndefined();
+    });
+
+    it('should parse write queue stats from 48-byte device info', () => {
+      const view = new DataView(new ArrayBuffer(48));
+      view.setUint8(44, 9);
+      view.setUint8(45, 16);
+      view.setUint16(46, 3, true);
+
+      expect(parseDeviceInfo(view).bleWrites).toEqual({ peakDepth: 9, capacity: 16, dropped: 3 });
+      expect(parseDeviceInfo(new DataView(new ArrayBuffer(44))).bleWrites).toBeUndefined();
     });
   });
 
@@ -118,6 +287,52 @@ describe('BLE Parser', () => {
       expect(result.confidence).toBe(85);
       expect(result.statusFlags).toBe(0);
       expect(result.noModel).toBe(false);
+      expect(result.timing).toBeUndefined();
+      expect(result.heads).toBeUndefined();
+    });
+
+    it('should parse extra head results', () => {
+      // Primary + two extra heads, no timing
+      const view = new DataView(new ArrayBuffer(8));
+      view.setUint8(0, 2);
+      view.setUint8(1, 80);
+      view.setUint8(2, INFERENCE_STATUS_MULTI_HEAD);
+      view.setUint8(4, 1);
+      view.setUint8(5, 73);
+      view.setUint8(6, 0);
+      view.setUint8(7, 55);
+
+      const result = parseInferenceResult(view);
+      expect(result.prediction).toBe(2);
+      expect(result.heads).toEqual([
+        { prediction: 1, confidence: 73 },
+        { prediction: 0, confidence: 55 },
+      ]);
+      expect(result.timing).toBeUndefined();
+    });
+
+    it('should parse the timing block after extra heads', () => {
+      // Primary + one extra head + timing block
+      const view = new DataView(new ArrayBuffer(6 + 14));
+      view.setUint8(0, 1);
+      view.setUint8(1, 90);
+      view.setUint8(2, INFERENCE_STATUS_MULTI_HEAD | INFERENCE_STATUS_TIMING);
+      view.setUint8(4, 0);
+      view.setUint8(5, 70);
+      view.setUint16(6, 4321, true);
+      view.setUint32(8, 1500, true);
+      view.setUint32(12, 18000, true);
+      view.setUint32(16, 250, true);
+
+      const result = parseInferenceResult(view);
+      expect(result.prediction).toBe(1);
+      expect(result.heads).toEqual([{ prediction: 0, confidence: 70 }]);
+      expect(result.timing).toEqual({
+        newestSequence: 4321,
+        queuedUs: 1500,
+        networkUs: 18000,
+        postUs: 250,
+      });
     });
   });
 });
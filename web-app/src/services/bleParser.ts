@@ -3,12 +3,21 @@
  * Decodes binary data from Arduino firmware
  */
 
-import type { SensorPacket, DeviceInfo, InferenceResult } from '../types/ble';
-import { SENSOR_SCALE } from '../config/constants';
-import { validatePacketCRC } from '../utils/crc8';
+import type {
+  SensorPacket,
+  DeviceInfo,
+  InferenceResult,
+  InferenceHeadResult,
+  InferenceTiming,
+} from '../types/ble';
+import { SENSOR_SCALE, SENSOR_STREAM } from '../config/constants';
+import { crc8, validatePacketCRC } from '../utils/crc8';
 
 export const INFERENCE_PREDICTION_NO_MODEL = 0xFF;
 export const INFERENCE_STATUS_NO_MODEL = 0x01;
+export const INFERENCE_STATUS_MULTI_HEAD = 0x02;
+export const INFERENCE_STATUS_TIMING = 0x04;
+export const INFERENCE_TIMING_SIZE = 14;
 
 // ============================================================================
 // Helper Functions
@@ -60,6 +69,181 @@ export function parseSensorPacket(data: DataView): SensorPacket | null {
   return packet;
 }
 
+// ============================================================================
+// Batched Sensor Parser (8-byte header + N x 12 bytes + CRC-8)
+// ============================================================================
+
+const SENSOR_BATCH_HEADER_SIZE = 8;
+const SENSOR_BATCH_SAMPLE_SIZE = 12;
+
+export function parseSensorBatch(data: DataView): SensorPacket[] | null {
+  if (data.byteLength < SENSOR_BATCH_HEADER_SIZE + 1
+    || data.getUint8(0) !== SENSOR_STREAM.BATCHED) {
+    console.error(`Invalid sensor batch header (size ${data.byteLength})`);
+    return null;
+  }
+
+  const count = data.getUint8(1);
+  const expectedSize = SENSOR_BATCH_HEADER_SIZE + count * SENSOR_BATCH_SAMPLE_SIZE + 1;
+  if (data.byteLength !== expectedSize) {
+    console.error(`Invalid sensor batch size: ${data.byteLength} (expected ${expectedSize})`);
+    return null;
+  }
+
+  const bytes = new Uint8Array(data.buffer, data.byteOffset, data.byteLength);
+  const crc = bytes[expectedSize - 1];
+  if (crc8(bytes.subarray(0, expectedSize - 1)) !== crc) {
+    console.warn('CRC validation failed for sensor batch');
+    return null;
+  }
+
+  const baseSequence = readUint16LE(data, 2);
+  const baseTimestamp = readUint16LE(data, 4);
+  const intervalUs = readUint16LE(data, 6);
+
+  const packets: SensorPacket[] = [];
+  for (let i = 0; i < count; i++) {
+    const offset = SENSOR_BATCH_HEADER_SIZE + i * SENSOR_BATCH_SAMPLE_SIZE;
+    packets.push({
+      ax: readInt16LE(data, offset) / SENSOR_SCALE.ACCEL,
+      ay: readInt16LE(data, offset + 2) / SENSOR_SCALE.ACCEL,
+      az: readInt16LE(data, offset + 4) / SENSOR_SCALE.ACCEL,
+      gx: readInt16LE(data, offset + 6) / SENSOR_SCALE.GYRO,
+      gy: readInt16LE(data, offset + 8) / SENSOR_SCALE.GYRO,
+      gz: readInt16LE(data, offset + 10) / SENSOR_SCALE.GYRO,
+      sequence: (baseSequence + i) & 0xffff,
+      timestamp: (baseTimestamp + Math.floor((i * intervalUs + 500) / 1000)) & 0xffff,
+      crc,
+    });
+  }
+
+  return packets;
+}
+
+/**
+ * Parse one sensor notification in either stream format.
+ */
+export function parseSensorNotification(data: DataView): SensorPacket[] | null {
+  if (data.byteLength === 17) {
+    const packet = parseSensorPacket(data);
+    return packet ? [packet] : null;
+  }
+  return parseSensorBatch(data);
+}
+
+// ============================================================================
+// Compressed Sensor Stream (zigzag-varint deltas, firmware sensor_stream.h)
+// ============================================================================
+
+const SENSOR_DELTA_HEADER_SIZE = 9;
+const SENSOR_DELTA_FLAG_KEYFRAME = 0x01;
+
+/**
+ * Stateful decoder for every sensor stream format. Compressed notifications
+ * continue from the previous one, so after a lost notification samples are
+ * dropped until the next keyframe (at most a few notifications).
+ */
+export class SensorStreamDecoder {
+  private format: number = SENSOR_STREAM.LEGACY;
+  private synced = false;
+  private expectedSequence = 0;
+  private last = [0, 0, 0, 0, 0, 0];
+
+  /** Format the firmware accepted during negotiation */
+  setFormat(format: number): void {
+    this.format = format;
+    this.reset();
+  }
+
+  reset(): void {
+    this.synced = false;
+    this.expectedSequence = 0;
+    this.last = [0, 0, 0, 0, 0, 0];
+  }
+
+  decode(data: DataView): SensorPacket[] | null {
+    // A compressed notification can be 17 bytes long, so rely on negotiation
+    if (this.format === SENSOR_STREAM.COMPRESSED
+      && data.byteLength > 0 && data.getUint8(0) === SENSOR_STREAM.COMPRESSED) {
+      return this.decodeCompressed(data);
+    }
+    return parseSensorNotification(data);
+  }
+
+  private decodeCompressed(data: DataView): SensorPacket[] | null {
+    const length = data.byteLength;
+    const bytes = new Uint8Array(data.buffer, data.byteOffset, length);
+    if (length < SENSOR_DELTA_HEADER_SIZE + 1) {
+      console.error(`Invalid compressed sensor size: ${length}`);
+      return null;
+    }
+    const crc = bytes[length - 1];
+    if (crc8(bytes.subarray(0, length - 1)) !== crc) {
+      console.warn('CRC validation failed for compressed sensor batch');
+      return null;
+    }
+
+    const count = bytes[1];
+    const keyframe = (bytes[2] & SENSOR_DELTA_FLAG_KEYFRAME) !== 0;
+    const baseSequence = readUint16LE(data, 3);
+    const baseTimestamp = readUint16LE(data, 5);
+    const intervalUs = readUint16LE(data, 7);
+
+    if (!keyframe && (!this.synced || baseSequence !== this.expectedSequence)) {
+      this.synced = false;
+      console.warn('Sensor notification lost, waiting for keyframe');
+      return null;
+    }
+
+    const values = keyframe ? [0, 0, 0, 0, 0, 0] : [...this.last];
+    const packets: SensorPacket[] = [];
+    let pos = SENSOR_DELTA_HEADER_SIZE;
+    const end = length - 1;
+
+    for (let i = 0; i < count; i++) {
+      for (let axis = 0; axis < 6; axis++) {
+        let zigzag = 0;
+        let shift = 0;
+        let done = false;
+        while (!done) {
+          if (pos >= end || shift > 14) {
+            this.synced = false;
+            console.error('Malformed compressed sensor batch');
+            return null;
+          }
+          const byte = bytes[pos++];
+          zigzag |= (byte & 0x7f) << shift;
+          shift += 7;
+          done = (byte & 0x80) === 0;
+        }
+        values[axis] += (zigzag >>> 1) ^ -(zigzag & 1);
+      }
+      packets.push({
+        ax: values[0] / SENSOR_SCALE.ACCEL,
+        ay: values[1] / SENSOR_SCALE.ACCEL,
+        az: values[2] / SENSOR_SCALE.ACCEL,
+        gx: values[3] / SENSOR_SCALE.GYRO,
+        gy: values[4] / SENSOR_SCALE.GYRO,
+        gz: values[5] / SENSOR_SCALE.GYRO,
+        sequence: (baseSequence + i) & 0xffff,
+        timestamp: (baseTimestamp + Math.floor((i * intervalUs + 500) / 1000)) & 0xffff,
+        crc,
+      });
+    }
+
+    if (pos !== end) {
+      this.synced = false;
+      console.error('Malformed compressed sensor batch');
+      return null;
+    }
+
+    this.last = values;
+    this.expectedSequence = (baseSequence + count) & 0xffff;
+    this.synced = true;
+    return packets;
+  }
+}
+
 // ============================================================================
 // Device Info Parser (20 bytes)
 // ============================================================================
@@ -76,6 +260,26 @@ export function parseDeviceInfo(data: DataView): DeviceInfo {
           (data.getUint8(22) << 8) |
           (data.getUint8(23) << 16)) >>> 0
       : 0;
+  const droppedSamples = data.byteLength >= 28 ? readUint32LE(data, 24) : 0;
+  const memory =
+    data.byteLength >= 44
+      ? {
+          stackPeak: readUint16LE(data, 28),
+          stackSize: readUint16LE(data, 30),
+          heapFree: readUint32LE(data, 32),
+          heapMinFree: readUint32LE(data, 36),
+          samplerStackPeak: readUint16LE(data, 40),
+          samplerStackSize: readUint16LE(data, 42),
+        }
+      : undefined;
+  const bleWrites =
+    data.byteLength >= 48
+      ? {
+          peakDepth: data.getUint8(44),
+          capacity: data.getUint8(45),
+          dropped: readUint16LE(data, 46),
+        }
+      : undefined;
 
   return {
     firmwareMajor: data.getUint8(0),
@@ -89,6 +293,9 @@ export function parseDeviceInfo(data: DataView): DeviceInfo {
     inferenceCount: readUint32LE(data, 16),
     hasModel,
     storedModelSize,
+    droppedSamples,
+    memory,
+    bleWrites,
   };
 }
 
@@ -108,11 +315,40 @@ export function parseInferenceResult(data: DataView): InferenceResult {
     prediction === INFERENCE_PREDICTION_NO_MODEL
     || (statusFlags & INFERENCE_STATUS_NO_MODEL) !== 0;
 
+  // The timing block is always last, after any extra head results
+  let timing: InferenceTiming | undefined;
+  let headsEnd = data.byteLength;
+  if ((statusFlags & INFERENCE_STATUS_TIMING) !== 0
+      && data.byteLength >= 4 + INFERENCE_TIMING_SIZE) {
+    const offset = data.byteLength - INFERENCE_TIMING_SIZE;
+    headsEnd = offset;
+    timing = {
+      newestSequence: readUint16LE(data, offset),
+      queuedUs: readUint32LE(data, offset + 2),
+      networkUs: readUint32LE(data, offset + 6),
+      postUs: readUint32LE(data, offset + 10),
+    };
+  }
+
+  // [prediction, confidence] per extra head, right after the primary result
+  let heads: InferenceHeadResult[] | undefined;
+  if ((statusFlags & INFERENCE_STATUS_MULTI_HEAD) !== 0) {
+    heads = [];
+    for (let offset = 4; offset + 2 <= headsEnd; offset += 2) {
+      heads.push({
+        prediction: data.getUint8(offset),
+        confidence: data.getUint8(offset + 1),
+      });
+    }
+  }
+
   return {
     prediction,
     confidence,  // Already in 0-100 range
     statusFlags,
     noModel,
+    heads,
+    timing,
   };
 }
 
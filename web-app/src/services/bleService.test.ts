@@ -59,3 +59,83 @@ describe('BLEService inference notifications', () => {
   });
 });
 
+
+describe('BLEService inference timing opt-in', () => {
+  // Config characteristic that behaves like firmware with `size` config bytes
+  function fakeConfig(size: number) {
+    const value = new Uint8Array(size);
+    value.set([25, 0, 100, 0, 2, 12]);
+    const writes: Uint8Array[] = [];
+    const configChar = {
+      readValue: vi.fn(async () => new DataView(value.slice().buffer)),
+      writeValue: vi.fn(async (data: Uint8Array) => {
+        writes.push(Uint8Array.from(data));
+        value[4] = data[4];
+        if (size >= 7) {
+          value[6] = data.length >= 7 ? data[6] & 0x01 : 0;
+        }
+      }),
+    };
+    return { configChar, writes };
+  }
+
+  function connectedService(configChar: unknown): BLEService {
+    const service = new BLEService();
+    const internals = service as unknown as Record<string, unknown>;
+    internals.configChar = configChar;
+    internals.modeChar = { writeValue: vi.fn(async () => undefined) };
+    internals.inferenceChar = {
+      startNotifications: vi.fn(async () => undefined),
+      stopNotifications: vi.fn(async () => undefined),
+      addEventListener: vi.fn(),
+      removeEventListener: vi.fn(),
+    };
+    return service;
+  }
+
+  it('sets inference_flags only when asked and keeps the stream format', async () => {
+    const { configChar, writes } = fakeConfig(7);
+    const service = connectedService(configChar);
+
+    await service.startInference(() => undefined, { timing: true });
+    expect(writes).toHaveLength(1);
+    expect(Array.from(writes[0])).toEqual([25, 0, 100, 0, 2, 12, 0x01]);
+
+    await service.stopInference();
+    await service.startInference(() => undefined);
+    expect(writes).toHaveLength(2);
+    expect(writes[1][6]).toBe(0);
+  });
+
+  it('keeps timing on when collect-mode negotiation rewrites the config', async () => {
+    const { configChar, writes } = fakeConfig(7);
+    const service = connectedService(configChar);
+
+    await service.startInference(() => undefined, { timing: true });
+    await (service as unknown as { negotiateStreamFormat: () => Promise<void> })
+      .negotiateStreamFormat();
+    expect(writes[1]).toHaveLength(7);
+    expect(writes[1][6]).toBe(0x01);
+  });
+
+  it('asks for batches of about 200 ms of samples', async () => {
+    const { configChar, writes } = fakeConfig(7);
+    const service = connectedService(configChar);
+
+    await (service as unknown as { negotiateStreamFormat: () => Promise<void> })
+      .negotiateStreamFormat();
+    expect(writes[0][4]).toBe(2);
+    expect(writes[0][5]).toBe(5); // 25 Hz
+  });
+
+  it('never sends inference_flags to firmware without them', async () => {
+    const { configChar, writes } = fakeConfig(6);
+    const service = connectedService(configChar);
+
+    await service.startInference(() => undefined, { timing: true });
+    expect(writes).toHaveLength(0);
+    await (service as unknown as { negotiateStreamFormat: () => Promise<void> })
+      .negotiateStreamFormat();
+    expect(writes[0]).toHaveLength(6);
+  });
+});
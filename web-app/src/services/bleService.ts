@@ -5,8 +5,8 @@
 
 import type { SensorPacket, DeviceInfo, InferenceResult } from '../types/ble';
 import { DeviceMode } from '../types/ble';
-import { BLE_CONFIG } from '../config/constants';
-import { parseSensorPacket, parseDeviceInfo, parseInferenceResult } from './bleParser';
+import { BLE_CONFIG, SENSOR_STREAM } from '../config/constants';
+import { SensorStreamDecoder, parseDeviceInfo, parseInferenceResult } from './bleParser';
 import { useConnectionStore } from '../state/connectionStore';
 
 export type SensorDataCallback = (packet: SensorPacket) => void;
@@ -14,6 +14,10 @@ export type InferenceCallback = (result: InferenceResult) => void;
 export type DisconnectCallback = () => void;
 export type ParseErrorCallback = (error: Error) => void;
 
+export interface InferenceOptions {
+  timing?: boolean; // Ask for the per-prediction timing block (InferenceResult.timing)
+}
+
 export class BLEService {
   private device: BluetoothDevice | null = null;
   private server: BluetoothRemoteGATTServer | null = null;
@@ -24,6 +28,7 @@ export class BLEService {
   private sensorChar: BluetoothRemoteGATTCharacteristic | null = null;
   private inferenceChar: BluetoothRemoteGATTCharacteristic | null = null;
   private deviceInfoChar: BluetoothRemoteGATTCharacteristic | null = null;
+  private configChar: BluetoothRemoteGATTCharacteristic | null = null;
 
   // Callbacks
   private sensorCallback: SensorDataCallback | null = null;
@@ -34,7 +39,9 @@ export class BLEService {
   // Event handlers (stored so we can remove them)
   private sensorHandler: ((event: Event) => void) | null = null;
   private inferenceHandler: ((event: Event) => void) | null = null;
+  private sensorDecoder = new SensorStreamDecoder();
   private reconnectTask: Promise<void> | null = null;
+  private inferenceTiming = false;
   private userInitiatedDisconnect = false;
 
   // ============================================================================
@@ -114,6 +121,7 @@ export class BLEService {
     this.sensorChar = null;
     this.inferenceChar = null;
     this.deviceInfoChar = null;
+    this.configChar = null;
   }
 
   private handleGattDisconnected = (): void => {
@@ -194,13 +202,20 @@ export class BLEService {
     this.deviceInfoChar = await this.service.getCharacteristic(
       BLE_CONFIG.DEVICE_INFO_UUID,
     );
+    this.configChar = await this.service.getCharacteristic(
+      BLE_CONFIG.CONFIG_CHAR_UUID,
+    );
 
     // Rehydrate notification listeners if streams were active pre-disconnect.
     if (this.sensorCallback) {
       await this.enableSensorNotifications();
+      await this.negotiateStreamFormat();
     }
     if (this.inferenceCallback) {
       await this.enableInferenceNotifications();
+      if (this.inferenceTiming) {
+        await this.writeInferenceFlags();
+      }
     }
   }
 
@@ -261,12 +276,15 @@ export class BLEService {
       );
     }
 
+    this.sensorDecoder.reset();
     this.sensorHandler = (event: Event) => {
       const target = event.target as BluetoothRemoteGATTCharacteristic;
       if (!target.value) return;
-      const packet = parseSensorPacket(target.value);
-      if (packet && this.sensorCallback) {
-        this.sensorCallback(packet);
+      const packets = this.sensorDecoder.decode(target.value);
+      if (packets && this.sensorCallback) {
+        for (const packet of packets) {
+          this.sensorCallback(packet);
+        }
       }
     };
 
@@ -277,6 +295,85 @@ export class BLEService {
     );
   }
 
+  /**
+   * Ask the firmware for compressed, batched sensor notifications. Older
+   * firmware has a 4-byte config characteristic (or falls back to another
+   * format) and the notification handler accepts every format.
+   */
+  private async negotiateStreamFormat(): Promise<void> {
+    if (!this.configChar) return;
+
+    try {
+      const current = await this.configChar.readValue();
+      if (current.byteLength < SENSOR_STREAM.CONFIG_SIZE) {
+        this.sensorDecoder.setFormat(SENSOR_STREAM.LEGACY);
+        return;
+      }
+
+      // Small batches: recordings are timed by arrival, so a sample must not
+      // wait long for the rest of its notification
+      const rate = current.getUint16(0, true);
+      const request = this.configRequest(current);
+      request[4] = SENSOR_STREAM.COMPRESSED;
+      request[5] = Math.max(1, Math.round((rate * SENSOR_STREAM.MAX_BATCH_MS) / 1000));
+      // Notifications may switch format before the read-back completes
+      this.sensorDecoder.setFormat(SENSOR_STREAM.COMPRESSED);
+      await this.configChar.writeValue(request);
+
+      const accepted = await this.configChar.readValue();
+      this.sensorDecoder.setFormat(accepted.getUint8(4));
+      console.log(
+        `Sensor stream format ${accepted.getUint8(4)}, `
+          + `up to ${accepted.getUint8(5)} samples/notification`,
+      );
+    } catch (err) {
+      this.sensorDecoder.setFormat(SENSOR_STREAM.LEGACY);
+      console.warn('Stream format negotiation failed, using legacy packets', err);
+    }
+  }
+
+  /**
+   * Config write that keeps what the firmware reported and carries the
+   * inference flags when its config characteristic has room for them
+   * (a shorter write clears them).
+   */
+  private configRequest(current: DataView): Uint8Array {
+    const size = current.byteLength >= SENSOR_STREAM.CONFIG_FLAGS_SIZE
+      ? SENSOR_STREAM.CONFIG_FLAGS_SIZE
+      : SENSOR_STREAM.CONFIG_SIZE;
+    const request = new Uint8Array(size);
+    request.set(new Uint8Array(current.buffer, current.byteOffset, SENSOR_STREAM.CONFIG_SIZE));
+    if (size === SENSOR_STREAM.CONFIG_FLAGS_SIZE) {
+      request[6] = this.inferenceTiming ? SENSOR_STREAM.CONFIG_INFERENCE_TIMING : 0;
+    }
+    return request;
+  }
+
+  /**
+   * Send the inference flags, leaving the stream format alone. Older
+   * firmware has no room for them and never sends timing.
+   * @returns whether the firmware now matches the requested flags
+   */
+  private async writeInferenceFlags(): Promise<boolean> {
+    if (!this.configChar) return false;
+
+    try {
+      const current = await this.configChar.readValue();
+      if (current.byteLength < SENSOR_STREAM.CONFIG_FLAGS_SIZE) {
+        return !this.inferenceTiming;
+      }
+      await this.configChar.writeValue(this.configRequest(current));
+
+      const accepted = await this.configChar.readValue();
+      const timing = accepted.byteLength >= SENSOR_STREAM.CONFIG_FLAGS_SIZE
+        && (accepted.getUint8(6) & SENSOR_STREAM.CONFIG_INFERENCE_TIMING) !== 0;
+      return timing === this.inferenceTiming;
+    } catch (err) {
+      console.warn('Inference flags write failed', err);
+      return false;
+    }
+  }
+
   async startSensorStream(callback: SensorDataCallback): Promise<void> {
     if (!this.sensorChar) {
       throw new Error('Not connected');
@@ -284,6 +381,7 @@ export class BLEService {
 
     // Set to collect mode
     await this.setMode(DeviceMode.COLLECT);
+    await this.negotiateStreamFormat();
 
     // Store callback
     this.sensorCallback = callback;
@@ -345,7 +443,10 @@ export class BLEService {
     );
   }
 
-  async startInference(callback: InferenceCallback): Promise<void> {
+  async startInference(
+    callback: InferenceCallback,
+    options: InferenceOptions = {},
+  ): Promise<void> {
     if (!this.inferenceChar) {
       throw new Error('Not connected');
     }
@@ -353,6 +454,13 @@ export class BLEService {
     // Set to inference mode
     await this.setMode(DeviceMode.INFERENCE);
 
+    // Timing stays off unless asked for; the firmware keeps whatever the
+    // last config write said, so always send it
+    this.inferenceTiming = options.timing ?? false;
+    if (!(await this.writeInferenceFlags()) && this.inferenceTiming) {
+      console.warn('Firmware does not report inference timing');
+    }
+
     // Store callback
     this.inferenceCallback = callback;
     await this.enableInferenceNotifications();
@@ -369,6 +477,7 @@ export class BLEService {
       }
       await this.inferenceChar.stopNotifications();
       this.inferenceCallback = null;
+      this.inferenceTiming = false;
       console.log('Inference mode stopped');
     }
   }
@@ -14,6 +14,13 @@ import * as tf from '@tensorflow/tfjs';
 import {
   extractSimpleNNWeights,
   weightsToBytes,
+  weightsToCompactBytes,
+  supportsCompactModel,
+  supportsPackedModel,
+  supportsSelectiveRepeat,
+  supportsDeltaModel,
+  packModelBytes,
+  encodeModelDelta,
   calculateCrc32,
 } from './modelExportService';
 import {
@@ -21,8 +28,12 @@ import {
   NN_HIDDEN_SIZE,
   NN_INPUT_SIZE,
   NN_MAX_CLASSES,
+  NN_MAX_HEADS,
   SIMPLE_NN_MAGIC,
+  SIMPLE_NN_HEADS_MAGIC,
+  SIMPLE_NN_COMPACT_MAGIC,
 } from '../config/constants';
+import type { DeviceInfo } from '../types/ble';
 
 // ---------------------------------------------------------------------------
 // Helper: create a small SimpleNN-compatible model
@@ -236,4 +247,232 @@ describe('weightsToBytes', () => {
     const unusedLabelOffset = labelsOffset + (4 * LABEL_MAX_LEN);
     expect(bytes[unusedLabelOffset]).toBe(0);
   });
+
+  it('appends the extra heads block for multi-head models', () => {
+    const weights = {
+      inputSize: NN_INPUT_SIZE,
+      hiddenSize: NN_HIDDEN_SIZE,
+      numClasses: 3,
+      hiddenWeights: new Float32Array(NN_HIDDEN_SIZE * NN_INPUT_SIZE),
+      hiddenBiases: new Float32Array(NN_HIDDEN_SIZE),
+      outputWeights: new Float32Array(3 * NN_HIDDEN_SIZE),
+      outputBiases: new Float32Array(3),
+    };
+    const head = {
+      numClasses: 2,
+      outputWeights: new Float32Array(2 * NN_HIDDEN_SIZE),
+      outputBiases: new Float32Array([0.25, 0.75]),
+      labels: ['Soft', 'Hard'],
+    };
+    const single = weightsToBytes(weights);
+    const bytes = weightsToBytes({ ...weights, extraHeads: [head] });
+
+    // SIMPLE_NN_UPLOAD_SIZE(1) in firmware/src/simple_nn.h
+    const headBytes =
+      4 + NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4 + NN_MAX_CLASSES * 4 + NN_MAX_CLASSES * LABEL_MAX_LEN;
+    expect(bytes.length).toBe(single.length + 8 + headBytes);
+    expect(Array.from(bytes.slice(0, single.length))).toEqual(Array.from(single));
+
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    expect(view.getUint32(single.length, true)).toBe(SIMPLE_NN_HEADS_MAGIC);
+    expect(view.getUint32(single.length + 4, true)).toBe(1);
+    const headOffset = single.length + 8;
+    expect(view.getUint32(headOffset, true)).toBe(2);
+    const biasOffset = headOffset + 4 + NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4;
+    expect(view.getFloat32(biasOffset + 4, true)).toBeCloseTo(0.75, 5);
+    const labelOffset = biasOffset + NN_MAX_CLASSES * 4;
+    expect(new TextDecoder().decode(bytes.slice(labelOffset + LABEL_MAX_LEN, labelOffset + LABEL_MAX_LEN + 4)))
+      .toBe('Hard');
+
+    const tooMany = Array.from({ length: NN_MAX_HEADS }, () => head);
+    expect(() => weightsToBytes({ ...weights, extraHeads: tooMany })).toThrow(/extra heads/);
+    expect(() => weightsToBytes({ ...weights, extraHeads: [{ ...head, numClasses: 3 }] }))
+      .toThrow(/head 1/);
+  });
+});
+
+describe('weightsToCompactBytes', () => {
+  const makeWeights = (numClasses: number) => {
+    const outputWeights = new Float32Array(numClasses * NN_HIDDEN_SIZE);
+    outputWeights[outputWeights.length - 1] = -4.5;
+    const outputBiases = new Float32Array(numClasses);
+    outputBiases[numClasses - 1] = 0.25;
+    return {
+      inputSize: NN_INPUT_SIZE,
+      hiddenSize: NN_HIDDEN_SIZE,
+      numClasses,
+      hiddenWeights: new Float32Array(NN_HIDDEN_SIZE * NN_INPUT_SIZE),
+      hiddenBiases: new Float32Array(NN_HIDDEN_SIZE),
+      outputWeights,
+      outputBiases,
+    };
+  };
+
+  it('sends only the used classes and NUL-terminated labels', () => {
+    const bytes = weightsToCompactBytes(makeWeights(2), ['Wave', 'AVeryLongGestureName']);
+
+    const floatsOffset = 20;
+    const outputBiasOffset =
+      floatsOffset + (NN_HIDDEN_SIZE * NN_INPUT_SIZE + NN_HIDDEN_SIZE + 2 * NN_HIDDEN_SIZE) * 4;
+    const labelsOffset = outputBiasOffset + 2 * 4;
+    expect(bytes.length).toBe(labelsOffset + 'Wave'.length + 1 + (LABEL_MAX_LEN - 1) + 1);
+
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    expect(view.getUint32(0, true)).toBe(SIMPLE_NN_COMPACT_MAGIC);
+    expect(view.getUint32(4, true)).toBe(2);
+    expect(view.getUint32(8, true)).toBe(NN_INPUT_SIZE);
+    expect(view.getUint32(12, true)).toBe(NN_HIDDEN_SIZE);
+    expect(view.getUint32(16, true)).toBe(0);
+    expect(view.getFloat32(outputBiasOffset - 4, true)).toBeCloseTo(-4.5, 5);
+    expect(view.getFloat32(outputBiasOffset + 4, true)).toBeCloseTo(0.25, 5);
+
+    const labels = new TextDecoder().decode(bytes.slice(labelsOffset)).split('\0');
+    expect(labels).toEqual(['Wave', 'AVeryLongGestureName'.slice(0, LABEL_MAX_LEN - 1), '']);
+
+    // Smaller than the padded layout, and it shrinks with the class count
+    expect(bytes.length).toBeLessThan(weightsToBytes(makeWeights(2), ['Wave', 'Shake']).length);
+  });
+
+  it('sends each extra head after the primary layer and its labels after the primary labels', () => {
+    const head = {
+      numClasses: 2,
+      outputWeights: new Float32Array(2 * NN_HIDDEN_SIZE).fill(0.5),
+      outputBiases: new Float32Array([1.5, -1.5]),
+      labels: ['Soft', 'Hard'],
+    };
+    const bytes = weightsToCompactBytes({ ...makeWeights(3), extraHeads: [head] }, ['A', 'B', 'C']);
+
+    const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+    expect(view.getUint32(16, true)).toBe(1);
+    const headOffset =
+      20 + (NN_HIDDEN_SIZE * NN_INPUT_SIZE + NN_HIDDEN_SIZE + 3 * (NN_HIDDEN_SIZE + 1)) * 4;
+    expect(view.getUint32(headOffset, true)).toBe(2);
+    expect(view.getFloat32(headOffset + 4, true)).toBeCloseTo(0.5, 5);
+    const headBiasOffset = headOffset + 4 + 2 * NN_HIDDEN_SIZE * 4;
+    expect(view.getFloat32(headBiasOffset + 4, true)).toBeCloseTo(-1.5, 5);
+
+    const labels = new TextDecoder().decode(bytes.slice(headBiasOffset + 8)).split('\0');
+    expect(labels).toEqual(['A', 'B', 'C', 'Soft', 'Hard', '']);
+  });
+
+  it('is only offered to firmware 1.2 and later', () => {
+    const info = (firmwareMajor: number, firmwareMinor: number) =>
+      ({ firmwareMajor, firmwareMinor }) as DeviceInfo;
+    expect(supportsCompactModel(null)).toBe(false);
+    expect(supportsCompactModel(info(1, 1))).toBe(false);
+    expect(supportsCompactModel(info(1, 2))).toBe(true);
+    expect(supportsCompactModel(info(2, 0))).toBe(true);
+  });
+});
+
+describe('packModelBytes', () => {
+  it('matches the firmware reference encoder byte for byte', () => {
+    // Float-like input: byte lane 3 repeats, as exponents do
+    const input = Uint8Array.from([
+      0, 38, 78, 61, 164, 210, 2, 61, 104, 158, 214, 61, 76, 138, 202, 61, 80, 150, 222, 61,
+      116, 194, 18, 61, 184, 14, 102, 61, 28, 122, 218, 61, 160, 6, 110, 61, 68, 178, 34, 61,
+    ]);
+    // firmware/src/model_codec.cpp packModelPayload() on the same bytes
+    const expected = [
+      0x53, 0x4e, 0x4e, 0x5a, 0x28, 0x00, 0x00, 0x00, 0x00, 0x00, 0x26, 0x4d, 0xa4, 0x6e, 0xb6,
+      0x37, 0x4c, 0xe6, 0xe8, 0x75, 0x04, 0x66, 0x22, 0xf2, 0x47, 0x7b, 0xa7, 0xe7, 0xfc, 0xf7,
+      0x44, 0x47, 0x9e, 0xa4, 0xcd, 0xaf, 0x3b, 0x4c, 0xdc, 0x36, 0x50, 0x19, 0x6a, 0x79, 0xaa,
+      0x54, 0xe5, 0x63, 0x4f, 0x04, 0xf0,
+    ];
+    expect(Array.from(packModelBytes(input))).toEqual(expected);
+  });
+
+  it('shrinks float weights and long runs of zeros', () => {
+    const weights = new Float32Array(4096);
+    for (let i = 0; i < weights.length; i++) {
+      weights[i] = Math.sin(i * 12.9898) * 0.1;
+    }
+    const weightBytes = new Uint8Array(weights.buffer);
+    expect(packModelBytes(weightBytes).length).toBeLessThan(weightBytes.length * 0.9);
+    expect(packModelBytes(new Uint8Array(4096)).length).toBeLessThan(256);
+  });
+
+  it('is only offered to firmware 1.3 and later', () => {
+    const info = (firmwareMajor: number, firmwareMinor: number) =>
+      ({ firmwareMajor, firmwareMinor }) as DeviceInfo;
+    expect(supportsPackedModel(info(1, 2))).toBe(false);
+    expect(supportsPackedModel(info(1, 3))).toBe(true);
+  });
+});
+
+describe('supportsSelectiveRepeat', () => {
+  it('is only offered to firmware 1.4 and later', () => {
+    const info = (firmwareMajor: number, firmwareMinor: number) =>
+      ({ firmwareMajor, firmwareMinor }) as DeviceInfo;
+    expect(supportsSelectiveRepeat(null)).toBe(false);
+    expect(supportsSelectiveRepeat(info(1, 3))).toBe(false);
+    expect(supportsSelectiveRepeat(info(1, 4))).toBe(true);
+    expect(supportsSelectiveRepeat(info(2, 0))).toBe(true);
+  });
+});
+
+describe('encodeModelDelta', () => {
+  const modelSize =
+    16 +
+    NN_HIDDEN_SIZE * NN_INPUT_SIZE * 4 +
+    NN_HIDDEN_SIZE * 4 +
+    NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4 +
+    NN_MAX_CLASSES * 4 +
+    NN_MAX_CLASSES * LABEL_MAX_LEN;
+  const outputWeightsOffset = 16 + NN_HIDDEN_SIZE * NN_INPUT_SIZE * 4 + NN_HIDDEN_SIZE * 4;
+
+  const makeBase = () => {
+    const base = new Uint8Array(modelSize);
+    const view = new DataView(base.buffer);
+    view.setUint32(0, SIMPLE_NN_MAGIC, true);
+    view.setUint32(4, 2, true);
+    view.setUint32(8, NN_INPUT_SIZE, true);
+    view.setUint32(12, NN_HIDDEN_SIZE, true);
+    return base;
+  };
+
+  it('matches the firmware reference encoder byte for byte', () => {
+    const base = makeBase();
+    const next = base.slice();
+    const view = new DataView(next.buffer);
+    view.setUint32(4, 3, true);
+    view.setFloat32(outputWeightsOffset, 0.5, true);
+    view.setFloat32(outputWeightsOffset + NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4 + 4, -1, true);
+    next.set(new TextEncoder().encode('Hi'), modelSize - (NN_MAX_CLASSES - 1) * LABEL_MAX_LEN);
+
+    // firmware/src/model_format.cpp encodeModelDelta() on the same models
+    const expected = [
+      0x53, 0x4e, 0x4e, 0x44, 0x37, 0x67, 0xe0, 0x69, 0x30, 0x31, 0x01, 0x00, 0x30, 0x31, 0x01,
+      0x00, 0x3e, 0xdc, 0x26, 0x50, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x04, 0x00,
+      0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x03, 0x03, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00,
+      0x01, 0x00, 0x00, 0x00, 0x3f, 0x04, 0x00, 0x00, 0x00, 0x06, 0x00, 0x00, 0x00, 0x02, 0x00,
+      0x00, 0x00, 0x80, 0xbf, 0x05, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00,
+      0x00, 0x48, 0x69,
+    ];
+    expect(Array.from(encodeModelDelta(base, next))).toEqual(expected);
+  });
+
+  it('sends only the output layer when that is all that changed', () => {
+    const base = makeBase();
+    const next = base.slice();
+    const view = new DataView(next.buffer);
+    for (let i = 0; i < 2 * NN_HIDDEN_SIZE; i++) {
+      view.setFloat32(outputWeightsOffset + i * 4, 0.01 * (i + 1), true);
+    }
+    const delta = encodeModelDelta(base, next);
+    expect(delta.length).toBeLessThan(24 + 12 + 2 * NN_HIDDEN_SIZE * 4 + 1);
+    expect(new DataView(delta.buffer).getUint32(20, true)).toBe(1);
+    expect(delta.length).toBeLessThan(modelSize / 100);
+
+    // Nothing changed: just the header
+    expect(encodeModelDelta(next, next).length).toBe(24);
+  });
+
+  it('is only offered to firmware 1.7 and later', () => {
+    const info = (firmwareMajor: number, firmwareMinor: number) =>
+      ({ firmwareMajor, firmwareMinor }) as DeviceInfo;
+    expect(supportsDeltaModel(null)).toBe(false);
+    expect(supportsDeltaModel(info(1, 6))).toBe(false);
+    expect(supportsDeltaModel(info(1, 7))).toBe(true);
+  });
 });
@@ -29,8 +29,19 @@ import {
   NN_INPUT_SIZE, 
   NN_HIDDEN_SIZE, 
   NN_MAX_CLASSES,
-  SIMPLE_NN_MAGIC
+  NN_MAX_HEADS,
+  SIMPLE_NN_MAGIC,
+  SIMPLE_NN_HEADS_MAGIC,
+  SIMPLE_NN_COMPACT_MAGIC,
+  SIMPLE_NN_PACKED_MAGIC,
+  SIMPLE_NN_DELTA_MAGIC,
+  COMPACT_MODEL_MIN_FIRMWARE,
+  PACKED_MODEL_MIN_FIRMWARE,
+  SELECTIVE_REPEAT_MIN_FIRMWARE,
+  UPLOAD_CREDITS_MIN_FIRMWARE,
+  DELTA_MODEL_MIN_FIRMWARE
 } from '../config/constants';
+import type { DeviceInfo } from '../types/ble';
 
 /**
  * SimpleNN Weight Structure
@@ -48,6 +59,21 @@ export interface SimpleNNWeights {
   hiddenBiases: Float32Array;   // Shape: [hiddenSize] = [32]
   outputWeights: Float32Array;  // Shape: [numClasses, hiddenSize] = [N, 32]
   outputBiases: Float32Array;   // Shape: [numClasses] = [N]
+
+  // Optional extra output heads on the same hidden layer (multi-head models)
+  extraHeads?: SimpleNNHeadWeights[];
+}
+
+/**
+ * One extra output head: a second (or third) output layer that reads the
+ * same 32 hidden neurons, e.g. "how hard?" next to "which gesture?".
+ * See SimpleNNHead in firmware/src/simple_nn.h.
+ */
+export interface SimpleNNHeadWeights {
+  numClasses: number;           // 1-8
+  outputWeights: Float32Array;  // Shape: [numClasses, hiddenSize]
+  outputBiases: Float32Array;   // Shape: [numClasses]
+  labels?: string[];
 }
 
 /**
@@ -167,16 +193,8 @@ export function extractSimpleNNWeights(model: tf.LayersModel): SimpleNNWeights {
   };
 }
 
-/**
- * Convert SimpleNN weights to binary format for BLE upload
- * 
- * The binary format is simply all the floats concatenated together:
- * [hiddenWeights][hiddenBiases][outputWeights][outputBiases]
- * 
- * Each float is 4 bytes (32 bits), stored in little-endian format
- * (which is what most computers and the Arduino use).
- */
-export function weightsToBytes(weights: SimpleNNWeights, labels: string[] = []): Uint8Array {
+// Both upload formats need a model the firmware was built for
+function validateWeights(weights: SimpleNNWeights): void {
   const expectedHiddenWeights = NN_HIDDEN_SIZE * NN_INPUT_SIZE;
   const expectedHiddenBiases = NN_HIDDEN_SIZE;
   const expectedOutputWeights = weights.numClasses * NN_HIDDEN_SIZE;
@@ -204,13 +222,46 @@ export function weightsToBytes(weights: SimpleNNWeights, labels: string[] = []):
     throw new Error(`Invalid output bias length ${weights.outputBiases.length}; expected ${expectedOutputBiases}`);
   }
 
+  const extraHeads = weights.extraHeads ?? [];
+  if (extraHeads.length > NN_MAX_HEADS - 1) {
+    throw new Error(`Too many extra heads ${extraHeads.length}; expected at most ${NN_MAX_HEADS - 1}`);
+  }
+  extraHeads.forEach((head, index) => {
+    if (head.numClasses < 1 || head.numClasses > NN_MAX_CLASSES) {
+      throw new Error(`Invalid class count ${head.numClasses} in head ${index + 1}; expected 1-${NN_MAX_CLASSES}`);
+    }
+    if (head.outputWeights.length !== head.numClasses * NN_HIDDEN_SIZE
+        || head.outputBiases.length !== head.numClasses) {
+      throw new Error(`Invalid output layer size in head ${index + 1}`);
+    }
+  });
+}
+
+/**
+ * Convert SimpleNN weights to binary format for BLE upload
+ * 
+ * The binary format is simply all the floats concatenated together:
+ * [hiddenWeights][hiddenBiases][outputWeights][outputBiases]
+ * followed, for multi-head models, by the SimpleNNExtraHeads block with one
+ * padded output layer per extra head.
+ * 
+ * Each float is 4 bytes (32 bits), stored in little-endian format
+ * (which is what most computers and the Arduino use).
+ */
+export function weightsToBytes(weights: SimpleNNWeights, labels: string[] = []): Uint8Array {
+  validateWeights(weights);
+
+  const extraHeads = weights.extraHeads ?? [];
+  const outputLayerBytes =
+    (NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4) +
+    (NN_MAX_CLASSES * 4) +
+    (NN_MAX_CLASSES * LABEL_MAX_LEN);
   const totalBytes =
     16 + // Header: magic, numClasses, inputSize, hiddenSize
     (NN_HIDDEN_SIZE * NN_INPUT_SIZE * 4) +
     (NN_HIDDEN_SIZE * 4) +
-    (NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4) +
-    (NN_MAX_CLASSES * 4) +
-    (NN_MAX_CLASSES * LABEL_MAX_LEN);
+    outputLayerBytes +
+    (extraHeads.length > 0 ? 8 + extraHeads.length * (4 + outputLayerBytes) : 0);
 
   const buffer = new ArrayBuffer(totalBytes);
   const view = new DataView(buffer);
@@ -235,7 +286,24 @@ export function weightsToBytes(weights: SimpleNNWeights, labels: string[] = []):
   };
 
   const ascii = new TextEncoder();
-  const safeLabels = labels.slice(0, NN_MAX_CLASSES);
+
+  // Fixed-width class labels [NN_MAX_CLASSES][LABEL_MAX_LEN]
+  const writeLabels = (headLabels: string[]) => {
+    for (let classIndex = 0; classIndex < NN_MAX_CLASSES; classIndex++) {
+      const rawLabel = headLabels[classIndex] ?? '';
+      const encoded = ascii.encode(rawLabel);
+      const copyLen = Math.min(encoded.length, LABEL_MAX_LEN - 1);
+
+      for (let i = 0; i < LABEL_MAX_LEN; i++) {
+        if (i < copyLen) {
+          view.setUint8(offset, encoded[i]);
+        } else {
+          view.setUint8(offset, 0);
+        }
+        offset += 1;
+      }
+    }
+  };
 
   // SimpleNNModel header
   writeUint32(SIMPLE_NN_MAGIC);
@@ -248,20 +316,17 @@ export function weightsToBytes(weights: SimpleNNWeights, labels: string[] = []):
   writeFloats(weights.hiddenBiases);
   writeFloats(weights.outputWeights, NN_MAX_CLASSES * NN_HIDDEN_SIZE);
   writeFloats(weights.outputBiases, NN_MAX_CLASSES);
+  writeLabels(labels);
 
-  // Fixed-width class labels [NN_MAX_CLASSES][LABEL_MAX_LEN]
-  for (let classIndex = 0; classIndex < NN_MAX_CLASSES; classIndex++) {
-    const rawLabel = safeLabels[classIndex] ?? '';
-    const encoded = ascii.encode(rawLabel);
-    const copyLen = Math.min(encoded.length, LABEL_MAX_LEN - 1);
-
-    for (let i = 0; i < LABEL_MAX_LEN; i++) {
-      if (i < copyLen) {
-        view.setUint8(offset, encoded[i]);
-      } else {
-        view.setUint8(offset, 0);
-      }
-      offset += 1;
+  // SimpleNNExtraHeads: only the heads in use are sent
+  if (extraHeads.length > 0) {
+    writeUint32(SIMPLE_NN_HEADS_MAGIC);
+    writeUint32(extraHeads.length);
+    for (const head of extraHeads) {
+      writeUint32(head.numClasses);
+      writeFloats(head.outputWeights, NN_MAX_CLASSES * NN_HIDDEN_SIZE);
+      writeFloats(head.outputBiases, NN_MAX_CLASSES);
+      writeLabels(head.labels ?? []);
     }
   }
   
@@ -270,12 +335,310 @@ export function weightsToBytes(weights: SimpleNNWeights, labels: string[] = []):
   return new Uint8Array(buffer);
 }
 
+/**
+ * Convert SimpleNN weights to the compact upload format
+ *
+ * The full format above pads every model to NN_MAX_CLASSES classes and
+ * fixed-width labels. The compact one only sends what this model uses, and
+ * the Arduino fills in the padding as the bytes arrive
+ * (see firmware/src/model_format.h):
+ * [header][hiddenWeights][hiddenBiases][outputWeights][outputBiases][labels]
+ *
+ * Labels are NUL-terminated; the firmware cuts them to LABEL_MAX_LEN - 1.
+ */
+export function weightsToCompactBytes(weights: SimpleNNWeights, labels: string[] = []): Uint8Array {
+  validateWeights(weights);
+
+  const ascii = new TextEncoder();
+  const extraHeads = weights.extraHeads ?? [];
+  const encodedLabels: Uint8Array[] = [];
+  const encodeLabels = (headLabels: string[], numClasses: number) => {
+    for (let classIndex = 0; classIndex < numClasses; classIndex++) {
+      const encoded = ascii.encode(headLabels[classIndex] ?? '');
+      // A NUL inside a label would end it early on the Arduino
+      const end = encoded.indexOf(0);
+      encodedLabels.push(encoded.slice(0, Math.min(end < 0 ? encoded.length : end, LABEL_MAX_LEN - 1)));
+    }
+  };
+  // Primary head first, then each extra head's
+  encodeLabels(labels, weights.numClasses);
+  for (const head of extraHeads) {
+    encodeLabels(head.labels ?? [], head.numClasses);
+  }
+
+  const totalBytes =
+    20 + // Header: magic, numClasses, inputSize, hiddenSize, numExtraHeads
+    (NN_HIDDEN_SIZE * NN_INPUT_SIZE * 4) +
+    (NN_HIDDEN_SIZE * 4) +
+    (weights.numClasses * NN_HIDDEN_SIZE * 4) +
+    (weights.numClasses * 4) +
+    extraHeads.reduce((sum, head) => sum + 4 + head.numClasses * (NN_HIDDEN_SIZE + 1) * 4, 0) +
+    encodedLabels.reduce((sum, label) => sum + label.length + 1, 0);
+
+  const bytes = new Uint8Array(totalBytes);
+  const view = new DataView(bytes.buffer);
+  let offset = 0;
+
+  const writeUint32 = (value: number) => {
+    view.setUint32(offset, value >>> 0, true);
+    offset += 4;
+  };
+  const writeFloats = (arr: Float32Array) => {
+    for (let i = 0; i < arr.length; i++) {
+      view.setFloat32(offset, arr[i], true);
+      offset += 4;
+    }
+  };
+
+  writeUint32(SIMPLE_NN_COMPACT_MAGIC);
+  writeUint32(weights.numClasses);
+  writeUint32(weights.inputSize);
+  writeUint32(weights.hiddenSize);
+  writeUint32(extraHeads.length);
+
+  writeFloats(weights.hiddenWeights);
+  writeFloats(weights.hiddenBiases);
+  writeFloats(weights.outputWeights);
+  writeFloats(weights.outputBiases);
+  for (const head of extraHeads) {
+    writeUint32(head.numClasses);
+    writeFloats(head.outputWeights);
+    writeFloats(head.outputBiases);
+  }
+
+  for (const label of encodedLabels) {
+    bytes.set(label, offset);
+    offset += label.length + 1; // Already zero: the terminator
+  }
+
+  console.log(`Packed compact SimpleNN model into ${offset} bytes`);
+
+  return bytes;
+}
+
+/**
+ * Pack (losslessly compress) a full or compact payload for upload
+ *
+ * This is the same adaptive binary range coder as LZMA uses, with one set
+ * of probabilities per byte lane (offset % 4), so the sign/exponent bytes
+ * of the floats are modelled apart from the mantissa bytes. The Arduino
+ * unpacks it as the chunks arrive (see firmware/src/model_codec.h).
+ *
+ * Trained weights are mostly mantissa noise, so expect about 1.2x.
+ */
+export function packModelBytes(payload: Uint8Array): Uint8Array {
+  const PROB_BITS = 11;
+  const MOVE_BITS = 5;
+  const PROB_ONE = 1 << PROB_BITS;
+  const RANGE_TOP = 2 ** 24;
+  const TWO_32 = 2 ** 32;
+
+  const out: number[] = [];
+  // low can carry into bit 32, so it is kept as a plain number
+  let low = 0;
+  let range = 0xffffffff;
+  let cache = 0;
+  let cacheSize = 1;
+
+  const shiftLow = () => {
+    const low32 = low % TWO_32;
+    if (low32 < 0xff000000 || low >= TWO_32) {
+      const carry = low >= TWO_32 ? 1 : 0;
+      let pending = cache;
+      do {
+        out.push((pending + carry) & 0xff);
+        pending = 0xff;
+      } while (--cacheSize !== 0);
+      cache = low32 >>> 24;
+    }
+    cacheSize++;
+    low = (low32 & 0xffffff) * 256;
+  };
+
+  const probs = Array.from({ length: 4 }, () => new Uint16Array(256).fill(PROB_ONE / 2));
+  for (let i = 0; i < payload.length; i++) {
+    const tree = probs[i % 4];
+    let node = 1;
+    for (let bit = 7; bit >= 0; bit--) {
+      const value = (payload[i] >> bit) & 1;
+      const prob = tree[node];
+      const bound = Math.floor(range / PROB_ONE) * prob;
+      if (value === 0) {
+        range = bound;
+        tree[node] = prob + ((PROB_ONE - prob) >> MOVE_BITS);
+      } else {
+        low += bound;
+        range -= bound;
+        tree[node] = prob - (prob >> MOVE_BITS);
+      }
+      while (range < RANGE_TOP) {
+        range *= 256;
+        shiftLow();
+      }
+      node = (node << 1) | value;
+    }
+  }
+  for (let i = 0; i < 5; i++) {
+    shiftLow();
+  }
+
+  // Header: magic, unpacked size
+  const packed = new Uint8Array(8 + out.length);
+  const view = new DataView(packed.buffer);
+  view.setUint32(0, SIMPLE_NN_PACKED_MAGIC, true);
+  view.setUint32(4, payload.length, true);
+  packed.set(out, 8);
+
+  console.log(`Packed ${payload.length} model bytes into ${packed.length}`);
+
+  return packed;
+}
+
+const DELTA_HEADER_SIZE = 24; // magic, baseCrc, baseSize, resultSize, resultCrc, patchCount
+const PATCH_HEADER_SIZE = 12; // tensor, offset, length
+
+/**
+ * Encode the patches that turn one full payload (weightsToBytes) into
+ * another, for a model update on firmware that has the first one
+ *
+ * Patches are per tensor (firmware/src/model_format.h ModelTensor), with
+ * offsets inside it: [tensor u32][offset u32][length u32][bytes]. Changed
+ * bytes closer together than a patch header share one patch. The Arduino
+ * refuses the delta unless it holds exactly `base` (baseCrc), and checks
+ * the patched model against resultCrc before it runs it.
+ *
+ * Only unchanged tensors are saved: retraining every layer moves every
+ * weight, and then the delta is as big as the model.
+ */
+export function encodeModelDelta(base: Uint8Array, next: Uint8Array): Uint8Array {
+  const hiddenWeights = NN_HIDDEN_SIZE * NN_INPUT_SIZE * 4;
+  const hiddenBiases = NN_HIDDEN_SIZE * 4;
+  const outputWeights = NN_MAX_CLASSES * NN_HIDDEN_SIZE * 4;
+  const outputBiases = NN_MAX_CLASSES * 4;
+  const labels = NN_MAX_CLASSES * LABEL_MAX_LEN;
+  const modelSize = 16 + hiddenWeights + hiddenBiases + outputWeights + outputBiases + labels;
+  // [tensor, size] in layout order; anything after the model is extra heads
+  const tensors: Array<[number, number]> = [
+    [0, 16],
+    [1, hiddenWeights],
+    [2, hiddenBiases],
+    [3, outputWeights],
+    [4, outputBiases],
+    [5, labels],
+    [6, Math.max(0, next.length - modelSize)],
+  ];
+
+  // Past the end of the base the Arduino starts from zeros
+  const changed = (pos: number) => next[pos] !== (pos < base.length ? base[pos] : 0);
+  const patches: Array<{ tensor: number; offset: number; bytes: Uint8Array }> = [];
+  let start = 0;
+  for (const [tensor, size] of tensors) {
+    const end = Math.min(start + size, next.length);
+    let pos = start;
+    while (pos < end) {
+      if (!changed(pos)) {
+        pos++;
+        continue;
+      }
+      let last = pos;
+      for (let i = pos + 1; i < end && i <= last + PATCH_HEADER_SIZE; i++) {
+        if (changed(i)) last = i;
+      }
+      patches.push({ tensor, offset: pos - start, bytes: next.subarray(pos, last + 1) });
+      pos = last + 1;
+    }
+    start += size;
+  }
+
+  const totalBytes = patches.reduce(
+    (sum, patch) => sum + PATCH_HEADER_SIZE + patch.bytes.length,
+    DELTA_HEADER_SIZE
+  );
+  const delta = new Uint8Array(totalBytes);
+  const view = new DataView(delta.buffer);
+  view.setUint32(0, SIMPLE_NN_DELTA_MAGIC, true);
+  view.setUint32(4, calculateCrc32(base), true);
+  view.setUint32(8, base.length, true);
+  view.setUint32(12, next.length, true);
+  view.setUint32(16, calculateCrc32(next), true);
+  view.setUint32(20, patches.length, true);
+  let offset = DELTA_HEADER_SIZE;
+  for (const patch of patches) {
+    view.setUint32(offset, patch.tensor, true);
+    view.setUint32(offset + 4, patch.offset, true);
+    view.setUint32(offset + 8, patch.bytes.length, true);
+    delta.set(patch.bytes, offset + PATCH_HEADER_SIZE);
+    offset += PATCH_HEADER_SIZE + patch.bytes.length;
+  }
+
+  console.log(`Model delta: ${patches.length} patches in ${delta.length} bytes`);
+
+  return delta;
+}
+
+function firmwareAtLeast(
+  info: DeviceInfo | null | undefined,
+  min: { major: number; minor: number }
+): boolean {
+  if (!info) return false;
+  if (info.firmwareMajor !== min.major) {
+    return info.firmwareMajor > min.major;
+  }
+  return info.firmwareMinor >= min.minor;
+}
+
+/**
+ * True when the connected firmware accepts weightsToCompactBytes() uploads
+ */
+export function supportsCompactModel(info: DeviceInfo | null | undefined): boolean {
+  return firmwareAtLeast(info, COMPACT_MODEL_MIN_FIRMWARE);
+}
+
+/**
+ * True when the connected firmware accepts packModelBytes() uploads
+ */
+export function supportsPackedModel(info: DeviceInfo | null | undefined): boolean {
+  return firmwareAtLeast(info, PACKED_MODEL_MIN_FIRMWARE);
+}
+
+/**
+ * True when the connected firmware takes chunks out of order and answers
+ * missing-range queries, so uploads can skip write acknowledgements
+ */
+export function supportsSelectiveRepeat(info: DeviceInfo | null | undefined): boolean {
+  return firmwareAtLeast(info, SELECTIVE_REPEAT_MIN_FIRMWARE);
+}
+
+/**
+ * True when model status updates advertise upload credits, so writes can
+ * be pipelined up to the Arduino's queue depth instead of paced
+ */
+export function supportsUploadCredits(info: DeviceInfo | null | undefined): boolean {
+  return firmwareAtLeast(info, UPLOAD_CREDITS_MIN_FIRMWARE);
+}
+
+/**
+ * True when the connected firmware accepts encodeModelDelta() uploads
+ */
+export function supportsDeltaModel(info: DeviceInfo | null | undefined): boolean {
+  return firmwareAtLeast(info, DELTA_MODEL_MIN_FIRMWARE);
+}
+
 /**
  * Main function: Convert TF.js model to bytes for BLE upload
+ *
+ * Use compact / packed only when supportsCompactModel() /
+ * supportsPackedModel() say the Arduino can decode them; older firmware
+ * only accepts the full layout.
  */
-export function modelToSimpleNNBytes(model: tf.LayersModel, labels: string[] = []): Uint8Array {
+export function modelToSimpleNNBytes(
+  model: tf.LayersModel,
+  labels: string[] = [],
+  options: { compact?: boolean; packed?: boolean } = {}
+): Uint8Array {
   const weights = extractSimpleNNWeights(model);
-  return weightsToBytes(weights, labels);
+  const payload = options.compact ? weightsToCompactBytes(weights, labels) : weightsToBytes(weights, labels);
+  return options.packed ? packModelBytes(payload) : payload;
 }
 
 /**
@@ -46,16 +46,50 @@ export interface DeviceInfo {
   inferenceCount: number;
   hasModel: boolean;     // true if firmware has a trained model in storage
   storedModelSize: number; // bytes (0 when no model)
+  droppedSamples: number;  // IMU samples lost to FIFO/ring overruns (0 on older firmware)
+  memory?: DeviceMemoryStats; // RAM telemetry (firmware with 44-byte device info)
+  bleWrites?: DeviceWriteQueueStats; // Write queue (firmware with 48-byte device info)
+}
+
+// Bytes; 0 = not measurable on that build
+export interface DeviceMemoryStats {
+  stackPeak: number;
+  stackSize: number;
+  heapFree: number;
+  heapMinFree: number;
+  samplerStackPeak: number;
+  samplerStackSize: number;
+}
+
+// BLE write queue: deepest it has been, its size, writes dropped when full
+export interface DeviceWriteQueueStats {
+  peakDepth: number;
+  capacity: number;
+  dropped: number;
 }
 
 // ============================================================================
 // Inference Result (4 bytes)
 // ============================================================================
+export interface InferenceTiming {
+  newestSequence: number; // Sequence of the sample that completed the window
+  queuedUs: number;       // Sample read → inference start
+  networkUs: number;      // SimpleNN forward pass (all heads)
+  postUs: number;         // Window prep, idle override, packet build
+}
+
+export interface InferenceHeadResult {
+  prediction: number;    // Class index within this head
+  confidence: number;    // 0-100
+}
+
 export interface InferenceResult {
   prediction: number;    // Class index
   confidence: number;    // 0-100
   statusFlags: number;   // Bitfield from firmware (0 when unused)
   noModel: boolean;      // True when firmware has no model loaded
+  heads?: InferenceHeadResult[]; // Extra heads of a multi-head model, head 1 first
+  timing?: InferenceTiming; // Present when the host enabled timing via config
 }
 
 // ============================================================================